@@ -5,7 +5,8 @@
 #ifndef AUDIO_AL_CHANNEL_H_
 #define AUDIO_AL_CHANNEL_H_
 
-#include <algorithm>
+#include <atomic>
+#include <cstdint>
 
 #include "Audio/AL/Sound.h"
 
@@ -13,26 +14,142 @@ namespace rainbow { namespace audio
 {
     struct Sound;
 
+    /// <summary>An OpenAL source.</summary>
+    /// <remarks>
+    ///   The source itself is only touched by the audio thread. The game
+    ///   thread sees the channel state as of its last command, until the
+    ///   audio thread frees the channel when playback ends.
+    /// </remarks>
     struct Channel
     {
     public:
-        static constexpr int kNumBuffers = 3;
+        enum class State : uint32_t
+        {
+            Free,
+            Playing,
+            Paused,
+        };
+
+        /// <summary>
+        ///   State and generation, which is bumped every time the channel is
+        ///   claimed.
+        /// </summary>
+        using Token = uint32_t;
+
+        /// <summary>Maximum number of buffers queued by a stream.</summary>
+        static constexpr int kMaxBuffers = 8;
+
+        static auto state_of(Token token)
+        {
+            return static_cast<State>(token & kStateMask);
+        }
 
-        Channel(unsigned int id, unsigned int* buffers)
-            : id_(id), sound_(nullptr)
+        explicit Channel(unsigned int id)
+            : id_(id), token_(0), underruns_(0), sound_(nullptr)
         {
-            std::copy_n(buffers, kNumBuffers, buffers_);
         }
 
-        auto buffers() { return buffers_; }
         auto id() const { return id_; }
 
+        auto token() const -> Token
+        {
+            return token_.load(std::memory_order_acquire);
+        }
+
+        auto state() const { return state_of(token()); }
+
+        /// <summary>
+        ///   Marks a free channel as playing a new sound. Returns
+        ///   <c>false</c> if the channel is in use.
+        /// </summary>
+        bool claim()
+        {
+            Token token = this->token();
+            if (state_of(token) != State::Free ||
+                !token_.compare_exchange_strong(
+                    token,
+                    (token & ~kStateMask) + kGeneration +
+                        static_cast<Token>(State::Playing),
+                    std::memory_order_acq_rel))
+            {
+                return false;
+            }
+
+            underruns_.store(0, std::memory_order_relaxed);
+            return true;
+        }
+
+        /// <summary>
+        ///   Sets the state to <paramref name="desired"/> only if it is
+        ///   currently <paramref name="expected"/>.
+        /// </summary>
+        bool exchange_state(State expected, State desired)
+        {
+            Token token = this->token();
+            while (state_of(token) == expected)
+            {
+                if (token_.compare_exchange_weak(
+                        token,
+                        (token & ~kStateMask) | static_cast<Token>(desired),
+                        std::memory_order_acq_rel))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /// <summary>
+        ///   Frees the channel only if it has not changed since
+        ///   <paramref name="token"/> was read.
+        /// </summary>
+        bool free(Token token)
+        {
+            return token_.compare_exchange_strong(
+                token, token & ~kStateMask, std::memory_order_acq_rel);
+        }
+
+        /// <summary>
+        ///   Returns the number of times the stream ran dry since the channel
+        ///   was claimed.
+        /// </summary>
+        auto underruns() const
+        {
+            return underruns_.load(std::memory_order_relaxed);
+        }
+
+        /// <summary>Counts a stream underrun, on the audio thread.</summary>
+        void count_underrun()
+        {
+            underruns_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /// <summary>Returns the sound played, on the game thread.</summary>
         auto sound() const { return sound_; }
         void set_sound(Sound* sound) { sound_ = sound; }
 
+        /// <summary>
+        ///   Static sound attached to the source, owned by the audio thread.
+        /// </summary>
+        Sound* attached = nullptr;
+
+        /// <summary>Streaming state, owned by the audio thread.</summary>
+        struct Stream
+        {
+            Sound* sound = nullptr;
+            int loop_count = 0;
+            int buffer_count = 0;
+            bool ended = false;
+            unsigned int buffers[kMaxBuffers]{};
+        } stream;
+
     private:
+        static constexpr Token kStateMask = 0x3;
+        static constexpr Token kGeneration = 0x4;
+
         const unsigned int id_;
-        unsigned int buffers_[kNumBuffers]{0, 0, 0};
+        std::atomic<Token> token_;
+        std::atomic<unsigned int> underruns_;
         Sound* sound_;
     };
 }}  // rainbow::audio
@@ -4,8 +4,11 @@
 
 #include "Audio/AL/Mixer.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 
+#include "Common/Profiler.h"
 #include "Platform/Macros.h"
 #if defined(RAINBOW_OS_IOS) || defined(RAINBOW_OS_MACOS)
 #   include <OpenAL/al.h>
@@ -25,14 +28,36 @@
 
 using rainbow::audio::ALMixer;
 using rainbow::audio::Channel;
+using rainbow::audio::MemoryUsage;
 using rainbow::audio::Sound;
+using rainbow::audio::Statistics;
 
 namespace
 {
-    constexpr size_t kAudioBufferSize = 8192;
+    /// <summary>
+    ///   How long the audio thread sleeps between refilling streams, unless
+    ///   woken by a command.
+    /// </summary>
+    constexpr std::chrono::milliseconds kRefillInterval{5};
+
+    /// <summary>Smallest stream buffer, in sample frames.</summary>
+    constexpr size_t kMinBufferFrames = 1024;
 
     ALMixer* al_mixer = nullptr;
 
+    using Clock = std::chrono::steady_clock;
+
+    /// <summary>
+    ///   Adds nanoseconds elapsed since <paramref name="start"/> to
+    ///   <paramref name="total"/>.
+    /// </summary>
+    void add_elapsed(std::atomic<uint64_t>& total, Clock::time_point start)
+    {
+        const auto elapsed = std::chrono::duration_cast<
+            std::chrono::nanoseconds>(Clock::now() - start);
+        total.fetch_add(elapsed.count(), std::memory_order_relaxed);
+    }
+
     struct ALCContextDestroyer
     {
         void operator()(ALCcontext* ctx) const { alcDestroyContext(ctx); }
@@ -43,25 +68,13 @@ namespace
         void operator()(ALCdevice* device) const { alcCloseDevice(device); }
     };
 
-    int get_channel_state(const Channel& channel)
+    int get_source_state(ALuint source)
     {
         ALint state{};
-        alGetSourcei(channel.id(), AL_SOURCE_STATE, &state);
+        alGetSourcei(source, AL_SOURCE_STATE, &state);
         return state;
     }
 
-    int get_channel_type(const Channel& channel)
-    {
-        ALint type{};
-        alGetSourcei(channel.id(), AL_SOURCE_TYPE, &type);
-        return type;
-    }
-
-    bool is_available(const Channel& channel)
-    {
-        return get_channel_type(channel) == AL_UNDETERMINED;
-    }
-
     bool is_fail(ALenum result) { return result != AL_NO_ERROR; }
 }
 
@@ -102,80 +115,22 @@ bool ALMixer::initialize(int max_channels)
         return false;
     }
 
-    const auto buffer_count = max_channels * Channel::kNumBuffers;
-    auto buffers = std::make_unique<ALuint[]>(buffer_count);
-    alGenBuffers(buffer_count, buffers.get());
-    result = alGetError();
-    if (is_fail(result))
-    {
-        LOGE("OpenAL: Failed to generate buffers (code: 0x%x)", result);
-        alDeleteSources(max_channels, sources.get());
-        return false;
-    }
-
-    channels_.reserve(max_channels);
     for (int i = 0; i < max_channels; ++i)
-    {
-        const int offset = i * Channel::kNumBuffers;
-        channels_.emplace_back(sources[i], buffers.get() + offset);
-    }
+        channels_.emplace_back(sources[i]);
 
     device.release();
     context_ = context.release();
     al_mixer = this;
 
+    running_ = true;
+    thread_ = std::thread([this] { run(); });
+
     return true;
 }
 
 void ALMixer::process()
 {
-    static char buffer[kAudioBufferSize];
-    for (Channel& channel : channels_)
-    {
-        const auto state = get_channel_state(channel);
-        const auto type = get_channel_type(channel);
-        if (type != AL_STREAMING)
-        {
-            if (type != AL_UNDETERMINED && state == AL_STOPPED)
-                stop(&channel);
-            continue;
-        }
-
-        if (state == AL_PAUSED)
-            continue;
-
-        auto sound = channel.sound();
-        auto stream = sound->file.get();
-
-        ALint processed{};
-        alGetSourcei(channel.id(), AL_BUFFERS_PROCESSED, &processed);
-        for (ALint i = 0; i < processed; ++i)
-        {
-            size_t length = stream->read(buffer, sizeof(buffer));
-            if (length == 0)
-            {
-                if (sound->loop_count == 0)
-                {
-                    processed = i;
-                    stop(&channel);
-                    break;
-                }
-                else if (sound->loop_count > 0)
-                {
-                    --sound->loop_count;
-                }
-                stream->rewind();
-                length = stream->read(buffer, sizeof(buffer));
-            }
-            ALuint bid{};
-            alSourceUnqueueBuffers(channel.id(), 1, &bid);
-            alBufferData(bid, sound->format, buffer, length, sound->rate);
-            alSourceQueueBuffers(channel.id(), 1, &bid);
-        }
-
-        if (processed > 0 && state == AL_STOPPED)
-            alSourcePlay(channel.id());
-    }
+    // Sources are managed by the audio thread.
 }
 
 void ALMixer::suspend(bool should_suspend)
@@ -185,6 +140,9 @@ void ALMixer::suspend(bool should_suspend)
 
     if (should_suspend)
     {
+        // The audio thread must stop touching the context before it goes.
+        post(Command::Type::Suspend);
+        flush();
         alcSuspendContext(context_);
         alcMakeContextCurrent(nullptr);
     }
@@ -192,6 +150,7 @@ void ALMixer::suspend(bool should_suspend)
     {
         alcMakeContextCurrent(context_);
         alcProcessContext(context_);
+        post(Command::Type::Wake);
     }
 }
 
@@ -207,11 +166,30 @@ auto ALMixer::create_sound(const char* path) -> Sound*
     return &i->second;
 }
 
+bool ALMixer::decode(Sound* sound)
+{
+    auto audio_file = IAudioFile::open(sound->key);
+    if (!*audio_file)
+        return false;
+
+    sound->format =
+        audio_file->channels() == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+    sound->rate = audio_file->rate();
+
+    const size_t size = audio_file->size();
+    auto buffer = std::make_unique<char[]>(size);
+    sound->size = read(*audio_file, buffer.get(), size);
+    alGenBuffers(1, &sound->buffer);
+    alBufferData(
+        sound->buffer, sound->format, buffer.get(), sound->size, sound->rate);
+    return true;
+}
+
 auto ALMixer::get_channel() -> Channel*
 {
     for (Channel& channel : channels_)
     {
-        if (is_available(channel))
+        if (channel.claim())
             return &channel;
     }
 
@@ -223,71 +201,455 @@ void ALMixer::release(Sound* sound)
     for (Channel& channel : channels_)
     {
         if (channel.sound() == sound)
-            stop(&channel);
+            rainbow::audio::stop(&channel);
+    }
+
+    if (!sound->stream)
+    {
+        Command command{Command::Type::Release};
+        command.sound = sound;
+        post(command);
     }
 
+    // The audio thread may still be reading from the sound.
+    flush();
     sounds_.erase(sound->key);
 }
 
+auto ALMixer::memory_usage() const -> MemoryUsage
+{
+    const double M = 1e-6;
+    return {mem_used_.load(std::memory_order_relaxed) * M,
+            mem_peak_.load(std::memory_order_relaxed) * M,
+            budget_.load(std::memory_order_relaxed) * M,
+            evictions_.load(std::memory_order_relaxed),
+            reloads_.load(std::memory_order_relaxed)};
+}
+
+void ALMixer::set_memory_budget(size_t bytes)
+{
+    budget_.store(bytes, std::memory_order_relaxed);
+    post(Command::Type::Evict);
+}
+
+auto ALMixer::statistics() const -> Statistics
+{
+    const int active_voices = static_cast<int>(
+        std::count_if(channels_.cbegin(), channels_.cend(), [](auto&& c) {
+            return c.state() != Channel::State::Free;
+        }));
+
+    const double s = 1e-9;
+    return {process_time_.load(std::memory_order_relaxed) * s,
+            updates_.load(std::memory_order_relaxed),
+            decode_time_.load(std::memory_order_relaxed) * s,
+            bytes_decoded_.load(std::memory_order_relaxed),
+            underruns_.load(std::memory_order_relaxed),
+            active_voices};
+}
+
+void ALMixer::post(const Command& command)
+{
+    // The queue is drained every few milliseconds, so it only fills up if
+    // hundreds of commands are posted at once.
+    while (!commands_.try_push(command))
+    {
+        wake_.notify_one();
+        std::this_thread::yield();
+    }
+    ++posted_;
+    wake_.notify_one();
+}
+
+void ALMixer::flush()
+{
+    wake_.notify_one();
+    while (executed_.load(std::memory_order_acquire) < posted_)
+        std::this_thread::yield();
+}
+
+void ALMixer::run()
+{
+    while (running_.load(std::memory_order_acquire))
+    {
+        const auto start = Clock::now();
+
+        Command command;
+        while (commands_.try_pop(command))
+        {
+            execute(command);
+            executed_.fetch_add(1, std::memory_order_release);
+        }
+
+        if (!suspended_)
+        {
+            refill();
+            if (should_evict_)
+                evict();
+        }
+
+        add_elapsed(process_time_, start);
+        updates_.fetch_add(1, std::memory_order_relaxed);
+
+        // Commands are posted without taking the lock, so a notification may
+        // be missed. The timeout bounds the delay.
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_.wait_for(lock, kRefillInterval, [this] {
+            return !commands_.empty() || !running_.load();
+        });
+    }
+}
+
+void ALMixer::execute(const Command& command)
+{
+    Channel* channel = command.channel;
+    switch (command.type)
+    {
+        case Command::Type::Start:
+            start(*channel, command.sound, command.position);
+            break;
+        case Command::Type::Play:
+            alSourcePlay(channel->id());
+            break;
+        case Command::Type::Pause:
+            alSourcePause(channel->id());
+            break;
+        case Command::Type::Stop:
+            stop(*channel);
+            break;
+        case Command::Type::Loop:
+            if (channel->stream.sound != nullptr)
+                channel->stream.loop_count = command.count;
+            else
+            {
+                // TODO: Doesn't actually set loop _count_.
+                alSourcei(channel->id(), AL_LOOPING, command.count);
+            }
+            break;
+        case Command::Type::Volume:
+            alSourcef(channel->id(), AL_GAIN, command.value);
+            break;
+        case Command::Type::Position: {
+            const ALfloat pos[]{command.position.x, command.position.y, 0.0f};
+            alSourcefv(channel->id(), AL_POSITION, pos);
+            break;
+        }
+        case Command::Type::Suspend:
+            suspended_ = true;
+            break;
+        case Command::Type::Wake:
+            suspended_ = false;
+            break;
+        case Command::Type::Load:
+            cache(command.sound);
+            break;
+        case Command::Type::Release: {
+            Sound* sound = command.sound;
+            if (sound->buffer == 0)
+                break;
+
+            cache_.erase(std::find(cache_.begin(), cache_.end(), sound));
+            mem_used_.fetch_sub(sound->size, std::memory_order_relaxed);
+            alDeleteBuffers(1, &sound->buffer);
+            sound->buffer = 0;
+            break;
+        }
+        case Command::Type::Evict:
+            should_evict_ = true;
+            break;
+        default:
+            break;
+    }
+}
+
+auto ALMixer::read(IAudioFile& file, void* dst, size_t size) -> size_t
+{
+    const auto start = Clock::now();
+    const size_t length = file.read(dst, size);
+    add_elapsed(decode_time_, start);
+    bytes_decoded_.fetch_add(length, std::memory_order_relaxed);
+    return length;
+}
+
+bool ALMixer::fill(Channel& channel, unsigned int buffer)
+{
+    Sound* sound = channel.stream.sound;
+    IAudioFile* file = sound->file.get();
+    buffer_.resize(sound->buffer_size);
+
+    size_t length = read(*file, buffer_.data(), buffer_.size());
+    if (length == 0)
+    {
+        int& loop_count = channel.stream.loop_count;
+        if (loop_count == 0)
+            return false;
+        if (loop_count > 0)
+            --loop_count;
+
+        file->rewind();
+        length = read(*file, buffer_.data(), buffer_.size());
+        if (length == 0)
+            return false;
+    }
+
+    alBufferData(buffer, sound->format, buffer_.data(), length, sound->rate);
+    return true;
+}
+
+void ALMixer::refill()
+{
+    R_PROFILE_ZONE("ALMixer::refill");
+
+    for (Channel& channel : channels_)
+    {
+        const Channel::Token token = channel.token();
+        if (Channel::state_of(token) == Channel::State::Free)
+            continue;
+
+        // Sources that have yet to start, or are paused, need no attention.
+        const ALuint source = channel.id();
+        const int state = get_source_state(source);
+        if (state == AL_INITIAL || state == AL_PAUSED)
+            continue;
+
+        Channel::Stream& stream = channel.stream;
+        if (stream.sound != nullptr && !stream.ended)
+        {
+            ALint processed{};
+            alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
+            ALint requeued = 0;
+            for (; requeued < processed; ++requeued)
+            {
+                ALuint buffer{};
+                alSourceUnqueueBuffers(source, 1, &buffer);
+                if (!fill(channel, buffer))
+                {
+                    // Let the buffers already queued play out.
+                    stream.ended = true;
+                    break;
+                }
+                alSourceQueueBuffers(source, 1, &buffer);
+            }
+
+            if (state == AL_STOPPED && requeued > 0)
+            {
+                // The stream ran dry; resume with the buffers just queued.
+                channel.count_underrun();
+                underruns_.fetch_add(1, std::memory_order_relaxed);
+                alSourcePlay(source);
+                continue;
+            }
+        }
+
+        // Unless the game thread has changed the channel in the meantime,
+        // free it once playback has ended.
+        if (state == AL_STOPPED && channel.free(token))
+            stop(channel);
+    }
+}
+
+void ALMixer::cache(Sound* sound)
+{
+    cache_.push_back(sound);
+    sound->last_played = ++clock_;
+
+    const size_t used =
+        mem_used_.fetch_add(sound->size, std::memory_order_relaxed) +
+        sound->size;
+    if (used > mem_peak_.load(std::memory_order_relaxed))
+        mem_peak_.store(used, std::memory_order_relaxed);
+
+    should_evict_ = true;
+}
+
+void ALMixer::evict()
+{
+    should_evict_ = false;
+
+    const size_t budget = budget_.load(std::memory_order_relaxed);
+    if (budget == 0 || mem_used_.load(std::memory_order_relaxed) <= budget)
+        return;
+
+    R_PROFILE_ZONE("ALMixer::evict");
+
+    std::sort(cache_.begin(), cache_.end(), [](const Sound* a, const Sound* b) {
+        return a->last_played < b->last_played;
+    });
+
+    auto is_attached = [this](const Sound* sound) {
+        return std::any_of(
+            channels_.cbegin(), channels_.cend(), [sound](const Channel& c) {
+                return c.attached == sound;
+            });
+    };
+
+    for (auto i = cache_.begin(); i != cache_.end();)
+    {
+        if (mem_used_.load(std::memory_order_relaxed) <= budget)
+            break;
+
+        Sound* sound = *i;
+        if (is_attached(sound))
+        {
+            ++i;
+            continue;
+        }
+
+        alDeleteBuffers(1, &sound->buffer);
+        sound->buffer = 0;
+        sound->evicted = true;
+        mem_used_.fetch_sub(sound->size, std::memory_order_relaxed);
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+        i = cache_.erase(i);
+    }
+}
+
+void ALMixer::start(Channel& channel, Sound* sound, const Vec2f& position)
+{
+    const ALuint source = channel.id();
+    if (sound->stream)
+    {
+        Channel::Stream& stream = channel.stream;
+        stream.sound = sound;
+        stream.loop_count = 0;
+        stream.buffer_count = sound->buffer_count;
+        stream.ended = false;
+        alGenBuffers(stream.buffer_count, stream.buffers);
+
+        // TODO: Prevent streaming from an already streaming sound.
+        sound->file->rewind();
+
+        int queued = 0;
+        for (; queued < stream.buffer_count; ++queued)
+        {
+            if (!fill(channel, stream.buffers[queued]))
+            {
+                stream.ended = true;
+                break;
+            }
+        }
+        alSourceQueueBuffers(source, queued, stream.buffers);
+    }
+    else
+    {
+        if (sound->buffer == 0)
+        {
+            // The sound was loaded lazily, or has been evicted.
+            if (!decode(sound))
+            {
+                LOGE("OpenAL: Failed to decode '%s'", sound->key);
+                channel.free(channel.token());
+                return;
+            }
+
+            if (sound->evicted)
+                reloads_.fetch_add(1, std::memory_order_relaxed);
+            cache(sound);
+        }
+
+        sound->last_played = ++clock_;
+        channel.attached = sound;
+        alSourcei(source, AL_BUFFER, sound->buffer);
+    }
+
+    alSourcei(source, AL_LOOPING, 0);
+    alSourcef(source, AL_GAIN, 1.0f);
+
+    const ALfloat pos[]{position.x, position.y, 0.0f};
+    alSourcefv(source, AL_POSITION, pos);
+    alSourcePlay(source);
+}
+
+void ALMixer::stop(Channel& channel)
+{
+    const ALuint source = channel.id();
+    alSourceStop(source);
+    alSourcei(source, AL_BUFFER, AL_NONE);
+
+    // Rewinding puts the source back in its initial state, so that it is
+    // left alone until it is started again.
+    alSourceRewind(source);
+
+    if (channel.attached != nullptr)
+    {
+        channel.attached = nullptr;
+        should_evict_ = true;
+    }
+
+    Channel::Stream& stream = channel.stream;
+    if (stream.sound != nullptr)
+    {
+        alDeleteBuffers(stream.buffer_count, stream.buffers);
+        stream = Channel::Stream{};
+    }
+}
+
 ALMixer::~ALMixer()
 {
+    if (thread_.joinable())
+    {
+        running_ = false;
+        wake_.notify_one();
+        thread_.join();
+    }
+
     al_mixer = nullptr;
 
     if (context_ == nullptr)
         return;
 
-    suspend(true);
-
     for (Channel& channel : channels_)
     {
+        stop(channel);
         const ALuint source = channel.id();
         alDeleteSources(1, &source);
-        alDeleteBuffers(Channel::kNumBuffers, channel.buffers());
     }
 
+    for (Sound* sound : cache_)
+        alDeleteBuffers(1, &sound->buffer);
+
+    alcSuspendContext(context_);
+    alcMakeContextCurrent(nullptr);
+
     std::unique_ptr<ALCdevice, ALCDeviceCloser> device(
         alcGetContextsDevice(context_));
     alcDestroyContext(context_);
 }
 
-auto rainbow::audio::load_sound(const char* path) -> Sound*
+auto rainbow::audio::load_sound(const char* path, Decode decode) -> Sound*
 {
     auto sound = al_mixer->create_sound(path);
-    if (sound == nullptr || sound->buffer > 0)
+    if (sound == nullptr || sound->loaded)
         return sound;
 
     R_ASSERT(!sound->stream, "Sound already opened as a stream");
 
-    auto audio_file = IAudioFile::open(path);
-    if (!*audio_file)
+    // Lazily loaded sounds are decoded by the audio thread when played.
+    if (decode == Decode::OnLoad)
     {
-        release(sound);
-        return nullptr;
-    }
-
-    sound->format =
-        audio_file->channels() == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
-    sound->rate = audio_file->rate();
+        if (!al_mixer->decode(sound))
+        {
+            release(sound);
+            return nullptr;
+        }
 
-    const size_t size = audio_file->size();
-    auto buffer = std::make_unique<char[]>(size);
-    alGenBuffers(1, &sound->buffer);
-    alBufferData(sound->buffer,
-                 sound->format,
-                 buffer.get(),
-                 audio_file->read(buffer.get(), size),
-                 sound->rate);
+        ALMixer::Command command{ALMixer::Command::Type::Load};
+        command.sound = sound;
+        al_mixer->post(command);
+    }
 
+    sound->loaded = true;
     return sound;
 }
 
-auto rainbow::audio::load_stream(const char* path) -> Sound*
+auto rainbow::audio::load_stream(const char* path,
+                                 const StreamBuffering& buffering) -> Sound*
 {
     auto sound = al_mixer->create_sound(path);
     if (sound == nullptr || sound->file != nullptr)
         return sound;
 
-    R_ASSERT(sound->buffer == 0, "Sound already opened as static");
+    R_ASSERT(!sound->loaded, "Sound already opened as static");
 
     auto audio_file = IAudioFile::open(path);
     if (!*audio_file)
@@ -300,108 +662,124 @@ auto rainbow::audio::load_stream(const char* path) -> Sound*
     sound->format =
         audio_file->channels() == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
     sound->rate = audio_file->rate();
+
+    // Buffers must hold whole sample frames.
+    const size_t frame_size = audio_file->channels() * 2;
+    sound->buffer_count =
+        std::min(std::max(buffering.count, 2), Channel::kMaxBuffers);
+    sound->buffer_size =
+        std::max(buffering.size / frame_size, kMinBufferFrames) * frame_size;
     sound->file = std::move(audio_file);
     return sound;
 }
 
 void rainbow::audio::release(Sound* sound)
 {
-    const auto stream = sound->stream;
-    const auto buffer = sound->buffer;
-
-    sound->file.release();
     al_mixer->release(sound);
+}
 
-    if (!stream)
-        alDeleteBuffers(1, &buffer);
+void rainbow::audio::set_priority(Sound*, int)
+{
+    // Busy channels are never taken over; priority does not apply.
+}
+
+auto rainbow::audio::memory_usage() -> MemoryUsage
+{
+    return al_mixer->memory_usage();
+}
+
+void rainbow::audio::set_memory_budget(size_t bytes)
+{
+    al_mixer->set_memory_budget(bytes);
+}
+
+auto rainbow::audio::statistics() -> Statistics
+{
+    return al_mixer->statistics();
+}
+
+auto rainbow::audio::underruns(Channel* channel) -> unsigned int
+{
+    return channel->underruns();
 }
 
 bool rainbow::audio::is_paused(Channel* channel)
 {
-    return get_channel_state(*channel) == AL_PAUSED;
+    return channel->state() == Channel::State::Paused;
 }
 
 bool rainbow::audio::is_playing(Channel* channel)
 {
-    const auto state = get_channel_state(*channel);
-    return state == AL_PLAYING || state == AL_PAUSED;
+    return channel->state() != Channel::State::Free;
 }
 
 void rainbow::audio::set_loop_count(Channel* channel, int count)
 {
-    // TODO: Doesn't actually set loop _count_.
-    alSourcei(channel->id(), AL_LOOPING, count);
+    ALMixer::Command command{ALMixer::Command::Type::Loop, channel};
+    command.count = count;
+    al_mixer->post(command);
 }
 
 void rainbow::audio::set_volume(Channel* channel, float volume)
 {
-    alSourcef(channel->id(), AL_GAIN, volume);
+    ALMixer::Command command{ALMixer::Command::Type::Volume, channel};
+    command.value = volume;
+    al_mixer->post(command);
 }
 
 void rainbow::audio::set_world_position(Channel* channel, const Vec2f& position)
 {
-    const ALfloat pos[]{position.x, position.y, 0.0f};
-    alSourcefv(channel->id(), AL_POSITION, pos);
+    ALMixer::Command command{ALMixer::Command::Type::Position, channel};
+    command.position = position;
+    al_mixer->post(command);
 }
 
 void rainbow::audio::pause(Channel* channel)
 {
-    alSourcePause(channel->id());
+    if (channel->exchange_state(Channel::State::Playing,
+                                Channel::State::Paused))
+    {
+        al_mixer->post({ALMixer::Command::Type::Pause, channel});
+    }
 }
 
 auto rainbow::audio::play(Channel* channel) -> Channel*
 {
-    if (get_channel_state(*channel) == AL_STOPPED)
+    if (channel->exchange_state(Channel::State::Paused,
+                                Channel::State::Playing))
+    {
+        al_mixer->post({ALMixer::Command::Type::Play, channel});
+    }
+    else if (channel->state() != Channel::State::Playing)
+    {
         return nullptr;
+    }
 
-    alSourcePlay(channel->id());
     return channel;
 }
 
 auto rainbow::audio::play(Sound* sound, const Vec2f& position) -> Channel*
 {
     Channel* channel = al_mixer->get_channel();
-    channel->set_sound(sound);
-
-    if (sound->stream)
-    {
-        static char buffer[kAudioBufferSize];
-
-        // TODO: Prevent streaming from an already streaming sound.
-        sound->file->rewind();
-
-        int i{};
-        for (; i < Channel::kNumBuffers; ++i)
-        {
-            const size_t size = sound->file->read(buffer, sizeof(buffer));
-            alBufferData(channel->buffers()[i],
-                         sound->format,
-                         buffer,
-                         size,
-                         sound->rate);
-            if (size < sizeof(buffer))
-                break;
-        }
-        alSourceQueueBuffers(channel->id(), i, channel->buffers());
-    }
-    else
-    {
-        alSourcei(channel->id(), AL_BUFFER, sound->buffer);
-    }
+    if (channel == nullptr)
+        return nullptr;
 
-    set_loop_count(channel, 0);
-    set_volume(channel, 1.0f);
+    channel->set_sound(sound);
 
-    set_world_position(channel, position);
-    alSourcePlay(channel->id());
+    ALMixer::Command command{ALMixer::Command::Type::Start, channel};
+    command.sound = sound;
+    command.position = position;
+    al_mixer->post(command);
     return channel;
 }
 
 void rainbow::audio::stop(Channel* channel)
 {
-    alSourceStop(channel->id());
-    alSourcei(channel->id(), AL_BUFFER, AL_NONE);
-    for (int i = 0; i < Channel::kNumBuffers; ++i)
-        alBufferData(channel->buffers()[i], AL_FORMAT_MONO16, nullptr, 0, 0);
+    if (!channel->exchange_state(Channel::State::Playing,
+                                 Channel::State::Free))
+    {
+        channel->exchange_state(Channel::State::Paused, Channel::State::Free);
+    }
     channel->set_sound(nullptr);
+    al_mixer->post({ALMixer::Command::Type::Stop, channel});
 }
@@ -5,13 +5,20 @@
 #ifndef AUDIO_AL_MIXER_H_
 #define AUDIO_AL_MIXER_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 #include "Audio/AL/Channel.h"
 #include "Audio/AL/Sound.h"
 #include "Audio/Mixer.h"
+#include "Threading/SpscQueue.h"
 
 typedef struct ALCcontext_struct ALCcontext;
 
@@ -21,27 +28,161 @@ typedef struct ALCcontext_struct ALCcontext;
 
 namespace rainbow { namespace audio
 {
+    /// <summary>OpenAL mixer.</summary>
+    /// <remarks>
+    ///   Sources are controlled by a dedicated audio thread, which also
+    ///   decodes and queues stream buffers so that a slow frame does not
+    ///   starve them. The game thread sends commands through a lock-free
+    ///   queue, and never waits for the audio thread except when releasing
+    ///   sounds or suspending.
+    ///
+    ///   The audio thread also owns the buffers of static sounds once they
+    ///   have been loaded. When they take up more memory than budgeted, the
+    ///   least recently played are evicted, and decoded again when needed.
+    /// </remarks>
     class ALMixer
     {
     public:
+        /// <summary>Command sent from the game thread.</summary>
+        struct Command
+        {
+            enum class Type
+            {
+                None,
+                Start,     ///< Start playing <c>sound</c> from the beginning.
+                Play,      ///< Resume playback.
+                Pause,
+                Stop,
+                Loop,      ///< Set the number of times to loop.
+                Volume,
+                Position,  ///< Set the world position.
+                Suspend,   ///< Stop touching OpenAL until woken.
+                Wake,
+                Load,      ///< Take ownership of a decoded <c>sound</c>.
+                Release,   ///< Delete the buffer of <c>sound</c>.
+                Evict,     ///< Evict sounds until within budget.
+            };
+
+            Type type = Type::None;
+            Channel* channel = nullptr;
+            Sound* sound = nullptr;
+            int count = 0;
+            float value = 0.0f;
+            Vec2f position;
+
+            Command() = default;
+            Command(Type t, Channel* c = nullptr) : type(t), channel(c)
+            {
+            }
+        };
+
         bool initialize(int max_channels);
         void process();
         void suspend(bool should_suspend);
 
         auto create_sound(const char* path) -> Sound*;
+
+        /// <summary>Decodes a static sound into a new buffer.</summary>
+        /// <remarks>
+        ///   Buffers may be created on any thread; only sources belong to
+        ///   the audio thread.
+        /// </remarks>
+        bool decode(Sound* sound);
+
+        /// <summary>Claims a free channel.</summary>
         auto get_channel() -> Channel*;
+
         void release(Sound* sound);
 
+        auto memory_usage() const -> MemoryUsage;
+        void set_memory_budget(size_t bytes);
+
+        auto statistics() const -> Statistics;
+
+        /// <summary>Sends a command to the audio thread.</summary>
+        void post(const Command& command);
+
+        /// <summary>
+        ///   Waits until the audio thread has executed all commands posted.
+        /// </summary>
+        void flush();
+
     protected:
         ~ALMixer();
 
     private:
-        std::vector<Channel> channels_;
+        // Channels contain atomics and cannot be moved.
+        std::deque<Channel> channels_;
         std::unordered_map<std::string, Sound> sounds_;
         ALCcontext* context_ = nullptr;
 #ifdef RAINBOW_OS_IOS
         RainbowAudioSession* audio_session_ = nil;
 #endif
+
+        SpscQueue<Command, 256> commands_;
+        size_t posted_ = 0;                   ///< Game thread only.
+        std::atomic<size_t> executed_{0};     ///< Commands executed.
+        std::atomic<bool> running_{false};
+        std::mutex wake_mutex_;
+        std::condition_variable wake_;
+        std::thread thread_;
+        std::vector<char> buffer_;  ///< Decode buffer; audio thread only.
+        bool suspended_ = false;    ///< Audio thread only.
+
+        // Static sound cache. Sounds and the clock are audio thread only.
+        std::vector<Sound*> cache_;         ///< Sounds with a buffer.
+        uint64_t clock_ = 0;                ///< Incremented on every start.
+        bool should_evict_ = false;
+        std::atomic<size_t> budget_{0};     ///< Budget in bytes; 0 is none.
+        std::atomic<size_t> mem_used_{0};
+        std::atomic<size_t> mem_peak_{0};
+        std::atomic<unsigned int> evictions_{0};
+        std::atomic<unsigned int> reloads_{0};
+
+        // Instrumentation. Only decoding may happen on the game thread.
+        std::atomic<uint64_t> process_time_{0};  ///< Nanoseconds.
+        std::atomic<unsigned int> updates_{0};
+        std::atomic<uint64_t> decode_time_{0};   ///< Nanoseconds.
+        std::atomic<uint64_t> bytes_decoded_{0};
+        std::atomic<unsigned int> underruns_{0};
+
+        /// <summary>Audio thread entry point.</summary>
+        void run();
+
+        void execute(const Command& command);
+
+        /// <summary>
+        ///   Reads up to <paramref name="size"/> bytes of samples from
+        ///   <paramref name="file"/>, counting the time it takes.
+        /// </summary>
+        auto read(IAudioFile& file, void* dst, size_t size) -> size_t;
+
+        /// <summary>
+        ///   Fills <paramref name="buffer"/> with the next chunk of the
+        ///   stream playing on <paramref name="channel"/>.
+        /// </summary>
+        /// <returns><c>false</c> if the stream has ended.</returns>
+        bool fill(Channel& channel, unsigned int buffer);
+
+        /// <summary>
+        ///   Frees channels that finished playing, and refills streams.
+        /// </summary>
+        void refill();
+
+        /// <summary>
+        ///   Adds a decoded static sound to the cache, and accounts for its
+        ///   memory.
+        /// </summary>
+        void cache(Sound* sound);
+
+        /// <summary>
+        ///   Evicts the least recently played static sounds not attached to
+        ///   any source, until memory used is within budget.
+        /// </summary>
+        void evict();
+
+        void start(Channel& channel, Sound* sound, const Vec2f& position);
+        void stop(Channel& channel);
     };
 
     using Mixer = TMixer<ALMixer>;
@@ -5,17 +5,29 @@
 #ifndef AUDIO_AL_SOUND_H_
 #define AUDIO_AL_SOUND_H_
 
+#include <cstdint>
+
 #include "Audio/AudioFile.h"
 
 namespace rainbow { namespace audio
 {
+    /// <summary>A static or streaming sound.</summary>
+    /// <remarks>
+    ///   Once a static sound has been played, its buffer is owned by the
+    ///   audio thread, which may evict it and decode it again later.
+    /// </remarks>
     struct Sound
     {
         bool stream = false;
+        bool loaded = false;     ///< Loaded as static; game thread only.
+        bool evicted = false;    ///< Buffer was evicted at least once.
         int format = 0;
         int rate = 0;
-        int loop_count = 0;
-        unsigned int buffer = 0;
+        int buffer_count = 0;    ///< Number of buffers to stream with.
+        size_t buffer_size = 0;  ///< Size of each stream buffer.
+        unsigned int buffer = 0; ///< Static buffer; 0 if not decoded.
+        size_t size = 0;         ///< Size of the decoded static buffer.
+        uint64_t last_played = 0;
         std::unique_ptr<IAudioFile> file;
         const char* key;
     };
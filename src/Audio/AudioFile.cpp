@@ -69,6 +69,11 @@ std::unique_ptr<IAudioFile> IAudioFile::open(const char* path)
 #ifdef USE_OGGVORBIS
     if (OggVorbisAudioFile::signature_matches(ArrayView<char>(signature)))
     {
+        // Prefer decoding from a mapping that is shared between streams.
+        auto data = OggVorbisAudioFile::map(path);
+        if (data)
+            return std::unique_ptr<IAudioFile>(new OggVorbisAudioFile(data));
+
         return std::unique_ptr<IAudioFile>(
             new OggVorbisAudioFile(std::move(file)));
     }
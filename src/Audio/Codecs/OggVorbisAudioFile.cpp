@@ -4,11 +4,16 @@
 
 #include "Audio/Codecs/OggVorbisAudioFile.h"
 
+#include <algorithm>
 #include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <utility>
 
 #include "Common/Algorithm.h"
 #include "Common/Logging.h"
+#include "FileSystem/Path.h"
 
 using rainbow::audio::OggVorbisAudioFile;
 
@@ -16,6 +21,68 @@ namespace
 {
     constexpr const char kIdOggVorbis[] = "OggS";
 
+    /// <summary>
+    ///   Number of bytes ahead of the read cursor to page in. Streams are
+    ///   read a few kilobytes at a time, so this covers many reads.
+    /// </summary>
+    constexpr size_t kReadAhead = 64 * 1024;
+
+    using Mapping = OggVorbisAudioFile::Mapping;
+
+    auto mapping_read(void* ptr, size_t size, size_t count, void* source)
+        -> size_t
+    {
+        auto mapping = static_cast<Mapping*>(source);
+        const DataMap& data = *mapping->data;
+        if (size == 0 || mapping->position >= data.size())
+            return 0;
+
+        count = std::min(count, (data.size() - mapping->position) / size);
+        const size_t length = size * count;
+        memcpy(ptr, data.data() + mapping->position, length);
+        mapping->position += length;
+
+        // Page in the next chunk before the cursor gets there.
+        if (mapping->position + kReadAhead / 2 > mapping->prefetched)
+        {
+            data.prefetch(mapping->position, kReadAhead);
+            mapping->prefetched = mapping->position + kReadAhead;
+        }
+
+        return count;
+    }
+
+    int mapping_seek(void* source, ogg_int64_t offset, int origin)
+    {
+        auto mapping = static_cast<Mapping*>(source);
+        const auto size = static_cast<ogg_int64_t>(mapping->data->size());
+        switch (origin)
+        {
+            case SEEK_SET:
+                break;
+            case SEEK_CUR:
+                offset += mapping->position;
+                break;
+            case SEEK_END:
+                offset += size;
+                break;
+            default:
+                return -1;
+        }
+
+        if (offset < 0 || offset > size)
+            return -1;
+
+        mapping->position = static_cast<size_t>(offset);
+        mapping->prefetched = 0;
+        return 0;
+    }
+
+    auto mapping_tell(void* source) -> long
+    {
+        return static_cast<Mapping*>(source)->position;
+    }
+
     void ov_log_error(int err)
     {
         const char* error = "Undocumented error.";
@@ -51,6 +118,46 @@ namespace
     }
 }
 
+auto OggVorbisAudioFile::map(const char* path)
+    -> std::shared_ptr<const DataMap>
+{
+    // Mappings are shared between streams so that the same file can be
+    // played several times at once without being mapped (or, on Windows,
+    // opened exclusively) more than once.
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::weak_ptr<const DataMap>>
+        mappings;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto i = mappings.find(path);
+    if (i != mappings.end())
+    {
+        auto data = i->second.lock();
+        if (data)
+            return data;
+    }
+
+    for (i = mappings.begin(); i != mappings.end();)
+    {
+        if (i->second.expired())
+            i = mappings.erase(i);
+        else
+            ++i;
+    }
+
+    auto data = std::make_shared<const DataMap>(
+        Path(path, Path::RelativeTo::CurrentPath));
+    if (!*data ||
+        !signature_matches(ArrayView<char>(
+            reinterpret_cast<const char*>(data->data()), data->size())))
+    {
+        return {};
+    }
+
+    mappings.emplace(path, data);
+    return data;
+}
+
 bool OggVorbisAudioFile::signature_matches(const ArrayView<char>& id)
 {
     const size_t size = array_size(kIdOggVorbis);
@@ -76,6 +183,29 @@ OggVorbisAudioFile::OggVorbisAudioFile(File&& f)
     }
 }
 
+OggVorbisAudioFile::OggVorbisAudioFile(std::shared_ptr<const DataMap> data)
+    : vi_(nullptr)
+{
+    mapping_.data = std::move(data);
+
+    const ov_callbacks callbacks{
+        &mapping_read, &mapping_seek, nullptr, &mapping_tell};
+    const int result =
+        ov_open_callbacks(&mapping_, &vf_, nullptr, 0, callbacks);
+    if (result < 0)
+    {
+        ov_log_error(result);
+        return;
+    }
+
+    vi_ = ov_info(&vf_, -1);
+    if (vi_ == nullptr)
+    {
+        ov_clear(&vf_);
+        LOGE("Vorbis: Failed to retrieve Ogg bitstream info.");
+    }
+}
+
 OggVorbisAudioFile::~OggVorbisAudioFile()
 {
     if (vi_ != nullptr)
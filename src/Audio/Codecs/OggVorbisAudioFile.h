@@ -5,6 +5,8 @@
 #ifndef AUDIO_CODECS_OGGVORBISAUDIOFILE_H_
 #define AUDIO_CODECS_OGGVORBISAUDIOFILE_H_
 
+#include <memory>
+
 #include "Platform/Macros.h"
 #ifdef RAINBOW_OS_MACOS
 #   pragma GCC diagnostic push
@@ -17,6 +19,7 @@
 #endif
 
 #include "Audio/AudioFile.h"
+#include "Common/DataMap.h"
 #include "Memory/Array.h"
 
 namespace rainbow { namespace audio
@@ -24,9 +27,31 @@ namespace rainbow { namespace audio
     class OggVorbisAudioFile final : public IAudioFile
     {
     public:
+        /// <summary>Read cursor into a memory-mapped file.</summary>
+        struct Mapping
+        {
+            std::shared_ptr<const DataMap> data;
+            size_t position = 0;
+            size_t prefetched = 0;  ///< End of range paged in so far.
+        };
+
+        /// <summary>
+        ///   Memory maps the Ogg file at <paramref name="path"/>. Streams
+        ///   opened on the same file share a single mapping.
+        /// </summary>
+        /// <returns>
+        ///   The mapped file; <c>nullptr</c> if it could not be mapped or is
+        ///   not an Ogg file.
+        /// </returns>
+        static auto map(const char* path) -> std::shared_ptr<const DataMap>;
+
         static bool signature_matches(const ArrayView<char>& signature);
 
         OggVorbisAudioFile(File&&);
+
+        /// <summary>Decodes straight from a memory-mapped file.</summary>
+        OggVorbisAudioFile(std::shared_ptr<const DataMap> data);
+
         ~OggVorbisAudioFile() override;
 
         // IAudioFile overrides.
@@ -45,6 +70,7 @@ namespace rainbow { namespace audio
 
     private:
         File file_;
+        Mapping mapping_;
         OggVorbis_File vf_;
         vorbis_info* vi_;
     };
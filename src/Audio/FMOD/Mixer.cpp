@@ -4,6 +4,9 @@
 
 #include "Audio/FMOD/Mixer.h"
 
+#include <algorithm>
+#include <chrono>
+
 #ifdef __GNUC__
 #   pragma GCC diagnostic push
 #   pragma GCC diagnostic ignored "-Wignored-qualifiers"
@@ -18,15 +21,21 @@
 #endif
 
 #include "Common/Logging.h"
+#include "Common/Profiler.h"
 
 using rainbow::audio::Channel;
 using rainbow::audio::FMODMixer;
+using rainbow::audio::MemoryUsage;
 using rainbow::audio::Sound;
+using rainbow::audio::Statistics;
 
 namespace
 {
     FMOD::Studio::System* fmod_studio = nullptr;
     FMOD::System* fmod_system = nullptr;
+    size_t memory_budget = 0;
+    std::chrono::nanoseconds process_time{0};
+    unsigned int updates = 0;
 
     bool is_fail(FMOD_RESULT result) { return result != FMOD_OK; }
 
@@ -36,7 +45,10 @@ namespace
     }
 
     template <typename F>
-    FMOD::Sound* create_sound(F&& create, const char* path)
+    FMOD::Sound* create_sound(F&& create,
+                              const char* path,
+                              FMOD_MODE mode,
+                              FMOD_CREATESOUNDEXINFO* exinfo = nullptr)
     {
 #ifdef RAINBOW_OS_ANDROID
         std::string uri("file:///android_asset/");
@@ -53,7 +65,7 @@ namespace
 #endif
 
         FMOD::Sound* sound;
-        auto result = create(asset, FMOD_DEFAULT, nullptr, &sound);
+        auto result = create(asset, mode, exinfo, &sound);
         if (is_fail(result))
         {
             log_error(result);
@@ -110,12 +122,18 @@ bool FMODMixer::initialize(int max_channels)
 
 void FMODMixer::process()
 {
+    R_PROFILE_ZONE("FMODMixer::process");
+
     ASSUME(fmod_studio != nullptr);
 
     if (fmod_studio == nullptr)
         return;
 
+    const auto start = std::chrono::steady_clock::now();
     fmod_studio->update();
+    process_time += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    ++updates;
 }
 
 void FMODMixer::suspend(bool should_suspend)
@@ -139,35 +157,52 @@ FMODMixer::~FMODMixer()
     fmod_studio = nullptr;
 }
 
-auto rainbow::audio::load_sound(const char* path) -> Sound*
+auto rainbow::audio::load_sound(const char* path, Decode decode) -> Sound*
 {
     ASSUME(fmod_system != nullptr);
 
     if (fmod_system == nullptr)
         return nullptr;
 
+    // FMOD cannot defer loading, but it can keep the sound compressed in
+    // memory and decode it while playing.
     auto sound = create_sound(
         [](auto&&... args) {
             return fmod_system->createSound(
                 std::forward<decltype(args)>(args)...);
         },
-        path);
+        path,
+        decode == Decode::OnFirstPlay ? FMOD_CREATECOMPRESSEDSAMPLE
+                                      : FMOD_DEFAULT);
     return to_opaque(sound);
 }
 
-auto rainbow::audio::load_stream(const char* path) -> Sound*
+auto rainbow::audio::load_stream(const char* path,
+                                 const StreamBuffering& buffering) -> Sound*
 {
     ASSUME(fmod_system != nullptr);
 
     if (fmod_system == nullptr)
         return nullptr;
 
+    // FMOD decodes each stream into a single buffer of its own, measured in
+    // PCM samples. Size it to hold as much as all of the requested buffers
+    // would, assuming 16-bit stereo. The file read buffer is shared by all
+    // streams and is left at its default.
+    const size_t kBytesPerSample = 4;
+    FMOD_CREATESOUNDEXINFO exinfo{};
+    exinfo.cbsize = sizeof(exinfo);
+    exinfo.decodebuffersize = static_cast<unsigned int>(
+        buffering.count * buffering.size / kBytesPerSample);
+
     auto sound = create_sound(
         [](auto&&... args) {
             return fmod_system->createStream(
                 std::forward<decltype(args)>(args)...);
         },
-        path);
+        path,
+        FMOD_DEFAULT,
+        &exinfo);
     return to_opaque(sound);
 }
 
@@ -176,6 +211,57 @@ void rainbow::audio::release(Sound* sound)
     from_opaque(sound)->release();
 }
 
+void rainbow::audio::set_priority(Sound* sound, int priority)
+{
+    // FMOD priorities go from 0, the most important, to 256. The default is
+    // 128, which maps to our 0.
+    auto fmod_sound = from_opaque(sound);
+    float frequency = 0.0f;
+    int fmod_priority = 0;
+    auto result = fmod_sound->getDefaults(&frequency, &fmod_priority);
+    if (is_fail(result))
+    {
+        log_error(result);
+        return;
+    }
+
+    fmod_priority = std::min(std::max(128 - priority, 0), 256);
+    result = fmod_sound->setDefaults(frequency, fmod_priority);
+    if (is_fail(result))
+        log_error(result);
+}
+
+auto rainbow::audio::memory_usage() -> MemoryUsage
+{
+    // FMOD does not track sounds separately; report all memory it uses.
+    int current = 0;
+    int peak = 0;
+    FMOD::Memory_GetStats(&current, &peak, false);
+
+    const double M = 1e-6;
+    return {current * M, peak * M, memory_budget * M, 0, 0};
+}
+
+void rainbow::audio::set_memory_budget(size_t bytes)
+{
+    // FMOD does not evict sounds; the budget is only reported.
+    memory_budget = bytes;
+}
+
+auto rainbow::audio::statistics() -> Statistics
+{
+    // FMOD decodes on its own threads, and does not expose decode time nor
+    // underruns.
+    int playing = 0;
+    fmod_system->getChannelsPlaying(&playing);
+    return {process_time.count() * 1e-9, updates, 0.0, 0, 0, playing};
+}
+
+auto rainbow::audio::underruns(Channel*) -> unsigned int
+{
+    return 0;
+}
+
 bool rainbow::audio::is_paused(Channel* channel)
 {
     bool paused{};
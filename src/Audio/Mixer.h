@@ -5,6 +5,9 @@
 #ifndef AUDIO_MIXER_H_
 #define AUDIO_MIXER_H_
 
+#include <cstddef>
+#include <cstdint>
+
 #include "Common/NonCopyable.h"
 #include "Math/Vec2.h"
 
@@ -13,6 +16,50 @@ namespace rainbow { namespace audio
     struct Channel;
     struct Sound;
 
+    /// <summary>Buffers used to stream a sound.</summary>
+    /// <remarks>
+    ///   More or larger buffers make streams more resilient to stalls, at
+    ///   the cost of memory. Not all backends use this.
+    /// </remarks>
+    struct StreamBuffering
+    {
+        int count = 4;        ///< Number of buffers queued at a time.
+        size_t size = 16384;  ///< Size of each buffer, in bytes.
+    };
+
+    /// <summary>When a static sound is decoded.</summary>
+    enum class Decode
+    {
+        OnLoad,       ///< Decode when loaded.
+        OnFirstPlay,  ///< Defer decoding until the sound is first played.
+    };
+
+    struct MemoryUsage
+    {
+        double used;              ///< Megabytes used by decoded sounds.
+        double peak;              ///< Peak megabytes used by decoded sounds.
+        double budget;            ///< Budget in megabytes; 0 if unlimited.
+        unsigned int evictions;   ///< Number of sounds evicted.
+        unsigned int reloads;     ///< Number of evicted sounds decoded again.
+    };
+
+    /// <summary>Mixer counters, accumulated since initialisation.</summary>
+    struct Statistics
+    {
+        double process_time;      ///< Seconds spent updating the mixer.
+        unsigned int updates;     ///< Number of times the mixer updated.
+        double decode_time;       ///< Seconds spent decoding.
+        uint64_t bytes_decoded;   ///< Bytes of samples decoded.
+        unsigned int underruns;   ///< Number of times output ran dry.
+        int active_voices;        ///< Number of sounds playing right now.
+
+        /// <summary>Returns decode throughput in bytes per second.</summary>
+        double decode_rate() const
+        {
+            return decode_time > 0.0 ? bytes_decoded / decode_time : 0.0;
+        }
+    };
+
     template <typename T>
     class TMixer : private T, private NonCopyable<TMixer<T>>
     {
@@ -31,10 +78,47 @@ namespace rainbow { namespace audio
 
     // Sound management
 
-    auto load_sound(const char* path) -> Sound*;
-    auto load_stream(const char* path) -> Sound*;
+    auto load_sound(const char* path, Decode decode = Decode::OnLoad)
+        -> Sound*;
+    auto load_stream(const char* path,
+                     const StreamBuffering& buffering = StreamBuffering{})
+        -> Sound*;
     void release(Sound* sound);
 
+    /// <summary>
+    ///   Sets how important <paramref name="sound"/> is. When all channels
+    ///   are busy, a new sound may only take over a channel playing a sound
+    ///   of equal or lower priority. Not all backends take over channels.
+    /// </summary>
+    /// <param name="priority">Higher is more important. Default: 0.</param>
+    void set_priority(Sound* sound, int priority);
+
+    // Memory management
+
+    /// <summary>Returns memory used by static sounds.</summary>
+    auto memory_usage() -> MemoryUsage;
+
+    /// <summary>
+    ///   Sets the memory budget for decoded static sounds. Once exceeded,
+    ///   sounds that are not playing are evicted, least recently played
+    ///   first, and decoded again the next time they are played. Not all
+    ///   backends evict sounds.
+    /// </summary>
+    /// <param name="bytes">Budget in bytes; 0 if unlimited.</param>
+    void set_memory_budget(size_t bytes);
+
+    // Instrumentation
+
+    /// <summary>Returns counters for profiling the mixer.</summary>
+    /// <remarks>Not all backends track all counters.</remarks>
+    auto statistics() -> Statistics;
+
+    /// <summary>
+    ///   Returns the number of times the sound playing on
+    ///   <paramref name="channel"/> ran dry since it started.
+    /// </summary>
+    auto underruns(Channel* channel) -> unsigned int;
+
     // Playback
 
     bool is_paused(Channel* channel);
@@ -58,6 +142,8 @@ namespace rainbow { namespace audio
 #   include "Audio/AL/Mixer.h"
 #elif defined(RAINBOW_AUDIO_FMOD)
 #   include "Audio/FMOD/Mixer.h"
+#elif defined(RAINBOW_AUDIO_SOFTWARE)
+#   include "Audio/Software/Mixer.h"
 #elif defined(RAINBOW_AUDIO_WWISE)
 #   include "Audio/Wwise/Mixer.h"
 #elif defined(RAINBOW_AUDIO_XAUDIO2)
@@ -0,0 +1,520 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include "Audio/Software/Mixer.h"
+
+#include <chrono>
+#include <cstdint>
+
+#include "Platform/Macros.h"
+#if defined(RAINBOW_OS_IOS) || defined(RAINBOW_OS_MACOS)
+#   include <OpenAL/al.h>
+#   include <OpenAL/alc.h>
+#else
+#   include <AL/al.h>
+#   include <AL/alc.h>
+#endif
+
+#include "Common/Logging.h"
+#include "Common/Profiler.h"
+
+using rainbow::audio::Channel;
+using rainbow::audio::MemoryUsage;
+using rainbow::audio::Sound;
+using rainbow::audio::SoftwareMixer;
+using rainbow::audio::Statistics;
+using rainbow::audio::VoiceMixer;
+
+namespace
+{
+    /// <summary>Number of voices that can play at once.</summary>
+    constexpr int kMaxVoices = 256;
+
+    constexpr int kOutputRate = 44100;
+
+    /// <summary>
+    ///   Frames mixed at a time. Together with the number of output buffers,
+    ///   this determines the latency.
+    /// </summary>
+    constexpr size_t kOutputFrames = 512;
+
+    /// <summary>How long the mixer thread sleeps between buffers.</summary>
+    constexpr std::chrono::milliseconds kPumpInterval{5};
+
+    SoftwareMixer* software_mixer = nullptr;
+
+    using Clock = std::chrono::steady_clock;
+
+    auto elapsed_since(Clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - start);
+    }
+
+    struct ALCContextDestroyer
+    {
+        void operator()(ALCcontext* ctx) const { alcDestroyContext(ctx); }
+    };
+
+    struct ALCDeviceCloser
+    {
+        void operator()(ALCdevice* device) const { alcCloseDevice(device); }
+    };
+
+    bool is_fail(ALenum result) { return result != AL_NO_ERROR; }
+
+    /// <summary>
+    ///   Returns the voice that <paramref name="channel"/> refers to, or
+    ///   <c>nullptr</c> if it has since been stolen or reused. Must be
+    ///   called while holding the mixer lock.
+    /// </summary>
+    /// <remarks>
+    ///   Channels are voice handles rather than pointers, so that stale
+    ///   channels cannot control a voice that is playing another sound.
+    /// </remarks>
+    VoiceMixer::Voice* from_opaque(Channel* channel)
+    {
+        const auto handle = static_cast<VoiceMixer::Handle>(
+            reinterpret_cast<uintptr_t>(channel));
+        return software_mixer->voices().voice_of(handle);
+    }
+
+    VoiceMixer::Source* from_opaque(Sound* sound)
+    {
+        return static_cast<VoiceMixer::Source*>(static_cast<void*>(sound));
+    }
+
+    Channel* to_opaque(VoiceMixer::Voice* voice)
+    {
+        const auto handle = software_mixer->voices().handle_of(voice);
+        return reinterpret_cast<Channel*>(static_cast<uintptr_t>(handle));
+    }
+
+    Sound* to_opaque(VoiceMixer::Source* source)
+    {
+        return static_cast<Sound*>(static_cast<void*>(source));
+    }
+
+    auto open(const char* path) -> std::unique_ptr<rainbow::audio::IAudioFile>
+    {
+        auto audio_file = rainbow::audio::IAudioFile::open(path);
+        if (!*audio_file)
+            return {};
+
+        if (audio_file->channels() > 2)
+        {
+            LOGE("Audio: Only mono and stereo sounds are supported: %s", path);
+            return {};
+        }
+
+        return audio_file;
+    }
+}
+
+bool SoftwareMixer::initialize(int max_channels)
+{
+    R_ASSERT(software_mixer == nullptr, "Audio is already initialised");
+
+    std::unique_ptr<ALCdevice, ALCDeviceCloser> device(alcOpenDevice(nullptr));
+    if (device == nullptr)
+    {
+        LOGE("OpenAL: Failed to open audio device (code: 0x%x)", alGetError());
+        return false;
+    }
+
+    std::unique_ptr<ALCcontext, ALCContextDestroyer> context(
+        alcCreateContext(device.get(), nullptr));
+    if (context == nullptr)
+    {
+        LOGE("OpenAL: Failed to create context (code: 0x%x)", alGetError());
+        return false;
+    }
+
+    alcMakeContextCurrent(context.get());
+
+    // OS X: Clear any errors from previous sessions.
+    alGetError();
+
+    alGenSources(1, &source_);
+    alGenBuffers(kOutputBuffers, buffers_);
+    auto result = alGetError();
+    if (is_fail(result))
+    {
+        LOGE("OpenAL: Failed to generate source (code: 0x%x)", result);
+        return false;
+    }
+
+    voices_ =
+        std::make_unique<VoiceMixer>(kMaxVoices, max_channels, kOutputRate);
+    output_.resize(kOutputFrames * VoiceMixer::kOutputChannels);
+
+    // Start with silence.
+    for (auto&& buffer : buffers_)
+    {
+        voices_->render(output_.data(), kOutputFrames);
+        alBufferData(buffer,
+                     AL_FORMAT_STEREO16,
+                     output_.data(),
+                     output_.size() * sizeof(int16_t),
+                     kOutputRate);
+    }
+    alSourceQueueBuffers(source_, kOutputBuffers, buffers_);
+    alSourcePlay(source_);
+
+    device.release();
+    context_ = context.release();
+    software_mixer = this;
+
+    running_ = true;
+    thread_ = std::thread([this] { run(); });
+
+    return true;
+}
+
+void SoftwareMixer::process()
+{
+    // Voices are mixed on the mixer thread.
+}
+
+void SoftwareMixer::suspend(bool should_suspend)
+{
+    if (context_ == nullptr)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    suspended_ = should_suspend;
+    if (should_suspend)
+    {
+        alSourcePause(source_);
+        alcSuspendContext(context_);
+        alcMakeContextCurrent(nullptr);
+    }
+    else
+    {
+        alcMakeContextCurrent(context_);
+        alcProcessContext(context_);
+        alSourcePlay(source_);
+    }
+}
+
+auto SoftwareMixer::create_sound(const char* path) -> VoiceMixer::Source*
+{
+    auto i = sounds_.find(path);
+    if (i == sounds_.end())
+    {
+        sounds_[path] = VoiceMixer::Source{};
+        i = sounds_.find(path);
+        i->second.key = i->first.c_str();
+    }
+    return &i->second;
+}
+
+bool SoftwareMixer::decode(VoiceMixer::Source* source)
+{
+    if (source->rate > 0)
+        return true;
+
+    auto audio_file = open(source->key);
+    if (!audio_file)
+        return false;
+
+    // Sounds are not played until decoded, so no voice can be reading it.
+    std::vector<int16_t>& samples = source->samples;
+    samples.resize(audio_file->size() / sizeof(int16_t));
+    const auto start = Clock::now();
+    const size_t size =
+        audio_file->read(samples.data(), samples.size() * sizeof(int16_t));
+    decode_time_ += elapsed_since(start);
+    bytes_decoded_ += size;
+    samples.resize(size / sizeof(int16_t));
+    samples.shrink_to_fit();
+    source->channels = audio_file->channels();
+    source->rate = audio_file->rate();
+
+    mem_used_ += samples.size() * sizeof(int16_t);
+    if (mem_used_ > mem_peak_)
+        mem_peak_ = mem_used_;
+
+    return true;
+}
+
+void SoftwareMixer::release(VoiceMixer::Source* source)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        voices_->release(source);
+    }
+
+    mem_used_ -= source->samples.size() * sizeof(int16_t);
+    sounds_.erase(source->key);
+}
+
+auto SoftwareMixer::memory_usage() const -> MemoryUsage
+{
+    const double M = 1e-6;
+    return {mem_used_ * M, mem_peak_ * M, budget_ * M, 0, 0};
+}
+
+auto SoftwareMixer::statistics() -> Statistics
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const double s = 1e-9;
+    return {process_time_.count() * s,
+            updates_,
+            (decode_time_ + voices_->decode_time()).count() * s,
+            bytes_decoded_ + voices_->bytes_decoded(),
+            underruns_,
+            voices_->audible_voices() + voices_->virtual_voices()};
+}
+
+void SoftwareMixer::run()
+{
+    while (running_.load(std::memory_order_acquire))
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!suspended_)
+                voices_->streams(streams_);
+        }
+
+        // Decode without holding the lock so that the game thread is never
+        // held up by it. Streams stay alive even if their voices stop.
+        for (auto&& stream : streams_)
+            voices_->decode(*stream);
+        streams_.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!suspended_)
+                pump();
+        }
+
+        std::this_thread::sleep_for(kPumpInterval);
+    }
+}
+
+void SoftwareMixer::pump()
+{
+    R_PROFILE_ZONE("SoftwareMixer::pump");
+
+    const auto start = Clock::now();
+
+    ALint processed{};
+    alGetSourcei(source_, AL_BUFFERS_PROCESSED, &processed);
+    for (; processed > 0; --processed)
+    {
+        ALuint buffer{};
+        alSourceUnqueueBuffers(source_, 1, &buffer);
+        voices_->render(output_.data(), kOutputFrames);
+        alBufferData(buffer,
+                     AL_FORMAT_STEREO16,
+                     output_.data(),
+                     output_.size() * sizeof(int16_t),
+                     kOutputRate);
+        alSourceQueueBuffers(source_, 1, &buffer);
+    }
+
+    // Restart if the source ran dry.
+    ALint state{};
+    alGetSourcei(source_, AL_SOURCE_STATE, &state);
+    if (state != AL_PLAYING)
+    {
+        if (state == AL_STOPPED)
+            ++underruns_;
+        alSourcePlay(source_);
+    }
+
+    process_time_ += elapsed_since(start);
+    ++updates_;
+}
+
+SoftwareMixer::~SoftwareMixer()
+{
+    if (thread_.joinable())
+    {
+        running_ = false;
+        thread_.join();
+    }
+
+    software_mixer = nullptr;
+
+    if (context_ == nullptr)
+        return;
+
+    alSourceStop(source_);
+    alSourcei(source_, AL_BUFFER, AL_NONE);
+    alDeleteSources(1, &source_);
+    alDeleteBuffers(kOutputBuffers, buffers_);
+
+    alcSuspendContext(context_);
+    alcMakeContextCurrent(nullptr);
+
+    std::unique_ptr<ALCdevice, ALCDeviceCloser> device(
+        alcGetContextsDevice(context_));
+    alcDestroyContext(context_);
+}
+
+auto rainbow::audio::load_sound(const char* path, Decode decode) -> Sound*
+{
+    auto source = software_mixer->create_sound(path);
+    if (source == nullptr)
+        return nullptr;
+
+    R_ASSERT(!source->is_stream(), "Sound already opened as a stream");
+
+    if (decode == Decode::OnLoad && !software_mixer->decode(source))
+    {
+        release(to_opaque(source));
+        return nullptr;
+    }
+
+    return to_opaque(source);
+}
+
+auto rainbow::audio::load_stream(const char* path, const StreamBuffering&)
+    -> Sound*
+{
+    // Streams are decoded in blocks by each voice; buffering does not apply.
+    auto source = software_mixer->create_sound(path);
+    if (source == nullptr || source->is_stream())
+        return to_opaque(source);
+
+    R_ASSERT(source->rate == 0, "Sound already opened as static");
+
+    auto audio_file = open(path);
+    if (!audio_file)
+    {
+        release(to_opaque(source));
+        return nullptr;
+    }
+
+    // The file is only opened to check it. Every voice that plays the
+    // stream opens its own.
+    source->channels = audio_file->channels();
+    source->rate = audio_file->rate();
+    source->stream = true;
+    return to_opaque(source);
+}
+
+void rainbow::audio::release(Sound* sound)
+{
+    software_mixer->release(from_opaque(sound));
+}
+
+void rainbow::audio::set_priority(Sound* sound, int priority)
+{
+    // Voices copy the priority when started, so that the mixer thread does
+    // not read it while it is being set.
+    from_opaque(sound)->priority = priority;
+}
+
+auto rainbow::audio::memory_usage() -> MemoryUsage
+{
+    return software_mixer->memory_usage();
+}
+
+void rainbow::audio::set_memory_budget(size_t bytes)
+{
+    // Sounds are not evicted; the budget is only reported.
+    software_mixer->set_memory_budget(bytes);
+}
+
+auto rainbow::audio::statistics() -> Statistics
+{
+    return software_mixer->statistics();
+}
+
+auto rainbow::audio::underruns(Channel*) -> unsigned int
+{
+    // Voices are mixed as a whole; only the output can run dry.
+    return 0;
+}
+
+bool rainbow::audio::is_paused(Channel* channel)
+{
+    std::lock_guard<std::mutex> lock(software_mixer->mutex());
+    auto voice = from_opaque(channel);
+    return voice != nullptr && software_mixer->voices().is_paused(voice);
+}
+
+bool rainbow::audio::is_playing(Channel* channel)
+{
+    std::lock_guard<std::mutex> lock(software_mixer->mutex());
+    auto voice = from_opaque(channel);
+    return voice != nullptr && software_mixer->voices().is_playing(voice);
+}
+
+void rainbow::audio::set_loop_count(Channel* channel, int count)
+{
+    std::lock_guard<std::mutex> lock(software_mixer->mutex());
+    auto voice = from_opaque(channel);
+    if (voice != nullptr)
+        software_mixer->voices().set_loop_count(voice, count);
+}
+
+void rainbow::audio::set_volume(Channel* channel, float volume)
+{
+    std::lock_guard<std::mutex> lock(software_mixer->mutex());
+    auto voice = from_opaque(channel);
+    if (voice != nullptr)
+        software_mixer->voices().set_volume(voice, volume);
+}
+
+void rainbow::audio::set_world_position(Channel* channel, const Vec2f& position)
+{
+    std::lock_guard<std::mutex> lock(software_mixer->mutex());
+    auto voice = from_opaque(channel);
+    if (voice != nullptr && software_mixer->voices().is_playing(voice))
+        software_mixer->voices().set_world_position(voice, position);
+}
+
+void rainbow::audio::pause(Channel* channel)
+{
+    std::lock_guard<std::mutex> lock(software_mixer->mutex());
+    auto voice = from_opaque(channel);
+    if (voice != nullptr && software_mixer->voices().is_playing(voice))
+        software_mixer->voices().set_paused(voice, true);
+}
+
+auto rainbow::audio::play(Channel* channel) -> Channel*
+{
+    std::lock_guard<std::mutex> lock(software_mixer->mutex());
+    auto voice = from_opaque(channel);
+    if (voice == nullptr || !software_mixer->voices().is_playing(voice))
+        return nullptr;
+
+    software_mixer->voices().set_paused(voice, false);
+    return channel;
+}
+
+auto rainbow::audio::play(Sound* sound, const Vec2f& position) -> Channel*
+{
+    auto source = from_opaque(sound);
+    std::unique_ptr<rainbow::audio::IAudioFile> file;
+    if (source->is_stream())
+    {
+        // Voices never share decoders. Open one before taking the lock.
+        file = open(source->key);
+        if (!file)
+            return nullptr;
+    }
+    else if (!software_mixer->decode(source))
+    {
+        // Sounds loaded lazily are decoded on first play.
+        LOGE("Audio: Failed to decode '%s'", source->key);
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(software_mixer->mutex());
+    return to_opaque(
+        software_mixer->voices().play(source, position, std::move(file)));
+}
+
+void rainbow::audio::stop(Channel* channel)
+{
+    std::lock_guard<std::mutex> lock(software_mixer->mutex());
+    auto voice = from_opaque(channel);
+    if (voice != nullptr)
+        software_mixer->voices().stop(voice);
+}
@@ -0,0 +1,103 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef AUDIO_SOFTWARE_MIXER_H_
+#define AUDIO_SOFTWARE_MIXER_H_
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Audio/Mixer.h"
+#include "Audio/Software/VoiceMixer.h"
+
+typedef struct ALCcontext_struct ALCcontext;
+
+namespace rainbow { namespace audio
+{
+    /// <summary>Software mixer.</summary>
+    /// <remarks>
+    ///   Sounds are mixed in software into a single stream, which a
+    ///   dedicated thread feeds to one OpenAL source. Far more sounds can
+    ///   play at once than there are hardware sources; only the loudest are
+    ///   mixed, see <see cref="VoiceMixer"/>.
+    /// </remarks>
+    class SoftwareMixer
+    {
+    public:
+        bool initialize(int max_channels);
+        void process();
+        void suspend(bool should_suspend);
+
+        auto create_sound(const char* path) -> VoiceMixer::Source*;
+
+        /// <summary>Decodes a static sound, if not already decoded.</summary>
+        bool decode(VoiceMixer::Source* source);
+
+        void release(VoiceMixer::Source* source);
+
+        auto memory_usage() const -> MemoryUsage;
+        void set_memory_budget(size_t bytes) { budget_ = bytes; }
+
+        auto statistics() -> Statistics;
+
+        /// <summary>
+        ///   Returns the lock that must be held while using
+        ///   <see cref="voices"/>.
+        /// </summary>
+        auto mutex() -> std::mutex& { return mutex_; }
+
+        auto voices() -> VoiceMixer& { return *voices_; }
+
+    protected:
+        ~SoftwareMixer();
+
+    private:
+        static constexpr int kOutputBuffers = 4;
+
+        std::unique_ptr<VoiceMixer> voices_;
+        std::unordered_map<std::string, VoiceMixer::Source> sounds_;
+        ALCcontext* context_ = nullptr;
+        unsigned int source_ = 0;
+        unsigned int buffers_[kOutputBuffers]{};
+        std::vector<int16_t> output_;  ///< Mixer thread only.
+
+        /// <summary>Streams to decode; mixer thread only.</summary>
+        std::vector<std::shared_ptr<VoiceMixer::Stream>> streams_;
+
+        std::mutex mutex_;  ///< Guards voices, and OpenAL after initialising.
+        std::thread thread_;
+        std::atomic<bool> running_{false};
+        bool suspended_ = false;
+
+        size_t mem_used_ = 0;
+        size_t mem_peak_ = 0;
+        size_t budget_ = 0;
+
+        // Instrumentation. Static sounds are decoded on the game thread;
+        // the rest is guarded by the mutex.
+        std::chrono::nanoseconds decode_time_{0};
+        uint64_t bytes_decoded_ = 0;
+        std::chrono::nanoseconds process_time_{0};
+        unsigned int updates_ = 0;
+        unsigned int underruns_ = 0;
+
+        /// <summary>Mixer thread entry point.</summary>
+        void run();
+
+        /// <summary>
+        ///   Mixes into the buffers that have been played, and queues them.
+        /// </summary>
+        void pump();
+    };
+
+    using Mixer = TMixer<SoftwareMixer>;
+}}  // namespace rainbow::audio
+
+#endif
@@ -0,0 +1,660 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include "Audio/Software/VoiceMixer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Common/Constants.h"
+#include "Common/Logging.h"
+#include "Common/Profiler.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define USE_SSE2 1
+#   include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#   define USE_NEON 1
+#   include <arm_neon.h>
+#endif
+
+using rainbow::audio::VoiceMixer;
+
+namespace
+{
+    constexpr uint64_t kUnity = uint64_t{1} << 32;
+    constexpr uint64_t kFractionMask = kUnity - 1;
+    constexpr float kFraction = 1.0f / kUnity;
+
+    /// <summary>Voices quieter than this (-60 dB) are virtualised.</summary>
+    constexpr float kInaudible = 1.0f / 1024;
+
+    /// <summary>
+    ///   Handles store the voice index, plus one, in the lower bits, and its
+    ///   generation in the upper bits.
+    /// </summary>
+    constexpr uint32_t kHandleIndexBits = 16;
+    constexpr uint32_t kHandleIndexMask = (1u << kHandleIndexBits) - 1;
+
+    /// <summary>Frames decoded at a time when streaming.</summary>
+    constexpr size_t kStreamBlockFrames = 4096;
+
+    /// <summary>Returns how loud <paramref name="voice"/> is.</summary>
+    float audibility(const VoiceMixer::Voice& voice)
+    {
+        if (voice.source->is_stream())
+            return std::numeric_limits<float>::max();
+
+        return voice.volume * std::max(voice.gain[0], voice.gain[1]);
+    }
+
+    /// <summary>
+    ///   Returns whether it is more important to mix <paramref name="a"/>
+    ///   than <paramref name="b"/>.
+    /// </summary>
+    bool is_more_important(const VoiceMixer::Voice& a,
+                           const VoiceMixer::Voice& b)
+    {
+        if (a.source->is_stream() != b.source->is_stream())
+            return a.source->is_stream();
+        if (a.priority != b.priority)
+            return a.priority > b.priority;
+
+        return audibility(a) > audibility(b);
+    }
+
+    /// <summary>Converts samples to floating point.</summary>
+    void convert(const int16_t* src, float* dst, size_t count)
+    {
+        size_t i = 0;
+#if defined(USE_SSE2)
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i s =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            // Sign-extend by unpacking into the upper halves, then shifting
+            // them down.
+            const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+            const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+            _mm_storeu_ps(dst + i, _mm_cvtepi32_ps(lo));
+            _mm_storeu_ps(dst + i + 4, _mm_cvtepi32_ps(hi));
+        }
+#elif defined(USE_NEON)
+        for (; i + 8 <= count; i += 8)
+        {
+            const int16x8_t s = vld1q_s16(src + i);
+            vst1q_f32(dst + i, vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))));
+            vst1q_f32(dst + i + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))));
+        }
+#endif
+        for (; i < count; ++i)
+            dst[i] = src[i];
+    }
+
+    /// <summary>Interpolates four samples at once.</summary>
+    void lerp4(const float* a, const float* b, const float* t, float* dst)
+    {
+#if defined(USE_SSE2)
+        const __m128 va = _mm_loadu_ps(a);
+        const __m128 vb = _mm_loadu_ps(b);
+        const __m128 vt = _mm_loadu_ps(t);
+        _mm_storeu_ps(dst, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), vt)));
+#elif defined(USE_NEON)
+        const float32x4_t va = vld1q_f32(a);
+        const float32x4_t vb = vld1q_f32(b);
+        vst1q_f32(dst, vmlaq_f32(va, vsubq_f32(vb, va), vld1q_f32(t)));
+#else
+        for (int i = 0; i < 4; ++i)
+            dst[i] = a[i] + (b[i] - a[i]) * t[i];
+#endif
+    }
+
+    /// <summary>
+    ///   Resamples <paramref name="count"/> frames from
+    ///   <paramref name="src"/> using linear interpolation. The last frame
+    ///   is held when interpolating past the end.
+    /// </summary>
+    void resample(const int16_t* src,
+                  size_t frames,
+                  int channels,
+                  uint64_t& position,
+                  uint64_t step,
+                  float* dst,
+                  size_t count)
+    {
+        if (step == kUnity && (position & kFractionMask) == 0)
+        {
+            convert(src + (position >> 32) * channels, dst, count * channels);
+            position += step * count;
+            return;
+        }
+
+        const size_t last = frames - 1;
+        const size_t frames_per_lerp = 4 / channels;
+        size_t i = 0;
+        for (; i + frames_per_lerp <= count; i += frames_per_lerp)
+        {
+            float a[4];
+            float b[4];
+            float t[4];
+            for (int k = 0; k < 4; ++k)
+            {
+                const uint64_t p = position + step * (k / channels);
+                const size_t index = static_cast<size_t>(p >> 32);
+                const size_t next = std::min(index + 1, last);
+                const int c = k % channels;
+                a[k] = src[index * channels + c];
+                b[k] = src[next * channels + c];
+                t[k] = (p & kFractionMask) * kFraction;
+            }
+            lerp4(a, b, t, dst + i * channels);
+            position += step * frames_per_lerp;
+        }
+
+        for (; i < count; ++i)
+        {
+            const size_t index = static_cast<size_t>(position >> 32);
+            const size_t next = std::min(index + 1, last);
+            const float t = (position & kFractionMask) * kFraction;
+            for (int c = 0; c < channels; ++c)
+            {
+                const float a = src[index * channels + c];
+                const float b = src[next * channels + c];
+                dst[i * channels + c] = a + (b - a) * t;
+            }
+            position += step;
+        }
+    }
+
+    /// <summary>
+    ///   Adds <paramref name="frames"/> frames of <paramref name="src"/> to
+    ///   the stereo <paramref name="bus"/>.
+    /// </summary>
+    void accumulate(float* bus,
+                    const float* src,
+                    size_t frames,
+                    int channels,
+                    float gain_l,
+                    float gain_r)
+    {
+        size_t i = 0;
+        if (channels == 1)
+        {
+#if defined(USE_SSE2)
+            const __m128 gain = _mm_setr_ps(gain_l, gain_r, gain_l, gain_r);
+            for (; i + 4 <= frames; i += 4)
+            {
+                const __m128 s = _mm_loadu_ps(src + i);
+                const __m128 lo = _mm_mul_ps(_mm_unpacklo_ps(s, s), gain);
+                const __m128 hi = _mm_mul_ps(_mm_unpackhi_ps(s, s), gain);
+                float* out = bus + i * 2;
+                _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), lo));
+                _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), hi));
+            }
+#elif defined(USE_NEON)
+            const float32x4_t gain{gain_l, gain_r, gain_l, gain_r};
+            for (; i + 4 <= frames; i += 4)
+            {
+                const float32x4_t s = vld1q_f32(src + i);
+                const float32x4x2_t lr = vzipq_f32(s, s);
+                float* out = bus + i * 2;
+                vst1q_f32(out, vmlaq_f32(vld1q_f32(out), lr.val[0], gain));
+                vst1q_f32(
+                    out + 4, vmlaq_f32(vld1q_f32(out + 4), lr.val[1], gain));
+            }
+#endif
+            for (; i < frames; ++i)
+            {
+                bus[i * 2] += src[i] * gain_l;
+                bus[i * 2 + 1] += src[i] * gain_r;
+            }
+        }
+        else
+        {
+            const size_t count = frames * 2;
+#if defined(USE_SSE2)
+            const __m128 gain = _mm_setr_ps(gain_l, gain_r, gain_l, gain_r);
+            for (; i + 4 <= count; i += 4)
+            {
+                _mm_storeu_ps(
+                    bus + i,
+                    _mm_add_ps(_mm_loadu_ps(bus + i),
+                               _mm_mul_ps(_mm_loadu_ps(src + i), gain)));
+            }
+#elif defined(USE_NEON)
+            const float32x4_t gain{gain_l, gain_r, gain_l, gain_r};
+            for (; i + 4 <= count; i += 4)
+            {
+                const float32x4_t s = vld1q_f32(src + i);
+                vst1q_f32(bus + i, vmlaq_f32(vld1q_f32(bus + i), s, gain));
+            }
+#endif
+            for (; i < count; i += 2)
+            {
+                bus[i] += src[i] * gain_l;
+                bus[i + 1] += src[i + 1] * gain_r;
+            }
+        }
+    }
+
+    /// <summary>Converts samples to 16-bit, with saturation.</summary>
+    void to_int16(const float* src, int16_t* dst, size_t count)
+    {
+        size_t i = 0;
+#if defined(USE_SSE2)
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i lo = _mm_cvtps_epi32(_mm_loadu_ps(src + i));
+            const __m128i hi = _mm_cvtps_epi32(_mm_loadu_ps(src + i + 4));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                             _mm_packs_epi32(lo, hi));
+        }
+#elif defined(USE_NEON)
+        for (; i + 8 <= count; i += 8)
+        {
+            const int16x4_t lo = vqmovn_s32(vcvtq_s32_f32(vld1q_f32(src + i)));
+            const int16x4_t hi =
+                vqmovn_s32(vcvtq_s32_f32(vld1q_f32(src + i + 4)));
+            vst1q_s16(dst + i, vcombine_s16(lo, hi));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            const long sample = std::lrint(src[i]);
+            dst[i] = static_cast<int16_t>(
+                std::min(std::max(sample, -32768L), 32767L));
+        }
+    }
+}
+
+VoiceMixer::Stream::Stream(std::unique_ptr<IAudioFile> file)
+    : file(std::move(file))
+{
+    // The stream is not shared yet, so the decoder's end can be filled here.
+    for (size_t i = 0; i < kBlocks; ++i)
+        spare.try_push({});
+}
+
+VoiceMixer::VoiceMixer(int max_voices, int max_audible, int rate)
+    : voices_(max_voices), max_audible_(max_audible), rate_(rate)
+{
+    R_ASSERT(static_cast<uint32_t>(max_voices) < kHandleIndexMask,
+             "Too many voices to fit in a handle");
+
+    active_.reserve(max_voices);
+    free_.reserve(max_voices);
+    for (auto i = voices_.rbegin(); i != voices_.rend(); ++i)
+        free_.push_back(&*i);
+}
+
+auto VoiceMixer::handle_of(const Voice* voice) const -> Handle
+{
+    if (voice == nullptr)
+        return 0;
+
+    const auto index = static_cast<Handle>(voice - voices_.data()) + 1;
+    return (static_cast<Handle>(voice->generation) << kHandleIndexBits) |
+           index;
+}
+
+auto VoiceMixer::voice_of(Handle handle) -> Voice*
+{
+    const Handle index = handle & kHandleIndexMask;
+    if (index == 0 || index > voices_.size())
+        return nullptr;
+
+    Voice& voice = voices_[index - 1];
+    return voice.generation == (handle >> kHandleIndexBits) ? &voice
+                                                             : nullptr;
+}
+
+void VoiceMixer::set_loop_count(Voice* voice, int count)
+{
+    voice->loop_count = count;
+}
+
+void VoiceMixer::set_paused(Voice* voice, bool paused)
+{
+    voice->paused = paused;
+}
+
+void VoiceMixer::set_volume(Voice* voice, float volume)
+{
+    voice->volume = volume;
+}
+
+void VoiceMixer::set_world_position(Voice* voice, const Vec2f& position)
+{
+    // Like OpenAL, only mono sources are positioned.
+    if (voice->source->channels != 1)
+    {
+        voice->gain[0] = 1.0f;
+        voice->gain[1] = 1.0f;
+        return;
+    }
+
+    // Attenuate by inverse distance from the listener at origin, clamped at
+    // reference distance 1, which is OpenAL's default distance model. Pan
+    // with constant power.
+    const float distance = std::hypot(position.x, position.y);
+    const float attenuation = distance > 1.0f ? 1.0f / distance : 1.0f;
+    const float pan = distance > 0.0f ? position.x / distance : 0.0f;
+    const float angle = (pan + 1.0f) * static_cast<float>(kPi_2) * 0.5f;
+    voice->gain[0] = std::cos(angle) * attenuation;
+    voice->gain[1] = std::sin(angle) * attenuation;
+}
+
+void VoiceMixer::decode(Stream& stream)
+{
+    if (stream.ended.load(std::memory_order_acquire))
+        return;
+
+    const int channels = stream.file->channels();
+    const size_t frame_size = channels * sizeof(int16_t);
+    const size_t block_size = kStreamBlockFrames * frame_size;
+
+    Stream::Block block;
+    while (stream.spare.try_pop(block))
+    {
+        block.samples.resize(kStreamBlockFrames * channels);
+        block.rewound = false;
+        size_t frames =
+            read(*stream.file, block.samples.data(), block_size) / frame_size;
+        if (frames == 0)
+        {
+            // Whether the voice loops may change until the mixer gets here,
+            // so always start over. The mixer drops the block if it ends.
+            stream.file->rewind();
+            block.rewound = true;
+            frames = read(*stream.file, block.samples.data(), block_size) /
+                     frame_size;
+            if (frames == 0)
+            {
+                stream.ended.store(true, std::memory_order_release);
+                return;
+            }
+        }
+
+        block.samples.resize(frames * channels);
+        stream.decoded.try_push(std::move(block));
+    }
+}
+
+auto VoiceMixer::play(const Source* source,
+                      const Vec2f& position,
+                      std::unique_ptr<IAudioFile> file) -> Voice*
+{
+    R_ASSERT(source->channels == 1 || source->channels == 2,
+             "Only mono and stereo sources are supported");
+    R_ASSERT(source->is_stream() == (file != nullptr),
+             "Streams, and only streams, must be played with a decoder");
+
+    Voice* voice = nullptr;
+    if (!free_.empty())
+    {
+        voice = free_.back();
+        free_.pop_back();
+    }
+    else
+    {
+        // Steal the least important voice, or the oldest if equally
+        // important. Voices of higher priority are left alone.
+        for (Voice& v : voices_)
+        {
+            if (v.source->is_stream() || v.priority > source->priority)
+                continue;
+
+            if (voice == nullptr || is_more_important(*voice, v) ||
+                (!is_more_important(v, *voice) && v.started < voice->started))
+            {
+                voice = &v;
+            }
+        }
+
+        if (voice == nullptr)
+            return nullptr;
+
+        ++steals_;
+    }
+
+    voice->source = source;
+    voice->position = 0;
+    voice->step = (static_cast<uint64_t>(source->rate) << 32) / rate_;
+    voice->volume = 1.0f;
+    voice->loop_count = 0;
+    voice->priority = source->priority;
+    voice->started = ++clock_;
+    ++voice->generation;
+    voice->paused = false;
+    if (source->is_stream())
+    {
+        // Nothing is played until the first block has been decoded.
+        voice->stream = std::make_shared<Stream>(std::move(file));
+        voice->data = nullptr;
+        voice->frames = 0;
+    }
+    else
+    {
+        voice->stream.reset();
+        voice->data = source->samples.data();
+        voice->frames = source->samples.size() / source->channels;
+    }
+    set_world_position(voice, position);
+    return voice;
+}
+
+void VoiceMixer::release(const Source* source)
+{
+    for (Voice& voice : voices_)
+    {
+        if (voice.source == source)
+            stop(&voice);
+    }
+}
+
+void VoiceMixer::render(int16_t* out, size_t frames)
+{
+    R_PROFILE_ZONE("VoiceMixer::render");
+
+    const size_t samples = frames * kOutputChannels;
+    bus_.assign(samples, 0.0f);
+    if (scratch_.size() < samples)
+        scratch_.resize(samples);
+
+    active_.clear();
+    for (Voice& voice : voices_)
+    {
+        if (voice.source != nullptr && !voice.paused)
+            active_.push_back(&voice);
+    }
+
+    // Move the voices that are most important to mix to the front.
+    const size_t max_audible =
+        std::min(active_.size(), static_cast<size_t>(max_audible_));
+    if (active_.size() > max_audible)
+    {
+        std::nth_element(active_.begin(),
+                         active_.begin() + max_audible,
+                         active_.end(),
+                         [](const Voice* a, const Voice* b) {
+                             return is_more_important(*a, *b);
+                         });
+    }
+
+    audible_ = 0;
+    virtual_ = 0;
+    for (size_t i = 0; i < active_.size(); ++i)
+    {
+        Voice& voice = *active_[i];
+        bool playing;
+        if (i < max_audible && audibility(voice) >= kInaudible)
+        {
+            playing = mix(voice, frames);
+            ++audible_;
+        }
+        else
+        {
+            playing = advance(voice, frames);
+            ++virtual_;
+        }
+
+        if (!playing)
+            stop(&voice);
+    }
+
+    to_int16(bus_.data(), out, samples);
+}
+
+void VoiceMixer::stop(Voice* voice)
+{
+    if (voice->source == nullptr)
+        return;
+
+    voice->source = nullptr;
+    voice->stream.reset();
+    voice->data = nullptr;
+    voice->frames = 0;
+    free_.push_back(voice);
+}
+
+void VoiceMixer::streams(std::vector<std::shared_ptr<Stream>>& streams) const
+{
+    for (const Voice& voice : voices_)
+    {
+        if (voice.stream)
+            streams.push_back(voice.stream);
+    }
+}
+
+bool VoiceMixer::advance(Voice& voice, size_t frames)
+{
+    voice.position += voice.step * frames;
+    return seek(voice);
+}
+
+bool VoiceMixer::mix(Voice& voice, size_t frames)
+{
+    const int channels = voice.source->channels;
+    const float gain_l = voice.volume * voice.gain[0];
+    const float gain_r = voice.volume * voice.gain[1];
+    float* bus = bus_.data();
+    while (frames > 0)
+    {
+        if (!seek(voice))
+            return false;
+
+        // A stream that has fallen behind is silent until it catches up.
+        if (voice.frames == 0)
+            return true;
+
+        // Mix up to the end of the current block.
+        const uint64_t end = static_cast<uint64_t>(voice.frames) << 32;
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(
+            frames, (end - voice.position + voice.step - 1) / voice.step));
+        resample(voice.data,
+                 voice.frames,
+                 channels,
+                 voice.position,
+                 voice.step,
+                 scratch_.data(),
+                 count);
+        accumulate(bus, scratch_.data(), count, channels, gain_l, gain_r);
+        bus += count * kOutputChannels;
+        frames -= count;
+    }
+
+    // End the voice as soon as it has played its last frame.
+    return seek(voice);
+}
+
+bool VoiceMixer::seek(Voice& voice)
+{
+    // A block may be shorter than how far past the end the voice is.
+    while ((voice.position >> 32) >= voice.frames)
+    {
+        if (!next_block(voice))
+            return false;
+        if (voice.frames == 0)
+            break;
+    }
+    return true;
+}
+
+bool VoiceMixer::next_block(Voice& voice)
+{
+    const Source* source = voice.source;
+    if (!source->is_stream())
+    {
+        if (voice.loop_count == 0 || voice.frames == 0)
+            return false;
+
+        // A sound shorter than the frames mixed at once, or than one step,
+        // may have been passed over several times.
+        const uint64_t length = static_cast<uint64_t>(voice.frames) << 32;
+        const uint64_t loops = voice.position / length;
+        if (voice.loop_count > 0)
+        {
+            if (loops > static_cast<uint64_t>(voice.loop_count))
+                return false;
+            voice.loop_count -= static_cast<int>(loops);
+        }
+
+        voice.position %= length;
+        return true;
+    }
+
+    // Carry over how far past the end of the block the voice is.
+    const uint64_t overshoot =
+        voice.position - (static_cast<uint64_t>(voice.frames) << 32);
+
+    // Hand the block that has been played back to the decoder.
+    Stream& stream = *voice.stream;
+    if (voice.data != nullptr)
+    {
+        stream.spare.try_push({std::move(voice.block), false});
+        voice.data = nullptr;
+        voice.frames = 0;
+    }
+
+    Stream::Block block;
+    if (!stream.decoded.try_pop(block))
+    {
+        // The decoder may have pushed its last block before ending.
+        if (!stream.ended.load(std::memory_order_acquire))
+        {
+            voice.position = 0;
+            return true;
+        }
+        if (!stream.decoded.try_pop(block))
+            return false;
+    }
+
+    if (block.rewound)
+    {
+        if (voice.loop_count == 0)
+            return false;
+        if (voice.loop_count > 0)
+            --voice.loop_count;
+    }
+
+    const int channels = source->channels;
+    voice.block = std::move(block.samples);
+    voice.data = voice.block.data();
+    voice.frames = voice.block.size() / channels;
+    voice.position = overshoot;
+    return true;
+}
+
+auto VoiceMixer::read(IAudioFile& file, void* dst, size_t size) -> size_t
+{
+    const auto start = std::chrono::steady_clock::now();
+    const size_t length = file.read(dst, size);
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    decode_time_.fetch_add(elapsed.count(), std::memory_order_relaxed);
+    bytes_decoded_.fetch_add(length, std::memory_order_relaxed);
+    return length;
+}
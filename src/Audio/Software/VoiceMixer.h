@@ -0,0 +1,269 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef AUDIO_SOFTWARE_VOICEMIXER_H_
+#define AUDIO_SOFTWARE_VOICEMIXER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Audio/AudioFile.h"
+#include "Common/NonCopyable.h"
+#include "Math/Vec2.h"
+#include "Threading/SpscQueue.h"
+
+namespace rainbow { namespace audio
+{
+    /// <summary>
+    ///   Mixes any number of voices into a single 16-bit stereo stream.
+    /// </summary>
+    /// <remarks>
+    ///   Only the most important voices are mixed, by priority and then by
+    ///   loudness. The rest are virtualised: their playback position
+    ///   advances, but they cost next to nothing until they become audible
+    ///   again. When all voices are busy, the least important voice of equal
+    ///   or lower priority is stolen. Streams are never virtualised nor
+    ///   stolen.
+    ///
+    ///   The mixer is not thread-safe, and does not open any audio device.
+    ///   The exception is <see cref="decode"/>, which decodes streams ahead
+    ///   of <see cref="render"/> and may run without holding the lock that
+    ///   guards the rest.
+    /// </remarks>
+    class VoiceMixer : private NonCopyable<VoiceMixer>
+    {
+    public:
+        /// <summary>Sample data played by voices.</summary>
+        struct Source
+        {
+            std::vector<int16_t> samples;  ///< Interleaved; static only.
+            int channels = 0;
+            int rate = 0;                  ///< 0 until decoded.
+            const char* key = nullptr;     ///< Name given by the owner.
+            int priority = 0;              ///< Higher is more important.
+            bool stream = false;           ///< Decoded by each voice.
+
+            bool is_stream() const { return stream; }
+        };
+
+        /// <summary>Decoder of a voice that plays a stream.</summary>
+        /// <remarks>
+        ///   Blocks go around between the decoder, which fills spare blocks,
+        ///   and the mixer, which plays decoded blocks and hands them back.
+        ///   Both ends are lock-free; the decoder may run on another thread.
+        /// </remarks>
+        struct Stream
+        {
+            struct Block
+            {
+                std::vector<int16_t> samples;
+                bool rewound = false;  ///< Starts over from the beginning.
+            };
+
+            /// <summary>Number of blocks decoded ahead, at most.</summary>
+            static constexpr size_t kBlocks = 3;
+
+            explicit Stream(std::unique_ptr<IAudioFile> file);
+
+            std::unique_ptr<IAudioFile> file;  ///< Owned by the decoder.
+            SpscQueue<Block, 4> decoded;       ///< Decoder to mixer.
+            SpscQueue<Block, 4> spare;         ///< Mixer to decoder.
+            std::atomic<bool> ended{false};    ///< No more can be decoded.
+        };
+
+        struct Voice
+        {
+            const Source* source = nullptr;   ///< <c>nullptr</c> if free.
+            const int16_t* data = nullptr;    ///< Current block of samples.
+            size_t frames = 0;                ///< Frames in current block.
+            uint64_t position = 0;            ///< 32.32 fixed-point frame.
+            uint64_t step = 0;                ///< Frames per output frame.
+            std::shared_ptr<Stream> stream;   ///< Set if streaming.
+            std::vector<int16_t> block;       ///< Stream block being played.
+            float volume = 1.0f;
+            float gain[2]{};                  ///< Panning and attenuation.
+            int loop_count = 0;               ///< Loops left; -1 is forever.
+            int priority = 0;                 ///< Source priority at play.
+            uint64_t started = 0;             ///< Order in which voices start.
+            uint16_t generation = 0;          ///< Bumped on every play.
+            bool paused = false;
+        };
+
+        /// <summary>
+        ///   Refers to a voice for as long as it plays the same sound. Once
+        ///   the voice is stolen or reused, its old handles are rejected.
+        ///   0 is never a valid handle.
+        /// </summary>
+        using Handle = uint32_t;
+
+        static constexpr int kOutputChannels = 2;
+
+        /// <param name="max_voices">Number of voices that can play.</param>
+        /// <param name="max_audible">Number of voices that are mixed.</param>
+        /// <param name="rate">Output sample rate.</param>
+        VoiceMixer(int max_voices, int max_audible, int rate);
+
+        /// <summary>
+        ///   Returns the number of voices mixed in last render.
+        /// </summary>
+        auto audible_voices() const { return audible_; }
+
+        /// <summary>Returns bytes of streams decoded so far.</summary>
+        auto bytes_decoded() const
+        {
+            return bytes_decoded_.load(std::memory_order_relaxed);
+        }
+
+        /// <summary>Returns time spent decoding streams so far.</summary>
+        auto decode_time() const
+        {
+            return std::chrono::nanoseconds(
+                decode_time_.load(std::memory_order_relaxed));
+        }
+
+        /// <summary>Returns a handle to <paramref name="voice"/>.</summary>
+        auto handle_of(const Voice* voice) const -> Handle;
+
+        auto max_voices() const { return static_cast<int>(voices_.size()); }
+        auto rate() const { return rate_; }
+
+        /// <summary>Returns the number of voices stolen so far.</summary>
+        auto steals() const { return steals_; }
+
+        /// <summary>
+        ///   Returns the number of voices virtualised in last render.
+        /// </summary>
+        auto virtual_voices() const { return virtual_; }
+
+        /// <summary>
+        ///   Returns the voice referred to by <paramref name="handle"/>.
+        /// </summary>
+        /// <returns>
+        ///   <c>nullptr</c> if the voice has since been stolen or reused.
+        /// </returns>
+        auto voice_of(Handle handle) -> Voice*;
+
+        bool is_paused(const Voice* voice) const
+        {
+            return voice->source != nullptr && voice->paused;
+        }
+
+        bool is_playing(const Voice* voice) const
+        {
+            return voice->source != nullptr;
+        }
+
+        void set_loop_count(Voice* voice, int count);
+        void set_paused(Voice* voice, bool paused);
+        void set_volume(Voice* voice, float volume);
+        void set_world_position(Voice* voice, const Vec2f& position);
+
+        /// <summary>
+        ///   Decodes blocks of <paramref name="stream"/> until it is as far
+        ///   ahead as it can be. Does not touch the rest of the mixer, so it
+        ///   may be called without holding its lock. Only one thread may
+        ///   decode a stream at a time.
+        /// </summary>
+        void decode(Stream& stream);
+
+        /// <summary>
+        ///   Starts playing <paramref name="source"/> from the beginning. If
+        ///   no voices are free, the voice with the lowest priority, then the
+        ///   least audible, then the oldest, is stolen.
+        /// </summary>
+        /// <returns>
+        ///   The voice playing the source; <c>nullptr</c> if all voices are
+        ///   streaming or playing sources of higher priority.
+        /// </returns>
+        /// <param name="source">Sound to play.</param>
+        /// <param name="position">World position to play it at.</param>
+        /// <param name="file">
+        ///   The voice's own decoder, if <paramref name="source"/> is a
+        ///   stream. Voices never share decoders.
+        /// </param>
+        auto play(const Source* source,
+                  const Vec2f& position,
+                  std::unique_ptr<IAudioFile> file = nullptr) -> Voice*;
+
+        /// <summary>
+        ///   Stops all voices playing <paramref name="source"/>.
+        /// </summary>
+        void release(const Source* source);
+
+        /// <summary>
+        ///   Mixes the next <paramref name="frames"/> frames into
+        ///   <paramref name="out"/>, which must fit interleaved stereo.
+        /// </summary>
+        /// <remarks>
+        ///   Streams that have not been decoded far enough are silent until
+        ///   they have; see <see cref="decode"/>.
+        /// </remarks>
+        void render(int16_t* out, size_t frames);
+
+        void stop(Voice* voice);
+
+        /// <summary>
+        ///   Stores the streams that are playing in <paramref name="streams"/>,
+        ///   so that they can be decoded without holding the mixer's lock.
+        /// </summary>
+        void streams(std::vector<std::shared_ptr<Stream>>& streams) const;
+
+    private:
+        std::vector<Voice> voices_;
+        std::vector<Voice*> active_;  ///< Playing voices in last render.
+        std::vector<Voice*> free_;
+        std::vector<float> bus_;      ///< Mixed output.
+        std::vector<float> scratch_;  ///< Resampled voice.
+        const int max_audible_;
+        const int rate_;
+        uint64_t clock_ = 0;
+        int audible_ = 0;
+        int virtual_ = 0;
+        unsigned int steals_ = 0;
+
+        // Updated by decode(), which may run without holding the lock.
+        std::atomic<uint64_t> bytes_decoded_{0};
+        std::atomic<int64_t> decode_time_{0};  ///< In nanoseconds.
+
+        /// <summary>
+        ///   Advances <paramref name="voice"/> without mixing it.
+        /// </summary>
+        /// <returns><c>false</c> if the voice has ended.</returns>
+        bool advance(Voice& voice, size_t frames);
+
+        /// <summary>
+        ///   Mixes <paramref name="voice"/> into the bus.
+        /// </summary>
+        /// <returns><c>false</c> if the voice has ended.</returns>
+        bool mix(Voice& voice, size_t frames);
+
+        /// <summary>
+        ///   Moves <paramref name="voice"/> to its next block of samples,
+        ///   looping if needed.
+        /// </summary>
+        /// <returns>
+        ///   <c>false</c> if there are no more samples. A stream that has not
+        ///   been decoded far enough is left with no samples.
+        /// </returns>
+        bool next_block(Voice& voice);
+
+        /// <summary>
+        ///   Moves <paramref name="voice"/> to the block containing its
+        ///   position.
+        /// </summary>
+        /// <returns><c>false</c> if the voice has ended.</returns>
+        bool seek(Voice& voice);
+
+        /// <summary>
+        ///   Reads up to <paramref name="size"/> bytes of samples from
+        ///   <paramref name="file"/>, counting the time it takes.
+        /// </summary>
+        auto read(IAudioFile& file, void* dst, size_t size) -> size_t;
+    };
+}}  // namespace rainbow::audio
+
+#endif
@@ -41,6 +41,16 @@ namespace rainbow
         /// <summary>Offsets data map's start address.</summary>
         void offset(size_t offset) { return T::offset(offset); }
 
+        /// <summary>
+        ///   Hints that <paramref name="size"/> bytes at
+        ///   <paramref name="offset"/> will be read soon, so that they can be
+        ///   paged in ahead of time.
+        /// </summary>
+        void prefetch(size_t offset, size_t size) const
+        {
+            T::prefetch(offset, size);
+        }
+
         /// <summary>Returns offset buffer size.</summary>
         size_t size() const { return T::size(); }
 
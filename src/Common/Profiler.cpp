@@ -0,0 +1,188 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include "Common/Profiler.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <unordered_set>
+
+#include "FileSystem/File.h"
+
+using rainbow::profiler::Zone;
+using rainbow::profiler::ZoneBuffer;
+
+namespace
+{
+    constexpr size_t kBufferCapacity = 1 << 14;
+    constexpr size_t kHistorySize = 1 << 16;
+
+    std::mutex g_mutex;  // Guards thread registration and interned names.
+    std::vector<std::unique_ptr<ZoneBuffer>> g_buffers;
+    std::unordered_set<std::string> g_names;
+
+    // Only touched by the main thread.
+    std::vector<Zone> g_frame;
+    std::deque<Zone> g_history;
+
+    thread_local ZoneBuffer* t_buffer = nullptr;
+    thread_local uint32_t t_depth = 0;
+
+    const auto g_epoch = std::chrono::steady_clock::now();
+
+    auto buffer() -> ZoneBuffer&
+    {
+        if (t_buffer == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            g_buffers.emplace_back(std::make_unique<ZoneBuffer>(
+                static_cast<uint32_t>(g_buffers.size()), kBufferCapacity));
+            t_buffer = g_buffers.back().get();
+        }
+        return *t_buffer;
+    }
+
+    void append_escaped(std::string& out, const char* str)
+    {
+        for (; *str != '\0'; ++str)
+        {
+            switch (*str)
+            {
+                case '"':
+                    out += "\\\"";
+                    break;
+                case '\\':
+                    out += "\\\\";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(*str) < 0x20)
+                        out += ' ';
+                    else
+                        out += *str;
+                    break;
+            }
+        }
+    }
+
+    template <typename F>
+    void drain_all(F&& f)
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        for (auto&& buffer : g_buffers)
+            buffer->drain(f);
+    }
+}
+
+namespace rainbow { namespace profiler { namespace detail
+{
+    std::atomic<bool> g_enabled{false};
+
+    auto begin_zone() -> uint64_t
+    {
+        ++t_depth;
+        return now();
+    }
+
+    void end_zone(const char* name, uint64_t begin)
+    {
+        const uint64_t end = now();
+        auto& b = buffer();
+        b.push({name, begin, end, b.thread(), --t_depth});
+    }
+}}}  // namespace rainbow::profiler::detail
+
+ZoneBuffer::ZoneBuffer(uint32_t thread, size_t capacity)
+    : zones_(std::make_unique<Zone[]>(capacity)), capacity_(capacity),
+      thread_(thread), head_(0), tail_(0), dropped_(0)
+{
+}
+
+void rainbow::profiler::end_frame()
+{
+    g_frame.clear();
+    drain_all([](const Zone& zone) { g_frame.push_back(zone); });
+    if (g_frame.empty())
+        return;
+
+    g_history.insert(g_history.end(), g_frame.cbegin(), g_frame.cend());
+    if (g_history.size() > kHistorySize)
+    {
+        g_history.erase(g_history.begin(),
+                        g_history.begin() + (g_history.size() - kHistorySize));
+    }
+}
+
+auto rainbow::profiler::intern(const std::string& name) -> const char*
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_names.insert(name).first->c_str();
+}
+
+auto rainbow::profiler::last_frame() -> const std::vector<Zone>&
+{
+    return g_frame;
+}
+
+auto rainbow::profiler::now() -> uint64_t
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - g_epoch)
+        .count();
+}
+
+void rainbow::profiler::record(const Zone& zone)
+{
+    buffer().push(zone);
+}
+
+void rainbow::profiler::set_enabled(bool enable)
+{
+    if (enable == is_enabled())
+        return;
+
+    if (enable)
+    {
+        // Discard anything left over from the previous session.
+        drain_all([](const Zone&) {});
+        g_frame.clear();
+        g_history.clear();
+    }
+    detail::g_enabled.store(enable, std::memory_order_relaxed);
+}
+
+auto rainbow::profiler::to_chrome_trace() -> std::string
+{
+    std::string trace = "{\"traceEvents\":[";
+    trace += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":";
+    trace += std::to_string(kGpuThread);
+    trace += ",\"args\":{\"name\":\"GPU\"}}";
+
+    char buffer[128];
+    for (auto&& zone : g_history)
+    {
+        trace += ",{\"name\":\"";
+        append_escaped(trace, zone.name);
+        std::snprintf(buffer,
+                      sizeof(buffer),
+                      "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,"
+                      "\"tid\":%" PRIu32 "}",
+                      zone.begin / 1000.0,
+                      (zone.end - zone.begin) / 1000.0,
+                      zone.thread);
+        trace += buffer;
+    }
+
+    trace += "],\"displayTimeUnit\":\"ms\"}";
+    return trace;
+}
+
+bool rainbow::profiler::write_chrome_trace(const char* path)
+{
+    const std::string trace = to_chrome_trace();
+    File file = File::open_write(path);
+    return file && file.write(trace.data(), trace.size()) == trace.size();
+}
@@ -0,0 +1,197 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef COMMON_PROFILER_H_
+#define COMMON_PROFILER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/NonCopyable.h"
+
+#define R_PROFILE_CONCAT_(a, b) a##b
+#define R_PROFILE_CONCAT(a, b) R_PROFILE_CONCAT_(a, b)
+
+/// <summary>
+///   Times the enclosing scope as zone <paramref name="name"/>. The name must
+///   outlive the profiler, e.g. a string literal.
+/// </summary>
+#define R_PROFILE_ZONE(name)                                                   \
+    rainbow::profiler::ScopedZone R_PROFILE_CONCAT(profile_zone_, __LINE__)(   \
+        name)
+
+namespace rainbow { namespace profiler
+{
+    /// <summary>Thread index of zones timed on the GPU.</summary>
+    constexpr uint32_t kGpuThread = std::numeric_limits<uint32_t>::max();
+
+    /// <summary>A timed scope.</summary>
+    struct Zone
+    {
+        const char* name;
+        uint64_t begin;   ///< Nanoseconds since the profiler was started.
+        uint64_t end;     ///< Nanoseconds since the profiler was started.
+        uint32_t thread;  ///< Index of the recording thread.
+        uint32_t depth;   ///< Number of enclosing zones on the same thread.
+    };
+
+    /// <summary>
+    ///   Fixed-size, single-producer single-consumer ring buffer of zones.
+    ///   Zones are dropped when the buffer is full.
+    /// </summary>
+    class ZoneBuffer : private NonCopyable<ZoneBuffer>
+    {
+    public:
+        ZoneBuffer(uint32_t thread, size_t capacity);
+
+        auto capacity() const { return capacity_; }
+
+        /// <summary>Returns the number of zones dropped so far.</summary>
+        auto dropped() const
+        {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+
+        auto thread() const { return thread_; }
+
+        /// <summary>
+        ///   Calls <paramref name="f"/> on every zone pushed since the last
+        ///   drain. Must only be called by the consumer.
+        /// </summary>
+        template <typename F>
+        void drain(F&& f)
+        {
+            size_t tail = tail_.load(std::memory_order_relaxed);
+            const size_t head = head_.load(std::memory_order_acquire);
+            for (; tail != head; ++tail)
+                f(zones_[tail % capacity_]);
+            tail_.store(tail, std::memory_order_release);
+        }
+
+        /// <summary>
+        ///   Appends <paramref name="zone"/>. Must only be called by the
+        ///   owning thread.
+        /// </summary>
+        void push(const Zone& zone)
+        {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            if (head - tail_.load(std::memory_order_acquire) == capacity_)
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            zones_[head % capacity_] = zone;
+            head_.store(head + 1, std::memory_order_release);
+        }
+
+    private:
+        std::unique_ptr<Zone[]> zones_;
+        const size_t capacity_;
+        const uint32_t thread_;
+        std::atomic<size_t> head_;  ///< Written by the producer only.
+        std::atomic<size_t> tail_;  ///< Written by the consumer only.
+        std::atomic<size_t> dropped_;
+    };
+
+    namespace detail
+    {
+        extern std::atomic<bool> g_enabled;
+
+        /// <summary>
+        ///   Returns the current time and increments the depth of the calling
+        ///   thread.
+        /// </summary>
+        auto begin_zone() -> uint64_t;
+
+        /// <summary>
+        ///   Decrements the depth of the calling thread and records the zone.
+        /// </summary>
+        void end_zone(const char* name, uint64_t begin);
+    }
+
+    /// <summary>Times a scope if the profiler is enabled.</summary>
+    /// <remarks>
+    ///   When the profiler is disabled, this costs a relaxed atomic load.
+    /// </remarks>
+    class ScopedZone : private NonCopyable<ScopedZone>
+    {
+    public:
+        explicit ScopedZone(const char* name)
+            : name_(detail::g_enabled.load(std::memory_order_relaxed)
+                        ? name
+                        : nullptr),
+              begin_(name_ == nullptr ? 0 : detail::begin_zone())
+        {
+        }
+
+        ~ScopedZone()
+        {
+            if (name_ != nullptr)
+                detail::end_zone(name_, begin_);
+        }
+
+    private:
+        const char* name_;
+        uint64_t begin_;
+    };
+
+    /// <summary>
+    ///   Collects zones recorded since the last call, from all threads. Must
+    ///   be called on the main thread once per frame.
+    /// </summary>
+    void end_frame();
+
+    /// <summary>
+    ///   Returns a string that stays valid for the lifetime of the program and
+    ///   equals <paramref name="name"/>. Used to name zones after data.
+    /// </summary>
+    auto intern(const std::string& name) -> const char*;
+
+    /// <summary>Returns whether the profiler is recording.</summary>
+    inline bool is_enabled()
+    {
+        return detail::g_enabled.load(std::memory_order_relaxed);
+    }
+
+    /// <summary>
+    ///   Returns zones collected by the last <see cref="end_frame"/>. Only
+    ///   valid on the main thread.
+    /// </summary>
+    auto last_frame() -> const std::vector<Zone>&;
+
+    /// <summary>
+    ///   Returns the current time, in nanoseconds since the profiler was
+    ///   started.
+    /// </summary>
+    auto now() -> uint64_t;
+
+    /// <summary>
+    ///   Records <paramref name="zone"/> as is, e.g. zones timed elsewhere.
+    /// </summary>
+    void record(const Zone& zone);
+
+    /// <summary>Starts or stops recording.</summary>
+    /// <remarks>History is cleared when recording starts.</remarks>
+    void set_enabled(bool enable);
+
+    /// <summary>
+    ///   Returns recently collected zones in Chrome's trace event format, as
+    ///   loaded by chrome://tracing.
+    /// </summary>
+    auto to_chrome_trace() -> std::string;
+
+    /// <summary>
+    ///   Writes recently collected zones to <paramref name="path"/> in
+    ///   Chrome's trace event format.
+    /// </summary>
+    bool write_chrome_trace(const char* path);
+}}  // namespace rainbow::profiler
+
+#endif
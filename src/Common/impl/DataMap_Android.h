@@ -16,6 +16,10 @@ namespace rainbow
 
         const byte_t* data() const;
         void offset(size_t offset) { off_ = offset; }
+
+        // Assets are paged in by the asset manager.
+        void prefetch(size_t, size_t) const {}
+
         size_t size() const;
 
         explicit operator bool() const { return static_cast<AAsset*>(asset_); }
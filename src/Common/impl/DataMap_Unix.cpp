@@ -7,6 +7,9 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
 
 #include "Common/Logging.h"
 #include "FileSystem/File.h"
@@ -31,7 +34,7 @@ DataMapUnix::DataMapUnix(const Path& path)
     {
         const int fd = fileno(f);
 #if defined(RAINBOW_OS_IOS) || defined(RAINBOW_OS_MACOS)
-        fcntl(fd, F_NOCACHE, 1);
+        // Bypassing the buffer cache would defeat prefetch().
         fcntl(fd, F_RDAHEAD, 1);
 #endif
         addr_ = mmap(nullptr, len_, PROT_READ, MAP_PRIVATE, fd, 0);
@@ -52,6 +55,22 @@ DataMapUnix::DataMapUnix(DataMapUnix&& data)
     data.addr_ = nullptr;
 }
 
+void DataMapUnix::prefetch(size_t offset, size_t size) const
+{
+    if (addr_ == nullptr || is_embedded_)
+        return;
+
+    offset += off_;
+    if (offset >= len_)
+        return;
+
+    // The range must start on a page boundary. The mapping itself does.
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    const size_t begin = offset & ~(page_size - 1);
+    const size_t end = std::min(offset + size, len_);
+    madvise(static_cast<char*>(addr_) + begin, end - begin, MADV_WILLNEED);
+}
+
 DataMapUnix::~DataMapUnix()
 {
     if (addr_ == nullptr || is_embedded_)
@@ -7,6 +7,8 @@
 #include <io.h>
 #include <Windows.h>
 
+#include <algorithm>
+
 #include "Common/Logging.h"
 #include "FileSystem/Path.h"
 
@@ -63,6 +65,22 @@ DataMapWin::DataMapWin(DataMapWin&& data)
     data.handle_ = nullptr;
 }
 
+void DataMapWin::prefetch(size_t offset, size_t size) const
+{
+#if _WIN32_WINNT >= 0x0602  // Windows 8
+    offset += off_;
+    if (addr_ == nullptr || offset >= len_)
+        return;
+
+    WIN32_MEMORY_RANGE_ENTRY range{
+        static_cast<char*>(addr_) + offset, std::min(size, len_ - offset)};
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    static_cast<void>(offset);
+    static_cast<void>(size);
+#endif
+}
+
 DataMapWin::~DataMapWin()
 {
     if (handle_ == nullptr)
@@ -26,6 +26,7 @@ namespace rainbow
         }
 
         void offset(size_t offset) { off_ = offset; }
+        void prefetch(size_t offset, size_t size) const;
         size_t size() const { return len_ - off_; }
 
         explicit operator bool() const { return addr_; }
@@ -4,6 +4,7 @@
 
 #include "Director.h"
 
+#include "Common/Profiler.h"
 #include "Common/Random.h"
 #include "Script/GameBase.h"
 
@@ -14,6 +15,9 @@
 namespace
 {
     constexpr int kMaxAudioChannels = 24;
+
+    /// <summary>Time spent uploading loaded textures each frame.</summary>
+    constexpr std::chrono::milliseconds kTextureUploadBudget{4};
 }
 
 namespace rainbow
@@ -39,11 +43,15 @@ namespace rainbow
 
     void Director::draw()
     {
+        R_PROFILE_ZONE("Director::draw");
+
+        gpu_timer_.begin("Director::draw");
         graphics::clear();
         scenegraph_.draw();
 #ifdef USE_PHYSICS
         b2::DebugDraw::Draw();
 #endif  // USE_PHYSICS
+        gpu_timer_.end();
     }
 
     void Director::init(const Vec2i& screen)
@@ -63,8 +71,13 @@ namespace rainbow
     {
         R_ASSERT(!terminated_, "App should have terminated by now");
 
+        // A frame is an update followed by a draw.
+        profiler::end_frame();
+        R_PROFILE_ZONE("Director::update");
+
         mixer_.process();
         timer_manager_.update(dt);
+        TextureManager::Get()->update(kTextureUploadBudget);
         script_->update(dt);
         scenegraph_.update(dt);
         TextureManager::Get()->trim();
@@ -6,10 +6,12 @@
 #define DIRECTOR_H_
 
 #include "Audio/Mixer.h"
+#include "Graphics/GpuTimer.h"
 #include "Graphics/Renderer.h"
 #include "Graphics/SceneGraph.h"
 #include "Input/Input.h"
 #include "Script/Timer.h"
+#include "Threading/JobSystem.h"
 
 class Data;
 class GameBase;
@@ -65,11 +67,13 @@ namespace rainbow
         bool active_;
         bool terminated_;
         const char* error_;
+        JobSystem job_system_;
         TimerManager timer_manager_;
         std::unique_ptr<GameBase> script_;
         GroupNode scenegraph_;
         Input input_;
         graphics::State renderer_;
+        graphics::GpuTimer gpu_timer_;
         audio::Mixer mixer_;
     };
 }
@@ -5,7 +5,9 @@
 #include "Graphics/Buffer.h"
 
 #include "Graphics/OpenGL.h"
+#include "Graphics/Renderer.h"
 #include "Graphics/ShaderDetails.h"
+#include "Graphics/SpriteInstance.h"
 #include "Graphics/SpriteVertex.h"
 
 using rainbow::graphics::Buffer;
@@ -20,11 +22,16 @@ namespace
     }
 }
 
-Buffer::Buffer() : id_(glGenBuffer()) {}
+Buffer::Buffer() : id_(glGenBuffer()), size_(0) {}
 
-Buffer::Buffer(const rainbow::ISolemnlySwearThatIAmOnlyTesting&) : id_(0) {}
+Buffer::Buffer(const rainbow::ISolemnlySwearThatIAmOnlyTesting&)
+    : id_(0), size_(0) {}
 
-Buffer::Buffer(Buffer&& buffer) : id_(buffer.id_) { buffer.id_ = 0; }
+Buffer::Buffer(Buffer&& buffer) : id_(buffer.id_), size_(buffer.size_)
+{
+    buffer.id_ = 0;
+    buffer.size_ = 0;
+}
 
 Buffer::~Buffer()
 {
@@ -70,10 +77,85 @@ void Buffer::bind(unsigned int index) const
     glVertexAttribPointer(index, 2, GL_FLOAT, GL_FALSE, sizeof(Vec2f), nullptr);
 }
 
+void Buffer::bind_instances() const
+{
+#ifdef USE_INSTANCED_ARRAYS
+    glBindBuffer(GL_ARRAY_BUFFER, id_);
+    glEnableVertexAttribArray(Shader::kAttributeColor);
+    glVertexAttribPointer(
+        Shader::kAttributeColor,
+        4,
+        GL_UNSIGNED_BYTE,
+        GL_TRUE,
+        sizeof(SpriteInstance),
+        reinterpret_cast<void*>(offsetof(SpriteInstance, color)));
+    glVertexAttribDivisor(Shader::kAttributeColor, 1);
+    glEnableVertexAttribArray(Shader::kAttributeTexCoord);
+    glVertexAttribPointer(
+        Shader::kAttributeTexCoord,
+        4,
+        GL_UNSIGNED_SHORT,
+        GL_TRUE,
+        sizeof(SpriteInstance),
+        reinterpret_cast<void*>(offsetof(SpriteInstance, texcoord)));
+    glVertexAttribDivisor(Shader::kAttributeTexCoord, 1);
+    glEnableVertexAttribArray(Shader::kAttributeTransform);
+    glVertexAttribPointer(
+        Shader::kAttributeTransform,
+        4,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(SpriteInstance),
+        reinterpret_cast<void*>(offsetof(SpriteInstance, center)));
+    glVertexAttribDivisor(Shader::kAttributeTransform, 1);
+    glEnableVertexAttribArray(Shader::kAttributeOrigin);
+    glVertexAttribPointer(
+        Shader::kAttributeOrigin,
+        3,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(SpriteInstance),
+        reinterpret_cast<void*>(offsetof(SpriteInstance, pivot)));
+    glVertexAttribDivisor(Shader::kAttributeOrigin, 1);
+#endif  // USE_INSTANCED_ARRAYS
+}
+
 void Buffer::upload(const void* data, size_t size) const
 {
     glBindBuffer(GL_ARRAY_BUFFER, id_);
     glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
     glBufferData(GL_ARRAY_BUFFER, size, data, GL_STREAM_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
+    size_ = size;
+
+#ifndef NDEBUG
+    rainbow::graphics::detail::g_bytes_uploaded_accumulator += size;
+#endif
+}
+
+void Buffer::upload(const void* data,
+                    size_t size,
+                    size_t offset,
+                    size_t length) const
+{
+    R_ASSERT(offset + length <= size, "Dirty range is out of bounds");
+
+    // Orphaning is cheaper than waiting on the GPU when most of the buffer
+    // needs to be replaced anyway.
+    if (size > size_ || length * 2 > size)
+    {
+        upload(data, size);
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, id_);
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    offset,
+                    length,
+                    static_cast<const char*>(data) + offset);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+#ifndef NDEBUG
+    rainbow::graphics::detail::g_bytes_uploaded_accumulator += length;
+#endif
 }
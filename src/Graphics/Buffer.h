@@ -27,14 +27,35 @@ namespace rainbow { namespace graphics
         /// <summary>Used by SpriteBatch for normal buffers.</summary>
         void bind(unsigned int index) const;
 
+        /// <summary>
+        ///   Used by SpriteBatch for instanced sprites. Advances once per
+        ///   instance.
+        /// </summary>
+        void bind_instances() const;
+
+        /// <summary>Returns the buffer object name.</summary>
+        auto id() const { return id_; }
+
         /// <summary>
         ///   Uploads <paramref name="data"/> of size <paramref name="size"/> to
         ///   the GPU buffer.
         /// </summary>
         void upload(const void* data, size_t size) const;
 
+        /// <summary>
+        ///   Uploads only the bytes in [<paramref name="offset"/>,
+        ///   <paramref name="offset"/> + <paramref name="length"/>) of
+        ///   <paramref name="data"/>. Falls back to a full upload if the buffer
+        ///   needs to grow or if most of the buffer is dirty.
+        /// </summary>
+        void upload(const void* data,
+                    size_t size,
+                    size_t offset,
+                    size_t length) const;
+
     private:
         unsigned int id_;
+        mutable size_t size_;  ///< Size of the GPU buffer, in bytes.
     };
 }}  // namespace rainbow::graphics
 
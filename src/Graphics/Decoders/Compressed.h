@@ -0,0 +1,44 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef GRAPHICS_DECODERS_COMPRESSED_H_
+#define GRAPHICS_DECODERS_COMPRESSED_H_
+
+#include <algorithm>
+#include <cstdint>
+
+namespace rainbow { namespace compressed
+{
+    /// <summary>
+    ///   Returns the number of levels in a full mipmap chain, down to 1x1.
+    /// </summary>
+    inline auto mipmap_count(uint32_t width, uint32_t height) -> uint32_t
+    {
+        uint32_t levels = 1;
+        for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+            ++levels;
+        return levels;
+    }
+
+    /// <summary>
+    ///   Returns the size of mipmap level <paramref name="level"/> of an
+    ///   image compressed in 4x4 blocks of <paramref name="block_size"/>
+    ///   bytes. Computed in 64 bits, so that it cannot wrap.
+    /// </summary>
+    /// <remarks>
+    ///   <paramref name="level"/> must be less than
+    ///   <see cref="mipmap_count"/>.
+    /// </remarks>
+    inline auto level_size(uint32_t width,
+                           uint32_t height,
+                           uint32_t level,
+                           uint32_t block_size) -> uint64_t
+    {
+        const uint64_t w = std::max(width >> level, 1u);
+        const uint64_t h = std::max(height >> level, 1u);
+        return ((w + 3) / 4) * ((h + 3) / 4) * block_size;
+    }
+}}
+
+#endif
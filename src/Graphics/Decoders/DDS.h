@@ -0,0 +1,192 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef GRAPHICS_DECODERS_DDS_H_
+#define GRAPHICS_DECODERS_DDS_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "Common/Logging.h"
+#include "Graphics/Decoders/Compressed.h"
+#include "Graphics/Renderer.h"
+
+#define USE_DDS
+
+namespace dds
+{
+    namespace
+    {
+        constexpr uint32_t four_cc(char a, char b, char c, char d)
+        {
+            return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) |
+                   (static_cast<uint32_t>(c) << 16) |
+                   (static_cast<uint32_t>(d) << 24);
+        }
+
+        const uint32_t kMagic = four_cc('D', 'D', 'S', ' ');
+        const uint32_t kDDSDLinearSize = 0x80000;
+        const uint32_t kDDPFFourCC = 0x4;
+        const uint32_t kDXGIFormatBC7 = 98;
+        const uint32_t kDXGIFormatBC7sRGB = 99;
+
+        /// DDS texture header, as specified by Microsoft.
+        /// \see https://msdn.microsoft.com/en-us/library/bb943982.aspx
+        struct DDSHeader
+        {
+            uint32_t magic;
+            uint32_t size;
+            uint32_t flags;
+            uint32_t height;
+            uint32_t width;
+            uint32_t pitch_or_linear_size;
+            uint32_t depth;
+            uint32_t mipmap_count;
+            uint32_t reserved1[11];
+            struct
+            {
+                uint32_t size;
+                uint32_t flags;
+                uint32_t four_cc;
+                uint32_t rgb_bit_count;
+                uint32_t bit_mask[4];
+            } pixel_format;
+            uint32_t caps[4];
+            uint32_t reserved2;
+        };
+
+        struct DDSHeaderDXT10
+        {
+            uint32_t dxgi_format;
+            uint32_t resource_dimension;
+            uint32_t misc_flag;
+            uint32_t array_size;
+            uint32_t misc_flags2;
+        };
+    }
+
+    bool check(const DataMap& data)
+    {
+        uint32_t magic;
+        if (data.size() < sizeof(DDSHeader))
+            return false;
+
+        memcpy(&magic, data.data(), sizeof(magic));
+        return magic == kMagic;
+    }
+
+    rainbow::Image decode(const DataMap& data)
+    {
+        rainbow::Image image;
+
+        DDSHeader header;
+        memcpy(&header, data.data(), sizeof(header));
+        size_t offset = sizeof(header);
+
+        uint32_t block_size = 16;
+        image.depth = 8;
+        image.channels = 4;
+        if ((header.pixel_format.flags & kDDPFFourCC) == 0)
+        {
+            LOGE("DDS: Uncompressed textures are not supported");
+            return image;
+        }
+        switch (header.pixel_format.four_cc)
+        {
+            case four_cc('D', 'X', 'T', '1'):
+                image.format = rainbow::Image::Format::S3TC;
+                image.internal_format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+                image.depth = 4;
+                block_size = 8;
+                break;
+            case four_cc('D', 'X', 'T', '3'):
+                image.format = rainbow::Image::Format::S3TC;
+                image.internal_format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+                break;
+            case four_cc('D', 'X', 'T', '5'):
+                image.format = rainbow::Image::Format::S3TC;
+                image.internal_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+                break;
+            case four_cc('D', 'X', '1', '0'): {
+                DDSHeaderDXT10 dx10;
+                if (data.size() < offset + sizeof(dx10))
+                    break;
+
+                memcpy(&dx10, data.data() + offset, sizeof(dx10));
+                offset += sizeof(dx10);
+                if (dx10.dxgi_format == kDXGIFormatBC7 ||
+                    dx10.dxgi_format == kDXGIFormatBC7sRGB)
+                {
+                    image.format = rainbow::Image::Format::BPTC;
+                    image.internal_format = GL_COMPRESSED_RGBA_BPTC_UNORM;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+
+        if (image.internal_format == 0)
+        {
+            LOGE("DDS: Unsupported texture format");
+            return image;
+        }
+
+        const auto max_size =
+            static_cast<uint32_t>(rainbow::graphics::max_texture_size());
+        if (header.width == 0 || header.height == 0 ||
+            header.width > max_size || header.height > max_size)
+        {
+            LOGE("DDS: Unsupported texture size: %ux%u",
+                 header.width,
+                 header.height);
+            return image;
+        }
+
+        if ((header.flags & kDDSDLinearSize) != 0 &&
+            header.pitch_or_linear_size !=
+                rainbow::compressed::level_size(
+                    header.width, header.height, 0, block_size))
+        {
+            LOGE("DDS: Image has unexpected size: %u bytes",
+                 header.pitch_or_linear_size);
+            return image;
+        }
+
+        // Levels are stored back to back, and their sizes are implied by
+        // their dimensions. The data is used in place; the caller keeps the
+        // file mapped.
+        image.width = header.width;
+        image.height = header.height;
+        const uint32_t levels = std::min(
+            std::max(header.mipmap_count, 1u),
+            rainbow::compressed::mipmap_count(image.width, image.height));
+        for (uint32_t i = 0; i < levels; ++i)
+        {
+            const uint64_t size = rainbow::compressed::level_size(
+                image.width, image.height, i, block_size);
+            if (data.size() - offset < size)
+                break;
+
+            const uint8_t* level = data.data() + offset;
+            if (i == 0)
+            {
+                image.data = level;
+                image.size = static_cast<size_t>(size);
+            }
+            else
+            {
+                image.mipmaps.push_back({level, static_cast<size_t>(size)});
+            }
+            offset += size;
+        }
+
+        if (image.data == nullptr)
+            LOGE("DDS: Image data is truncated");
+        return image;
+    }
+}
+
+#endif
@@ -0,0 +1,196 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef GRAPHICS_DECODERS_KTX_H_
+#define GRAPHICS_DECODERS_KTX_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "Common/Logging.h"
+#include "Graphics/Decoders/Compressed.h"
+#include "Graphics/Renderer.h"
+
+#define USE_KTX
+
+namespace ktx
+{
+    namespace
+    {
+        const uint8_t kIdentifier[12]{
+            0xab, 'K', 'T', 'X', ' ', '1', '1', 0xbb, '\r', '\n', 0x1a, '\n'};
+        const uint32_t kEndianness = 0x04030201;
+
+        /// KTX texture header, as specified by the Khronos Group.
+        /// \see https://www.khronos.org/opengles/sdk/tools/KTX/file_format_spec/
+        struct KTXHeader
+        {
+            uint8_t identifier[12];
+            uint32_t endianness;
+            uint32_t gl_type;
+            uint32_t gl_type_size;
+            uint32_t gl_format;
+            uint32_t gl_internal_format;
+            uint32_t gl_base_internal_format;
+            uint32_t pixel_width;
+            uint32_t pixel_height;
+            uint32_t pixel_depth;
+            uint32_t number_of_array_elements;
+            uint32_t number_of_faces;
+            uint32_t number_of_mipmap_levels;
+            uint32_t bytes_of_key_value_data;
+        };
+
+        auto format_of(uint32_t internal_format) -> rainbow::Image::Format
+        {
+            switch (internal_format)
+            {
+                case GL_COMPRESSED_RGBA_ASTC_4x4_KHR:
+                    return rainbow::Image::Format::ASTC;
+                case GL_COMPRESSED_RGBA_BPTC_UNORM:
+                    return rainbow::Image::Format::BPTC;
+                case GL_ETC1_RGB8_OES:
+                    return rainbow::Image::Format::ETC1;
+                case GL_COMPRESSED_RGB8_ETC2:
+                case GL_COMPRESSED_RGBA8_ETC2_EAC:
+                    return rainbow::Image::Format::ETC2;
+                case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+                case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+                case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+                case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+                    return rainbow::Image::Format::S3TC;
+                default:
+                    return rainbow::Image::Format::Unknown;
+            }
+        }
+
+        auto read_uint32(const uint8_t* data) -> uint32_t
+        {
+            uint32_t value;
+            memcpy(&value, data, sizeof(value));
+            return value;
+        }
+    }
+
+    bool check(const DataMap& data)
+    {
+        return data.size() >= sizeof(KTXHeader) &&
+               memcmp(data.data(), kIdentifier, sizeof(kIdentifier)) == 0;
+    }
+
+    rainbow::Image decode(const DataMap& data)
+    {
+        rainbow::Image image;
+
+        KTXHeader header;
+        memcpy(&header, data.data(), sizeof(header));
+        if (header.endianness != kEndianness)
+        {
+            LOGE("KTX: Big-endian files are not supported");
+            return image;
+        }
+
+        image.format = format_of(header.gl_internal_format);
+        if (header.gl_type != 0 ||
+            image.format == rainbow::Image::Format::Unknown)
+        {
+            LOGE("KTX: Unsupported texture format: 0x%x",
+                 header.gl_internal_format);
+            return image;
+        }
+
+        if (header.pixel_depth > 1 || header.number_of_array_elements > 0 ||
+            header.number_of_faces != 1)
+        {
+            LOGE("KTX: Only 2D textures are supported");
+            return image;
+        }
+
+        const auto max_size =
+            static_cast<uint32_t>(rainbow::graphics::max_texture_size());
+        if (header.pixel_width == 0 || header.pixel_height == 0 ||
+            header.pixel_width > max_size || header.pixel_height > max_size)
+        {
+            LOGE("KTX: Unsupported texture size: %ux%u",
+                 header.pixel_width,
+                 header.pixel_height);
+            return image;
+        }
+
+        if (header.bytes_of_key_value_data > data.size() - sizeof(header))
+        {
+            LOGE("KTX: Image data is truncated");
+            return image;
+        }
+
+        image.width = header.pixel_width;
+        image.height = header.pixel_height;
+        image.internal_format = header.gl_internal_format;
+        switch (image.internal_format)
+        {
+            case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+            case GL_ETC1_RGB8_OES:
+            case GL_COMPRESSED_RGB8_ETC2:
+                image.depth = 4;
+                image.channels = 3;
+                break;
+            case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+                image.depth = 4;
+                image.channels = 4;
+                break;
+            default:
+                image.depth = 8;
+                image.channels = 4;
+                break;
+        }
+
+        // Each level is prefixed with its size, and padded to 4 bytes. The
+        // data is used in place; the caller keeps the file mapped. All
+        // supported formats use 4x4 blocks, i.e. 2 bytes per bit of depth.
+        const uint32_t block_size = image.depth * 2;
+        const uint32_t levels =
+            std::min(std::max(header.number_of_mipmap_levels, 1u),
+                     rainbow::compressed::mipmap_count(image.width,
+                                                       image.height));
+        size_t offset = sizeof(header) + header.bytes_of_key_value_data;
+        for (uint32_t i = 0; i < levels; ++i)
+        {
+            if (data.size() - offset < 4)
+                break;
+
+            const uint32_t size = read_uint32(data.data() + offset);
+            offset += 4;
+            if (size != rainbow::compressed::level_size(
+                            image.width, image.height, i, block_size))
+            {
+                LOGE("KTX: Mipmap level %u has unexpected size: %u bytes",
+                     i,
+                     size);
+                return rainbow::Image{};
+            }
+
+            if (data.size() - offset < size)
+                break;
+
+            const uint8_t* level = data.data() + offset;
+            if (i == 0)
+            {
+                image.data = level;
+                image.size = size;
+            }
+            else
+            {
+                image.mipmaps.push_back({level, size});
+            }
+            offset = std::min(offset + ((size + 3) & ~3u), data.size());
+        }
+
+        if (image.data == nullptr)
+            LOGE("KTX: Image data is truncated");
+        return image;
+    }
+}
+
+#endif
@@ -0,0 +1,422 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include "Graphics/Decoders/Software.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "Common/Logging.h"
+#include "Graphics/Decoders/Compressed.h"
+#include "Graphics/OpenGL.h"
+
+using rainbow::byte_t;
+
+namespace
+{
+    constexpr unsigned int kBlockSize = 4;
+
+    /// <summary>One decoded 4x4 block, in RGBA.</summary>
+    using Block = byte_t[kBlockSize * kBlockSize][4];
+
+    using BlockDecoder = void (*)(const byte_t*, Block&);
+
+    const int kETCModifiers[8][4]{
+        {2, 8, -2, -8},
+        {5, 17, -5, -17},
+        {9, 29, -9, -29},
+        {13, 42, -13, -42},
+        {18, 60, -18, -60},
+        {24, 80, -24, -80},
+        {33, 106, -33, -106},
+        {47, 183, -47, -183}};
+
+    const int kETCDistances[8]{3, 6, 11, 16, 23, 32, 41, 64};
+
+    auto clamp(int value) -> byte_t
+    {
+        return static_cast<byte_t>(std::min(std::max(value, 0), 255));
+    }
+
+    /// <summary>Expands an N-bit value to 8 bits.</summary>
+    template <unsigned int N>
+    auto expand(unsigned int value) -> int
+    {
+        return (value << (8 - N)) | (value >> (2 * N - 8));
+    }
+
+    auto read16(const byte_t* data) -> unsigned int
+    {
+        return data[0] | (data[1] << 8);
+    }
+
+    auto read32(const byte_t* data) -> uint32_t
+    {
+        return data[0] | (data[1] << 8) | (data[2] << 16) |
+               (static_cast<uint32_t>(data[3]) << 24);
+    }
+
+    auto read64_be(const byte_t* data) -> uint64_t
+    {
+        uint64_t value = 0;
+        for (int i = 0; i < 8; ++i)
+            value = (value << 8) | data[i];
+        return value;
+    }
+
+    void set(byte_t (&pixel)[4], int r, int g, int b, int a = 255)
+    {
+        pixel[0] = clamp(r);
+        pixel[1] = clamp(g);
+        pixel[2] = clamp(b);
+        pixel[3] = clamp(a);
+    }
+
+    /* S3TC */
+
+    void decode_bc1_color(const byte_t* data, bool has_alpha, Block& block)
+    {
+        const unsigned int c0 = read16(data);
+        const unsigned int c1 = read16(data + 2);
+
+        int palette[4][4];
+        for (int i = 0; i < 2; ++i)
+        {
+            const unsigned int c = i == 0 ? c0 : c1;
+            palette[i][0] = expand<5>((c >> 11) & 0x1f);
+            palette[i][1] = expand<6>((c >> 5) & 0x3f);
+            palette[i][2] = expand<5>(c & 0x1f);
+            palette[i][3] = 255;
+        }
+
+        if (c0 > c1 || !has_alpha)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                palette[2][j] = (2 * palette[0][j] + palette[1][j]) / 3;
+                palette[3][j] = (palette[0][j] + 2 * palette[1][j]) / 3;
+            }
+            palette[2][3] = 255;
+            palette[3][3] = 255;
+        }
+        else
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                palette[2][j] = (palette[0][j] + palette[1][j]) / 2;
+                palette[3][j] = 0;
+            }
+            palette[2][3] = 255;
+            palette[3][3] = 0;
+        }
+
+        const uint32_t indices = read32(data + 4);
+        for (unsigned int i = 0; i < kBlockSize * kBlockSize; ++i)
+        {
+            const int* color = palette[(indices >> (i * 2)) & 0x3];
+            set(block[i], color[0], color[1], color[2], color[3]);
+        }
+    }
+
+    void decode_bc1(const byte_t* data, Block& block)
+    {
+        decode_bc1_color(data, false, block);
+    }
+
+    void decode_bc1_alpha(const byte_t* data, Block& block)
+    {
+        decode_bc1_color(data, true, block);
+    }
+
+    void decode_bc2(const byte_t* data, Block& block)
+    {
+        decode_bc1_color(data + 8, false, block);
+        for (unsigned int i = 0; i < kBlockSize * kBlockSize; ++i)
+        {
+            const unsigned int alpha = (data[i / 2] >> ((i % 2) * 4)) & 0xf;
+            block[i][3] = static_cast<byte_t>(expand<4>(alpha));
+        }
+    }
+
+    void decode_bc3(const byte_t* data, Block& block)
+    {
+        decode_bc1_color(data + 8, false, block);
+
+        const int a0 = data[0];
+        const int a1 = data[1];
+        int alpha[8]{a0, a1};
+        if (a0 > a1)
+        {
+            for (int i = 2; i < 8; ++i)
+                alpha[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+        }
+        else
+        {
+            for (int i = 2; i < 6; ++i)
+                alpha[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+            alpha[6] = 0;
+            alpha[7] = 255;
+        }
+
+        uint64_t indices = 0;
+        for (int i = 7; i >= 2; --i)
+            indices = (indices << 8) | data[i];
+        for (unsigned int i = 0; i < kBlockSize * kBlockSize; ++i)
+            block[i][3] = static_cast<byte_t>(alpha[(indices >> (i * 3)) & 7]);
+    }
+
+    /* ETC */
+
+    auto bits(uint64_t value, unsigned int high, unsigned int low)
+        -> unsigned int
+    {
+        return (value >> low) & ((1u << (high - low + 1)) - 1);
+    }
+
+    /// <summary>Returns the index of pixel (x,y) in an ETC block.</summary>
+    auto etc_index(uint64_t block, unsigned int x, unsigned int y)
+        -> unsigned int
+    {
+        // Pixel indices are stored column by column.
+        const unsigned int k = x * kBlockSize + y;
+        return (bits(block, k + 16, k + 16) << 1) | bits(block, k, k);
+    }
+
+    void decode_etc_paint(uint64_t b, const int (&paint)[4][3], Block& block)
+    {
+        for (unsigned int y = 0; y < kBlockSize; ++y)
+        {
+            for (unsigned int x = 0; x < kBlockSize; ++x)
+            {
+                const int* color = paint[etc_index(b, x, y)];
+                set(block[y * kBlockSize + x], color[0], color[1], color[2]);
+            }
+        }
+    }
+
+    /// <summary>ETC2 "T" mode.</summary>
+    void decode_etc2_t(uint64_t b, Block& block)
+    {
+        const int c1[3]{expand<4>((bits(b, 60, 59) << 2) | bits(b, 57, 56)),
+                        expand<4>(bits(b, 55, 52)),
+                        expand<4>(bits(b, 51, 48))};
+        const int c2[3]{expand<4>(bits(b, 47, 44)),
+                        expand<4>(bits(b, 43, 40)),
+                        expand<4>(bits(b, 39, 36))};
+        const int d = kETCDistances[(bits(b, 35, 34) << 1) | bits(b, 32, 32)];
+
+        int paint[4][3];
+        for (int i = 0; i < 3; ++i)
+        {
+            paint[0][i] = c1[i];
+            paint[1][i] = c2[i] + d;
+            paint[2][i] = c2[i];
+            paint[3][i] = c2[i] - d;
+        }
+        decode_etc_paint(b, paint, block);
+    }
+
+    /// <summary>ETC2 "H" mode.</summary>
+    void decode_etc2_h(uint64_t b, Block& block)
+    {
+        const unsigned int r1 = bits(b, 62, 59);
+        const unsigned int g1 = (bits(b, 58, 56) << 1) | bits(b, 52, 52);
+        const unsigned int b1 = (bits(b, 51, 51) << 3) | bits(b, 49, 47);
+        const unsigned int r2 = bits(b, 46, 43);
+        const unsigned int g2 = bits(b, 42, 39);
+        const unsigned int b2 = bits(b, 38, 35);
+
+        // The last bit of the distance index is implied by the order of the
+        // base colours.
+        const unsigned int order =
+            ((r1 << 8) | (g1 << 4) | b1) >= ((r2 << 8) | (g2 << 4) | b2);
+        const int d = kETCDistances[(bits(b, 34, 34) << 2) |
+                                    (bits(b, 32, 32) << 1) | order];
+
+        const int c1[3]{expand<4>(r1), expand<4>(g1), expand<4>(b1)};
+        const int c2[3]{expand<4>(r2), expand<4>(g2), expand<4>(b2)};
+        int paint[4][3];
+        for (int i = 0; i < 3; ++i)
+        {
+            paint[0][i] = c1[i] + d;
+            paint[1][i] = c1[i] - d;
+            paint[2][i] = c2[i] + d;
+            paint[3][i] = c2[i] - d;
+        }
+        decode_etc_paint(b, paint, block);
+    }
+
+    /// <summary>ETC2 planar mode.</summary>
+    void decode_etc2_planar(uint64_t b, Block& block)
+    {
+        const int o[3]{
+            expand<6>(bits(b, 62, 57)),
+            expand<7>((bits(b, 56, 56) << 6) | bits(b, 54, 49)),
+            expand<6>((bits(b, 48, 48) << 5) | (bits(b, 44, 43) << 3) |
+                      bits(b, 41, 39))};
+        const int h[3]{expand<6>((bits(b, 38, 34) << 1) | bits(b, 32, 32)),
+                       expand<7>(bits(b, 31, 25)),
+                       expand<6>(bits(b, 24, 19))};
+        const int v[3]{expand<6>(bits(b, 18, 13)),
+                       expand<7>(bits(b, 12, 6)),
+                       expand<6>(bits(b, 5, 0))};
+
+        for (int y = 0; y < 4; ++y)
+        {
+            for (int x = 0; x < 4; ++x)
+            {
+                int color[3];
+                for (int i = 0; i < 3; ++i)
+                {
+                    color[i] = (x * (h[i] - o[i]) + y * (v[i] - o[i]) +
+                                4 * o[i] + 2) >> 2;
+                }
+                set(block[y * kBlockSize + x], color[0], color[1], color[2]);
+            }
+        }
+    }
+
+    void decode_etc(const byte_t* data, bool etc2, Block& block)
+    {
+        const uint64_t b = read64_be(data);
+
+        int base[2][3];
+        if (bits(b, 33, 33) == 0)
+        {
+            // Individual mode: two 4-bit colours.
+            for (int i = 0; i < 3; ++i)
+            {
+                base[0][i] = expand<4>(bits(b, 63 - i * 8, 60 - i * 8));
+                base[1][i] = expand<4>(bits(b, 59 - i * 8, 56 - i * 8));
+            }
+        }
+        else
+        {
+            // Differential mode: a 5-bit colour and a 3-bit signed delta.
+            int c[2][3];
+            for (int i = 0; i < 3; ++i)
+            {
+                const int delta = bits(b, 58 - i * 8, 56 - i * 8);
+                c[0][i] = bits(b, 63 - i * 8, 59 - i * 8);
+                c[1][i] = c[0][i] + (delta >= 4 ? delta - 8 : delta);
+            }
+
+            // Overflows select the modes added in ETC2.
+            if (etc2)
+            {
+                if (c[1][0] < 0 || c[1][0] > 31)
+                    return decode_etc2_t(b, block);
+                if (c[1][1] < 0 || c[1][1] > 31)
+                    return decode_etc2_h(b, block);
+                if (c[1][2] < 0 || c[1][2] > 31)
+                    return decode_etc2_planar(b, block);
+            }
+
+            for (int i = 0; i < 3; ++i)
+            {
+                base[0][i] = expand<5>(c[0][i] & 0x1f);
+                base[1][i] = expand<5>(c[1][i] & 0x1f);
+            }
+        }
+
+        const int* modifiers[2]{kETCModifiers[bits(b, 39, 37)],
+                                kETCModifiers[bits(b, 36, 34)]};
+        const bool flipped = bits(b, 32, 32) != 0;
+        for (unsigned int y = 0; y < kBlockSize; ++y)
+        {
+            for (unsigned int x = 0; x < kBlockSize; ++x)
+            {
+                const unsigned int sub = (flipped ? y : x) >= 2;
+                const int m = modifiers[sub][etc_index(b, x, y)];
+                set(block[y * kBlockSize + x],
+                    base[sub][0] + m,
+                    base[sub][1] + m,
+                    base[sub][2] + m);
+            }
+        }
+    }
+
+    void decode_etc1(const byte_t* data, Block& block)
+    {
+        decode_etc(data, false, block);
+    }
+
+    void decode_etc2(const byte_t* data, Block& block)
+    {
+        decode_etc(data, true, block);
+    }
+
+    /// <summary>Returns the decoder and block size of a format.</summary>
+    auto block_decoder(unsigned int format, size_t& block_size)
+        -> BlockDecoder
+    {
+        block_size = 8;
+        switch (format)
+        {
+            case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+                return &decode_bc1;
+            case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+                return &decode_bc1_alpha;
+            case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+                block_size = 16;
+                return &decode_bc2;
+            case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+                block_size = 16;
+                return &decode_bc3;
+            case GL_ETC1_RGB8_OES:
+                return &decode_etc1;
+            case GL_COMPRESSED_RGB8_ETC2:
+                return &decode_etc2;
+            default:
+                return nullptr;
+        }
+    }
+}
+
+bool rainbow::software::can_decode(unsigned int format)
+{
+    size_t block_size;
+    return block_decoder(format, block_size) != nullptr;
+}
+
+auto rainbow::software::decode(unsigned int format,
+                               unsigned int width,
+                               unsigned int height,
+                               const byte_t* data,
+                               size_t size) -> std::unique_ptr<byte_t[]>
+{
+    size_t block_size;
+    const BlockDecoder decode_block = block_decoder(format, block_size);
+    if (decode_block == nullptr)
+        return {};
+
+    if (size < compressed::level_size(width, height, 0, block_size))
+    {
+        LOGE("Compressed image data is truncated");
+        return {};
+    }
+
+    auto pixels =
+        std::make_unique<byte_t[]>(static_cast<size_t>(width) * height * 4);
+    Block block;
+    for (unsigned int by = 0; by < height; by += kBlockSize)
+    {
+        for (unsigned int bx = 0; bx < width; bx += kBlockSize)
+        {
+            decode_block(data, block);
+            data += block_size;
+
+            // Blocks along the edges may be partially outside the image.
+            const unsigned int h = std::min(kBlockSize, height - by);
+            const unsigned int w = std::min(kBlockSize, width - bx);
+            for (unsigned int y = 0; y < h; ++y)
+            {
+                std::copy_n(block[y * kBlockSize],
+                            w * 4,
+                            pixels.get() + ((by + y) * width + bx) * 4);
+            }
+        }
+    }
+    return pixels;
+}
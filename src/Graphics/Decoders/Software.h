@@ -0,0 +1,46 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef GRAPHICS_DECODERS_SOFTWARE_H_
+#define GRAPHICS_DECODERS_SOFTWARE_H_
+
+#include <memory>
+
+#include "Common/DataMap.h"
+
+namespace rainbow { namespace software
+{
+    /// <summary>
+    ///   Returns whether image data compressed with OpenGL format
+    ///   <paramref name="format"/> can be decoded on the CPU.
+    /// </summary>
+    /// <remarks>
+    ///   Supports S3TC (BC1, BC2, BC3), ETC1, and ETC2 RGB8.
+    /// </remarks>
+    bool can_decode(unsigned int format);
+
+    /// <summary>
+    ///   Decodes block compressed image data into 32-bit RGBA.
+    /// </summary>
+    /// <remarks>
+    ///   Used when the graphics driver does not support the compressed format,
+    ///   and in tests. This is much slower than uploading the compressed data.
+    /// </remarks>
+    /// <param name="format">OpenGL format of the compressed data.</param>
+    /// <param name="width">Width of the image, in pixels.</param>
+    /// <param name="height">Height of the image, in pixels.</param>
+    /// <param name="data">Compressed image data.</param>
+    /// <param name="size">Size of <paramref name="data"/>, in bytes.</param>
+    /// <returns>
+    ///   Decoded pixels, row by row; <c>nullptr</c> if the format is not
+    ///   supported, or if <paramref name="data"/> is too small.
+    /// </returns>
+    auto decode(unsigned int format,
+                unsigned int width,
+                unsigned int height,
+                const byte_t* data,
+                size_t size) -> std::unique_ptr<byte_t[]>;
+}}
+
+#endif
@@ -0,0 +1,266 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include "Graphics/DistanceField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    constexpr double kInfinity = 1e20;
+    constexpr double kSqrt2 = 1.41421356237309504880;
+
+    /// <summary>
+    ///   Computes the squared distance transform of the sampled function
+    ///   <paramref name="f"/> in one dimension, in place. The sample each
+    ///   distance was measured from is written to <paramref name="nearest"/>,
+    ///   which has the same stride as <paramref name="f"/>.
+    /// </summary>
+    /// <remarks>
+    ///   Finds the lower envelope of the parabolas rooted at each sample.
+    ///   <paramref name="v"/>, <paramref name="z"/> and <paramref name="d"/>
+    ///   are scratch buffers of at least <paramref name="n"/>,
+    ///   <paramref name="n"/> + 1 and <paramref name="n"/> elements.
+    /// </remarks>
+    void transform_1d(double* f,
+                      int* nearest,
+                      size_t stride,
+                      int n,
+                      int* v,
+                      double* z,
+                      double* d)
+    {
+        int k = 0;
+        v[0] = 0;
+        z[0] = -kInfinity;
+        z[1] = kInfinity;
+        for (int q = 1; q < n; ++q)
+        {
+            const double fq = f[q * stride] + q * q;
+            auto intersect = [f, stride, q, fq](int r) {
+                return (fq - (f[r * stride] + r * r)) / (2 * (q - r));
+            };
+            double s = intersect(v[k]);
+            while (s <= z[k])
+                s = intersect(v[--k]);
+            ++k;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = kInfinity;
+        }
+
+        k = 0;
+        for (int q = 0; q < n; ++q)
+        {
+            while (z[k + 1] < q)
+                ++k;
+            const int r = v[k];
+            d[q] = (q - r) * (q - r) + f[r * stride];
+            nearest[q * stride] = r;
+        }
+        for (int q = 0; q < n; ++q)
+            f[q * stride] = d[q];
+    }
+
+    /// <summary>
+    ///   Finds the nearest seed of every pixel in a grid of
+    ///   <paramref name="width"/> by <paramref name="height"/>. Seeds are
+    ///   pixels set to 0; all others must be <c>kInfinity</c>.
+    /// </summary>
+    /// <returns>
+    ///   Index of each pixel's nearest seed; -1 if there are no seeds.
+    /// </returns>
+    auto nearest_seeds(std::vector<double>& grid, int width, int height)
+        -> std::vector<int>
+    {
+        const int n = std::max(width, height);
+        std::vector<int> v(n);
+        std::vector<double> z(n + 1);
+        std::vector<double> d(n);
+
+        // The first pass finds the nearest row in each column, and the second
+        // the nearest column in each row.
+        std::vector<int> rows(grid.size());
+        std::vector<int> columns(grid.size());
+        for (int x = 0; x < width; ++x)
+        {
+            transform_1d(grid.data() + x,
+                         rows.data() + x,
+                         width,
+                         height,
+                         v.data(),
+                         z.data(),
+                         d.data());
+        }
+        for (int y = 0; y < height; ++y)
+        {
+            transform_1d(grid.data() + y * width,
+                         columns.data() + y * width,
+                         1,
+                         width,
+                         v.data(),
+                         z.data(),
+                         d.data());
+        }
+
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                const int i = y * width + x;
+                const int column = columns[i];
+                columns[i] = grid[i] >= kInfinity
+                                 ? -1
+                                 : rows[y * width + column] * width + column;
+            }
+        }
+        return columns;
+    }
+
+    /// <summary>
+    ///   Estimates the distance from the centre of a pixel to the edge that
+    ///   passes through it, given its coverage <paramref name="a"/> and the
+    ///   direction (<paramref name="gx"/>, <paramref name="gy"/>) of the
+    ///   edge normal. Positive if the centre is outside.
+    /// </summary>
+    /// <remarks>
+    ///   From Stefan Gustavson and Robin Strand, "Anti-aliased Euclidean
+    ///   distance transform", Pattern Recognition Letters 32 (2011).
+    /// </remarks>
+    auto edge_distance(double gx, double gy, double a) -> double
+    {
+        if (gx == 0.0 || gy == 0.0)
+            return 0.5 - a;
+
+        // The edge is symmetric about the axes and diagonals, so only the
+        // first octant needs to be handled.
+        const double length = std::sqrt(gx * gx + gy * gy);
+        gx = std::abs(gx / length);
+        gy = std::abs(gy / length);
+        if (gx < gy)
+            std::swap(gx, gy);
+
+        const double a1 = 0.5 * gy / gx;
+        if (a < a1)
+            return 0.5 * (gx + gy) - std::sqrt(2.0 * gx * gy * a);
+        if (a < 1.0 - a1)
+            return (0.5 - a) * gx;
+        return -0.5 * (gx + gy) + std::sqrt(2.0 * gx * gy * (1.0 - a));
+    }
+
+    /// <summary>
+    ///   Computes the distance from every pixel to the nearest covered one,
+    ///   offset by where the edge passes through it. 0 for pixels that are
+    ///   mostly covered.
+    /// </summary>
+    /// <param name="coverage">Coverage of each pixel, from 0 to 1.</param>
+    /// <param name="gx">Horizontal component of edge normals.</param>
+    /// <param name="gy">Vertical component of edge normals.</param>
+    auto distance_to_coverage(const std::vector<double>& coverage,
+                              const std::vector<double>& gx,
+                              const std::vector<double>& gy,
+                              int width,
+                              int height) -> std::vector<double>
+    {
+        std::vector<double> grid(coverage.size());
+        std::transform(coverage.begin(),
+                       coverage.end(),
+                       grid.begin(),
+                       [](double a) { return a > 0.0 ? 0.0 : kInfinity; });
+        const std::vector<int> nearest = nearest_seeds(grid, width, height);
+
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                const int i = y * width + x;
+                const int seed = nearest[i];
+                if (seed < 0)
+                {
+                    grid[i] = kInfinity;
+                    continue;
+                }
+
+                // Far from the seed, the edge is assumed to face this pixel.
+                const double dx = x - seed % width;
+                const double dy = y - seed / width;
+                const double distance =
+                    seed == i
+                        ? edge_distance(gx[i], gy[i], coverage[i])
+                        : std::sqrt(dx * dx + dy * dy) +
+                              edge_distance(dx, dy, coverage[seed]);
+                grid[i] = std::max(distance, 0.0);
+            }
+        }
+        return grid;
+    }
+}
+
+void rainbow::graphics::make_distance_field(const uint8_t* bitmap,
+                                            const Vec2u& size,
+                                            int pitch,
+                                            unsigned int padding,
+                                            float spread,
+                                            uint8_t* out)
+{
+    const int width = size.x + padding * 2;
+    const int height = size.y + padding * 2;
+    const size_t area = width * height;
+
+    std::vector<double> coverage(area, 0.0);
+    for (unsigned int y = 0; y < size.y; ++y)
+    {
+        const uint8_t* row = bitmap + y * pitch;
+        const size_t offset = (y + padding) * width + padding;
+        for (unsigned int x = 0; x < size.x; ++x)
+            coverage[offset + x] = row[x] / 255.0;
+    }
+
+    // Estimate the edge normal of partially covered pixels with a Sobel
+    // filter. Pixels outside the bitmap are not covered.
+    auto at = [&coverage, width, height](int x, int y) {
+        return x < 0 || x >= width || y < 0 || y >= height
+                   ? 0.0
+                   : coverage[y * width + x];
+    };
+    std::vector<double> gx(area, 0.0);
+    std::vector<double> gy(area, 0.0);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const int i = y * width + x;
+            if (coverage[i] <= 0.0 || coverage[i] >= 1.0)
+                continue;
+
+            gx[i] = -at(x - 1, y - 1) - kSqrt2 * at(x - 1, y) -
+                    at(x - 1, y + 1) + at(x + 1, y - 1) +
+                    kSqrt2 * at(x + 1, y) + at(x + 1, y + 1);
+            gy[i] = -at(x - 1, y - 1) - kSqrt2 * at(x, y - 1) -
+                    at(x + 1, y - 1) + at(x - 1, y + 1) +
+                    kSqrt2 * at(x, y + 1) + at(x + 1, y + 1);
+        }
+    }
+
+    // |outside| holds, for every pixel, the distance to the edge if outside
+    // the glyph; |inside|, if inside. The inside is found the same way, with
+    // coverage inverted.
+    const std::vector<double> outside =
+        distance_to_coverage(coverage, gx, gy, width, height);
+    for (auto&& a : coverage)
+        a = 1.0 - a;
+    const std::vector<double> inside =
+        distance_to_coverage(coverage, gx, gy, width, height);
+
+    const double scale = 0.5 / spread;
+    for (size_t i = 0; i < area; ++i)
+    {
+        const double distance = inside[i] - outside[i];
+        const double value =
+            std::min(std::max(0.5 + distance * scale, 0.0), 1.0);
+        out[i] = static_cast<uint8_t>(std::lround(value * 255.0));
+    }
+}
@@ -0,0 +1,46 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef GRAPHICS_DISTANCEFIELD_H_
+#define GRAPHICS_DISTANCEFIELD_H_
+
+#include <cstdint>
+
+#include "Math/Vec2.h"
+
+namespace rainbow { namespace graphics
+{
+    /// <summary>
+    ///   Generates a signed distance field from an 8-bit coverage bitmap.
+    /// </summary>
+    /// <remarks>
+    ///   Edges pass through partially covered pixels, offset from their
+    ///   centres by their coverage, so that anti-aliased edges keep their
+    ///   sub-pixel position. Distances are Euclidean distances to the
+    ///   nearest pixel on the other side of the edge, found with Felzenszwalb
+    ///   and Huttenlocher's algorithm, plus that pixel's offset to the edge.
+    ///   Output values are 128 on the edge, increasing inside, and reach 0 and
+    ///   255 at <paramref name="spread"/> pixels away from it.
+    /// </remarks>
+    /// <param name="bitmap">Coverage bitmap.</param>
+    /// <param name="size">Width and height of the bitmap.</param>
+    /// <param name="pitch">Number of bytes per row of the bitmap.</param>
+    /// <param name="padding">
+    ///   Number of pixels to add around the bitmap. Should be at least
+    ///   <paramref name="spread"/> to fit the whole field.
+    /// </param>
+    /// <param name="spread">Distance, in pixels, covered by the field.</param>
+    /// <param name="out">
+    ///   [out] Distance field of the bitmap with padding, one byte per pixel
+    ///   with no gaps between rows.
+    /// </param>
+    void make_distance_field(const uint8_t* bitmap,
+                             const Vec2u& size,
+                             int pitch,
+                             unsigned int padding,
+                             float spread,
+                             uint8_t* out);
+}}  // namespace rainbow::graphics
+
+#endif
@@ -0,0 +1,119 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include "Graphics/DynamicBatch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Graphics/Renderer.h"
+#include "Graphics/SpriteBatch.h"
+
+using rainbow::graphics::DynamicBatch;
+
+namespace
+{
+    /// <summary>
+    ///   Expands an instance into the four vertices of its quad, the same way
+    ///   <c>Fixed2DInstanced.vsh</c> does.
+    /// </summary>
+    auto expand(const SpriteInstance& instance, SpriteVertex* out)
+        -> SpriteVertex*
+    {
+        const Vec2f corners[]{{0.0f, 0.0f},
+                              {1.0f, 0.0f},
+                              {1.0f, 1.0f},
+                              {0.0f, 1.0f}};
+        const Vec2f uv0{instance.texcoord[0] / 65535.0f,
+                        instance.texcoord[1] / 65535.0f};
+        const Vec2f uv2{instance.texcoord[2] / 65535.0f,
+                        instance.texcoord[3] / 65535.0f};
+        const Vec2f origin{instance.pivot.x, 1.0f - instance.pivot.y};
+        const float c = std::cos(instance.angle);
+        const float s = std::sin(instance.angle);
+        for (auto&& corner : corners)
+        {
+            const Vec2f p{instance.extent.x * (corner.x - origin.x),
+                          instance.extent.y * (corner.y - origin.y)};
+            out->color = instance.color;
+            out->texcoord = {uv0.x + (uv2.x - uv0.x) * corner.x,
+                             uv0.y + (uv2.y - uv0.y) * corner.y};
+            out->position = {instance.center.x + c * p.x + s * p.y,
+                             instance.center.y + c * p.y - s * p.x};
+            ++out;
+        }
+        return out;
+    }
+}
+
+bool DynamicBatch::can_merge(const SpriteBatch& a, const SpriteBatch& b)
+{
+    return a.has_same_textures(b) && a.normals() == nullptr &&
+           b.normals() == nullptr && !a.is_instanced() && !b.is_instanced();
+}
+
+DynamicBatch::DynamicBatch()
+    : vertices_(nullptr), count_(0), first_(nullptr), size_(0)
+{
+}
+
+DynamicBatch::DynamicBatch(
+    const rainbow::ISolemnlySwearThatIAmOnlyTesting& test)
+    : buffer_(test), vertices_(nullptr), count_(0), first_(nullptr), size_(0)
+{
+}
+
+void DynamicBatch::assign(const SpriteBatch* const* batches, size_t count)
+{
+    first_ = count > 0 ? batches[0] : nullptr;
+    size_ = count;
+    count_ = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (batches[i]->is_visible())
+            count_ += batches[i]->size() * 4;
+    }
+
+    if (count_ == 0)
+    {
+        vertices_ = nullptr;
+        return;
+    }
+
+    vertices_ = buffer_.map(count_);
+    auto out = vertices_;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const SpriteBatch& batch = *batches[i];
+        if (!batch.is_visible())
+            continue;
+
+        if (batch.is_instanced())
+        {
+            const SpriteInstance* instances = batch.instances();
+            for (size_t j = 0; j < batch.size(); ++j)
+                out = expand(instances[j], out);
+        }
+        else
+        {
+            out = std::copy_n(batch.vertices(), batch.size() * 4, out);
+        }
+    }
+}
+
+void DynamicBatch::draw()
+{
+    if (count_ == 0)
+        return;
+
+    buffer_.unmap(count_);
+    vertices_ = nullptr;
+
+    first_->bind_textures();
+    buffer_.draw_elements(vertex_count());
+
+#ifndef NDEBUG
+    detail::g_draws_saved_accumulator += size_ - 1;
+#endif
+}
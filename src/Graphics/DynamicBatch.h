@@ -0,0 +1,66 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef GRAPHICS_DYNAMICBATCH_H_
+#define GRAPHICS_DYNAMICBATCH_H_
+
+#include "Graphics/StreamingBuffer.h"
+
+class SpriteBatch;
+
+namespace rainbow { namespace graphics
+{
+    /// <summary>
+    ///   Draws several sprite batches with a single draw call by copying their
+    ///   vertices straight into a streaming vertex buffer every frame.
+    /// </summary>
+    /// <remarks>
+    ///   Batches must use the same texture atlas and program, and cannot have
+    ///   normal maps. They are drawn in the order they are assigned. Instanced
+    ///   batches are expanded into vertices, but are never merged.
+    /// </remarks>
+    class DynamicBatch : private NonCopyable<DynamicBatch>
+    {
+    public:
+        /// <summary>
+        ///   Returns whether <paramref name="a"/> and <paramref name="b"/> can
+        ///   be drawn together. Programs must be compared by the caller.
+        /// </summary>
+        static bool can_merge(const SpriteBatch& a, const SpriteBatch& b);
+
+        DynamicBatch();
+        explicit DynamicBatch(const rainbow::ISolemnlySwearThatIAmOnlyTesting&);
+
+        /// <summary>Returns the number of batches assigned.</summary>
+        auto size() const { return size_; }
+
+        /// <summary>Returns the vertex count.</summary>
+        auto vertex_count() const { return count_ / 4 * 6; }
+
+        /// <summary>
+        ///   Returns the vertices written by the last <see cref="assign"/>.
+        ///   Only valid until <see cref="draw"/>, and only readable when the
+        ///   streaming buffer falls back to orphaning.
+        /// </summary>
+        auto vertices() const -> const SpriteVertex* { return vertices_; }
+
+        /// <summary>
+        ///   Writes the vertices of <paramref name="count"/> batches into the
+        ///   streaming buffer.
+        /// </summary>
+        void assign(const SpriteBatch* const* batches, size_t count);
+
+        /// <summary>Draws the assigned batches.</summary>
+        void draw();
+
+    private:
+        StreamingBuffer buffer_;
+        SpriteVertex* vertices_;    ///< Mapped vertex buffer.
+        size_t count_;              ///< Number of vertices written.
+        const SpriteBatch* first_;  ///< Provides textures.
+        size_t size_;               ///< Number of batches merged.
+    };
+}}  // namespace rainbow::graphics
+
+#endif
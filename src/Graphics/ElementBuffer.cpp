@@ -4,10 +4,43 @@
 
 #include "Graphics/ElementBuffer.h"
 
+#include <memory>
+
+#include "Common/Algorithm.h"
 #include "Graphics/OpenGL.h"
+#include "Graphics/Renderer.h"
 
 using rainbow::graphics::ElementBuffer;
 
+namespace
+{
+    bool supports_32bit_indices()
+    {
+#ifdef GL_ES_VERSION_2_0
+        static const bool supported =
+            rainbow::graphics::has_extension("GL_OES_element_index_uint");
+        return supported;
+#else
+        return true;
+#endif
+    }
+
+    template <typename T>
+    void upload_indices(size_t quads)
+    {
+        const size_t count = quads * 6;
+        auto indices = std::make_unique<T[]>(count);
+        rainbow::graphics::generate_quad_indices(
+            ArraySpan<T>(indices.get(), count));
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                     count * sizeof(T),
+                     indices.get(),
+                     GL_STATIC_DRAW);
+    }
+}
+
+constexpr size_t ElementBuffer::kInitialCapacity;
+
 ElementBuffer::~ElementBuffer()
 {
     if (buffer_ == 0)
@@ -22,6 +55,53 @@ void ElementBuffer::bind() const
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer_);
 }
 
+auto ElementBuffer::reserve(size_t count) -> size_t
+{
+    const size_t quads = (count + 5) / 6;
+    if (quads <= capacity_)
+        return count;
+
+    size_t capacity = std::max(capacity_, kInitialCapacity);
+    while (capacity < quads)
+        capacity *= 2;
+
+    bind();
+    if (capacity <= kMaxQuadsPerShortIndex)
+    {
+        upload_indices<GLushort>(capacity);
+        type_ = GL_UNSIGNED_SHORT;
+    }
+    else if (supports_32bit_indices())
+    {
+        upload_indices<GLuint>(capacity);
+        type_ = GL_UNSIGNED_INT;
+    }
+    else
+    {
+        // Quads past the limit cannot be addressed, and would go missing
+        // without a trace. Make it impossible to miss.
+        R_ABORT("32-bit indices are unsupported; cannot draw %zu quads in a "
+                "single call (max %zu)",
+                quads,
+                kMaxQuadsPerShortIndex);
+        LOGE("32-bit indices are unsupported; dropped %zu of %zu quads",
+             quads - kMaxQuadsPerShortIndex,
+             quads);
+        if (capacity_ < kMaxQuadsPerShortIndex)
+        {
+            upload_indices<GLushort>(kMaxQuadsPerShortIndex);
+            type_ = GL_UNSIGNED_SHORT;
+            capacity_ = kMaxQuadsPerShortIndex;
+        }
+        return capacity_ * 6;
+    }
+
+    R_ASSERT(glGetError() == GL_NO_ERROR, "Failed to upload element buffer");
+
+    capacity_ = capacity;
+    return count;
+}
+
 void ElementBuffer::upload(const void* data, size_t size) const
 {
     bind();
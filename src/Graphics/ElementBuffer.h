@@ -7,14 +7,74 @@
 
 #include <cstdlib>
 
+#include "Memory/Array.h"
+
 namespace rainbow { namespace graphics
 {
+    /// <summary>
+    ///   Largest number of quads addressable with 16-bit indices.
+    /// </summary>
+    constexpr size_t kMaxQuadsPerShortIndex = 65536 / 4;
+
+    /// <summary>
+    ///   Fills <paramref name="indices"/> with quad indices, starting at quad
+    ///   <paramref name="first"/>. Each quad is drawn as two triangles, 0,1,2
+    ///   and 2,3,0.
+    /// </summary>
+    template <typename T>
+    void generate_quad_indices(ArraySpan<T> indices, size_t first = 0)
+    {
+        const size_t count = indices.size() / 6;
+        T* i = indices.data();
+        for (size_t quad = first; quad < first + count; ++quad)
+        {
+            const T v = static_cast<T>(quad * 4);
+            *i++ = v;
+            *i++ = v + 1;
+            *i++ = v + 2;
+            *i++ = v + 2;
+            *i++ = v + 3;
+            *i++ = v;
+        }
+    }
+
+    /// <summary>
+    ///   Index buffer shared by all quad-based drawables (sprite batches,
+    ///   labels). Grows on demand and switches to 32-bit indices when 16-bit
+    ///   indices can no longer address all vertices.
+    /// </summary>
     class ElementBuffer
     {
     public:
+        /// <summary>Number of quads initially reserved for.</summary>
+        static constexpr size_t kInitialCapacity = 4096;
+
         ~ElementBuffer();
 
+        /// <summary>Returns number of quads this buffer can index.</summary>
+        auto capacity() const { return capacity_; }
+
+        /// <summary>Returns the index type, e.g. GL_UNSIGNED_SHORT.</summary>
+        auto type() const { return type_; }
+
         void bind() const;
+
+        /// <summary>
+        ///   Ensures that <paramref name="count"/> indices can be drawn,
+        ///   growing the buffer if necessary.
+        /// </summary>
+        /// <returns>
+        ///   Number of indices that can be drawn. Less than
+        ///   <paramref name="count"/> only if the hardware does not support
+        ///   32-bit indices, in which case an error is logged for every such
+        ///   call. Debug builds abort instead.
+        /// </returns>
+        auto reserve(size_t count) -> size_t;
+
+        /// <summary>
+        ///   Replaces buffer contents with arbitrary indices. Used by buffers
+        ///   not shared with quad-based drawables.
+        /// </summary>
         void upload(const void* data, size_t size) const;
 
         ElementBuffer& operator=(unsigned int buffer)
@@ -25,6 +85,8 @@ namespace rainbow { namespace graphics
 
     private:
         unsigned int buffer_ = 0;
+        unsigned int type_ = 0;
+        size_t capacity_ = 0;
     };
 }}  // namespace rainbow::graphics
 
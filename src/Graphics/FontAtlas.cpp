@@ -4,7 +4,9 @@
 
 #include "Graphics/FontAtlas.h"
 
-#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 
 #ifdef __GNUC__
 #   pragma GCC diagnostic push
@@ -16,283 +18,727 @@
 #   pragma GCC diagnostic pop
 #endif
 
+#include "Common/Algorithm.h"
 #include "Common/Data.h"
+#include "Common/Logging.h"
+#include "Common/Profiler.h"
+#include "Common/UTF8.h"
+#include "Graphics/DistanceField.h"
+#include "Graphics/FontCache.h"
 #include "Graphics/OpenGL.h"
+#include "Graphics/Renderer.h"
 #include "Graphics/TextureManager.h"
+#include "Threading/JobSystem.h"
 
-using rainbow::array_size;
+using rainbow::JobSystem;
 using rainbow::Texture;
+using rainbow::graphics::FontCache;
+using rainbow::graphics::FontFace;
+using rainbow::graphics::make_distance_field;
+using rainbow::graphics::ShelfPacker;
 
 using uchar_t = unsigned char;
 using uint_t = unsigned int;
 
 namespace
 {
-    const float kGlyphMargin = 2.0f;     ///< Margin around rendered font glyph.
-    const uint_t kASCIIOffset = 32;      ///< Start loading from character 32.
-    const uint_t kDPI = 96;              ///< Horizontal/vertical resolution in dpi.
-    const uint_t kGlyphPadding = 3;      ///< Padding around font glyph texture.
-    const uint_t kGlyphPadding2 = kGlyphPadding * 2;
-    const int kNumGlyphsPerColRow = 12;  ///< Number of glyphs per column/row on texture.
-    const int kPixelFormat = 64;         ///< 26.6 fixed-point pixel coordinates.
+    const float kGlyphMargin = 2.0f;    ///< Margin around rendered font glyph.
+    const uint_t kGlyphPadding = 3;     ///< Padding around font glyph texture.
+    const uint_t kGlyphsPerRow = 16;    ///< Glyphs per row on a texture page.
+    const uint_t kMinEvictions = 32;    ///< Glyphs evicted at a time.
+    const uint_t kMinPageSize = 256;
+    const uint_t kMaxPageSize = 2048;
+    const int kPixelFormat = 64;        ///< 26.6 fixed-point pixel coordinates.
+
+    // Besides printable ASCII, these glyphs are rasterised in the background
+    // when a font is created.
+    const uint32_t kCommonCharacters[]{
+        0x00c5,  // LATIN CAPITAL LETTER A WITH RING ABOVE
+        0x00c6,  // LATIN CAPITAL LETTER AE
+        0x00d8,  // LATIN CAPITAL LETTER O WITH STROKE
+        0x00e5,  // LATIN SMALL LETTER A WITH RING ABOVE
+        0x00e6,  // LATIN SMALL LETTER AE
+        0x00f8,  // LATIN SMALL LETTER O WITH STROKE
+    };
+    const uint32_t kFirstPrintable = 0x20;  ///< SPACE
+    const uint32_t kLastPrintable = 0x7e;   ///< TILDE
+
+    unsigned int g_atlas_count = 0;
 
+    /// <summary>
+    ///   Copies an 8-bit bitmap into a GL_LUMINANCE_ALPHA buffer. Luminance is
+    ///   always white; alpha is the coverage.
+    /// </summary>
     void copy_bitmap_into(uchar_t* dst,
                           const Vec2u& dst_sz,
                           const Vec2u& off,
                           const uchar_t* src,
-                          const Vec2u& src_sz)
+                          const Vec2u& src_sz,
+                          int src_pitch)
     {
-        const size_t stride = (dst_sz.x - src_sz.x) * 2;
-        size_t i = 0;
-        uchar_t* ptr = dst + (off.y * dst_sz.x + off.x) * 2;
         for (uint_t y = 0; y < src_sz.y; ++y)
         {
+            uchar_t* ptr = dst + ((off.y + y) * dst_sz.x + off.x) * 2;
+            const uchar_t* row = src + y * src_pitch;
             for (uint_t x = 0; x < src_sz.x; ++x)
             {
-                *ptr = std::numeric_limits<uchar_t>::max();
-                *(++ptr) = src[i];
-                ++ptr;
-                ++i;
+                *ptr++ = std::numeric_limits<uchar_t>::max();
+                *ptr++ = row[x];
             }
-            ptr += stride;
         }
     }
 
-    Vec2u max_glyph_size(const FT_Face& face,
-                         const FontGlyph* glyphs,
-                         size_t count)
+    /// <summary>
+    ///   Returns the margin around a glyph's bitmap that is drawn. Distance
+    ///   fields extend beyond the glyph to make room for outlines and glows.
+    /// </summary>
+    float glyph_margin(FontAtlas::Mode mode)
     {
-        Vec2u max;
-        std::for_each(glyphs,
-                      glyphs + count,
-                      [&face, &max](const FontGlyph& glyph) {
-            if (FT_Load_Char(face, glyph.code, FT_LOAD_DEFAULT))
-            {
-                max.x = 0;
-                R_ABORT("Failed to load characters");
-                UNREACHABLE();
-                return;
-            }
-            const FT_Glyph_Metrics& metrics = face->glyph->metrics;
-            if (metrics.width > static_cast<FT_Pos>(max.x))
-                max.x = static_cast<Vec2u::value_type>(metrics.width);
-            if (metrics.height > static_cast<FT_Pos>(max.y))
-                max.y = static_cast<Vec2u::value_type>(metrics.height);
-        });
-        if (max.x == 0)
-            return Vec2u();
-        return Vec2u(max.x / kPixelFormat + kGlyphPadding2,
-                     max.y / kPixelFormat + kGlyphPadding2);
+        return mode == FontAtlas::Mode::DistanceField
+                   ? FontAtlas::kDistanceFieldSpread
+                   : kGlyphMargin;
     }
 
-    class FontFace
+    /// <summary>Returns the padding around a glyph's bitmap.</summary>
+    uint_t glyph_padding(FontAtlas::Mode mode)
     {
-    public:
-        FontFace(FT_Library library, const Data& font) : face_(nullptr)
+        return mode == FontAtlas::Mode::DistanceField
+                   ? FontAtlas::kDistanceFieldSpread + 1
+                   : kGlyphPadding;
+    }
+
+    /// <summary>
+    ///   Copies the bitmap of the glyph in <paramref name="slot"/> into
+    ///   <paramref name="dst"/>, inside the padding of the glyph's slot at
+    ///   <paramref name="origin"/>. In distance field mode, the slot is filled
+    ///   with the glyph's distance field, generated in
+    ///   <paramref name="scratch"/>.
+    /// </summary>
+    void copy_glyph_into(uchar_t* dst,
+                         const Vec2u& dst_sz,
+                         const Vec2u& origin,
+                         const FT_GlyphSlot slot,
+                         FontAtlas::Mode mode,
+                         std::vector<uint8_t>& scratch)
+    {
+        const FT_Bitmap& bitmap = slot->bitmap;
+        if (!bitmap.buffer)
+            return;
+
+        R_ASSERT(bitmap.num_grays == 256, "");
+        R_ASSERT(bitmap.pixel_mode == FT_PIXEL_MODE_GRAY, "");
+        const Vec2u size(bitmap.width, bitmap.rows);
+        const uint_t padding = glyph_padding(mode);
+        if (mode == FontAtlas::Mode::DistanceField)
         {
-            FT_Error error =
-                FT_New_Memory_Face(library,
-                                   static_cast<const FT_Byte*>(font.bytes()),
-                                   font.size(),
-                                   0,
-                                   &face_);
-            R_ASSERT(!error, "Failed to load font face");
-            R_ASSERT(FT_IS_SCALABLE(face_),
-                     "Unscalable fonts are not supported");
-            error = FT_Select_Charmap(face_, FT_ENCODING_UNICODE);
-            R_ASSERT(!error, "Failed to select character map");
-            static_cast<void>(error);
+            const Vec2u field_size(size.x + padding * 2, size.y + padding * 2);
+            scratch.resize(field_size.x * field_size.y);
+            make_distance_field(bitmap.buffer,
+                                size,
+                                bitmap.pitch,
+                                padding,
+                                FontAtlas::kDistanceFieldSpread,
+                                scratch.data());
+            copy_bitmap_into(
+                dst, dst_sz, origin, scratch.data(), field_size, field_size.x);
+            return;
         }
 
-        ~FontFace()
-        {
-            if (!face_)
-                return;
+        copy_bitmap_into(dst,
+                         dst_sz,
+                         origin + Vec2u(padding, padding),
+                         bitmap.buffer,
+                         size,
+                         bitmap.pitch);
+    }
 
-            FT_Done_Face(face_);
-        }
+    /// <summary>
+    ///   Loads and renders glyph <paramref name="c"/>. The face must be
+    ///   locked.
+    /// </summary>
+    /// <returns>
+    ///   <c>false</c> if the font does not have the glyph.
+    /// </returns>
+    bool load_glyph(FT_Face face, uint32_t c)
+    {
+        const FT_UInt index = FT_Get_Char_Index(face, c);
+        return index != 0 && FT_Load_Glyph(face, index, FT_LOAD_RENDER) == 0;
+    }
 
-        FT_Face operator->() const { return face_; }
-        explicit operator bool() const { return face_ != nullptr; }
-        operator const FT_Face&() const { return face_; }
+    /// <summary>
+    ///   Sets up <paramref name="glyph"/> from the glyph in
+    ///   <paramref name="slot"/>, placed at <paramref name="origin"/> on
+    ///   texture page <paramref name="page"/>.
+    /// </summary>
+    void set_glyph(FontGlyph& glyph,
+                   uint32_t c,
+                   const FT_GlyphSlot slot,
+                   uint_t page,
+                   const Vec2u& origin,
+                   uint_t page_size,
+                   FontAtlas::Mode mode)
+    {
+        const FT_Bitmap& bitmap = slot->bitmap;
+        const float margin = glyph_margin(mode);
+        const float padding = glyph_padding(mode);
 
-    private:
-        FT_Face face_;
-    };
+        glyph.code = c;
+        glyph.advance = slot->advance.x / kPixelFormat;
+        glyph.left = slot->bitmap_left;
+        glyph.page = page;
+
+        SpriteVertex* vx = glyph.quad;
+
+        vx[0].position.x = -margin;
+        vx[0].position.y = static_cast<float>(slot->bitmap_top -
+                                              static_cast<int>(bitmap.rows)) -
+                           margin;
+        vx[1].position.x = static_cast<float>(bitmap.width) + margin;
+        vx[1].position.y = vx[0].position.y;
+        vx[2].position.x = vx[1].position.x;
+        vx[2].position.y = static_cast<float>(slot->bitmap_top) + margin;
+        vx[3].position.x = vx[0].position.x;
+        vx[3].position.y = vx[2].position.y;
 
-    class FontLibrary
+        const float pixel = 1.0f / page_size;
+        vx[0].texcoord.x = (padding - margin + origin.x) * pixel;
+        vx[0].texcoord.y =
+            (padding + bitmap.rows + margin + origin.y) * pixel;
+        vx[1].texcoord.x =
+            (padding + bitmap.width + margin + origin.x) * pixel;
+        vx[1].texcoord.y = vx[0].texcoord.y;
+        vx[2].texcoord.x = vx[1].texcoord.x;
+        vx[2].texcoord.y = (padding - margin + origin.y) * pixel;
+        vx[3].texcoord.x = vx[0].texcoord.x;
+        vx[3].texcoord.y = vx[2].texcoord.y;
+    }
+
+    /// <summary>Returns the size of the slot needed for a bitmap.</summary>
+    auto slot_size(const FT_Bitmap& bitmap, FontAtlas::Mode mode)
     {
-    public:
-        FontLibrary() : library_(nullptr)
-        {
-            FT_Init_FreeType(&library_);
-            R_ASSERT(library_, "Failed to initialise FreeType");
-        }
+        // Rows of GL_LUMINANCE_ALPHA pixels must be 4-byte aligned for
+        // uploading.
+        const uint_t padding2 = glyph_padding(mode) * 2;
+        Vec2u size(bitmap.width + padding2, bitmap.rows + padding2);
+        size.x += size.x & 1;
+        return size;
+    }
 
-        ~FontLibrary()
+    /// <summary>
+    ///   Returns a cache key for unnamed font data. Keyed by contents, as the
+    ///   same address may be reused by a different font once freed.
+    /// </summary>
+    auto face_key(const Data& font)
+    {
+        // 64-bit FNV-1a
+        uint64_t hash = 0xcbf29ce484222325ull;
+        const auto bytes = static_cast<const uint8_t*>(font.bytes());
+        for (size_t i = 0; i < font.size(); ++i)
         {
-            if (!library_)
-                return;
-
-            FT_Done_FreeType(library_);
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
         }
+        return std::to_string(hash) + ':' + std::to_string(font.size());
+    }
+}
+
+/// <summary>
+///   Common glyphs rasterised on a worker thread onto a copy of the first
+///   texture page. Owned by the job until it is done.
+/// </summary>
+struct FontAtlas::Preload
+{
+    std::shared_ptr<FontFace> face;
+    const Mode mode;
+    ShelfPacker packer;
+    std::vector<uint8_t> bitmap;  ///< GL_LUMINANCE_ALPHA page.
+    std::vector<uint8_t> field;   ///< Scratch buffer for distance fields.
+    std::vector<CachedGlyph> glyphs;
+    uint_t rows;                  ///< Number of rows in use.
+    std::atomic<bool> done;
+
+    Preload(std::shared_ptr<FontFace> face_, Mode mode_, uint_t page_size)
+        : face(std::move(face_)), mode(mode_), packer(page_size, page_size),
+          rows(0), done(false)
+    {
+    }
 
-        explicit operator bool() const { return library_ != nullptr; }
-        operator const FT_Library&() const { return library_; }
+    void run();
+};
 
-    private:
-        FT_Library library_;
+void FontAtlas::Preload::run()
+{
+    R_PROFILE_ZONE("FontAtlas::Preload");
+
+    const uint_t page_size = packer.width();
+    bitmap.resize(page_size * page_size * 2);
+
+    auto rasterize = [this, page_size](uint32_t c) {
+        std::lock_guard<std::mutex> lock(face->mutex());
+        const FT_Face ft_face = face->get();
+        if (!load_glyph(ft_face, c))
+            return;
+
+        const FT_GlyphSlot slot = ft_face->glyph;
+        const Vec2u size = slot_size(slot->bitmap, mode);
+        Vec2u origin;
+        if (!packer.insert(size, origin))
+            return;
+
+        const Vec2u page(page_size, page_size);
+        copy_glyph_into(bitmap.data(), page, origin, slot, mode, field);
+        rows = std::max(rows, origin.y + size.y);
+
+        glyphs.emplace_back();
+        CachedGlyph& cached = glyphs.back();
+        cached.origin = origin;
+        cached.size = size;
+        cached.last_used = 0;
+        cached.retains = 0;
+        set_glyph(cached.glyph, c, slot, 0, origin, page_size, mode);
     };
+
+    for (uint32_t c = kFirstPrintable; c <= kLastPrintable; ++c)
+        rasterize(c);
+    for (uint32_t c : kCommonCharacters)
+        rasterize(c);
+
+    done.store(true, std::memory_order_release);
 }
 
-FontAtlas::FontAtlas(const char* path, float pt)
-    : FontAtlas(path, Data::load_asset(path), pt) {}
+constexpr unsigned int FontAtlas::kDistanceFieldSpread;
+constexpr unsigned int FontAtlas::kMaxPages;
+constexpr unsigned int FontAtlas::kMaxShapedLines;
 
-FontAtlas::FontAtlas(const char* name, const Data& font, float pt)
-    : pt_(pt), height_(0)
+FontAtlas::FontAtlas(const char* path, float pt, Mode mode)
+    : pt_(pt), mode_(mode), height_(0), page_size_(0), is_testing_(false),
+      name_(path), clock_(0)
 {
-    texture_ = TextureManager::Get()->create(
-        name,
-        [this, &font](TextureManager& texture_manager, const Texture& texture)
-        {
-            load(texture_manager, texture, font);
-        });
+    name_ += '#';
+    name_ += std::to_string(++g_atlas_count);
+
+    auto& cache = FontCache::Get();
+    auto face = cache.find(path, pt);
+    load(face ? std::move(face)
+              : cache.open(path, Data::load_asset(path), pt));
+}
+
+FontAtlas::FontAtlas(const char* name, const Data& font, float pt, Mode mode)
+    : pt_(pt), mode_(mode), height_(0), page_size_(0), is_testing_(false),
+      name_(name != nullptr ? name : ""), clock_(0)
+{
+    const std::string key = name_.empty() ? face_key(font) : name_;
+    name_ += '#';
+    name_ += std::to_string(++g_atlas_count);
+    load(FontCache::Get().open(key, font, pt));
+}
+
+FontAtlas::FontAtlas(const Data& font,
+                     float pt,
+                     const rainbow::ISolemnlySwearThatIAmOnlyTesting&,
+                     Mode mode)
+    : pt_(pt), mode_(mode), height_(0), page_size_(0), is_testing_(true),
+      clock_(0)
+{
+    load(FontCache::Get().open(face_key(font), font, pt));
+}
+
+FontAtlas::~FontAtlas() = default;
+
+void FontAtlas::bind(uint_t page) const
+{
+    R_ASSERT(page < pages_.size(), "Invalid texture page");
+
+    pages_[page].texture.bind();
+}
+
+auto FontAtlas::get_glyph(uint32_t c) -> const FontGlyph*
+{
+    if (!is_ready())
+        return &placeholder_;
+
+    auto i = glyphs_.find(c);
+    CachedGlyph* cached =
+        (i == glyphs_.end() ? rasterize(c) : &i->second);
+    if (cached == nullptr)
+        return nullptr;
+
+    cached->last_used = ++clock_;
+    return &cached->glyph;
+}
+
+bool FontAtlas::is_ready()
+{
+    if (preload_ && preload_->done.load(std::memory_order_acquire))
+        finish_preload();
+    return !preload_;
+}
+
+auto FontAtlas::kerning(uint32_t left, uint32_t right) -> int
+{
+    if (!face_ || !FT_HAS_KERNING(face_->get()))
+        return 0;
+
+    // Only pairs that are actually used are stored.
+    const uint64_t pair = (static_cast<uint64_t>(left) << 32) | right;
+    auto i = kerning_.find(pair);
+    if (i != kerning_.end())
+        return i->second;
+
+    std::lock_guard<std::mutex> lock(face_->mutex());
+
+    const FT_Face face = face_->get();
+    FT_Vector kerning{0, 0};
+    FT_Get_Kerning(face,
+                   FT_Get_Char_Index(face, left),
+                   FT_Get_Char_Index(face, right),
+                   FT_KERNING_DEFAULT,
+                   &kerning);
+    const int x = static_cast<int>(kerning.x / kPixelFormat);
+    kerning_.emplace(pair, x);
+    return x;
+}
+
+void FontAtlas::release(const FontGlyph& glyph)
+{
+    if (is_placeholder(glyph))
+        return;
+
+    auto i = glyphs_.find(glyph.code);
+    R_ASSERT(i != glyphs_.end() && i->second.retains > 0,
+             "Glyph was not retained");
+
+    --i->second.retains;
+}
+
+void FontAtlas::retain(const FontGlyph& glyph)
+{
+    if (is_placeholder(glyph))
+        return;
+
+    auto i = glyphs_.find(glyph.code);
+    R_ASSERT(i != glyphs_.end(), "Glyph is not in the cache");
+
+    ++i->second.retains;
 }
 
-auto FontAtlas::get_glyph(uint_t c) const -> const FontGlyph*
+auto FontAtlas::shape(const char* text, size_t length) -> const ShapedText&
 {
-#if FONTATLAS_EXTENDED > 0
-    if (c >= 0x80u)
+    std::string key(text, length);
+    auto i = shaped_.find(key);
+    if (i != shaped_.end())
     {
-        const auto first = charset_ + kNumCharacters;
-        const auto last = first + FONTATLAS_EXTENDED;
-        const auto i = std::find_if(first, last, [c](const FontGlyph& glyph) {
-            return glyph.code == c;
+        i->second.last_used = ++clock_;
+        return i->second.glyphs;
+    }
+
+    if (shaped_.size() >= kMaxShapedLines)
+        evict_shaped();
+
+    R_PROFILE_ZONE("FontAtlas::shape");
+
+    ShapedText glyphs;
+    glyphs.reserve(length);
+    uint32_t prev = 0;
+    rainbow::for_each_utf8(key.c_str(), [this, &glyphs, &prev](uint32_t c) {
+        glyphs.push_back({c, prev == 0 ? 0 : kerning(prev, c)});
+        prev = c;
+    });
+
+    auto& line = shaped_[std::move(key)];
+    line.glyphs = std::move(glyphs);
+    line.last_used = ++clock_;
+    return line.glyphs;
+}
+
+bool FontAtlas::add_page()
+{
+    if (pages_.size() >= kMaxPages)
+        return false;
+
+    pages_.emplace_back(page_size_);
+    if (is_testing_)
+        return true;
+
+    const std::string id = name_ + '/' + std::to_string(pages_.size());
+    pages_.back().texture = TextureManager::Get()->create(
+        id.c_str(),
+        [size = page_size_](TextureManager& texture_manager,
+                            const Texture& texture) {
+            // GL_LUMINANCE8_ALPHA8 buffer
+            const size_t length = size * size * 2;
+            auto buffer = std::make_unique<GLubyte[]>(length);
+            std::fill_n(buffer.get(), length, 0);
+            texture_manager.upload(texture,
+                                   GL_LUMINANCE_ALPHA,
+                                   size,
+                                   size,
+                                   GL_LUMINANCE_ALPHA,
+                                   buffer.get());
         });
-        return (i == last ? nullptr : i);
+    return true;
+}
+
+bool FontAtlas::evict(const Vec2u& size)
+{
+    std::vector<std::pair<uint64_t, uint32_t>> candidates;
+    for (auto&& i : glyphs_)
+    {
+        if (i.second.retains == 0)
+            candidates.emplace_back(i.second.last_used, i.first);
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    // Evict a few glyphs at a time so that the cost of finding candidates is
+    // spread over several insertions.
+    bool fits = false;
+    uint_t evicted = 0;
+    for (auto&& candidate : candidates)
+    {
+        if (fits && evicted >= kMinEvictions)
+            break;
+
+        auto i = glyphs_.find(candidate.second);
+        const CachedGlyph& cached = i->second;
+        free_slots_.push_back({cached.glyph.page, cached.origin, cached.size});
+        fits = fits || (cached.size.x >= size.x && cached.size.y >= size.y);
+        glyphs_.erase(i);
+        ++evicted;
+    }
+
+    return fits;
+}
+
+void FontAtlas::evict_shaped()
+{
+    // Evict the least recently used half.
+    std::vector<uint64_t> last_used;
+    last_used.reserve(shaped_.size());
+    for (auto&& line : shaped_)
+        last_used.push_back(line.second.last_used);
+
+    auto median = last_used.begin() + last_used.size() / 2;
+    std::nth_element(last_used.begin(), median, last_used.end());
+    for (auto i = shaped_.begin(); i != shaped_.end();)
+    {
+        if (i->second.last_used <= *median)
+            i = shaped_.erase(i);
+        else
+            ++i;
     }
-#endif
-    return &charset_[static_cast<uchar_t>(c) - kASCIIOffset];
 }
 
-void FontAtlas::load(TextureManager& texture_manager,
-                     const rainbow::Texture& texture,
-                     const Data& font)
+void FontAtlas::finish_preload()
 {
-    R_ASSERT(font, "Failed to load font");
+    R_PROFILE_ZONE("FontAtlas::finish_preload");
 
-    for (uint_t i = 0; i < kNumCharacters; ++i)
-        charset_[i].code = i + kASCIIOffset;
+    Preload& preload = *preload_;
+    Page& page = pages_.front();
+    if (!is_testing_ && preload.rows > 0)
+    {
+        TextureManager::Get()->upload_region(page.texture,
+                                             0,
+                                             0,
+                                             page_size_,
+                                             preload.rows,
+                                             GL_LUMINANCE_ALPHA,
+                                             preload.bitmap.data());
+    }
 
-#if FONTATLAS_EXTENDED > 0
-    const unsigned int characters[]{
-        0x00c5,  // LATIN CAPITAL LETTER A WITH RING ABOVE
-        0x00c6,  // LATIN CAPITAL LETTER AE
-        0x00d8,  // LATIN CAPITAL LETTER O WITH STROKE
-        0x00e5,  // LATIN SMALL LETTER A WITH RING ABOVE
-        0x00e6,  // LATIN SMALL LETTER AE
-        0x00f8,  // LATIN SMALL LETTER O WITH STROKE
-    };
-    for (size_t i = 0; i < array_size(characters); ++i)
-        charset_[kNumCharacters + i].code = characters[i];
-#endif
+    page.packer = std::move(preload.packer);
+    for (auto&& cached : preload.glyphs)
+        glyphs_.emplace(cached.glyph.code, cached);
 
-    FontLibrary library;
-    if (!library)
-        return;
+    preload_.reset();
+}
 
-    FontFace face(library, font);
+void FontAtlas::load(std::shared_ptr<FontFace> face)
+{
     if (!face)
         return;
 
-    FT_Set_Char_Size(face, 0, pt_ * kPixelFormat, kDPI, kDPI);
-    const Vec2u& max = max_glyph_size(face, charset_, array_size(charset_));
-    if (max.is_zero())
+    face_ = std::move(face);
+    height_ = face_->height();
+
+    const uint_t max_page_size =
+        is_testing_ ? kMaxPageSize
+                    : std::min<uint_t>(kMaxPageSize,
+                                       rainbow::graphics::max_texture_size());
+    page_size_ = rainbow::clamp(
+        rainbow::ceil_pow2((height_ + glyph_padding(mode_) * 2) *
+                           kGlyphsPerRow),
+        kMinPageSize,
+        max_page_size);
+
+    pages_.reserve(kMaxPages);
+    add_page();
+
+    placeholder_.code = 0;
+    placeholder_.advance = height_ / 2;
+    placeholder_.left = 0;
+    placeholder_.page = 0;
+    for (auto&& vx : placeholder_.quad)
+        vx = SpriteVertex{};
+
+    // Rasterising glyphs takes a while. Let a worker do it if there is one;
+    // otherwise, glyphs are rasterised on first use.
+    auto jobs = JobSystem::Get();
+    if (jobs == nullptr || jobs->worker_count() == 0)
         return;
-    const Vec2u size(rainbow::ceil_pow2(max.x * kNumGlyphsPerColRow),
-                     rainbow::ceil_pow2(max.y * kNumGlyphsPerColRow));
-
-    // GL_LUMINANCE8_ALPHA8 buffer
-    Vec2u offset(size.x * size.y * 2, 0);
-    auto buffer = std::make_unique<GLubyte[]>(offset.x);
-    std::fill_n(buffer.get(), offset.x, 0);
-
-    // Copy all glyph bitmaps to our texture.
-    offset.x = 0;
-    const Vec2f pixel(1.0f / size.x, 1.0f / size.y);
-    for (auto& glyph : charset_)
+
+    preload_ = std::make_shared<Preload>(face_, mode_, page_size_);
+    jobs->submit([preload = preload_] { preload->run(); });
+}
+
+auto FontAtlas::rasterize(uint32_t c) -> CachedGlyph*
+{
+    if (!face_)
+        return nullptr;
+
+    // Other fonts of the same size may be using the face on other threads.
+    std::lock_guard<std::mutex> lock(face_->mutex());
+
+    const FT_Face face = face_->get();
+    if (!load_glyph(face, c))
+        return nullptr;
+
+    const FT_GlyphSlot slot = face->glyph;
+    const Vec2u size = slot_size(slot->bitmap, mode_);
+
+    Slot region;
+    if (!reserve(size, region))
     {
-        FT_Load_Char(face, glyph.code, FT_LOAD_RENDER);
+        LOGE("FontAtlas: No room for glyph U+%04X", c);
+        return nullptr;
+    }
 
-        const FT_GlyphSlot& slot = face->glyph;
-        const FT_Bitmap& bitmap = slot->bitmap;
+    // Upload the whole slot so that any previous glyph is cleared.
+    if (!is_testing_)
+    {
+        const size_t length = region.size.x * region.size.y * 2;
+        if (bitmap_.size() < length)
+            bitmap_.resize(length);
+        std::fill_n(bitmap_.begin(), length, 0);
+        copy_glyph_into(
+            bitmap_.data(), region.size, Vec2u::Zero, slot, mode_, field_);
+        TextureManager::Get()->upload_region(pages_[region.page].texture,
+                                             region.origin.x,
+                                             region.origin.y,
+                                             region.size.x,
+                                             region.size.y,
+                                             GL_LUMINANCE_ALPHA,
+                                             bitmap_.data());
+    }
 
-        // Make sure bitmap data has enough space to the right. Otherwise, start
-        // a new line.
-        const uint_t width = bitmap.width + kGlyphPadding2;
-        if (offset.x + width > size.x)
-        {
-            offset.x = 0;
-            offset.y += max.y;
-        }
+    CachedGlyph& cached = glyphs_[c];
+    cached.origin = region.origin;
+    cached.size = region.size;
+    cached.last_used = 0;
+    cached.retains = 0;
+    set_glyph(cached.glyph,
+              c,
+              slot,
+              region.page,
+              region.origin,
+              page_size_,
+              mode_);
+    return &cached;
+}
 
-        // Copy bitmap data to texture.
-        if (bitmap.buffer)
+bool FontAtlas::recycle_page(const Vec2u& size, Slot& slot)
+{
+    std::vector<uint64_t> last_used(pages_.size(), 0);
+    for (auto&& i : glyphs_)
+    {
+        const CachedGlyph& cached = i.second;
+        auto& page_last_used = last_used[cached.glyph.page];
+        page_last_used = cached.retains > 0
+                             ? std::numeric_limits<uint64_t>::max()
+                             : std::max(page_last_used, cached.last_used);
+    }
+
+    const auto oldest = std::min_element(last_used.cbegin(), last_used.cend());
+    if (oldest == last_used.cend() ||
+        *oldest == std::numeric_limits<uint64_t>::max())
+    {
+        return false;
+    }
+
+    const auto page = static_cast<uint_t>(oldest - last_used.cbegin());
+    for (auto i = glyphs_.begin(); i != glyphs_.end();)
+    {
+        if (i->second.glyph.page == page)
+            i = glyphs_.erase(i);
+        else
+            ++i;
+    }
+    free_slots_.erase(std::remove_if(free_slots_.begin(),
+                                     free_slots_.end(),
+                                     [page](const Slot& free_slot) {
+                                         return free_slot.page == page;
+                                     }),
+                      free_slots_.end());
+
+    auto& packer = pages_[page].packer;
+    packer.clear();
+    if (!packer.insert(size, slot.origin))
+        return false;
+
+    slot.page = page;
+    slot.size = size;
+    return true;
+}
+
+bool FontAtlas::reserve(const Vec2u& size, Slot& slot)
+{
+    if (take_free_slot(size, slot))
+        return true;
+
+    for (uint_t i = 0; i < pages_.size(); ++i)
+    {
+        if (pages_[i].packer.insert(size, slot.origin))
         {
-            R_ASSERT(bitmap.num_grays == 256, "");
-            R_ASSERT(bitmap.pixel_mode == FT_PIXEL_MODE_GRAY, "");
-            copy_bitmap_into(buffer.get(), size, offset + kGlyphPadding,
-                             bitmap.buffer, Vec2u(bitmap.width, bitmap.rows));
+            slot.page = i;
+            slot.size = size;
+            return true;
         }
+    }
 
-        // Save font glyph data.
-        glyph.advance = slot->advance.x / kPixelFormat;
-        glyph.left = slot->bitmap_left;
+    if (add_page() && pages_.back().packer.insert(size, slot.origin))
+    {
+        slot.page = static_cast<uint_t>(pages_.size() - 1);
+        slot.size = size;
+        return true;
+    }
 
-        SpriteVertex* vx = glyph.quad;
+    if (evict(size) && take_free_slot(size, slot))
+        return true;
 
-        vx[0].position.x = -kGlyphMargin;
-        vx[0].position.y = static_cast<float>(slot->bitmap_top -
-                                              static_cast<int>(bitmap.rows)) -
-                           kGlyphMargin;
-        vx[1].position.x = static_cast<float>(bitmap.width) + kGlyphMargin;
-        vx[1].position.y = vx[0].position.y;
-        vx[2].position.x = vx[1].position.x;
-        vx[2].position.y = static_cast<float>(slot->bitmap_top) + kGlyphMargin;
-        vx[3].position.x = vx[0].position.x;
-        vx[3].position.y = vx[2].position.y;
+    // Evicted slots are too small. Start over on a page without retained
+    // glyphs instead.
+    return recycle_page(size, slot);
+}
 
-        vx[0].texcoord.x = (kGlyphPadding - kGlyphMargin + offset.x) * pixel.x;
-        vx[0].texcoord.y =
-            (kGlyphPadding + bitmap.rows + kGlyphMargin + offset.y) * pixel.y;
-        vx[1].texcoord.x =
-            (kGlyphPadding + bitmap.width + kGlyphMargin + offset.x) * pixel.x;
-        vx[1].texcoord.y = vx[0].texcoord.y;
-        vx[2].texcoord.x = vx[1].texcoord.x;
-        vx[2].texcoord.y = (kGlyphPadding - kGlyphMargin + offset.y) * pixel.y;
-        vx[3].texcoord.x = vx[0].texcoord.x;
-        vx[3].texcoord.y = vx[2].texcoord.y;
+bool FontAtlas::take_free_slot(const Vec2u& size, Slot& slot)
+{
+    auto best = free_slots_.end();
+    for (auto i = free_slots_.begin(); i != free_slots_.end(); ++i)
+    {
+        if (i->size.x < size.x || i->size.y < size.y)
+            continue;
 
-#ifdef FONTATLAS_KERNING
-        if (FT_HAS_KERNING(face))
+        if (best == free_slots_.end() ||
+            i->size.x * i->size.y < best->size.x * best->size.y)
         {
-            int i = -1;
-            FT_Vector kerning;
-            for (auto& left : charset_)
-            {
-                FT_Get_Kerning(
-                    face, left.code, glyph.code, FT_KERNING_DEFAULT, &kerning);
-                glyph.kern[++i] = static_cast<short>(kerning.x / kPixelFormat);
-            }
+            best = i;
         }
-#endif
-
-        // Advance to the next "slot" in our texture.
-        offset.x += width;
     }
 
-    height_ = face->size->metrics.height / kPixelFormat;
+    if (best == free_slots_.end())
+        return false;
 
-    texture_manager.upload(texture, GL_LUMINANCE_ALPHA, size.x, size.y,
-                           GL_LUMINANCE_ALPHA, buffer.get());
+    slot = *best;
+    *best = free_slots_.back();
+    free_slots_.pop_back();
+    return true;
 }
@@ -4,30 +4,54 @@
 
 #ifndef GRAPHICS_FONTATLAS_H_
 #define GRAPHICS_FONTATLAS_H_
-#define FONTATLAS_EXTENDED 6
-//#define FONTATLAS_KERNING
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "Graphics/FontGlyph.h"
+#include "Graphics/ShelfPacker.h"
 #include "Graphics/Texture.h"
 #include "Memory/SharedPtr.h"
 
 class Data;
-class TextureManager;
 
-namespace rainbow { class Texture; }
+namespace rainbow { namespace graphics { class FontFace; }}
 
 /// <summary>Uses FreeType to load OpenType and TrueType fonts.</summary>
 /// <remarks>
 ///   <para>
-///     Creates textures from font glyphs for symbols 32 through 126. Copies
-///     bitmap data into a larger buffer which is then used as texture.
+///     Glyphs are rasterised on first use and packed onto one or more texture
+///     pages. Only the new glyph is uploaded. When all pages are full, the
+///     least recently used glyphs that are no longer retained are evicted to
+///     make room.
+///   </para>
+///   <para>
+///     If the job system has workers, the most common glyphs are rasterised
+///     on a worker thread when the font is created. Until they have been
+///     uploaded, all glyphs are blank placeholders. FreeType faces are shared
+///     with other fonts of the same font file and size.
+///   </para>
+///   <para>
+///     Text is shaped one line at a time. Shaping applies pair kerning from
+///     the font's kerning table. Kerning pairs are looked up on first use, and
+///     shaped lines are cached so that the same text is not shaped again.
+///   </para>
+///   <para>
+///     In <see cref="Mode::DistanceField"/> mode, glyphs are stored as signed
+///     distance fields instead of coverage. A single atlas can then be drawn
+///     crisply at any scale and rotation, with optional outline and glow, but
+///     must be drawn with the distance field shader.
 ///   </para>
 ///   Features:
 ///   <list type="bullet">
 ///     <item>Anti-aliasing</item>
+///     <item>Any Unicode code point supported by the font</item>
 ///     <item>Kerning</item>
+///     <item>Signed distance fields</item>
 ///   </list>
-///   <para>TODO: Optimise texture size by sorting glyphs.</para>
 ///   References
 ///   <list type="bullet">
 ///     <item>http://iphone-3d-programming.labs.oreilly.com/ch07.html</item>
@@ -40,35 +64,202 @@ namespace rainbow { class Texture; }
 class FontAtlas : public RefCounted
 {
 public:
-    FontAtlas(const char* path, float pt);
-    FontAtlas(const char* name, const Data& font, float pt);
+    /// <summary>How glyphs are stored on texture pages.</summary>
+    enum class Mode
+    {
+        Bitmap,        ///< Coverage; drawn at the font's size.
+        DistanceField  ///< Signed distance; drawn at any size.
+    };
+
+    /// <summary>
+    ///   Distance, in pixels at the font's size, covered by distance fields.
+    ///   Outlines and glows can be at most this wide.
+    /// </summary>
+    static constexpr unsigned int kDistanceFieldSpread = 8;
+
+    /// <summary>Maximum number of texture pages per font.</summary>
+    static constexpr unsigned int kMaxPages = 4;
+
+    /// <summary>Maximum number of shaped lines kept in the cache.</summary>
+    static constexpr unsigned int kMaxShapedLines = 256;
+
+    /// <summary>A character positioned by the shaper.</summary>
+    struct ShapedGlyph
+    {
+        uint32_t code;  ///< UTF-32 code.
+        int kerning;    ///< Horizontal adjustment before the character.
+    };
+
+    using ShapedText = std::vector<ShapedGlyph>;
+
+    FontAtlas(const char* path, float pt, Mode mode = Mode::Bitmap);
+    FontAtlas(const char* name,
+              const Data& font,
+              float pt,
+              Mode mode = Mode::Bitmap);
+    FontAtlas(const Data& font,
+              float pt,
+              const rainbow::ISolemnlySwearThatIAmOnlyTesting&,
+              Mode mode = Mode::Bitmap);
+    ~FontAtlas();
+
+    /// <summary>Returns the number of glyphs in the cache.</summary>
+    auto glyph_count() const { return glyphs_.size(); }
+
+    /// <summary>Returns the number of shaped lines in the cache.</summary>
+    auto shaped_count() const { return shaped_.size(); }
 
     /// <summary>Returns the line height.</summary>
     auto height() const { return height_; }
 
+    /// <summary>
+    ///   Returns whether <paramref name="glyph"/> is a placeholder.
+    /// </summary>
+    bool is_placeholder(const FontGlyph& glyph) const
+    {
+        return &glyph == &placeholder_;
+    }
+
     /// <summary>Returns whether this FontAtlas is valid.</summary>
-    bool is_valid() const { return texture_; }
+    bool is_valid() const { return static_cast<bool>(face_); }
+
+    /// <summary>Returns how glyphs are stored.</summary>
+    auto mode() const { return mode_; }
+
+    /// <summary>Returns the number of texture pages in use.</summary>
+    auto page_count() const
+    {
+        return static_cast<unsigned int>(pages_.size());
+    }
+
+    /// <summary>Returns the width and height of a texture page.</summary>
+    auto page_size() const { return page_size_; }
 
-    /// <summary>Sets this font as active texture.</summary>
-    void bind() const { texture_.bind(); }
+    /// <summary>Sets texture page as active texture.</summary>
+    void bind(unsigned int page = 0) const;
 
-    /// <summary>Returns the glyph for character <paramref name="c"/>.</summary>
-    auto get_glyph(unsigned int c) const -> const FontGlyph*;
+    /// <summary>
+    ///   Returns the glyph for character <paramref name="c"/>, rasterising it
+    ///   if needed, or <c>nullptr</c> if the font does not have it. Returns a
+    ///   placeholder while the font is not ready.
+    /// </summary>
+    /// <remarks>
+    ///   The glyph may be evicted by the next call unless it is retained.
+    /// </remarks>
+    auto get_glyph(uint32_t c) -> const FontGlyph*;
 
-protected:
-    /// <summary>Load characters 32 through 126 from the ASCII table.</summary>
-    static const unsigned int kNumCharacters = 95;
+    /// <summary>
+    ///   Returns whether glyphs rasterised in the background have been
+    ///   uploaded, uploading them if they are done. Must be called on the
+    ///   rendering thread.
+    /// </summary>
+    bool is_ready();
+
+    /// <summary>
+    ///   Returns the horizontal kerning between characters
+    ///   <paramref name="left"/> and <paramref name="right"/>, in pixels at
+    ///   the font's size.
+    /// </summary>
+    auto kerning(uint32_t left, uint32_t right) -> int;
+
+    /// <summary>Releases a glyph previously retained.</summary>
+    void release(const FontGlyph& glyph);
+
+    /// <summary>Prevents a glyph from being evicted.</summary>
+    void retain(const FontGlyph& glyph);
+
+    /// <summary>
+    ///   Returns the first <paramref name="length"/> bytes of
+    ///   <paramref name="text"/> shaped with this font. The text must not
+    ///   contain line breaks.
+    /// </summary>
+    /// <remarks>
+    ///   The result may be evicted from the cache by the next call.
+    /// </remarks>
+    auto shape(const char* text, size_t length) -> const ShapedText&;
 
 private:
+    struct CachedGlyph
+    {
+        FontGlyph glyph;
+        Vec2u origin;          ///< Top left corner of the slot on its page.
+        Vec2u size;            ///< Size of the slot on its page.
+        uint64_t last_used;    ///< When the glyph was last requested.
+        unsigned int retains;  ///< Number of times the glyph is retained.
+    };
+
+    struct Page
+    {
+        rainbow::Texture texture;
+        rainbow::graphics::ShelfPacker packer;
+
+        explicit Page(unsigned int size) : packer(size, size) {}
+    };
+
+    struct Preload;
+
+    struct ShapedLine
+    {
+        ShapedText glyphs;
+        uint64_t last_used;  ///< When the line was last requested.
+    };
+
+    struct Slot
+    {
+        unsigned int page;
+        Vec2u origin;
+        Vec2u size;
+    };
+
     const float pt_;            ///< Font point size.
-    Colorb color_;              ///< Font colour.
+    const Mode mode_;           ///< How glyphs are stored.
     int height_;                ///< Font line height.
-    rainbow::Texture texture_;  ///< Texture name.
-    FontGlyph charset_[kNumCharacters + FONTATLAS_EXTENDED];  ///< Character set.
+    unsigned int page_size_;    ///< Width and height of a texture page.
+    bool is_testing_;           ///< Whether to skip texture uploads.
+    std::string name_;          ///< Prefix of texture page identifiers.
+    std::shared_ptr<rainbow::graphics::FontFace> face_;
+    std::shared_ptr<Preload> preload_;  ///< Glyphs rasterised in background.
+    FontGlyph placeholder_;             ///< Blank glyph used while loading.
+    std::unordered_map<uint32_t, CachedGlyph> glyphs_;
+    std::vector<Page> pages_;
+    std::vector<Slot> free_slots_;  ///< Slots of evicted glyphs.
+    std::vector<uint8_t> bitmap_;   ///< Scratch buffer for uploads.
+    std::vector<uint8_t> field_;    ///< Scratch buffer for distance fields.
+    std::unordered_map<uint64_t, int> kerning_;  ///< Kerning pairs looked up.
+    std::unordered_map<std::string, ShapedLine> shaped_;
+    uint64_t clock_;                ///< Incremented on every request.
+
+    /// <summary>Adds a texture page unless at the limit.</summary>
+    bool add_page();
+
+    /// <summary>
+    ///   Evicts unretained glyphs, least recently used first, until a slot
+    ///   that fits <paramref name="size"/> is freed.
+    /// </summary>
+    bool evict(const Vec2u& size);
+
+    /// <summary>Evicts the least recently used shaped lines.</summary>
+    void evict_shaped();
+
+    /// <summary>Uploads and adds glyphs rasterised in the background.</summary>
+    void finish_preload();
+
+    void load(std::shared_ptr<rainbow::graphics::FontFace> face);
+
+    /// <summary>
+    ///   Evicts all glyphs on the least recently used page without retained
+    ///   glyphs, and reserves a slot on it.
+    /// </summary>
+    bool recycle_page(const Vec2u& size, Slot& slot);
+
+    /// <summary>Rasterises and uploads glyph <paramref name="c"/>.</summary>
+    auto rasterize(uint32_t c) -> CachedGlyph*;
+
+    /// <summary>Finds a slot that fits <paramref name="size"/>.</summary>
+    bool reserve(const Vec2u& size, Slot& slot);
 
-    void load(TextureManager& texture_manager,
-              const rainbow::Texture& texture,
-              const Data& font);
+    /// <summary>Takes the smallest free slot that fits.</summary>
+    bool take_free_slot(const Vec2u& size, Slot& slot);
 };
 
 #endif
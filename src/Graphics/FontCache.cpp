@@ -0,0 +1,187 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include "Graphics/FontCache.h"
+
+#ifdef __GNUC__
+#   pragma GCC diagnostic push
+#   pragma GCC diagnostic ignored "-Wold-style-cast"
+#endif
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#ifdef __GNUC__
+#   pragma GCC diagnostic pop
+#endif
+
+#include "Common/Data.h"
+#include "Common/Logging.h"
+
+using rainbow::graphics::FontCache;
+using rainbow::graphics::FontFace;
+using rainbow::graphics::FontLibrary;
+
+namespace
+{
+    const FT_UInt kDPI = 96;      ///< Horizontal/vertical resolution in dpi.
+    const int kPixelFormat = 64;  ///< 26.6 fixed-point pixel coordinates.
+
+    /// <summary>Erases entries whose weak pointer has expired.</summary>
+    template <typename Map>
+    void prune(Map& map)
+    {
+        for (auto i = map.begin(); i != map.end();)
+        {
+            if (i->second.expired())
+                i = map.erase(i);
+            else
+                ++i;
+        }
+    }
+}
+
+namespace rainbow { namespace graphics
+{
+    /// <summary>FreeType library instance.</summary>
+    /// <remarks>
+    ///   Opening and closing faces modifies the library and must be done while
+    ///   holding <see cref="mutex"/>.
+    /// </remarks>
+    class FontLibrary : private NonCopyable<FontLibrary>
+    {
+    public:
+        FontLibrary() : library_(nullptr)
+        {
+            FT_Init_FreeType(&library_);
+            R_ASSERT(library_, "Failed to initialise FreeType");
+        }
+
+        ~FontLibrary()
+        {
+            if (library_ != nullptr)
+                FT_Done_FreeType(library_);
+        }
+
+        auto get() const { return library_; }
+        auto mutex() -> std::mutex& { return mutex_; }
+
+    private:
+        FT_Library library_;
+        std::mutex mutex_;
+    };
+}}  // namespace rainbow::graphics
+
+FontFace::FontFace(std::shared_ptr<FontLibrary> library,
+                   std::shared_ptr<const Bytes> font,
+                   float pt)
+    : library_(std::move(library)), font_(std::move(font)), face_(nullptr),
+      height_(0)
+{
+    if (library_->get() == nullptr)
+        return;
+
+    FT_Face face = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(library_->mutex());
+        const FT_Error error = FT_New_Memory_Face(
+            library_->get(), font_->data(), font_->size(), 0, &face);
+        R_ASSERT(!error, "Failed to load font face");
+        if (error)
+            return;
+    }
+
+    R_ASSERT(FT_IS_SCALABLE(face), "Unscalable fonts are not supported");
+    FT_Error error = FT_Select_Charmap(face, FT_ENCODING_UNICODE);
+    R_ASSERT(!error, "Failed to select character map");
+    error = FT_Set_Char_Size(face, 0, pt * kPixelFormat, kDPI, kDPI);
+    R_ASSERT(!error, "Failed to set character size");
+    static_cast<void>(error);
+
+    face_ = face;
+    height_ = face->size->metrics.height / kPixelFormat;
+}
+
+FontFace::~FontFace()
+{
+    if (face_ == nullptr)
+        return;
+
+    std::lock_guard<std::mutex> lock(library_->mutex());
+    FT_Done_Face(face_);
+}
+
+auto FontCache::Get() -> FontCache&
+{
+    static FontCache cache;
+    return cache;
+}
+
+auto FontCache::face_count() -> size_t
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (auto&& face : faces_)
+    {
+        if (!face.second.expired())
+            ++count;
+    }
+    return count;
+}
+
+auto FontCache::find(const std::string& name, float pt)
+    -> std::shared_ptr<FontFace>
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return find_locked({name, pt});
+}
+
+auto FontCache::open(const std::string& name, const Data& font, float pt)
+    -> std::shared_ptr<FontFace>
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const Key key{name, pt};
+    auto face = find_locked(key);
+    if (face)
+        return face;
+
+    // Font files are shared between sizes.
+    auto bytes = fonts_[name].lock();
+    if (!bytes)
+    {
+        // Drop fonts and faces that are no longer in use before adding more.
+        prune(fonts_);
+        prune(faces_);
+
+        R_ASSERT(font, "Failed to load font");
+        if (!font)
+            return {};
+
+        const auto data = static_cast<const uint8_t*>(font.bytes());
+        bytes = std::make_shared<const FontFace::Bytes>(
+            data, data + font.size());
+        fonts_[name] = bytes;
+    }
+
+    if (!library_)
+        library_ = std::make_shared<FontLibrary>();
+
+    face = std::make_shared<FontFace>(library_, std::move(bytes), pt);
+    if (!face->is_valid())
+        return {};
+
+    faces_[key] = face;
+    return face;
+}
+
+auto FontCache::find_locked(const Key& key) -> std::shared_ptr<FontFace>
+{
+    auto i = faces_.find(key);
+    if (i == faces_.end())
+        return {};
+
+    auto face = i->second.lock();
+    if (!face)
+        faces_.erase(i);
+    return face;
+}
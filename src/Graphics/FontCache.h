@@ -0,0 +1,111 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef GRAPHICS_FONTCACHE_H_
+#define GRAPHICS_FONTCACHE_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Common/NonCopyable.h"
+
+class Data;
+
+struct FT_FaceRec_;
+
+namespace rainbow { namespace graphics
+{
+    class FontLibrary;
+
+    /// <summary>A FreeType face set to a fixed size.</summary>
+    /// <remarks>
+    ///   Faces are shared by all font atlases of the same font and size. A
+    ///   face may only be used by one thread at a time; lock
+    ///   <see cref="mutex"/> while using it.
+    /// </remarks>
+    class FontFace : private NonCopyable<FontFace>
+    {
+    public:
+        using Bytes = std::vector<uint8_t>;
+
+        FontFace(std::shared_ptr<FontLibrary> library,
+                 std::shared_ptr<const Bytes> font,
+                 float pt);
+        ~FontFace();
+
+        /// <summary>Returns the FreeType face.</summary>
+        auto get() const { return face_; }
+
+        /// <summary>Returns the line height.</summary>
+        auto height() const { return height_; }
+
+        /// <summary>Returns whether the face was successfully opened.</summary>
+        bool is_valid() const { return face_ != nullptr; }
+
+        auto mutex() -> std::mutex& { return mutex_; }
+
+    private:
+        std::shared_ptr<FontLibrary> library_;
+        std::shared_ptr<const Bytes> font_;  ///< Referenced by the face.
+        FT_FaceRec_* face_;
+        int height_;
+        std::mutex mutex_;
+    };
+
+    /// <summary>
+    ///   Process-wide FreeType library and cache of open faces, keyed by font
+    ///   and size.
+    /// </summary>
+    /// <remarks>
+    ///   The cache does not keep faces alive; a face is closed when the last
+    ///   font atlas using it is destroyed. Font files are shared between
+    ///   sizes in the same way.
+    /// </remarks>
+    class FontCache : private NonCopyable<FontCache>
+    {
+    public:
+        static auto Get() -> FontCache&;
+
+        /// <summary>Returns the number of open faces.</summary>
+        auto face_count() -> size_t;
+
+        /// <summary>
+        ///   Returns font <paramref name="name"/> at <paramref name="pt"/> if
+        ///   it is open; <c>nullptr</c> otherwise.
+        /// </summary>
+        auto find(const std::string& name, float pt)
+            -> std::shared_ptr<FontFace>;
+
+        /// <summary>
+        ///   Returns font <paramref name="name"/> at <paramref name="pt"/>,
+        ///   opening it from <paramref name="font"/> if needed.
+        /// </summary>
+        /// <returns>
+        ///   The face, or <c>nullptr</c> if it could not be opened.
+        /// </returns>
+        auto open(const std::string& name, const Data& font, float pt)
+            -> std::shared_ptr<FontFace>;
+
+    private:
+        using Key = std::pair<std::string, float>;
+
+        std::mutex mutex_;
+        std::shared_ptr<FontLibrary> library_;
+        std::unordered_map<std::string, std::weak_ptr<const FontFace::Bytes>>
+            fonts_;
+        std::map<Key, std::weak_ptr<FontFace>> faces_;
+
+        FontCache() = default;
+
+        auto find_locked(const Key& key) -> std::shared_ptr<FontFace>;
+    };
+}}  // namespace rainbow::graphics
+
+#endif
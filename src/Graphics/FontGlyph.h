@@ -15,11 +15,8 @@ struct FontGlyph
     unsigned int code;     ///< UTF-32 code.
     int advance;           ///< Horizontal advancement.
     int left;              ///< Left alignment.
+    unsigned int page;     ///< Texture page the glyph is on.
     SpriteVertex quad[4];  ///< Sprite vertices.
-
-#ifdef FONTATLAS_KERNING
-    short int kern[95];    ///< Font kerning information for each character.
-#endif
 };
 
 #endif
@@ -0,0 +1,110 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include "Graphics/GpuTimer.h"
+
+#include "Common/Logging.h"
+#include "Common/Profiler.h"
+#include "Graphics/OpenGL.h"
+#include "Graphics/Renderer.h"
+
+// OpenGL ES 2.0 and legacy macOS contexts have no timer queries.
+#if !defined(GL_ES_VERSION_2_0) && !defined(RAINBOW_OS_MACOS)
+#   define USE_TIMER_QUERIES 1
+#endif
+
+using rainbow::graphics::GpuTimer;
+
+namespace
+{
+    bool supports_timer_queries()
+    {
+#ifdef USE_TIMER_QUERIES
+        static const bool supported =
+            rainbow::graphics::has_extension("GL_ARB_timer_query");
+        return supported;
+#else
+        return false;
+#endif
+    }
+}
+
+GpuTimer::GpuTimer() : queries_{}, next_(0), active_(nullptr) {}
+
+GpuTimer::~GpuTimer()
+{
+#ifdef USE_TIMER_QUERIES
+    for (auto&& query : queries_)
+    {
+        if (query.id != 0)
+            glDeleteQueries(1, &query.id);
+    }
+#endif
+}
+
+void GpuTimer::begin(const char* name)
+{
+    R_ASSERT(active_ == nullptr, "Timer queries cannot be nested");
+
+    if (!profiler::is_enabled() || !supports_timer_queries())
+        return;
+
+#ifdef USE_TIMER_QUERIES
+    collect();
+
+    // Skip this frame rather than wait if the GPU is lagging behind.
+    auto& query = queries_[next_];
+    if (query.name != nullptr)
+        return;
+
+    if (query.id == 0)
+        glGenQueries(1, &query.id);
+
+    query.name = name;
+    query.begin = profiler::now();
+    glBeginQuery(GL_TIME_ELAPSED, query.id);
+    active_ = &query;
+    next_ = (next_ + 1) % kNumQueries;
+#else
+    static_cast<void>(name);
+#endif
+}
+
+void GpuTimer::end()
+{
+    if (active_ == nullptr)
+        return;
+
+#ifdef USE_TIMER_QUERIES
+    glEndQuery(GL_TIME_ELAPSED);
+#endif
+    active_ = nullptr;
+}
+
+void GpuTimer::collect()
+{
+#ifdef USE_TIMER_QUERIES
+    // Queries finish in the order they were issued, starting with the oldest.
+    for (size_t i = 0; i < kNumQueries; ++i)
+    {
+        auto& query = queries_[(next_ + i) % kNumQueries];
+        if (query.name == nullptr)
+            continue;
+
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE)
+            break;
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &elapsed);
+        profiler::record({query.name,
+                          query.begin,
+                          query.begin + elapsed,
+                          profiler::kGpuThread,
+                          0});
+        query.name = nullptr;
+    }
+#endif
+}
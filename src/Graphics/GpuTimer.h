@@ -0,0 +1,60 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef GRAPHICS_GPUTIMER_H_
+#define GRAPHICS_GPUTIMER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "Common/NonCopyable.h"
+
+namespace rainbow { namespace graphics
+{
+    /// <summary>
+    ///   Times GPU work with timer queries and feeds the results to the
+    ///   profiler, a few frames late so that the CPU never waits on the GPU.
+    /// </summary>
+    /// <remarks>
+    ///   Timer queries cannot be nested. Zones are placed on the GPU thread at
+    ///   the time the commands were submitted. Does nothing while the profiler
+    ///   is disabled, or where timer queries are unavailable, e.g. on OpenGL
+    ///   ES 2.0.
+    /// </remarks>
+    class GpuTimer : private NonCopyable<GpuTimer>
+    {
+    public:
+        GpuTimer();
+        ~GpuTimer();
+
+        /// <summary>
+        ///   Starts timing commands as zone <paramref name="name"/>. The name
+        ///   must outlive the profiler.
+        /// </summary>
+        void begin(const char* name);
+
+        /// <summary>Stops timing commands.</summary>
+        void end();
+
+    private:
+        static constexpr size_t kNumQueries = 4;
+
+        struct Query
+        {
+            unsigned int id;
+            const char* name;  ///< Pending until the result has been read.
+            uint64_t begin;    ///< CPU time of submission.
+        };
+
+        std::array<Query, kNumQueries> queries_;
+        size_t next_;
+        Query* active_;
+
+        /// <summary>Records the results of finished queries.</summary>
+        void collect();
+    };
+}}  // namespace rainbow::graphics
+
+#endif
@@ -5,6 +5,8 @@
 #ifndef GRAPHICS_IMAGE_H_
 #define GRAPHICS_IMAGE_H_
 
+#include <vector>
+
 #include "Common/DataMap.h"
 
 namespace rainbow
@@ -14,8 +16,11 @@ namespace rainbow
         enum class Format
         {
             Unknown,
+            ASTC,   // OpenGL ES 3.2, Mali, PowerVR
             ATITC,  // Adreno
+            BPTC,   // Desktops
             ETC1,   // OpenGL ES standard
+            ETC2,   // OpenGL ES 3.0 standard
             PVRTC,  // iOS, OMAP43xx, PowerVR
             S3TC,   // Desktops, Tegra
             PNG,
@@ -27,7 +32,7 @@ namespace rainbow
         ///   Supports
         ///   <list type="bullet">
         ///     <item>iOS: PVRTC and whatever UIImage devours.</item>
-        ///     <item>Others: PNG.</item>
+        ///     <item>Others: PNG, KTX, and DDS.</item>
         ///   </list>
         ///   Limitations
         ///   <list type="bullet">
@@ -39,10 +44,22 @@ namespace rainbow
         ///       PVRTC: PVR3 only; square, power of 2; no mipmaps;
         ///       pre-multiplied alpha.
         ///     </item>
+        ///     <item>
+        ///       KTX: Version 1, compressed 2D textures only; no cube maps or
+        ///       arrays.
+        ///     </item>
+        ///     <item>DDS: DXT1, DXT3, DXT5, and BC7 only.</item>
         ///   </list>
         /// </remarks>
         static Image decode(const DataMap&, float scale);
 
+        /// <summary>Compressed mipmap level, beyond the first.</summary>
+        struct Mipmap
+        {
+            const byte_t* data;
+            size_t size;
+        };
+
         Format format = Format::Unknown;
         unsigned int width = 0;
         unsigned int height = 0;
@@ -51,12 +68,20 @@ namespace rainbow
         size_t size = 0;
         const byte_t* data = nullptr;
 
+        /// <summary>
+        ///   OpenGL format of compressed image data; 0 if not compressed.
+        /// </summary>
+        unsigned int internal_format = 0;
+
+        std::vector<Mipmap> mipmaps;
+
         Image() = default;
 
         Image(Image&& image)
             : format(image.format), width(image.width), height(image.height),
               depth(image.depth), channels(image.channels), size(image.size),
-              data(image.data)
+              data(image.data), internal_format(image.internal_format),
+              mipmaps(std::move(image.mipmaps))
         {
             image.format = Format::Unknown;
             image.width = 0;
@@ -65,14 +90,18 @@ namespace rainbow
             image.channels = 0;
             image.size = 0;
             image.data = nullptr;
+            image.internal_format = 0;
         }
 
         ~Image()
         {
             switch (format)
             {
+                case Format::ASTC:
                 case Format::ATITC:
+                case Format::BPTC:
                 case Format::ETC1:
+                case Format::ETC2:
                 case Format::PVRTC:
                 case Format::S3TC:
                     break;
@@ -94,6 +123,8 @@ namespace rainbow
 #   include "Graphics/Decoders/PNG.h"
 #   include "Graphics/Decoders/SVG.h"
 #endif
+#include "Graphics/Decoders/DDS.h"
+#include "Graphics/Decoders/KTX.h"
 #ifdef GL_IMG_texture_compression_pvrtc
 #   include "Graphics/Decoders/PVRTC.h"
 #endif  // GL_IMG_texture_compression_pvrtc
@@ -107,6 +138,16 @@ namespace rainbow
             return pvrtc::decode(data);
 #endif  // USE_PVRTC
 
+#ifdef USE_KTX
+        if (ktx::check(data))
+            return ktx::decode(data);
+#endif  // USE_KTX
+
+#ifdef USE_DDS
+        if (dds::check(data))
+            return dds::decode(data);
+#endif  // USE_DDS
+
 #ifdef USE_PNG
         if (png::check(data))
             return png::decode(data);
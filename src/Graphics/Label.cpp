@@ -6,7 +6,7 @@
 
 #include <cstring>
 
-#include "Common/UTF8.h"
+#include "Graphics/TextBatch.h"
 #include "Math/Transform.h"
 
 using rainbow::is_equal;
@@ -17,13 +17,33 @@ namespace
 }
 
 Label::Label()
-    : scale_(1.0f), alignment_(TextAlignment::Left), angle_(0.0f), count_(0),
-      stale_(0), width_(0),
-      cutoff_(std::numeric_limits<decltype(cutoff_)>::max()), size_(0)
+    : bounds_(rainbow::Rect::none()), scale_(1.0f),
+      alignment_(TextAlignment::Left), angle_(0.0f), count_(0), stale_(0),
+      width_(0), cutoff_(std::numeric_limits<decltype(cutoff_)>::max()),
+      size_(0), has_placeholders_(false),
+      dirty_offset_(std::numeric_limits<size_t>::max()),
+      first_dirty_(std::numeric_limits<unsigned int>::max()),
+      batch_(nullptr)
 {
     array_.reconfigure([this] { buffer_.bind(); });
 }
 
+Label::~Label()
+{
+    if (batch_ != nullptr)
+        batch_->remove(*this);
+    release_glyphs();
+}
+
+constexpr float Label::kMaxDistanceFieldScale;
+
+auto Label::scale() const -> float
+{
+    return !font_ || font_->mode() != FontAtlas::Mode::DistanceField
+               ? std::min(scale_, 1.0f)
+               : scale_;
+}
+
 void Label::set_alignment(TextAlignment a)
 {
     alignment_ = a;
@@ -38,15 +58,32 @@ void Label::set_color(Colorb c)
 
 void Label::set_font(SharedPtr<FontAtlas> f)
 {
+    release_glyphs();
+    runs_.clear();
+    has_placeholders_ = false;
     font_ = std::move(f);
     set_needs_update(kStaleBuffer);
 }
 
+void Label::set_glow(float width, Colorb color)
+{
+    glow_.width = rainbow::clamp<float>(
+        width, 0.0f, FontAtlas::kDistanceFieldSpread);
+    glow_.color = color;
+}
+
+void Label::set_outline(float width, Colorb color)
+{
+    outline_.width = rainbow::clamp<float>(
+        width, 0.0f, FontAtlas::kDistanceFieldSpread);
+    outline_.color = color;
+}
+
 void Label::set_position(const Vec2f& position)
 {
     position_.x = std::round(position.x);
     position_.y = std::round(position.y);
-    set_needs_update(kStaleBuffer);
+    set_needs_update(kStalePosition);
 }
 
 void Label::set_rotation(float r)
@@ -63,32 +100,47 @@ void Label::set_scale(float f)
     if (is_equal(f, scale_))
         return;
 
-    scale_ = rainbow::clamp(f, 0.01f, 1.0f);
+    scale_ = rainbow::clamp(f, 0.01f, kMaxDistanceFieldScale);
     set_needs_update(kStaleBuffer);
 }
 
 void Label::set_text(const char* text)
 {
-    const size_t len = strlen(text);
-    if (len > size_)
+    // Only characters from the first difference need to be laid out again.
+    size_t offset = 0;
+    if (text_)
     {
-        text_ = std::make_unique<char[]>(len + 1);
+        const char* current = text_.get();
+        while (current[offset] != '\0' && current[offset] == text[offset])
+            ++offset;
+        if (current[offset] == text[offset])
+            return;
+    }
+
+    const size_t len = offset + strlen(text + offset);
+    if (!text_ || len > size_)
+    {
+        auto str = std::make_unique<char[]>(len + 1);
+        std::copy_n(text, offset, str.get());
+        text_ = std::move(str);
         size_ = len;
         set_needs_update(kStaleBufferSize);
     }
-    std::copy_n(text, len, text_.get());
+    std::copy_n(text + offset, len - offset, text_.get() + offset);
     text_[len] = '\0';
-    set_needs_update(kStaleBuffer);
+    dirty_offset_ = std::min(dirty_offset_, offset);
+    set_needs_update(kStaleText);
 }
 
 void Label::move(const Vec2f& delta)
 {
     position_ += delta;
-    set_needs_update(kStaleBuffer);
+    set_needs_update(kStalePosition);
 }
 
 void Label::update()
 {
+    check_font();
     if (stale_)
     {
         update_internal();
@@ -97,63 +149,52 @@ void Label::update()
     }
 }
 
+void Label::check_font()
+{
+    if (has_placeholders_ && font_->is_ready())
+        set_needs_update(kStaleBuffer);
+}
+
 void Label::update_internal()
 {
-    // Note: This algorithm currently does not support font kerning.
-    if (stale_ & kStaleBuffer)
+    if (stale_ & kStaleBufferSize)
     {
-        if (stale_ & kStaleBufferSize)
-            vertices_ = std::make_unique<SpriteVertex[]>(size_ * 4);
-        width_ = 0;
-        unsigned int start = 0;
-        unsigned int count = 0;
-        const bool is_rotated = !is_equal(angle_, 0.0f);
-        const Vec2f R = (is_rotated ? Vec2f(cosf(-angle_), sinf(-angle_))
-                                    : Vec2f(1.0f, 0.0f));
-        const bool needs_alignment =
-            alignment_ != TextAlignment::Left || is_rotated;
-        Vec2f pen = (needs_alignment ? Vec2f::Zero : position_);
-        const float origin_x = pen.x;
-        SpriteVertex* vx = vertices_.get();
-
-        rainbow::for_each_utf8(
-            text_.get(),
-            [this, &start, &count, &pen, origin_x, R, needs_alignment, &vx](
-                uint32_t ch)
-            {
-                if (ch == '\n')
-                {
-                    save(start, count, pen.x - origin_x, R, needs_alignment);
-                    pen.x = origin_x;
-                    start = count;
-                    pen.y -= font_->height() * scale_;
-                    return;
-                }
-
-                const FontGlyph* glyph = font_->get_glyph(ch);
-                if (!glyph)
-                    return;
-
-                pen.x += glyph->left * scale_;
-
-                for (size_t i = 0; i < 4; ++i)
-                {
-                    vx->color = color_;
-                    vx->texcoord = glyph->quad[i].texcoord;
-                    vx->position = glyph->quad[i].position;
-                    vx->position *= scale_;
-                    vx->position += pen;
-                    ++vx;
-                }
-
-                pen.x += (glyph->advance - glyph->left) * scale_;
-                ++count;
-            });
+        auto vertices = std::make_unique<SpriteVertex[]>(size_ * 4);
+        if ((stale_ & kStaleBuffer) == 0)
+            std::copy_n(vertices_.get(), count_, vertices.get());
+        vertices_ = std::move(vertices);
+    }
+
+    // Nothing can be laid out until there is both text and a font.
+    if (!text_ || !font_)
+        return;
 
-        count_ = count * 4;
-        save(start, count, pen.x - origin_x, R, needs_alignment);
+    if ((stale_ & kStaleBuffer) || lines_.empty())
+        layout(0);
+    else if (stale_ & (kStaleText | kStalePosition))
+    {
+        size_t line = lines_.size();
+        if (stale_ & kStaleText)
+        {
+            // Find the line containing the first changed character.
+            line = std::upper_bound(lines_.cbegin(),
+                                    lines_.cend(),
+                                    dirty_offset_,
+                                    [](size_t offset, const Line& l) {
+                                        return offset < l.offset;
+                                    }) -
+                   lines_.cbegin() - 1;
+        }
+
+        // Lines that are kept only need to be moved.
+        translate(position_ - laid_out_at_, line);
+        if (line < lines_.size())
+            layout(line);
+        else
+            laid_out_at_ = position_;
     }
-    else if (stale_ & kStaleColor)
+
+    if ((stale_ & kStaleColor) && (stale_ & kStaleBuffer) == 0)
     {
         std::for_each(vertices_.get(),
                       vertices_.get() + count_,
@@ -161,15 +202,138 @@ void Label::update_internal()
                       {
                           v.color = color;
                       });
+        mark_dirty(0);
+    }
+
+    dirty_offset_ = std::numeric_limits<size_t>::max();
+}
+
+void Label::layout(size_t line)
+{
+    const bool is_rotated = !is_equal(angle_, 0.0f);
+    const Vec2f R = (is_rotated ? Vec2f(cosf(-angle_), sinf(-angle_))
+                                : Vec2f(1.0f, 0.0f));
+    const bool needs_alignment =
+        alignment_ != TextAlignment::Left || is_rotated;
+    const float scale = this->scale();
+    const float line_height = font_->height() * scale;
+    Vec2f pen = (needs_alignment ? Vec2f::Zero : position_);
+    const float origin_x = pen.x;
+    pen.y -= line_height * line;
+
+    size_t offset = 0;
+    unsigned int count = 0;
+    if (line > 0)
+    {
+        offset = lines_[line].offset;
+        count = lines_[line].first;
+    }
+    lines_.resize(line);
+    lines_.push_back({offset, count, 0.0f, rainbow::Rect::none()});
+
+    // Drop runs of characters that will be laid out again.
+    while (!runs_.empty() && runs_.back().first >= count)
+        runs_.pop_back();
+    if (!runs_.empty())
+        runs_.back().count = count - runs_.back().first;
+
+    // Glyphs in use must not be evicted from the font's cache. Retain the new
+    // glyphs before releasing the old ones so that glyphs in both are never
+    // evicted in between.
+    std::vector<const FontGlyph*> glyphs;
+    glyphs.reserve(glyphs_.size() - count);
+
+    const unsigned int first = count;
+    SpriteVertex* vx = vertices_.get() + count * 4;
+    const char* text = text_.get();
+    while (true)
+    {
+        const char* line = text + offset;
+        const char* end = strchr(line, '\n');
+        const size_t length = end == nullptr ? strlen(line) : end - line;
+        for (auto&& shaped : font_->shape(line, length))
+        {
+            const FontGlyph* glyph = font_->get_glyph(shaped.code);
+            if (!glyph)
+                continue;
+
+            font_->retain(*glyph);
+            glyphs.push_back(glyph);
+            if (runs_.empty() || runs_.back().page != glyph->page)
+                runs_.push_back({glyph->page, count, 0});
+            ++runs_.back().count;
+
+            pen.x += (shaped.kerning + glyph->left) * scale;
+
+            for (size_t i = 0; i < 4; ++i)
+            {
+                vx->color = color_;
+                vx->texcoord = glyph->quad[i].texcoord;
+                vx->position = glyph->quad[i].position;
+                vx->position *= scale;
+                vx->position += pen;
+                ++vx;
+            }
+
+            pen.x += (glyph->advance - glyph->left) * scale;
+            ++count;
+        }
+
+        if (end == nullptr)
+            break;
+
+        save(lines_.back(), count, pen.x - origin_x, R, needs_alignment);
+        pen.x = origin_x;
+        pen.y -= line_height;
+        offset += length + 1;
+        lines_.push_back({offset, count, 0.0f, rainbow::Rect::none()});
+    }
+    save(lines_.back(), count, pen.x - origin_x, R, needs_alignment);
+
+    std::for_each(glyphs_.cbegin() + first,
+                  glyphs_.cend(),
+                  [this](const FontGlyph* glyph) { font_->release(*glyph); });
+    glyphs_.resize(first);
+    glyphs_.insert(glyphs_.end(), glyphs.cbegin(), glyphs.cend());
+
+    has_placeholders_ = std::any_of(
+        glyphs_.cbegin(), glyphs_.cend(), [this](const FontGlyph* glyph) {
+            return font_->is_placeholder(*glyph);
+        });
+
+    count_ = count * 4;
+    width_ = 0;
+    bounds_ = rainbow::Rect::none();
+    for (auto&& l : lines_)
+    {
+        width_ = std::max<unsigned int>(width_, l.width);
+        bounds_.extend(l.bounds);
     }
+
+    laid_out_at_ = position_;
+    mark_dirty(first * 4);
 }
 
-void Label::upload() const
+void Label::release_glyphs()
 {
-    buffer_.upload(vertices_.get(), count_ * sizeof(vertices_[0]));
+    for (auto&& glyph : glyphs_)
+        font_->release(*glyph);
+    glyphs_.clear();
 }
 
-void Label::save(unsigned int start,
+void Label::upload()
+{
+    // Batched labels are uploaded by their batch.
+    if (batch_ != nullptr || first_dirty_ >= count_)
+        return;
+
+    const size_t size = count_ * sizeof(vertices_[0]);
+    const size_t offset = first_dirty_ * sizeof(vertices_[0]);
+    buffer_.upload(vertices_.get(), size, offset, size - offset);
+    first_dirty_ = std::numeric_limits<unsigned int>::max();
+}
+
+void Label::save(Line& line,
                  unsigned int end,
                  float width,
                  const Vec2f& R,
@@ -178,7 +342,7 @@ void Label::save(unsigned int start,
     if (needs_alignment)
     {
         std::for_each(
-            vertices_.get() + start * 4,
+            vertices_.get() + line.first * 4,
             vertices_.get() + end * 4,
             [
               offset = width * kAlignmentFactor[static_cast<int>(alignment_)],
@@ -191,6 +355,52 @@ void Label::save(unsigned int start,
                 v.position = rainbow::transform_srt(p, sin_r, cos_r, translate);
             });
     }
-    if (width > width_)
-        width_ = width;
+
+    line.width = width;
+    line.bounds = rainbow::Rect::none();
+    std::for_each(vertices_.get() + line.first * 4,
+                  vertices_.get() + end * 4,
+                  [&bounds = line.bounds](const SpriteVertex& v) {
+                      bounds.extend(v.position);
+                  });
+}
+
+void Label::translate(const Vec2f& delta, size_t lines)
+{
+    if (delta.is_zero() || lines == 0)
+        return;
+
+    const unsigned int end =
+        lines < lines_.size() ? lines_[lines].first * 4 : count_;
+    std::for_each(vertices_.get(),
+                  vertices_.get() + end,
+                  [delta](SpriteVertex& v) { v.position += delta; });
+
+    bounds_ = rainbow::Rect::none();
+    for (size_t i = 0; i < lines; ++i)
+    {
+        auto& bounds = lines_[i].bounds;
+        if (!bounds.is_empty())
+        {
+            bounds.left += delta.x;
+            bounds.bottom += delta.y;
+            bounds.right += delta.x;
+            bounds.top += delta.y;
+        }
+        bounds_.extend(bounds);
+    }
+    mark_dirty(0);
+}
+
+#ifdef RAINBOW_TEST
+Label::Label(const rainbow::ISolemnlySwearThatIAmOnlyTesting& test)
+    : bounds_(rainbow::Rect::none()), scale_(1.0f),
+      alignment_(TextAlignment::Left), angle_(0.0f), count_(0), stale_(0),
+      width_(0), cutoff_(std::numeric_limits<decltype(cutoff_)>::max()),
+      size_(0), has_placeholders_(false), buffer_(test),
+      dirty_offset_(std::numeric_limits<size_t>::max()),
+      first_dirty_(std::numeric_limits<unsigned int>::max()),
+      batch_(nullptr)
+{
 }
+#endif  // RAINBOW_TEST
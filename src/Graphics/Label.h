@@ -6,14 +6,25 @@
 #define GRAPHICS_LABEL_H_
 
 #include <memory>
+#include <vector>
 
 #include "Graphics/Buffer.h"
 #include "Graphics/FontAtlas.h"
 #include "Graphics/VertexArray.h"
+#include "Math/Geometry.h"
+
+class TextBatch;
 
 /// <summary>Label for displaying text.</summary>
+/// <remarks>
+///   Layout is incremental. Moving a label only translates its vertices, and
+///   changing its text only lays out the lines from the first changed
+///   character onwards. Only vertices that changed are uploaded.
+/// </remarks>
 class Label : private NonCopyable<Label>
 {
+    friend TextBatch;
+
 public:
     enum class TextAlignment
     {
@@ -25,23 +36,64 @@ public:
     static const unsigned int kStaleBuffer      = 1u << 0;
     static const unsigned int kStaleBufferSize  = 1u << 1;
     static const unsigned int kStaleColor       = 1u << 2;
+    static const unsigned int kStaleText        = 1u << 3;
+    static const unsigned int kStalePosition    = 1u << 4;
     static const unsigned int kStaleMask        = 0xffffu;
 
+    /// <summary>Outline or glow around text.</summary>
+    /// <remarks>Only drawn with distance field fonts.</remarks>
+    struct Effect
+    {
+        float width = 0.0f;  ///< Width in pixels at the font's size.
+        Colorb color;
+    };
+
+    /// <summary>Maximum scale of labels using distance field fonts.</summary>
+    static constexpr float kMaxDistanceFieldScale = 8.0f;
+
+    /// <summary>Consecutive characters on the same font texture page.</summary>
+    struct Run
+    {
+        unsigned int page;   ///< Font texture page.
+        unsigned int first;  ///< Index of the first character.
+        unsigned int count;  ///< Number of characters.
+    };
+
     Label();
-    virtual ~Label() = default;
+    virtual ~Label();
+
+    /// <summary>Returns the bounds of the text as of the last update.</summary>
+    auto bounds() const -> const rainbow::Rect& { return bounds_; }
 
     /// <summary>Returns label text color.</summary>
     auto color() const { return color_; }
 
+    /// <summary>Returns the glow around the text.</summary>
+    auto glow() const -> const Effect& { return glow_; }
+
     /// <summary>Returns the assigned font.</summary>
     auto font() const -> const FontAtlas& { return *font_.get(); }
 
     /// <summary>Returns the number of characters.</summary>
     auto length() const { return count_ / 4; }
 
+    /// <summary>Returns the outline around the text.</summary>
+    auto outline() const -> const Effect& { return outline_; }
+
     /// <summary>Returns label position.</summary>
     auto position() const -> const Vec2f& { return position_; }
 
+    /// <summary>
+    ///   Returns characters grouped by font texture page, in drawing order.
+    /// </summary>
+    auto runs() const -> const std::vector<Run>& { return runs_; }
+
+    /// <summary>
+    ///   Returns label scale as drawn. Labels using bitmap fonts are never
+    ///   scaled up.
+    /// </summary>
+    auto scale() const -> float;
+
     /// <summary>Returns the string.</summary>
     auto text() const { return text_.get(); }
 
@@ -57,6 +109,9 @@ public:
         return std::min(count_ + (count_ >> 1), cutoff_);
     }
 
+    /// <summary>Returns whether the label is drawn by a batch.</summary>
+    bool is_batched() const { return batch_ != nullptr; }
+
     /// <summary>Returns label width.</summary>
     auto width() const { return width_; }
 
@@ -69,6 +124,18 @@ public:
     /// <summary>Sets text font.</summary>
     void set_font(SharedPtr<FontAtlas>);
 
+    /// <summary>
+    ///   Sets glow around the text. A width of 0 disables it. Widths are
+    ///   clamped to the font's distance field spread.
+    /// </summary>
+    void set_glow(float width, Colorb color);
+
+    /// <summary>
+    ///   Sets outline around the text. A width of 0 disables it. Widths are
+    ///   clamped to the font's distance field spread.
+    /// </summary>
+    void set_outline(float width, Colorb color);
+
     /// <summary>Sets label as needing update.</summary>
     void set_needs_update(unsigned int what) { stale_ |= what; }
 
@@ -81,15 +148,19 @@ public:
     void set_rotation(float r);
 
     /// <summary>
-    ///   Sets label scale. Value is clamped between 0.01 and 1.0.
+    ///   Sets label scale. Value is clamped between 0.01 and 1.0, or
+    ///   <see cref="kMaxDistanceFieldScale"/> for distance field fonts.
     /// </summary>
     void set_scale(float f);
 
     /// <summary>Sets text to display.</summary>
     void set_text(const char*);
 
-    /// <summary>Binds all used textures.</summary>
-    void bind_textures() const { font_->bind(); }
+    /// <summary>Binds the font texture page of the first run.</summary>
+    void bind_textures() const
+    {
+        font_->bind(runs_.empty() ? 0 : runs_.front().page);
+    }
 
     /// <summary>Moves label by (x,y).</summary>
     void move(const Vec2f&);
@@ -97,6 +168,10 @@ public:
     /// <summary>Populates the vertex array.</summary>
     virtual void update();
 
+#ifdef RAINBOW_TEST
+    explicit Label(const rainbow::ISolemnlySwearThatIAmOnlyTesting&);
+#endif
+
 protected:
     int cutoff() const { return cutoff_ / 6; }
     void set_cutoff(int cutoff) { cutoff_ = cutoff * 6; }
@@ -105,16 +180,42 @@ protected:
     SpriteVertex* vertex_buffer() const { return vertices_.get(); }
 
     void clear_state() { stale_ = 0; }
+
+    /// <summary>
+    ///   Marks vertices from <paramref name="first"/> onwards as needing
+    ///   upload.
+    /// </summary>
+    void mark_dirty(unsigned int first)
+    {
+        first_dirty_ = std::min(first_dirty_, first);
+    }
+
+    /// <summary>
+    ///   Sets the label as needing update if it was laid out with placeholder
+    ///   glyphs and the font has since become ready.
+    /// </summary>
+    void check_font();
+
     void update_internal();
-    void upload() const;
+    void upload();
 
 private:
+    /// <summary>A laid out line of text.</summary>
+    struct Line
+    {
+        size_t offset;         ///< Byte offset of the line in the text.
+        unsigned int first;    ///< Index of the first character.
+        float width;           ///< Width of the line.
+        rainbow::Rect bounds;  ///< Bounds of the line.
+    };
+
     using String = std::unique_ptr<char[]>;
     using VertexBuffer = std::unique_ptr<SpriteVertex[]>;
 
     VertexBuffer vertices_;      ///< Client vertex buffer.
     String text_;                ///< Content of this label.
     Vec2f position_;             ///< Position of the text (bottom left).
+    rainbow::Rect bounds_;       ///< Bounds of the text.
     Colorb color_;               ///< Color of the text.
     float scale_;                ///< Label scale factor.
     TextAlignment alignment_;    ///< Text alignment.
@@ -124,21 +225,48 @@ private:
     unsigned int width_;         ///< Label width.
     unsigned int cutoff_;        ///< Number of characters to render.
     size_t size_;                ///< Size of the char array.
+    bool has_placeholders_;      ///< Whether the font was not ready.
+    Effect outline_;             ///< Outline around the text.
+    Effect glow_;                ///< Glow around the text.
     rainbow::graphics::Buffer buffer_;      ///< Vertex buffer.
     rainbow::graphics::VertexArray array_;  ///< Vertex array object.
     SharedPtr<FontAtlas> font_;  ///< The font used in this label.
+    std::vector<const FontGlyph*> glyphs_;  ///< Glyph of each character.
+    std::vector<Run> runs_;      ///< Characters grouped by texture page.
+    std::vector<Line> lines_;    ///< Lines as of the last layout.
+    Vec2f laid_out_at_;          ///< Position as of the last layout.
+    size_t dirty_offset_;        ///< Byte offset of first changed character.
+    unsigned int first_dirty_;   ///< First vertex that needs upload.
+    TextBatch* batch_;           ///< Batch drawing this label, if any.
+
+    /// <summary>
+    ///   Lays out text from line <paramref name="line"/> onwards, keeping
+    ///   the vertices and glyphs of preceding lines.
+    /// </summary>
+    void layout(size_t line);
 
-    /// <summary>Saves line width and aligns the line if needed.</summary>
-    /// <param name="start">First character of line.</param>
+    /// <summary>Releases all glyphs retained from the font.</summary>
+    void release_glyphs();
+
+    /// <summary>
+    ///   Saves line width and bounds, and aligns the line if needed.
+    /// </summary>
+    /// <param name="line">Line to save.</param>
     /// <param name="end">End character.</param>
     /// <param name="width">Width of line.</param>
     /// <param name="R">Rotation vector.</param>
     /// <param name="needs_alignment">Whether alignment is needed.</param>
-    void save(unsigned int start,
+    void save(Line& line,
               unsigned int end,
               float width,
               const Vec2f& R,
               bool needs_alignment);
+
+    /// <summary>
+    ///   Translates the first <paramref name="lines"/> lines by
+    ///   <paramref name="delta"/>.
+    /// </summary>
+    void translate(const Vec2f& delta, size_t lines);
 };
 
 #endif
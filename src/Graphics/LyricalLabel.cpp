@@ -162,12 +162,21 @@ void LyricalLabel::stop_animation(Animation animation)
 
 void LyricalLabel::update()
 {
+    check_font();
     if (state() != 0)
     {
         if ((state() & kStaleMask) != 0)
         {
+            // Attributes are applied on top of laid out vertices. Moving the
+            // label keeps them, but vertices that are kept when the text
+            // changes would get them applied twice.
+            if (applied_ > 0 && (state() & kStaleText))
+                set_needs_update(kStaleBuffer);
+            const bool keeps_attributes =
+                (state() & kStaleMask) == kStalePosition;
             update_internal();
-            applied_ = 0;
+            if (!keeps_attributes)
+                applied_ = 0;
         }
 
         auto buffer = vertex_buffer();
@@ -175,6 +184,7 @@ void LyricalLabel::update()
         {
             const auto& attr = attributes_[applied_];
             const Vec2u interval = get_interval(attr);
+            mark_dirty(interval.x);
             switch (attr.type)
             {
                 case Attribute::Type::Color:
@@ -223,6 +233,7 @@ void LyricalLabel::undo_from(std::vector<Attribute>::const_iterator first)
     for (auto attr = first; attr != attributes_.cend(); ++attr)
     {
         const Vec2u interval = get_interval(*attr);
+        mark_dirty(interval.x);
         switch (attr->type)
         {
             case Attribute::Type::Color: {
@@ -43,4 +43,34 @@
 #   define USE_VERTEX_ARRAY_OBJECT 1
 #endif
 
+// Compressed texture formats are extensions, and their enums are not defined
+// by every platform's headers.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#   define GL_COMPRESSED_RGB_S3TC_DXT1_EXT   0x83F0
+#   define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT  0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+#   define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT  0x83F2
+#   define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT  0x83F3
+#endif
+#ifndef GL_ETC1_RGB8_OES
+#   define GL_ETC1_RGB8_OES                  0x8D64
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#   define GL_COMPRESSED_RGB8_ETC2           0x9274
+#   define GL_COMPRESSED_RGBA8_ETC2_EAC      0x9278
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#   define GL_COMPRESSED_RGBA_BPTC_UNORM     0x8E8C
+#endif
+#ifndef GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+#   define GL_COMPRESSED_RGBA_ASTC_4x4_KHR   0x93B0
+#endif
+
+// OpenGL ES 2.0 and legacy macOS contexts only expose instancing through
+// vendor-specific entry points.
+#if !defined(GL_ES_VERSION_2_0) && !defined(RAINBOW_OS_MACOS)
+#   define USE_INSTANCED_ARRAYS 1
+#endif
+
 #endif
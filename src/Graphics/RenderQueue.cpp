@@ -0,0 +1,163 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include "Graphics/RenderQueue.h"
+
+#include <algorithm>
+#include <tuple>
+
+#include "Graphics/DynamicBatch.h"
+#include "Graphics/OpenGL.h"
+#include "Graphics/Renderer.h"
+#include "Graphics/SpriteBatch.h"
+
+using rainbow::graphics::BlendMode;
+using rainbow::graphics::DrawCommand;
+using rainbow::graphics::RenderQueue;
+
+namespace
+{
+    bool has_same_state(const DrawCommand& a, const DrawCommand& b)
+    {
+        return a.program == b.program && a.texture == b.texture &&
+               a.blend == b.blend;
+    }
+}
+
+constexpr unsigned int RenderQueue::kNoGroup;
+
+void RenderQueue::clear()
+{
+    commands_.clear();
+    batch_count_ = 0;
+}
+
+void RenderQueue::flush()
+{
+    auto shader_manager = ShaderManager::Get();
+    const unsigned int program = shader_manager->current();
+    BlendMode blend = BlendMode::Alpha;
+
+    for (size_t i = 0; i < commands_.size();)
+    {
+        const auto& command = commands_[i];
+        shader_manager->use(command.program == ShaderManager::kInvalidProgram
+                                ? program
+                                : command.program);
+        if (command.blend != blend)
+        {
+            blend = command.blend;
+            set_blend_mode(blend);
+        }
+
+        const size_t run = mergeable_run(i);
+        if (run > 1)
+        {
+            merged_.clear();
+            for (size_t j = i; j < i + run; ++j)
+                merged_.push_back(commands_[j].batch);
+
+            auto& dynamic_batch = detail::dynamic_batch();
+            dynamic_batch.assign(merged_.data(), merged_.size());
+            dynamic_batch.draw();
+        }
+        else
+        {
+            command.draw(command.object);
+        }
+
+        i += run;
+    }
+
+    shader_manager->use(program);
+    if (blend != BlendMode::Alpha)
+        set_blend_mode(BlendMode::Alpha);
+
+    clear();
+}
+
+void RenderQueue::push(DrawCommand::Function draw,
+                       const void* object,
+                       unsigned int program,
+                       const void* texture,
+                       BlendMode blend,
+                       int layer,
+                       unsigned int group,
+                       const SpriteBatch* batch)
+{
+    const unsigned int sequence = next_sequence();
+    commands_.push_back({draw,
+                         object,
+                         program,
+                         texture,
+                         batch,
+                         blend,
+                         layer,
+                         group == kNoGroup ? sequence : group,
+                         sequence});
+}
+
+void RenderQueue::sort()
+{
+    // Commands outside a sort group are their own group, so only commands
+    // that share a group can be reordered by state.
+    std::sort(commands_.begin(),
+              commands_.end(),
+              [](const DrawCommand& a, const DrawCommand& b) {
+                  return std::tie(a.layer,
+                                  a.group,
+                                  a.program,
+                                  a.texture,
+                                  a.blend,
+                                  a.sequence) < std::tie(b.layer,
+                                                         b.group,
+                                                         b.program,
+                                                         b.texture,
+                                                         b.blend,
+                                                         b.sequence);
+              });
+
+    batch_count_ = commands_.empty() ? 0 : 1;
+    for (size_t i = 1; i < commands_.size(); ++i)
+    {
+        if (!has_same_state(commands_[i - 1], commands_[i]))
+            ++batch_count_;
+    }
+}
+
+auto RenderQueue::mergeable_run(size_t first) const -> size_t
+{
+    const auto& command = commands_[first];
+    if (command.batch == nullptr)
+        return 1;
+
+    size_t last = first + 1;
+    while (last < commands_.size())
+    {
+        const auto& next = commands_[last];
+        if (next.batch == nullptr || !has_same_state(command, next) ||
+            !DynamicBatch::can_merge(*command.batch, *next.batch))
+        {
+            break;
+        }
+        ++last;
+    }
+    return last - first;
+}
+
+void rainbow::graphics::set_blend_mode(BlendMode mode)
+{
+    switch (mode)
+    {
+        case BlendMode::Alpha:
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+        case BlendMode::Additive:
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+            break;
+        case BlendMode::Premultiplied:
+            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+    }
+}
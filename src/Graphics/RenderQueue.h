@@ -0,0 +1,110 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef GRAPHICS_RENDERQUEUE_H_
+#define GRAPHICS_RENDERQUEUE_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "Common/NonCopyable.h"
+
+class SpriteBatch;
+
+namespace rainbow { namespace graphics
+{
+    enum class BlendMode
+    {
+        Alpha,          ///< Source alpha, one minus source alpha (default).
+        Additive,       ///< Source alpha, one.
+        Premultiplied,  ///< One, one minus source alpha.
+    };
+
+    struct DrawCommand
+    {
+        using Function = void (*)(const void*);
+
+        Function draw;        ///< Issues the actual draw call.
+        const void* object;   ///< Object passed to <see cref="draw"/>.
+        unsigned int program; ///< Program to use; 0 for the current program.
+        const void* texture;  ///< Texture bound by the command, if known.
+        const SpriteBatch* batch;  ///< Sprite batch that may be merged.
+        BlendMode blend;
+        int layer;
+        unsigned int group;
+        unsigned int sequence;
+    };
+
+    /// <summary>
+    ///   Collects draw commands so that they can be sorted by render state
+    ///   before they are executed.
+    /// </summary>
+    /// <remarks>
+    ///   Commands are drawn in ascending layer order. Within a layer, commands
+    ///   are drawn in submission order except for those that share a sort
+    ///   group; these are ordered by program, texture and blend mode so that
+    ///   commands with identical state end up next to each other.
+    /// </remarks>
+    class RenderQueue : private NonCopyable<RenderQueue>
+    {
+    public:
+        /// <summary>Sort group of commands that must keep their order.</summary>
+        static constexpr unsigned int kNoGroup = ~0u;
+
+        auto begin() const { return commands_.cbegin(); }
+        auto end() const { return commands_.cend(); }
+
+        /// <summary>
+        ///   Returns the number of runs of commands with identical state.
+        ///   Only valid after <see cref="sort"/>.
+        /// </summary>
+        auto batch_count() const { return batch_count_; }
+
+        /// <summary>Returns the sequence number of the next command.</summary>
+        auto next_sequence() const
+        {
+            return static_cast<unsigned int>(commands_.size());
+        }
+
+        auto size() const { return commands_.size(); }
+
+        void clear();
+
+        /// <summary>Executes all commands, then clears the queue.</summary>
+        /// <remarks>
+        ///   Programs and blend modes are only changed when they differ from
+        ///   the previous command, and are restored when done. Consecutive
+        ///   commands with mergeable sprite batches and identical state are
+        ///   drawn with a single draw call.
+        /// </remarks>
+        void flush();
+
+        void push(DrawCommand::Function draw,
+                  const void* object,
+                  unsigned int program,
+                  const void* texture,
+                  BlendMode blend,
+                  int layer,
+                  unsigned int group,
+                  const SpriteBatch* batch = nullptr);
+
+        /// <summary>Sorts commands and counts state changes.</summary>
+        void sort();
+
+    private:
+        std::vector<DrawCommand> commands_;
+        std::vector<const SpriteBatch*> merged_;
+        unsigned int batch_count_ = 0;
+
+        /// <summary>
+        ///   Returns the number of commands, starting at
+        ///   <paramref name="first"/>, that can be merged into one draw call.
+        /// </summary>
+        auto mergeable_run(size_t first) const -> size_t;
+    };
+
+    void set_blend_mode(BlendMode mode);
+}}  // namespace rainbow::graphics
+
+#endif
@@ -4,20 +4,17 @@
 
 #include "Graphics/Renderer.h"
 
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
+#include "Graphics/Buffer.h"
+#include "Graphics/DynamicBatch.h"
 #include "Graphics/Label.h"
+#include "Graphics/Shaders.h"
+#include "Graphics/Shaders/DistanceField.h"
 #include "Graphics/SpriteBatch.h"
-
-#define S0(i)  (i) * 4
-#define S1(i)  S0(i), S0(i) + 1, S0(i) + 2, S0(i) + 2, S0(i) + 3, S0(i)
-
-#define S4(i)        S1((i)),    S1((i) +    1),    S1((i) +    2),    S1((i) +    3)
-#define S16(i)       S4((i)),    S4((i) +    4),    S4((i) +    8),    S4((i) +   12)
-#define S64(i)      S16((i)),   S16((i) +   16),   S16((i) +   32),   S16((i) +   48)
-#define S256(i)     S64((i)),   S64((i) +   64),   S64((i) +  128),   S64((i) +  192)
-#define S1024(i)   S256((i)),  S256((i) +  256),  S256((i) +  512),  S256((i) +  768)
-#define S4096(i)  S1024((i)), S1024((i) + 1024), S1024((i) + 2048), S1024((i) + 3072)
+#include "Graphics/TextBatch.h"
 
 using rainbow::Rect;
 using rainbow::graphics::State;
@@ -26,22 +23,122 @@ namespace graphics = rainbow::graphics;
 
 namespace
 {
+    size_t g_bytes_uploaded = 0;
+    unsigned int g_culled_count = 0;
     unsigned int g_draw_count = 0;
+    unsigned int g_draws_saved = 0;
+    graphics::StateChanges g_state_changes;
     State* g_state = nullptr;
 }
 
 namespace rainbow { namespace graphics { namespace detail
 {
 #ifndef NDEBUG
+    unsigned int g_culled_count_accumulator = 0;
     unsigned int g_draw_count_accumulator = 0;
+    unsigned int g_draws_saved_accumulator = 0;
+    size_t g_bytes_uploaded_accumulator = 0;
+    StateChanges g_state_changes_accumulator;
 #endif  // NDEBUG
+
+    auto distance_field_shader() -> const shaders::DistanceField&
+    {
+        // Compiled on first use as most games never need it.
+        if (!g_state->distance_field_shader)
+        {
+            g_state->distance_field_shader =
+                std::make_unique<shaders::DistanceField>();
+        }
+        return *g_state->distance_field_shader;
+    }
+
+    auto dynamic_batch() -> DynamicBatch&
+    {
+        // Created on first use as the buffers require a graphics context.
+        if (!g_state->dynamic_batch)
+            g_state->dynamic_batch = std::make_unique<DynamicBatch>();
+        return *g_state->dynamic_batch;
+    }
+
+    auto element_buffer() -> ElementBuffer&
+    {
+        return g_state->element_buffer;
+    }
+
+    auto instanced_program() -> unsigned int
+    {
+        if (g_state->instanced_program != ShaderManager::kInvalidProgram)
+            return g_state->instanced_program;
+
+        Shader::Params shaders[]{
+            {Shader::kTypeVertex, 0, shaders::kFixed2DInstancedv,
+             shaders::integrated::kFixed2DInstancedv},
+            {Shader::kTypeFragment, 1, nullptr, nullptr},  // kFixed2Df
+            {Shader::kTypeInvalid, 0, nullptr, nullptr}};
+        const Shader::AttributeParams attributes[]{
+            {Shader::kAttributeVertex, "vertex"},
+            {Shader::kAttributeColor, "color"},
+            {Shader::kAttributeTexCoord, "texcoord"},
+            {Shader::kAttributeTransform, "transform"},
+            {Shader::kAttributeOrigin, "origin"},
+            {Shader::kAttributeNone, nullptr}};
+        auto& shader_manager = g_state->shader_manager;
+        const unsigned int program =
+            shader_manager.compile(shaders, attributes);
+        if (program == ShaderManager::kInvalidProgram)
+            return program;
+
+        ShaderManager::Context context;
+        shader_manager.use(program);
+        glUniform1i(glGetUniformLocation(
+                        shader_manager.get_program().program, "texture"),
+                    0);
+
+        g_state->instanced_program = program;
+        return program;
+    }
+
+    auto unit_quad() -> const Buffer&
+    {
+        // Created on first use as the buffer requires a graphics context.
+        if (!g_state->unit_quad)
+        {
+            const Vec2f corners[]{{0.0f, 0.0f},
+                                  {1.0f, 0.0f},
+                                  {1.0f, 1.0f},
+                                  {0.0f, 1.0f}};
+            g_state->unit_quad = std::make_unique<Buffer>();
+            g_state->unit_quad->upload(corners, sizeof(corners));
+        }
+        return *g_state->unit_quad;
+    }
 }}}
 
+auto graphics::culled_count() -> unsigned int
+{
+    return g_culled_count;
+}
+
 auto graphics::draw_count() -> unsigned int
 {
     return g_draw_count;
 }
 
+auto graphics::draws_saved() -> unsigned int
+{
+    return g_draws_saved;
+}
+
+auto graphics::bytes_uploaded() -> size_t
+{
+    return g_bytes_uploaded;
+}
+
+auto graphics::state_changes() -> const StateChanges&
+{
+    return g_state_changes;
+}
+
 auto graphics::max_texture_size() -> int
 {
     static const int max_texture_size = [] {
@@ -52,6 +149,21 @@ auto graphics::max_texture_size() -> int
     return max_texture_size;
 }
 
+bool graphics::supports_compressed_format(unsigned int format)
+{
+    static const std::vector<int> formats = [] {
+        int count = 0;
+        glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+        std::vector<int> formats(count);
+        if (count > 0)
+            glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+        return formats;
+    }();
+    return std::find(formats.begin(),
+                     formats.end(),
+                     static_cast<int>(format)) != formats.end();
+}
+
 auto graphics::projection() -> const Rect&
 {
     return g_state->rect;
@@ -132,11 +244,37 @@ void graphics::clear()
     glClear(GL_COLOR_BUFFER_BIT);
 
 #ifndef NDEBUG
+    g_culled_count = detail::g_culled_count_accumulator;
+    detail::g_culled_count_accumulator = 0;
     g_draw_count = detail::g_draw_count_accumulator;
     detail::g_draw_count_accumulator = 0;
+    g_draws_saved = detail::g_draws_saved_accumulator;
+    detail::g_draws_saved_accumulator = 0;
+    g_bytes_uploaded = detail::g_bytes_uploaded_accumulator;
+    detail::g_bytes_uploaded_accumulator = 0;
+    g_state_changes = detail::g_state_changes_accumulator;
+    detail::g_state_changes_accumulator = StateChanges{};
 #endif
 }
 
+namespace
+{
+    void use_distance_field_shader(const Label& label)
+    {
+        // Distances are encoded so that 0.5 spans the spread. Keep the edge
+        // about one screen pixel wide at any scale.
+        const float units_per_pixel = 0.5f / FontAtlas::kDistanceFieldSpread;
+        const float scale = label.scale() * g_state->zoom;
+        const auto& shader = graphics::detail::distance_field_shader();
+        g_state->shader_manager.use(shader.id());
+        shader.set_smoothing(0.5f * units_per_pixel / scale);
+        shader.set_effects(label.outline().width * units_per_pixel,
+                           label.outline().color,
+                           label.glow().width * units_per_pixel,
+                           label.glow().color);
+    }
+}
+
 auto graphics::convert_to_flipped_view(const Vec2i& p) -> Vec2i
 {
     return convert_to_view(Vec2i(p.x, g_state->window.y - p.y));
@@ -157,6 +295,125 @@ auto graphics::convert_to_view(const Vec2i& p) -> Vec2i
                      g_state->origin.y / g_state->zoom);
 }
 
+void graphics::draw(const SpriteBatch& batch)
+{
+    if (!batch.is_ready())
+        return;
+
+    if (!batch.is_instanced())
+    {
+        draw<SpriteBatch>(batch);
+        return;
+    }
+
+#ifdef USE_INSTANCED_ARRAYS
+    if (!batch.is_visible() || batch.size() == 0)
+        return;
+
+    // Custom programs expect sprite vertices; expand the instances instead
+    // of swapping in the instanced program.
+    if (g_state->shader_manager.current() != ShaderManager::kDefaultProgram)
+    {
+        const SpriteBatch* batches[]{&batch};
+        auto& dynamic_batch = detail::dynamic_batch();
+        dynamic_batch.assign(batches, 1);
+        dynamic_batch.draw();
+        return;
+    }
+
+    auto& elements = detail::element_buffer();
+    const auto count = elements.reserve(6);
+    ShaderManager::Context context;
+    g_state->shader_manager.use(detail::instanced_program());
+    batch.vertex_array().bind();
+    batch.bind_textures();
+    glDrawElementsInstanced(
+        GL_TRIANGLES, count, elements.type(), nullptr, batch.size());
+
+#ifndef NDEBUG
+    ++detail::g_draw_count_accumulator;
+#endif
+#endif  // USE_INSTANCED_ARRAYS
+}
+
+void graphics::draw(const Label& label)
+{
+    auto& elements = detail::element_buffer();
+    const size_t count = elements.reserve(label.vertex_count());
+    const size_t index_size =
+        elements.type() == GL_UNSIGNED_SHORT ? sizeof(GLushort)
+                                             : sizeof(GLuint);
+    const unsigned int program = g_state->shader_manager.current();
+    const bool is_distance_field =
+        label.font().mode() == FontAtlas::Mode::DistanceField;
+    if (is_distance_field)
+        use_distance_field_shader(label);
+
+    label.vertex_array().bind();
+    for (auto&& run : label.runs())
+    {
+        const size_t first = run.first * 6;
+        if (first >= count)
+            break;
+
+        label.font().bind(run.page);
+        glDrawElements(GL_TRIANGLES,
+                       std::min<size_t>(run.count * 6, count - first),
+                       elements.type(),
+                       reinterpret_cast<const void*>(first * index_size));
+
+#ifndef NDEBUG
+        ++detail::g_draw_count_accumulator;
+#endif
+    }
+
+    if (is_distance_field)
+        g_state->shader_manager.use(program);
+}
+
+void graphics::draw(const TextBatch& batch)
+{
+    if (batch.runs().empty())
+        return;
+
+    auto& elements = detail::element_buffer();
+    const size_t count = elements.reserve(batch.vertex_count());
+    const size_t index_size =
+        elements.type() == GL_UNSIGNED_SHORT ? sizeof(GLushort)
+                                             : sizeof(GLuint);
+    const unsigned int program = g_state->shader_manager.current();
+    const bool is_distance_field =
+        batch.font().mode() == FontAtlas::Mode::DistanceField;
+
+    batch.vertex_array().bind();
+    const Label* state = nullptr;
+    for (auto&& run : batch.runs())
+    {
+        const size_t first = size_t{run.first} * 6;
+        if (first >= count)
+            break;
+
+        if (is_distance_field && run.label != state)
+        {
+            use_distance_field_shader(*run.label);
+            state = run.label;
+        }
+
+        batch.font().bind(run.page);
+        glDrawElements(GL_TRIANGLES,
+                       std::min<size_t>(run.count * 6, count - first),
+                       elements.type(),
+                       reinterpret_cast<const void*>(first * index_size));
+
+#ifndef NDEBUG
+        ++detail::g_draw_count_accumulator;
+#endif
+    }
+
+    if (is_distance_field)
+        g_state->shader_manager.use(program);
+}
+
 bool graphics::has_extension(const char* extension)
 {
     static auto gl_extensions =
@@ -164,6 +421,18 @@ bool graphics::has_extension(const char* extension)
     return strstr(gl_extensions, extension);
 }
 
+bool graphics::supports_instancing()
+{
+#ifdef USE_INSTANCED_ARRAYS
+    static const bool supported =
+        has_extension("GL_ARB_instanced_arrays") &&
+        has_extension("GL_ARB_draw_instanced");
+    return supported;
+#else
+    return false;
+#endif
+}
+
 void graphics::reset()
 {
     glDisable(GL_CULL_FACE);
@@ -190,6 +459,8 @@ void graphics::unbind_all()
     g_state->texture_manager.bind();
 }
 
+State::State() = default;
+
 State::~State()
 {
     if (this == g_state)
@@ -217,15 +488,14 @@ bool State::initialize()
     if (!shader_manager.init())
         return false;
 
-    const unsigned short kDefaultIndices[]{S4096(0)};
-    static_assert(
-        sizeof(kDefaultIndices) == kMaxSprites * 6 * sizeof(kDefaultIndices[0]),
-        "Number of indices do not match set number of sprites");
-
     unsigned int buffer;
     glGenBuffers(1, &buffer);
     element_buffer = buffer;
-    element_buffer.upload(kDefaultIndices, sizeof(kDefaultIndices));
+    element_buffer.reserve(ElementBuffer::kInitialCapacity * 6);
+
+    // Image decoders run on worker threads, where these cannot be queried.
+    graphics::max_texture_size();
+    graphics::supports_compressed_format(0);
 
     const bool success = glGetError() == GL_NO_ERROR;
     if (success)
@@ -5,25 +5,106 @@
 #ifndef GRAPHICS_RENDERER_H_
 #define GRAPHICS_RENDERER_H_
 
+#include <memory>
+
 #include "Graphics/ElementBuffer.h"
 #include "Graphics/ShaderManager.h"
 #include "Graphics/TextureManager.h"
 #include "Math/Geometry.h"
 
+class Label;
+class SpriteBatch;
+class TextBatch;
+
+namespace rainbow { namespace shaders { class DistanceField; }}
+
 namespace rainbow { namespace graphics
 {
+    class Buffer;
+    class DynamicBatch;
+
+    /// <summary>
+    ///   Number of program and texture changes requested, and how many of
+    ///   those actually reached OpenGL. The difference is the number of
+    ///   redundant state changes that were filtered out.
+    /// </summary>
+    struct StateChanges
+    {
+        unsigned int program_requests = 0;
+        unsigned int programs = 0;
+        unsigned int texture_requests = 0;
+        unsigned int textures = 0;
+    };
+
     namespace detail
     {
 #ifndef NDEBUG
+        extern unsigned int g_culled_count_accumulator;
         extern unsigned int g_draw_count_accumulator;
+        extern unsigned int g_draws_saved_accumulator;
+        extern size_t g_bytes_uploaded_accumulator;
+        extern StateChanges g_state_changes_accumulator;
 #endif
+
+        /// <summary>
+        ///   Returns the shader used for labels with distance field fonts.
+        /// </summary>
+        auto distance_field_shader() -> const shaders::DistanceField&;
+
+        auto dynamic_batch() -> DynamicBatch&;
+        auto element_buffer() -> ElementBuffer&;
+
+        /// <summary>Returns the program used for instanced sprites.</summary>
+        auto instanced_program() -> unsigned int;
+
+        /// <summary>
+        ///   Returns a buffer with the corners of a unit quad, used to expand
+        ///   instanced sprites.
+        /// </summary>
+        auto unit_quad() -> const Buffer&;
     }
 
-    ///<summary>Hard-coded limit on number of sprites.</summary>
-    static constexpr size_t kMaxSprites = 4096;
+    /// <summary>
+    ///   Returns the number of scene graph nodes, or whole subtrees, skipped
+    ///   by culling last frame.
+    /// </summary>
+    auto culled_count() -> unsigned int;
 
     auto draw_count() -> unsigned int;
+
+    /// <summary>
+    ///   Returns the number of draw calls saved by merging sprite batches last
+    ///   frame.
+    /// </summary>
+    auto draws_saved() -> unsigned int;
+
+    /// <summary>
+    ///   Returns the number of bytes uploaded to vertex buffers last frame.
+    /// </summary>
+    auto bytes_uploaded() -> size_t;
+
+    /// <summary>Returns state changes made last frame.</summary>
+    auto state_changes() -> const StateChanges&;
+
+    /// <summary>
+    ///   Returns the largest texture size supported by the driver.
+    /// </summary>
+    /// <remarks>
+    ///   Queried once while the renderer is initialised, and safe to call
+    ///   from any thread afterwards.
+    /// </remarks>
     auto max_texture_size() -> int;
+
+    /// <summary>
+    ///   Returns whether the driver accepts compressed textures in
+    ///   <paramref name="format"/>.
+    /// </summary>
+    /// <remarks>
+    ///   Queried once while the renderer is initialised, and safe to call
+    ///   from any thread afterwards.
+    /// </remarks>
+    bool supports_compressed_format(unsigned int format);
+
     auto projection() -> const Rect&;
     auto resolution() -> const Vec2i&;
     auto window_size() -> const Vec2i&;
@@ -40,13 +121,31 @@ namespace rainbow { namespace graphics
     auto convert_to_screen(const Vec2i&) -> Vec2i;
     auto convert_to_view(const Vec2i&) -> Vec2i;
 
+    /// <summary>
+    ///   Draws a sprite batch, using instancing if the batch is instanced.
+    /// </summary>
+    void draw(const SpriteBatch& batch);
+
+    /// <summary>
+    ///   Draws a label, with one draw call per font texture page used. Labels
+    ///   with distance field fonts are drawn with the distance field shader.
+    /// </summary>
+    void draw(const Label& label);
+
+    /// <summary>
+    ///   Draws a batch of labels, with one draw call per font texture page
+    ///   used, or per change of distance field scale and effects.
+    /// </summary>
+    void draw(const TextBatch& batch);
+
     template <typename T>
     void draw(const T& obj)
     {
+        auto& elements = detail::element_buffer();
+        const auto count = elements.reserve(obj.vertex_count());
         obj.vertex_array().bind();
         obj.bind_textures();
-        glDrawElements(
-            GL_TRIANGLES, obj.vertex_count(), GL_UNSIGNED_SHORT, nullptr);
+        glDrawElements(GL_TRIANGLES, count, elements.type(), nullptr);
 
 #ifndef NDEBUG
         ++detail::g_draw_count_accumulator;
@@ -67,6 +166,11 @@ namespace rainbow { namespace graphics
 
     bool has_extension(const char* extension);
 
+    /// <summary>
+    ///   Returns whether instanced arrays and instanced draws are supported.
+    /// </summary>
+    bool supports_instancing();
+
     void reset();
 
     void scissor(int x, int y, int width, int height);
@@ -109,7 +213,12 @@ namespace rainbow { namespace graphics
         ElementBuffer element_buffer;
         TextureManager texture_manager;
         ShaderManager shader_manager;
+        std::unique_ptr<shaders::DistanceField> distance_field_shader;
+        std::unique_ptr<DynamicBatch> dynamic_batch;
+        std::unique_ptr<Buffer> unit_quad;
+        unsigned int instanced_program = ShaderManager::kInvalidProgram;
 
+        State();
         ~State();
 
         bool initialize();
@@ -4,15 +4,20 @@
 
 #include "Graphics/SceneGraph.h"
 
+#include <algorithm>
+
 #include "Graphics/Animation.h"
 #include "Graphics/Drawable.h"
 #include "Graphics/Label.h"
 #include "Graphics/Renderer.h"
 #include "Graphics/SpriteBatch.h"
+#include "Graphics/TextBatch.h"
+#include "Threading/JobSystem.h"
 
 static_assert(ShaderManager::kInvalidProgram == 0,
               "Inlined SceneNode(Type, void*) assumes kInvalidProgram == 0");
 
+using rainbow::Rect;
 using rainbow::SceneNode;
 
 namespace
@@ -25,6 +30,7 @@ namespace
     private:
         Animation& animation_;
 
+        auto bounds_impl() const -> Rect override { return Rect::none(); }
         void draw_impl() const override {}
         void move_impl(const Vec2f&) const override {}
 
@@ -63,8 +69,14 @@ namespace
     private:
         Label& label_;
 
+        auto bounds_impl() const -> Rect override { return label_.bounds(); }
         void draw_impl() const override { rainbow::graphics::draw(label_); }
 
+        auto texture_key() const -> const void* override
+        {
+            return &label_.font();
+        }
+
         void move_impl(const Vec2f& delta) const override
         {
             label_.move(delta);
@@ -76,6 +88,40 @@ namespace
         }
     };
 
+    class TextBatchNode final : public SceneNode
+    {
+    public:
+        TextBatchNode(TextBatch& batch) : text_batch_(batch) {}
+
+    private:
+        TextBatch& text_batch_;
+
+        auto bounds_impl() const -> Rect override
+        {
+            return text_batch_.bounds();
+        }
+
+        void draw_impl() const override
+        {
+            rainbow::graphics::draw(text_batch_);
+        }
+
+        auto texture_key() const -> const void* override
+        {
+            return &text_batch_.font();
+        }
+
+        void move_impl(const Vec2f& delta) const override
+        {
+            text_batch_.move(delta);
+        }
+
+        void update_impl(unsigned long) const override
+        {
+            text_batch_.update();
+        }
+    };
+
     class SpriteBatchNode final : public SceneNode
     {
     public:
@@ -84,6 +130,12 @@ namespace
     private:
         SpriteBatch& sprite_batch_;
 
+        auto bounds_impl() const -> Rect override
+        {
+            return sprite_batch_.is_visible() ? sprite_batch_.bounds()
+                                              : Rect::none();
+        }
+
         void draw_impl() const override
         {
             rainbow::graphics::draw(sprite_batch_);
@@ -94,26 +146,115 @@ namespace
             sprite_batch_.move(delta);
         }
 
-        void update_impl(unsigned long) const override
+        void update_impl(unsigned long) const override {}
+
+        auto texture_key() const -> const void* override
+        {
+            return &sprite_batch_.texture();
+        }
+
+        auto mergeable_batch() const -> const SpriteBatch* override
+        {
+            return sprite_batch_.is_ready() ? &sprite_batch_ : nullptr;
+        }
+
+        auto deferred_target() const -> const void* override
         {
-            sprite_batch_.update();
+            return &sprite_batch_;
         }
+
+        void prepare_impl() const override { sprite_batch_.prepare(); }
+        void commit_impl() const override { sprite_batch_.upload(); }
     };
 }
 
+struct SceneNode::DrawState
+{
+    unsigned int program;
+    rainbow::graphics::BlendMode blend_mode;
+    int layer;
+    unsigned int group;
+    bool auto_merge;
+    bool culling;
+    rainbow::Rect viewport;
+};
+
 void SceneNode::draw() const
+{
+    R_PROFILE_ZONE("SceneNode::draw");
+
+    queue_.clear();
+    draw(queue_,
+         {ShaderManager::kInvalidProgram,
+          rainbow::graphics::BlendMode::Alpha,
+          0,
+          rainbow::graphics::RenderQueue::kNoGroup,
+          false,
+          false,
+          {}});
+    queue_.sort();
+    queue_.flush();
+}
+
+void SceneNode::draw(rainbow::graphics::RenderQueue& queue,
+                     const DrawState& parent) const
 {
     if (!is_enabled())
         return;
 
-    ShaderManager::Context context;
+    DrawState state = parent;
     if (program_ != ShaderManager::kInvalidProgram)
-        ShaderManager::Get()->use(program_);
+        state.program = program_;
+    if (has_blend_mode_)
+        state.blend_mode = blend_mode_;
+    if (has_layer_)
+        state.layer = layer_;
+    if (auto_merges_)
+        state.auto_merge = true;
+    if (sorts_by_state_ &&
+        state.group == rainbow::graphics::RenderQueue::kNoGroup)
+    {
+        state.group = queue.next_sequence();
+    }
+    if (culls_ && !state.culling)
+    {
+        state.culling = true;
+        state.viewport = rainbow::graphics::projection();
+    }
 
-    draw_impl();
+    if (state.culling && !bounds_.intersects(state.viewport))
+    {
+#ifndef NDEBUG
+        ++rainbow::graphics::detail::g_culled_count_accumulator;
+#endif
+        return;
+    }
+
+    // The subtree is visible, but this node may not be.
+    if (!state.culling || bounds_impl().intersects(state.viewport))
+    {
+        queue.push([](const void* ptr) {
+                       auto node = static_cast<const SceneNode*>(ptr);
+                       R_PROFILE_ZONE(node->zone_name());
+                       node->draw_impl();
+                   },
+                   this,
+                   state.program,
+                   texture_key(),
+                   state.blend_mode,
+                   state.layer,
+                   state.group,
+                   state.auto_merge ? mergeable_batch() : nullptr);
+    }
+#ifndef NDEBUG
+    else
+    {
+        ++rainbow::graphics::detail::g_culled_count_accumulator;
+    }
+#endif
 
     for (auto&& child : children_)
-        child->draw();
+        child->draw(queue, state);
 }
 
 void SceneNode::move(const Vec2f& delta) const
@@ -128,10 +269,75 @@ void SceneNode::update(unsigned long dt) const
     if (!is_enabled())
         return;
 
+    R_PROFILE_ZONE("SceneNode::update");
+
+    std::vector<const SceneNode*> deferred;
+    update(dt, deferred);
+    if (deferred.empty())
+    {
+        update_bounds();
+        return;
+    }
+
+    // Several nodes may point to the same object, which must not be prepared
+    // concurrently.
+    std::sort(deferred.begin(),
+              deferred.end(),
+              [](const SceneNode* a, const SceneNode* b) {
+                  return a->deferred_target() < b->deferred_target();
+              });
+    deferred.erase(std::unique(deferred.begin(),
+                               deferred.end(),
+                               [](const SceneNode* a, const SceneNode* b) {
+                                   return a->deferred_target() ==
+                                          b->deferred_target();
+                               }),
+                   deferred.end());
+
+    rainbow::parallel_for(
+        deferred.size(), 1, [&deferred](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                R_PROFILE_ZONE(deferred[i]->zone_name());
+                deferred[i]->prepare_impl();
+            }
+        });
+
+    for (auto&& node : deferred)
+        node->commit_impl();
+
+    // Sprite batch bounds are only known once they have been prepared.
+    update_bounds();
+}
+
+void SceneNode::update(unsigned long dt,
+                       std::vector<const SceneNode*>& deferred) const
+{
+    if (!is_enabled())
+        return;
+
+    // Includes the subtree so that zones nest like the scene graph.
+    R_PROFILE_ZONE(zone_name());
+
     update_impl(dt);
+    if (deferred_target() != nullptr)
+        deferred.push_back(this);
+
+    for (auto&& child : children_)
+        child->update(dt, deferred);
+}
 
+void SceneNode::update_bounds() const
+{
+    bounds_ = bounds_impl();
     for (auto&& child : children_)
-        child->update(dt);
+    {
+        if (!child->is_enabled())
+            continue;
+
+        child->update_bounds();
+        bounds_.extend(child->bounds_);
+    }
 }
 
 // Workaround for https://gcc.gnu.org/bugzilla/show_bug.cgi?id=56480
@@ -167,6 +373,12 @@ std::unique_ptr<SceneNode> SceneNode::create(SpriteBatch& s)
     return std::unique_ptr<SceneNode>(new SpriteBatchNode(s));
 }
 
+template <>
+std::unique_ptr<SceneNode> SceneNode::create(TextBatch& t)
+{
+    return std::unique_ptr<SceneNode>(new TextBatchNode(t));
+}
+
 #if defined(__GNUC__) && !defined(__clang__)
 }
 #endif
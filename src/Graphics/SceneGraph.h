@@ -6,16 +6,21 @@
 #define GRAPHICS_SCENEGRAPH_H_
 
 #include <memory>
+#include <vector>
 
 #define USE_NODE_TAGS !defined(NDEBUG) || defined(USE_HEIMDALL)
 #if USE_NODE_TAGS
 #   include <string>
 #endif
 
+#include "Common/Profiler.h"
 #include "Common/TreeNode.h"
+#include "Graphics/RenderQueue.h"
+#include "Math/Geometry.h"
 #include "Math/Vec2.h"
 
 class Drawable;
+class SpriteBatch;
 
 namespace rainbow
 {
@@ -42,6 +47,13 @@ namespace rainbow
 
         virtual ~SceneNode() = default;
 
+        /// <summary>
+        ///   Returns the bounds of this node and its enabled descendants as of
+        ///   the last update. Nodes that can draw anywhere, e.g. drawables,
+        ///   have infinite bounds.
+        /// </summary>
+        auto bounds() const -> const Rect& { return bounds_; }
+
         /// <summary>Returns whether this node is enabled.</summary>
         bool is_enabled() const { return enabled_; }
         void set_enabled(bool enabled) { enabled_ = enabled; }
@@ -53,9 +65,57 @@ namespace rainbow
         /// </summary>
         void attach_program(unsigned int program) { program_ = program; }
 
+        /// <summary>
+        ///   Sets the blend mode used to draw this node and any of its
+        ///   descendants unless they also have a blend mode set.
+        /// </summary>
+        void set_blend_mode(graphics::BlendMode mode)
+        {
+            blend_mode_ = mode;
+            has_blend_mode_ = true;
+        }
+
+        /// <summary>
+        ///   Sets the layer of this node and any of its descendants unless
+        ///   they also have a layer set. Higher layers are drawn on top of
+        ///   lower layers. The default layer is 0.
+        /// </summary>
+        void set_layer(int layer)
+        {
+            layer_ = layer;
+            has_layer_ = true;
+        }
+
+        /// <summary>
+        ///   Sets whether this node and its descendants may be drawn out of
+        ///   order to minimise program, texture and blend mode changes. Only
+        ///   enable this for nodes that do not overlap one another, or where
+        ///   the order of overlapping nodes does not matter.
+        /// </summary>
+        void set_state_sorting(bool enable) { sorts_by_state_ = enable; }
+
+        /// <summary>
+        ///   Sets whether consecutive sprite batches in this subtree that share
+        ///   texture atlas and program are merged into a single draw call.
+        ///   Batches with normal maps are not merged. Draw order is preserved.
+        /// </summary>
+        void set_auto_merge(bool enable) { auto_merges_ = enable; }
+
+        /// <summary>
+        ///   Sets whether this node and its descendants are skipped when
+        ///   drawing if their bounds lie outside the current projection.
+        ///   Bounds are recalculated on every update.
+        /// </summary>
+        void set_culling(bool enable) { culls_ = enable; }
+
 #if USE_NODE_TAGS
         const std::string& tag() const { return tag_; }
-        void set_tag(std::string tag) { tag_ = std::move(tag); }
+
+        void set_tag(std::string tag)
+        {
+            tag_ = std::move(tag);
+            zone_name_ = profiler::intern(tag_);
+        }
 #endif
 
         /// <summary>Adds a child group node.</summary>
@@ -89,32 +149,122 @@ namespace rainbow
         }
 
         /// <summary>Draws this node and all its enabled children.</summary>
+        /// <remarks>
+        ///   Nodes are drawn in depth-first order, layer by layer. Nodes with
+        ///   state sorting enabled are sorted by state first.
+        /// </remarks>
         void draw() const;
 
         /// <summary>Recursively moves all sprites by (x,y).</summary>
         void move(const Vec2f& delta) const;
 
         /// <summary>Updates this node and all its enabled children.</summary>
+        /// <remarks>
+        ///   Nodes are updated in order on the calling thread. Nodes that can
+        ///   be prepared in parallel, e.g. sprite batches, are then prepared on
+        ///   the job system and committed on the calling thread.
+        /// </remarks>
         void update(unsigned long dt) const;
 
     protected:
-        SceneNode() : enabled_(true), program_(0) {}
+        SceneNode()
+            : enabled_(true), auto_merges_(false), culls_(false),
+              has_blend_mode_(false), has_layer_(false), sorts_by_state_(false),
+              program_(0), blend_mode_(graphics::BlendMode::Alpha), layer_(0),
+              bounds_(Rect::infinite()) {}
 
     private:
+        struct DrawState;
+
         bool enabled_;
+        bool auto_merges_;
+        bool culls_;
+        bool has_blend_mode_;
+        bool has_layer_;
+        bool sorts_by_state_;
         unsigned int program_;
+        graphics::BlendMode blend_mode_;
+        int layer_;
+        mutable Rect bounds_;  ///< Bounds of this subtree.
+
+        /// <summary>
+        ///   Commands of the subtree being drawn. Kept between frames so that
+        ///   its storage is reused.
+        /// </summary>
+        mutable graphics::RenderQueue queue_;
+
 #if USE_NODE_TAGS
         std::string tag_;
+        const char* zone_name_ = "SceneNode";  ///< Tag, as named in profiles.
+#endif
+
+        /// <summary>Returns the name of this node's profiler zones.</summary>
+        auto zone_name() const -> const char*
+        {
+#if USE_NODE_TAGS
+            return zone_name_;
+#else
+            return "SceneNode";
 #endif
+        }
 
         virtual void draw_impl() const = 0;
         virtual void move_impl(const Vec2f&) const = 0;
         virtual void update_impl(unsigned long dt) const = 0;
+
+        /// <summary>
+        ///   Returns the bounds of what this node draws, excluding its
+        ///   children. Infinite if unknown.
+        /// </summary>
+        virtual auto bounds_impl() const -> Rect { return Rect::infinite(); }
+
+        /// <summary>
+        ///   Returns the texture this node binds when drawn, or
+        ///   <c>nullptr</c> if it is unknown. Used for sorting only.
+        /// </summary>
+        virtual auto texture_key() const -> const void* { return nullptr; }
+
+        /// <summary>
+        ///   Returns the sprite batch drawn by this node if it may be merged
+        ///   with others; <c>nullptr</c> otherwise.
+        /// </summary>
+        virtual auto mergeable_batch() const -> const SpriteBatch*
+        {
+            return nullptr;
+        }
+
+        /// <summary>
+        ///   Returns the object updated by <see cref="prepare_impl"/> and
+        ///   <see cref="commit_impl"/>, or <c>nullptr</c> if this node has no
+        ///   deferred update. Nodes sharing a target are only updated once.
+        /// </summary>
+        virtual auto deferred_target() const -> const void* { return nullptr; }
+
+        /// <summary>
+        ///   Deferred part of the update that may run on a worker thread,
+        ///   concurrently with other nodes.
+        /// </summary>
+        virtual void prepare_impl() const {}
+
+        /// <summary>
+        ///   Completes a deferred update on the calling thread, e.g. uploads to
+        ///   the GPU.
+        /// </summary>
+        virtual void commit_impl() const {}
+
+        void draw(graphics::RenderQueue& queue, const DrawState& state) const;
+
+        void update(unsigned long dt,
+                    std::vector<const SceneNode*>& deferred) const;
+
+        /// <summary>Recalculates the bounds of this subtree.</summary>
+        void update_bounds() const;
     };
 
     class GroupNode final : public SceneNode
     {
     private:
+        auto bounds_impl() const -> Rect override { return Rect::none(); }
         void draw_impl() const override {}
         void move_impl(const Vec2f&) const override {}
         void update_impl(unsigned long) const override {}
@@ -15,6 +15,8 @@ namespace Shader
         kAttributeColor,
         kAttributeTexCoord,
         kAttributeNormal,
+        kAttributeTransform,
+        kAttributeOrigin,
         kAttributeNone
     };
 
@@ -201,8 +201,16 @@ void ShaderManager::update_viewport()
 
 void ShaderManager::use(unsigned int program)
 {
+#ifndef NDEBUG
+    ++rainbow::graphics::detail::g_state_changes_accumulator.program_requests;
+#endif
+
     if (program != current_)
     {
+#ifndef NDEBUG
+        ++rainbow::graphics::detail::g_state_changes_accumulator.programs;
+#endif
+
 #ifndef USE_VERTEX_ARRAY_OBJECT
         const Shader::Details& current = get_program();
 #endif  // !USE_VERTEX_ARRAY_OBJECT
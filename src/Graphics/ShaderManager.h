@@ -61,6 +61,9 @@ public:
     unsigned int compile(Shader::Params* shaders,
                          const Shader::AttributeParams* attributes);
 
+    /// <summary>Returns the program currently in use.</summary>
+    auto current() const { return current_; }
+
     /// <summary>Returns current program details.</summary>
     const Shader::Details& get_program() const
     {
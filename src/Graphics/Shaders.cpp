@@ -17,8 +17,10 @@ namespace rainbow
 
         const char kDiffuseLight2Df[]      = "Shaders/DiffuseLight2D.fsh";
         const char kDiffuseLightNormalf[]  = "Shaders/DiffuseLightNormal.fsh";
+        const char kDistanceFieldf[]       = "Shaders/DistanceField.fsh";
         const char kFixed2Df[]             = "Shaders/Fixed2D.fsh";
         const char kFixed2Dv[]             = "Shaders/Fixed2D.vsh";
+        const char kFixed2DInstancedv[]    = "Shaders/Fixed2DInstanced.vsh";
         const char kNormalMappedv[]        = "Shaders/NormalMapped.vsh";
         const char kSimple2Dv[]            = "Shaders/Simple2D.vsh";
         const char kSimplef[]              = "Shaders/Simple.fsh";
@@ -13,8 +13,10 @@ namespace rainbow
         {
             extern const char kDiffuseLight2Df[];
             extern const char kDiffuseLightNormalf[];
+            extern const char kDistanceFieldf[];
             extern const char kFixed2Df[];
             extern const char kFixed2Dv[];
+            extern const char kFixed2DInstancedv[];
             extern const char kNormalMappedv[];
             extern const char kSimple2Dv[];
             extern const char kSimplef[];
@@ -22,8 +24,10 @@ namespace rainbow
 
         extern const char kDiffuseLight2Df[];
         extern const char kDiffuseLightNormalf[];
+        extern const char kDistanceFieldf[];
         extern const char kFixed2Df[];
         extern const char kFixed2Dv[];
+        extern const char kFixed2DInstancedv[];
         extern const char kNormalMappedv[];
         extern const char kSimple2Dv[];
         extern const char kSimplef[];
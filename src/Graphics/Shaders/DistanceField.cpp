@@ -0,0 +1,71 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include "Graphics/Shaders/DistanceField.h"
+
+#include "Graphics/Renderer.h"
+#include "Graphics/Shaders.h"
+
+namespace
+{
+    void set_color(int location, const Colorb& c)
+    {
+        const float kNormalize = 1.0f / 255.0f;
+        glUniform4f(location,
+                    c.r * kNormalize,
+                    c.g * kNormalize,
+                    c.b * kNormalize,
+                    c.a * kNormalize);
+    }
+}
+
+namespace rainbow { namespace shaders
+{
+    DistanceField::DistanceField()
+        : smoothing_(0), outline_(0), outline_color_(0), glow_(0),
+          glow_color_(0), program_(ShaderManager::kInvalidProgram)
+    {
+        Shader::Params shaders[]{
+            {Shader::kTypeVertex, 0, nullptr, nullptr},  // kFixed2Dv
+            {Shader::kTypeFragment, 0, kDistanceFieldf,
+             integrated::kDistanceFieldf},
+            {Shader::kTypeInvalid, 0, nullptr, nullptr}};
+        program_ = ShaderManager::Get()->compile(shaders, nullptr);
+        if (program_ == ShaderManager::kInvalidProgram)
+            return;
+
+        ShaderManager::Context context;
+        ShaderManager::Get()->use(program_);
+        const Shader::Details& details =
+            ShaderManager::Get()->get_program(program_);
+        smoothing_ = glGetUniformLocation(details.program, "smoothing");
+        outline_ = glGetUniformLocation(details.program, "outline");
+        outline_color_ =
+            glGetUniformLocation(details.program, "outline_color");
+        glow_ = glGetUniformLocation(details.program, "glow");
+        glow_color_ = glGetUniformLocation(details.program, "glow_color");
+        glUniform1i(glGetUniformLocation(details.program, "texture"), 0);
+        glUniform1f(outline_, 0.0f);
+        glUniform1f(glow_, 0.0f);
+
+        R_ASSERT(glGetError() == GL_NO_ERROR,
+                 "Failed to load distance field shader");
+    }
+
+    void DistanceField::set_smoothing(float smoothing) const
+    {
+        glUniform1f(smoothing_, smoothing);
+    }
+
+    void DistanceField::set_effects(float outline,
+                                    const Colorb& outline_color,
+                                    float glow,
+                                    const Colorb& glow_color) const
+    {
+        glUniform1f(outline_, outline);
+        set_color(outline_color_, outline_color);
+        glUniform1f(glow_, glow);
+        set_color(glow_color_, glow_color);
+    }
+}}  // namespace rainbow::shaders
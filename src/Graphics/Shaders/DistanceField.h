@@ -0,0 +1,48 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef GRAPHICS_SHADERS_DISTANCEFIELD_H_
+#define GRAPHICS_SHADERS_DISTANCEFIELD_H_
+
+#include "Common/Color.h"
+
+namespace rainbow { namespace shaders
+{
+    /// <summary>
+    ///   Renders text from signed distance field font atlases, with optional
+    ///   outline and glow.
+    /// </summary>
+    class DistanceField
+    {
+    public:
+        DistanceField();
+
+        unsigned int id() const { return program_; }
+
+        /// <summary>Sets the width of the anti-aliased edge.</summary>
+        /// <remarks>The program must be in use.</remarks>
+        void set_smoothing(float smoothing) const;
+
+        /// <summary>
+        ///   Sets outline and glow. Widths are in distance units, where 0.5
+        ///   spans the distance field's spread. A width of 0 disables the
+        ///   effect.
+        /// </summary>
+        /// <remarks>The program must be in use.</remarks>
+        void set_effects(float outline,
+                         const Colorb& outline_color,
+                         float glow,
+                         const Colorb& glow_color) const;
+
+    private:
+        int smoothing_;      ///< Half the width of the anti-aliased edge.
+        int outline_;        ///< Width of the outline.
+        int outline_color_;  ///< Colour of the outline.
+        int glow_;           ///< Width of the glow.
+        int glow_color_;     ///< Colour of the glow.
+        unsigned int program_;
+    };
+}}  // namespace rainbow::shaders
+
+#endif
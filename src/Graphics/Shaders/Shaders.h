@@ -82,6 +82,54 @@ void main()
 }
 )";
 
+const char kDistanceFieldf[] =
+R"(
+#ifdef GL_ES
+#   ifdef GL_FRAGMENT_PRECISION_HIGH
+precision highp float;
+#   else
+precision mediump float;
+#   endif
+#else
+#   define lowp
+#endif
+
+uniform float smoothing;
+uniform float outline;
+uniform lowp vec4 outline_color;
+uniform float glow;
+uniform lowp vec4 glow_color;
+uniform sampler2D texture;
+
+varying lowp vec4 v_color;
+varying vec2 v_texcoord;
+
+void main()
+{
+    float distance = texture2D(texture, v_texcoord).a;
+    float fill = smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);
+
+    vec4 color = v_color;
+    float alpha = fill;
+    if (outline > 0.0)
+    {
+        float edge = 0.5 - outline;
+        alpha = smoothstep(edge - smoothing, edge + smoothing, distance);
+        color = mix(outline_color, v_color, fill);
+    }
+    color.a *= alpha;
+
+    if (glow > 0.0)
+    {
+        float edge = 0.5 - outline;
+        float halo = smoothstep(edge - glow, edge, distance) * glow_color.a;
+        color = mix(vec4(glow_color.rgb, halo), color, color.a);
+    }
+
+    gl_FragColor = color;
+}
+)";
+
 const char kFixed2Df[] =
 R"(
 #ifdef GL_ES
@@ -134,6 +182,43 @@ void main()
 }
 )";
 
+const char kFixed2DInstancedv[] =
+R"(
+#ifdef GL_ES
+#   ifdef GL_FRAGMENT_PRECISION_HIGH
+precision highp float;
+#   else
+precision mediump float;
+#   endif
+#else
+#   define lowp
+#endif
+
+uniform mat4 mvp_matrix;
+
+attribute vec4 color;
+attribute vec3 origin;
+attribute vec4 texcoord;
+attribute vec4 transform;
+
+attribute vec2 vertex;
+
+varying lowp vec4 v_color;
+varying vec2 v_texcoord;
+
+void main()
+{
+    v_color = color;
+    v_texcoord = mix(texcoord.xy, texcoord.zw, vertex);
+
+    vec2 p = transform.zw * (vertex - vec2(origin.x, 1.0 - origin.y));
+    float c = cos(origin.z);
+    float s = sin(origin.z);
+    vec2 position = vec2(c * p.x + s * p.y, c * p.y - s * p.x);
+    gl_Position = mvp_matrix * vec4(transform.xy + position, 0.0, 1.0);
+}
+)";
+
 const char kNormalMappedv[] =
 R"(
 #ifdef GL_ES
@@ -0,0 +1,74 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include "Graphics/ShelfPacker.h"
+
+using rainbow::graphics::ShelfPacker;
+
+namespace
+{
+    /// <summary>
+    ///   Shelves are only reused by rectangles at least this fraction of their
+    ///   height, to avoid filling tall shelves with short rectangles.
+    /// </summary>
+    constexpr unsigned int kMinShelfFill = 70;  // percent
+}
+
+ShelfPacker::ShelfPacker(unsigned int width, unsigned int height)
+    : width_(width), height_(height), bottom_(0)
+{
+}
+
+void ShelfPacker::clear()
+{
+    bottom_ = 0;
+    shelves_.clear();
+}
+
+bool ShelfPacker::insert(const Vec2u& size, Vec2u& position)
+{
+    if (size.x > width_ || size.y > height_)
+        return false;
+
+    // Prefer the tightest shelf. Shelves that are too tall are only used when
+    // there is no room for a new one.
+    Shelf* best = nullptr;
+    Shelf* fallback = nullptr;
+    for (auto&& shelf : shelves_)
+    {
+        if (shelf.height < size.y || shelf.x + size.x > width_)
+            continue;
+
+        if (fallback == nullptr || shelf.height < fallback->height)
+            fallback = &shelf;
+        if (size.y * 100 >= shelf.height * kMinShelfFill)
+        {
+            if (best == nullptr || shelf.height < best->height)
+                best = &shelf;
+        }
+    }
+
+    if (best == nullptr)
+    {
+        if (bottom_ + size.y <= height_)
+        {
+            shelves_.push_back({bottom_, size.y, 0});
+            bottom_ += size.y;
+            best = &shelves_.back();
+        }
+        else if (fallback != nullptr)
+        {
+            best = fallback;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    position.x = best->x;
+    position.y = best->y;
+    best->x += size.x;
+    return true;
+}
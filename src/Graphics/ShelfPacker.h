@@ -0,0 +1,57 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef GRAPHICS_SHELFPACKER_H_
+#define GRAPHICS_SHELFPACKER_H_
+
+#include <vector>
+
+#include "Math/Vec2.h"
+
+namespace rainbow { namespace graphics
+{
+    /// <summary>
+    ///   Packs rectangles into a fixed-size area by placing them side by side
+    ///   on horizontal shelves.
+    /// </summary>
+    /// <remarks>
+    ///   A rectangle goes on the shelf that wastes the least height. A new
+    ///   shelf is opened below the last one when none fit. Works well for
+    ///   rectangles of similar height, e.g. font glyphs.
+    /// </remarks>
+    class ShelfPacker
+    {
+    public:
+        ShelfPacker(unsigned int width, unsigned int height);
+
+        auto height() const { return height_; }
+        auto width() const { return width_; }
+
+        /// <summary>Removes all rectangles.</summary>
+        void clear();
+
+        /// <summary>
+        ///   Finds room for a rectangle of <paramref name="size"/>.
+        /// </summary>
+        /// <param name="size">Size of the rectangle.</param>
+        /// <param name="position">[out] Top left corner.</param>
+        /// <returns><c>true</c> if the rectangle was placed.</returns>
+        bool insert(const Vec2u& size, Vec2u& position);
+
+    private:
+        struct Shelf
+        {
+            unsigned int y;       ///< Top of the shelf.
+            unsigned int height;  ///< Height of the shelf.
+            unsigned int x;       ///< Left of the unused space.
+        };
+
+        unsigned int width_;
+        unsigned int height_;
+        unsigned int bottom_;  ///< Bottom of the last shelf.
+        std::vector<Shelf> shelves_;
+    };
+}}  // namespace rainbow::graphics
+
+#endif
@@ -4,8 +4,12 @@
 
 #include "Graphics/Sprite.h"
 
+#include <algorithm>
+#include <utility>
+
 #include "Graphics/SpriteBatch.h"
 #include "Math/Transform.h"
+#include "Math/TransformBatch.h"
 
 namespace
 {
@@ -33,6 +37,11 @@ namespace
     {
         return ((state & kIsFlipped) >> 0xf) + ((state & kIsMirrored) >> 0xf);
     }
+
+    uint16_t normalize(float f)
+    {
+        return static_cast<uint16_t>(f * 65535.0f + 0.5f);
+    }
 }
 
 Sprite& SpriteRef::operator*() const
@@ -49,7 +58,8 @@ Sprite::Sprite(Sprite&& s)
     : state_(s.state_ | kStaleMask), center_(s.center_), position_(s.position_),
       texture_(s.texture_), color_(s.color_), width_(s.width_),
       height_(s.height_), angle_(s.angle_), pivot_(s.pivot_), scale_(s.scale_),
-      normal_map_(s.normal_map_), id_(s.id_), vertex_array_(s.vertex_array_)
+      normal_map_(s.normal_map_), id_(s.id_), vertex_array_(s.vertex_array_),
+      arrays_(s.arrays_)
 {
     s.id_ = kNoId;
     s.vertex_array_ = nullptr;
@@ -57,28 +67,28 @@ Sprite::Sprite(Sprite&& s)
 
 auto Sprite::is_flipped() const -> bool
 {
-    return (state_ & kIsFlipped) == kIsFlipped;
+    return (state_ref() & kIsFlipped) == kIsFlipped;
 }
 
 auto Sprite::is_hidden() const -> bool
 {
-    return (state_ & kIsHidden) == kIsHidden;
+    return (state_ref() & kIsHidden) == kIsHidden;
 }
 
 auto Sprite::is_mirrored() const -> bool
 {
-    return (state_ & kIsMirrored) == kIsMirrored;
+    return (state_ref() & kIsMirrored) == kIsMirrored;
 }
 
 void Sprite::set_color(Colorb c)
 {
-    state_ |= kStaleTexture;
+    state_ref() |= kStaleTexture;
     color_ = c;
 }
 
 void Sprite::set_normal(unsigned int id)
 {
-    state_ |= kStaleNormalMap;
+    state_ref() |= kStaleNormalMap;
     normal_map_ = id;
 }
 
@@ -88,28 +98,30 @@ void Sprite::set_pivot(const Vec2f& pivot)
              pivot.y >= 0.0f && pivot.y <= 1.0f,
              "Invalid pivot point");
 
+    Vec2f& current = pivot_ref();
     Vec2f diff = pivot;
-    diff -= pivot_;
+    diff -= current;
     if (diff.is_zero())
         return;
 
-    diff.x *= width_ * scale_.x;
-    diff.y *= height_ * scale_.y;
-    center_ += diff;
-    position_ += diff;
-    pivot_ = pivot;
+    const Vec2f& scale = scale_ref();
+    diff.x *= width_ * scale.x;
+    diff.y *= height_ * scale.y;
+    center_ref() += diff;
+    position_ref() += diff;
+    current = pivot;
 }
 
 void Sprite::set_position(const Vec2f& position)
 {
-    state_ |= kStalePosition;
-    position_ = position;
+    state_ref() |= kStalePosition;
+    position_ref() = position;
 }
 
 void Sprite::set_rotation(float r)
 {
-    state_ |= kStaleBuffer;
-    angle_ = r;
+    state_ref() |= kStaleBuffer;
+    angle_ref() = r;
 }
 
 void Sprite::set_scale(const Vec2f& f)
@@ -117,20 +129,21 @@ void Sprite::set_scale(const Vec2f& f)
     R_ASSERT(f.x > 0.0f && f.y > 0.0f,
              "Can't scale with a factor of zero or less");
 
-    state_ |= kStaleBuffer;
-    scale_ = f;
+    state_ref() |= kStaleBuffer;
+    scale_ref() = f;
 }
 
 void Sprite::set_texture(unsigned int id)
 {
-    state_ |= kStaleTexture;
+    state_ref() |= kStaleTexture;
     texture_ = id;
 }
 
 void Sprite::flip()
 {
-    state_ ^= kIsFlipped;
-    state_ |= kStaleTexture;
+    unsigned int& state = state_ref();
+    state ^= kIsFlipped;
+    state |= kStaleTexture;
 }
 
 void Sprite::hide()
@@ -138,25 +151,31 @@ void Sprite::hide()
     if (is_hidden())
         return;
 
-    state_ |= kIsHidden | kStaleMask;
+    state_ref() |= kIsHidden | kStaleMask;
+}
+
+void Sprite::invalidate()
+{
+    state_ref() |= kStaleMask;
 }
 
 void Sprite::mirror()
 {
-    state_ ^= kIsMirrored;
-    state_ |= kStaleTexture;
+    unsigned int& state = state_ref();
+    state ^= kIsMirrored;
+    state |= kStaleTexture;
 }
 
 void Sprite::move(const Vec2f& delta)
 {
-    state_ |= kStalePosition;
-    position_ += delta;
+    state_ref() |= kStalePosition;
+    position_ref() += delta;
 }
 
 void Sprite::rotate(float r)
 {
-    state_ |= kStaleBuffer;
-    angle_ += r;
+    state_ref() |= kStaleBuffer;
+    angle_ref() += r;
 }
 
 void Sprite::show()
@@ -164,14 +183,17 @@ void Sprite::show()
     if (!is_hidden())
         return;
 
-    state_ &= ~kIsHidden;
-    state_ |= kStaleMask;
+    unsigned int& state = state_ref();
+    state &= ~kIsHidden;
+    state |= kStaleMask;
 }
 
 auto Sprite::update(ArraySpan<SpriteVertex> vertex_array,
-                    const TextureAtlas& texture) -> bool
+                    const TextureAtlas& texture,
+                    rainbow::TransformBatch* transforms) -> bool
 {
-    if ((state_ & kStaleMask) == 0)
+    unsigned int& state = state_ref();
+    if ((state & kStaleMask) == 0)
         return false;
 
     if (is_hidden())
@@ -180,31 +202,36 @@ auto Sprite::update(ArraySpan<SpriteVertex> vertex_array,
         vertex_array[1].position = Vec2f::Zero;
         vertex_array[2].position = Vec2f::Zero;
         vertex_array[3].position = Vec2f::Zero;
-        state_ &= ~kStaleMask;
+        state &= ~kStaleMask;
         return true;
     }
 
-    if (state_ & kStaleBuffer)
+    Vec2f& center = center_ref();
+    Vec2f& position = position_ref();
+    if (state & kStaleBuffer)
     {
-        if (state_ & kStalePosition)
-            center_ = position_;
+        if (state & kStalePosition)
+            center = position;
 
-        rainbow::transform(*this, vertex_array);
+        if (transforms != nullptr)
+            transforms->push(*this, &vertex_array[0].position);
+        else
+            rainbow::transform(*this, vertex_array);
     }
-    else if (state_ & kStalePosition)
+    else if (state & kStalePosition)
     {
-        position_ -= center_;
-        vertex_array[0].position += position_;
-        vertex_array[1].position += position_;
-        vertex_array[2].position += position_;
-        vertex_array[3].position += position_;
-        center_ += position_;
-        position_ = center_;
+        position -= center;
+        vertex_array[0].position += position;
+        vertex_array[1].position += position;
+        vertex_array[2].position += position;
+        vertex_array[3].position += position;
+        center += position;
+        position = center;
     }
 
-    if (state_ & kStaleTexture)
+    if (state & kStaleTexture)
     {
-        const unsigned int f = flip_index(state_);
+        const unsigned int f = flip_index(state);
         const auto& tx = texture[texture_];
         for (unsigned int i = 0; i < 4; ++i)
         {
@@ -213,26 +240,159 @@ auto Sprite::update(ArraySpan<SpriteVertex> vertex_array,
         }
     }
 
-    state_ &= ~kStaleMask;
+    state &= ~kStaleMask;
     vertex_array_ = vertex_array.data();
     return true;
 }
 
+auto Sprite::update(SpriteInstance& instance, const TextureAtlas& texture)
+    -> bool
+{
+    unsigned int& state = state_ref();
+    if ((state & kStaleMask) == 0)
+        return false;
+
+    // Instances are small enough that it is cheaper to rewrite them whole
+    // than to track which parts are stale.
+    Vec2f& center = center_ref();
+    center = position_ref();
+    instance.center = center;
+    state &= ~kStaleMask;
+    vertex_array_ = nullptr;
+
+    if (is_hidden())
+    {
+        instance.extent = Vec2f::Zero;
+        return true;
+    }
+
+    const Vec2f& scale = scale_ref();
+    instance.extent.x = width_ * scale.x;
+    instance.extent.y = height_ * scale.y;
+    instance.pivot = pivot_ref();
+    instance.angle = angle_ref();
+    instance.color = color_;
+
+    const auto& tx = texture[texture_];
+    Vec2f uv0 = tx.vx[0];
+    Vec2f uv2 = tx.vx[2];
+    if (is_mirrored())
+        std::swap(uv0.x, uv2.x);
+    if (is_flipped())
+        std::swap(uv0.y, uv2.y);
+    instance.texcoord[0] = normalize(uv0.x);
+    instance.texcoord[1] = normalize(uv0.y);
+    instance.texcoord[2] = normalize(uv2.x);
+    instance.texcoord[3] = normalize(uv2.y);
+    return true;
+}
+
 auto Sprite::update(ArraySpan<Vec2f> normal_array, const TextureAtlas& normal)
     -> bool
 {
-    if ((state_ & kStaleNormalMap) == 0)
+    unsigned int& state = state_ref();
+    if ((state & kStaleNormalMap) == 0)
         return false;
 
-    state_ ^= kStaleNormalMap;
+    state ^= kStaleNormalMap;
 
-    const unsigned int f = flip_index(state_);
+    const unsigned int f = flip_index(state);
     const auto& tx = normal[normal_map_];
     for (unsigned int i = 0; i < 4; ++i)
         normal_array[kFlipTable[f + i]] = tx.vx[i];
     return true;
 }
 
+void Sprite::update(rainbow::SpriteArrays& arrays,
+                    Sprite* sprites,
+                    size_t begin,
+                    size_t end,
+                    SpriteVertex* vertices,
+                    const TextureAtlas& texture,
+                    unsigned int& first,
+                    unsigned int& last)
+{
+    // Consecutive sprites that need a full transform are computed together.
+    size_t run = end;
+    auto flush = [&arrays, vertices, end, &run](size_t i) {
+        if (run < i)
+        {
+            rainbow::transform_quads(arrays.position.data() + run,
+                                     arrays.angle.data() + run,
+                                     arrays.scale.data() + run,
+                                     arrays.pivot.data() + run,
+                                     arrays.size.data() + run,
+                                     i - run,
+                                     &vertices[run * 4].position,
+                                     sizeof(SpriteVertex));
+        }
+        run = end;
+    };
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        unsigned int& state = arrays.state[i];
+        if ((state & kStaleMask) == 0)
+        {
+            flush(i);
+            continue;
+        }
+
+        first = std::min(first, static_cast<unsigned int>(i));
+        last = i + 1;
+
+        SpriteVertex* vertex_array = vertices + i * 4;
+        if (state & kIsHidden)
+        {
+            flush(i);
+            vertex_array[0].position = Vec2f::Zero;
+            vertex_array[1].position = Vec2f::Zero;
+            vertex_array[2].position = Vec2f::Zero;
+            vertex_array[3].position = Vec2f::Zero;
+            state &= ~kStaleMask;
+            continue;
+        }
+
+        if (state & kStaleBuffer)
+        {
+            if (state & kStalePosition)
+                arrays.center[i] = arrays.position[i];
+            if (run == end)
+                run = i;
+        }
+        else
+        {
+            flush(i);
+            if (state & kStalePosition)
+            {
+                const Vec2f delta = arrays.position[i] - arrays.center[i];
+                vertex_array[0].position += delta;
+                vertex_array[1].position += delta;
+                vertex_array[2].position += delta;
+                vertex_array[3].position += delta;
+                arrays.center[i] = arrays.position[i];
+            }
+        }
+
+        Sprite& sprite = sprites[i];
+        if (state & kStaleTexture)
+        {
+            const unsigned int f = flip_index(state);
+            const auto& tx = texture[sprite.texture_];
+            for (unsigned int j = 0; j < 4; ++j)
+            {
+                vertex_array[kFlipTable[f + j]].color = sprite.color_;
+                vertex_array[kFlipTable[f + j]].texcoord = tx.vx[j];
+            }
+        }
+
+        state &= ~kStaleMask;
+        sprite.vertex_array_ = vertex_array;
+    }
+
+    flush(end);
+}
+
 Sprite& Sprite::operator=(Sprite&& s)
 {
     state_ = s.state_ | kStaleMask;
@@ -248,9 +408,99 @@ Sprite& Sprite::operator=(Sprite&& s)
     normal_map_ = s.normal_map_;
     id_ = s.id_;
     vertex_array_ = s.vertex_array_;
+    arrays_ = s.arrays_;
 
     s.id_ = kNoId;
     s.vertex_array_ = nullptr;
 
     return *this;
 }
+
+void Sprite::set_arrays(rainbow::SpriteArrays* arrays)
+{
+    if (arrays == arrays_)
+        return;
+
+    if (arrays_ != nullptr)
+    {
+        const size_t i = arrays_->index(this);
+        state_ = arrays_->state[i];
+        center_ = arrays_->center[i];
+        position_ = arrays_->position[i];
+        angle_ = arrays_->angle[i];
+        pivot_ = arrays_->pivot[i];
+        scale_ = arrays_->scale[i];
+    }
+
+    if (arrays != nullptr)
+    {
+        const size_t i = arrays->index(this);
+        arrays->state[i] = state_;
+        arrays->center[i] = center_;
+        arrays->position[i] = position_;
+        arrays->angle[i] = angle_;
+        arrays->pivot[i] = pivot_;
+        arrays->scale[i] = scale_;
+        arrays->size[i] = Vec2f(width_, height_);
+    }
+
+    arrays_ = arrays;
+}
+
+void rainbow::SpriteArrays::invalidate(size_t first, size_t last)
+{
+    for (size_t i = first; i < last; ++i)
+        state[i] |= kStaleMask;
+}
+
+void rainbow::SpriteArrays::reserve(size_t n)
+{
+    state.reserve(n);
+    center.reserve(n);
+    position.reserve(n);
+    angle.reserve(n);
+    pivot.reserve(n);
+    scale.reserve(n);
+    size.reserve(n);
+}
+
+void rainbow::SpriteArrays::resize(size_t n)
+{
+    state.resize(n);
+    center.resize(n);
+    position.resize(n);
+    angle.resize(n);
+    pivot.resize(n);
+    scale.resize(n);
+    size.resize(n);
+}
+
+void rainbow::SpriteArrays::rotate(size_t first, size_t n_first, size_t last)
+{
+    auto rotate = [first, n_first, last](auto& array) {
+        std::rotate(array.begin() + first,
+                    array.begin() + n_first,
+                    array.begin() + last);
+    };
+    rotate(state);
+    rotate(center);
+    rotate(position);
+    rotate(angle);
+    rotate(pivot);
+    rotate(scale);
+    rotate(size);
+    invalidate(first, last);
+}
+
+void rainbow::SpriteArrays::swap(size_t a, size_t b)
+{
+    std::swap(state[a], state[b]);
+    std::swap(center[a], center[b]);
+    std::swap(position[a], position[b]);
+    std::swap(angle[a], angle[b]);
+    std::swap(pivot[a], pivot[b]);
+    std::swap(scale[a], scale[b]);
+    std::swap(size[a], size[b]);
+    state[a] |= kStaleMask;
+    state[b] |= kStaleMask;
+}
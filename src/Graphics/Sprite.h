@@ -5,7 +5,10 @@
 #ifndef GRAPHICS_SPRITE_H_
 #define GRAPHICS_SPRITE_H_
 
+#include <vector>
+
 #include "Common/NonCopyable.h"
+#include "Graphics/SpriteInstance.h"
 #include "Graphics/SpriteVertex.h"
 #include "Memory/Array.h"
 
@@ -13,6 +16,48 @@ class Sprite;
 class SpriteBatch;
 class TextureAtlas;
 
+namespace rainbow
+{
+    class TransformBatch;
+
+    /// <summary>
+    ///   Sprite properties that are read every frame, stored as a structure
+    ///   of arrays by batches that ask for it. Element <c>i</c> belongs to
+    ///   the <c>i</c>th sprite of the batch.
+    /// </summary>
+    struct SpriteArrays
+    {
+        const Sprite* sprites = nullptr;  ///< First sprite of the batch.
+        std::vector<unsigned int> state;  ///< See <see cref="Sprite"/>.
+        std::vector<Vec2f> center;        ///< Committed positions.
+        std::vector<Vec2f> position;      ///< Uncommitted positions.
+        std::vector<float> angle;
+        std::vector<Vec2f> pivot;
+        std::vector<Vec2f> scale;
+        std::vector<Vec2f> size;          ///< Sizes (not scaled).
+
+        /// <summary>Returns the index of <paramref name="sprite"/>.</summary>
+        auto index(const Sprite* sprite) const -> size_t;
+
+        /// <summary>
+        ///   Marks all buffers of sprites [first, last) as stale.
+        /// </summary>
+        void invalidate(size_t first, size_t last);
+
+        void reserve(size_t n);
+        void resize(size_t n);
+
+        /// <summary>
+        ///   Performs a left rotation on a range of elements, and marks them
+        ///   as stale.
+        /// </summary>
+        void rotate(size_t first, size_t n_first, size_t last);
+
+        /// <summary>Swaps two elements, and marks them as stale.</summary>
+        void swap(size_t a, size_t b);
+    };
+}
+
 class SpriteRef
 {
 public:
@@ -70,16 +115,16 @@ public:
     Sprite(unsigned int w, unsigned int h) : width_(w), height_(h) {}
     Sprite(Sprite&&);
 
-    auto angle() const { return angle_; }
+    auto angle() const { return angle_ref(); }
     auto color() const { return color_; }
     auto height() const { return height_; }
     auto id() const { return id_; }
     auto is_flipped() const -> bool;
     auto is_hidden() const -> bool;
     auto is_mirrored() const -> bool;
-    auto pivot() const { return pivot_; }
-    auto position() const { return position_; }
-    auto scale() const { return scale_; }
+    auto pivot() const { return pivot_ref(); }
+    auto position() const { return position_ref(); }
+    auto scale() const { return scale_ref(); }
     auto vertex_array() const -> const SpriteVertex* { return vertex_array_; }
     auto width() const { return width_; }
 
@@ -126,6 +171,9 @@ public:
     /// <summary>Hides sprite if it is currently shown.</summary>
     void hide();
 
+    /// <summary>Marks all buffers as stale.</summary>
+    void invalidate();
+
     /// <summary>Mirrors sprite.</summary>
     void mirror();
 
@@ -139,11 +187,25 @@ public:
     void show();
 
     /// <summary>Updates the vertex buffer.</summary>
+    /// <param name="transforms">
+    ///   If set, vertex positions are queued here instead of being computed
+    ///   immediately. They are not valid until the batch has been applied.
+    /// </param>
     /// <returns>
     ///   <c>true</c> if the buffer has changed; <c>false</c> otherwise.
     /// </returns>
     auto update(ArraySpan<SpriteVertex> vertex_array,
-                const TextureAtlas& texture) -> bool;
+                const TextureAtlas& texture,
+                rainbow::TransformBatch* transforms = nullptr) -> bool;
+
+    /// <summary>Updates the instance buffer.</summary>
+    /// <remarks>
+    ///   Sprites drawn with instancing have no vertex array.
+    /// </remarks>
+    /// <returns>
+    ///   <c>true</c> if the buffer has changed; <c>false</c> otherwise.
+    /// </returns>
+    auto update(SpriteInstance& instance, const TextureAtlas& texture) -> bool;
 
     /// <summary>Updates the normal buffer.</summary>
     /// <returns>
@@ -152,10 +214,30 @@ public:
     auto update(ArraySpan<Vec2f> normal_array,
                 const TextureAtlas& normal) -> bool;
 
+    /// <summary>
+    ///   Updates the vertex buffer of sprites [begin, end), whose properties
+    ///   are stored in <paramref name="arrays"/>. Quads that need a full
+    ///   transform are computed straight from the arrays, several at a time.
+    /// </summary>
+    /// <param name="first">
+    ///   Lowered to the first sprite whose buffer changed, if any.
+    /// </param>
+    /// <param name="last">
+    ///   Set to one past the last sprite whose buffer changed, if any.
+    /// </param>
+    static void update(rainbow::SpriteArrays& arrays,
+                       Sprite* sprites,
+                       size_t begin,
+                       size_t end,
+                       SpriteVertex* vertices,
+                       const TextureAtlas& texture,
+                       unsigned int& first,
+                       unsigned int& last);
+
     Sprite& operator=(Sprite&&);
 
 #ifdef RAINBOW_TEST
-    auto state() const { return state_; }
+    auto state() const { return state_ref(); }
 #endif
 
 private:
@@ -172,8 +254,105 @@ private:
     unsigned int normal_map_ = 0;
     int id_ = kNoId;                        ///< Sprite identifier.
     SpriteVertex* vertex_array_ = nullptr;  ///< Interleaved vertex array.
+
+    /// <summary>
+    ///   Batch storage of the properties above that are read every frame;
+    ///   <c>nullptr</c> if they are stored in this sprite.
+    /// </summary>
+    rainbow::SpriteArrays* arrays_ = nullptr;
+
+    /// <summary>
+    ///   Returns <paramref name="member"/>, or its element in
+    ///   <paramref name="array"/> if the sprite's properties are stored by
+    ///   its batch.
+    /// </summary>
+    template <typename T>
+    auto hot(T Sprite::*member,
+             std::vector<T> rainbow::SpriteArrays::*array) const -> const T&
+    {
+        return arrays_ == nullptr ? this->*member
+                                  : (arrays_->*array)[arrays_->index(this)];
+    }
+
+    template <typename T>
+    auto hot(T Sprite::*member, std::vector<T> rainbow::SpriteArrays::*array)
+        -> T&
+    {
+        return arrays_ == nullptr ? this->*member
+                                  : (arrays_->*array)[arrays_->index(this)];
+    }
+
+    auto angle_ref() const -> const float&
+    {
+        return hot(&Sprite::angle_, &rainbow::SpriteArrays::angle);
+    }
+
+    auto angle_ref() -> float&
+    {
+        return hot(&Sprite::angle_, &rainbow::SpriteArrays::angle);
+    }
+
+    auto center_ref() -> Vec2f&
+    {
+        return hot(&Sprite::center_, &rainbow::SpriteArrays::center);
+    }
+
+    auto pivot_ref() const -> const Vec2f&
+    {
+        return hot(&Sprite::pivot_, &rainbow::SpriteArrays::pivot);
+    }
+
+    auto pivot_ref() -> Vec2f&
+    {
+        return hot(&Sprite::pivot_, &rainbow::SpriteArrays::pivot);
+    }
+
+    auto position_ref() const -> const Vec2f&
+    {
+        return hot(&Sprite::position_, &rainbow::SpriteArrays::position);
+    }
+
+    auto position_ref() -> Vec2f&
+    {
+        return hot(&Sprite::position_, &rainbow::SpriteArrays::position);
+    }
+
+    auto scale_ref() const -> const Vec2f&
+    {
+        return hot(&Sprite::scale_, &rainbow::SpriteArrays::scale);
+    }
+
+    auto scale_ref() -> Vec2f&
+    {
+        return hot(&Sprite::scale_, &rainbow::SpriteArrays::scale);
+    }
+
+    auto state_ref() const -> const unsigned int&
+    {
+        return hot(&Sprite::state_, &rainbow::SpriteArrays::state);
+    }
+
+    auto state_ref() -> unsigned int&
+    {
+        return hot(&Sprite::state_, &rainbow::SpriteArrays::state);
+    }
+
+    /// <summary>
+    ///   Moves the properties read every frame to <paramref name="arrays"/>,
+    ///   or back into the sprite if <c>nullptr</c>. The arrays must already
+    ///   have room for the sprite.
+    /// </summary>
+    void set_arrays(rainbow::SpriteArrays* arrays);
+
+    friend SpriteBatch;
 };
 
+inline auto rainbow::SpriteArrays::index(const Sprite* sprite) const
+    -> size_t
+{
+    return sprite - sprites;
+}
+
 class SpriteModel
 {
 public:
@@ -4,10 +4,24 @@
 
 #include "Graphics/SpriteBatch.h"
 
+#include <limits>
+
 #include "Graphics/Renderer.h"
+#include "Threading/JobSystem.h"
+
+namespace
+{
+    /// <summary>
+    ///   Number of sprites updated per job. Batches smaller than this are
+    ///   updated on the calling thread.
+    /// </summary>
+    constexpr size_t kSpritesPerJob = 1024;
+}
 
 SpriteBatch::SpriteBatch(unsigned int hint)
-    : count_(0), reserved_(0), visible_(true)
+    : count_(0), bounds_(rainbow::Rect::none()),
+      first_dirty_(std::numeric_limits<unsigned int>::max()),
+      last_dirty_(0), reserved_(0), instanced_(false), visible_(true)
 {
     resize(hint);
     array_.reconfigure(std::bind(&SpriteBatch::bind_arrays, this));
@@ -34,12 +48,17 @@ SpriteBatch::SpriteBatch(SharedPtr<TextureAtlas> texture, SpriteList sprites)
 SpriteBatch::SpriteBatch(SpriteBatch&& batch)
     : sprites_(std::move(batch.sprites_)),
       vertices_(std::move(batch.vertices_)),
-      normals_(std::move(batch.normals_)), count_(batch.count_),
+      normals_(std::move(batch.normals_)),
+      instances_(std::move(batch.instances_)),
+      arrays_(std::move(batch.arrays_)), count_(batch.count_),
       vertex_buffer_(std::move(batch.vertex_buffer_)),
       normal_buffer_(std::move(batch.normal_buffer_)),
       array_(std::move(batch.array_)), normal_(std::move(batch.normal_)),
-      texture_(std::move(batch.texture_)), reserved_(batch.reserved_),
-      visible_(batch.visible_)
+      texture_(std::move(batch.texture_)),
+      chunks_(std::move(batch.chunks_)), bounds_(batch.bounds_),
+      first_dirty_(batch.first_dirty_),
+      last_dirty_(batch.last_dirty_), reserved_(batch.reserved_),
+      instanced_(batch.instanced_), visible_(batch.visible_)
 {
     batch.clear();
 }
@@ -49,10 +68,41 @@ SpriteBatch::~SpriteBatch()
     sprites_.release(count_);
     vertices_.release(count_ * 4);
     normals_.release(count_ * 4);
+    instances_.release(count_);
+}
+
+void SpriteBatch::set_instanced(bool enable)
+{
+    enable = enable && !normals_ && rainbow::graphics::supports_instancing();
+    if (enable == instanced_)
+        return;
+
+    if (enable)
+    {
+        instances_.resize(0, reserved_);
+        std::uninitialized_fill_n(instances_.get(), count_, SpriteInstance{});
+        vertices_.release(count_ * 4);
+        vertices_.reset();
+    }
+    else
+    {
+        vertices_.resize(0, reserved_ * 4);
+        std::uninitialized_fill_n(vertices_.get(), count_ * 4, SpriteVertex{});
+        instances_.release(count_);
+        instances_.reset();
+    }
+
+    instanced_ = enable;
+    for (auto&& sprite : *this)
+        sprite.invalidate();
+    array_.reconfigure(std::bind(&SpriteBatch::bind_arrays, this));
 }
 
 void SpriteBatch::set_normal(SharedPtr<TextureAtlas> texture)
 {
+    // Normal-mapped sprites are expanded on the CPU.
+    set_instanced(false);
+
     if (!normals_)
     {
         normals_.resize(0, reserved_ * 4);
@@ -63,6 +113,28 @@ void SpriteBatch::set_normal(SharedPtr<TextureAtlas> texture)
     normal_ = std::move(texture);
 }
 
+void SpriteBatch::set_storage(Storage storage)
+{
+    if (storage == this->storage())
+        return;
+
+    if (storage == Storage::StructOfArrays)
+    {
+        arrays_ = std::make_unique<rainbow::SpriteArrays>();
+        arrays_->sprites = sprites_.get();
+        arrays_->reserve(reserved_);
+        arrays_->resize(count_);
+        for (auto&& sprite : *this)
+            sprite.set_arrays(arrays_.get());
+    }
+    else
+    {
+        for (auto&& sprite : *this)
+            sprite.set_arrays(nullptr);
+        arrays_.reset();
+    }
+}
+
 void SpriteBatch::set_texture(SharedPtr<TextureAtlas> texture)
 {
     texture_ = std::move(texture);
@@ -91,9 +163,6 @@ void SpriteBatch::bring_to_front(const SpriteRef& s)
 
 SpriteRef SpriteBatch::create_sprite(unsigned int width, unsigned int height)
 {
-    R_ASSERT(count_ <= rainbow::graphics::kMaxSprites,
-             "Hard-coded limit reached");
-
     if (count_ == reserved_)
     {
         const unsigned int half = reserved_ / 2;
@@ -102,6 +171,17 @@ SpriteRef SpriteBatch::create_sprite(unsigned int width, unsigned int height)
 
     Sprite& sprite = sprites_[count_];
     new (&sprite) Sprite(width, height);
+    if (arrays_)
+    {
+        arrays_->resize(count_ + 1);
+        sprite.set_arrays(arrays_.get());
+    }
+    if (instanced_)
+    {
+        std::uninitialized_fill_n(instances_ + count_, 1, SpriteInstance{});
+        return {this, count_++};
+    }
+
     const unsigned int offset = count_ * 4;
     std::uninitialized_fill_n(vertices_ + offset, 4, SpriteVertex{});
     if (normals_)
@@ -114,6 +194,8 @@ void SpriteBatch::erase(const SpriteRef& s)
     if (s.i_ + 1 < count_)
         bring_to_front(s);
     sprites_[--count_].~Sprite();
+    if (arrays_)
+        arrays_->resize(count_);
 }
 
 SpriteRef SpriteBatch::find_sprite_by_id(int id) const
@@ -141,42 +223,89 @@ void SpriteBatch::swap(const SpriteRef& a_ref, const SpriteRef& b_ref)
         return;
 
     std::swap(*a_ref, *b_ref);
+    if (arrays_)
+        arrays_->swap(a_ref.i_, b_ref.i_);
 }
 
-void SpriteBatch::update()
+void SpriteBatch::prepare()
 {
-    bool needs_update = false;
-    if (normals_)
+    // Sprites stay dirty until the textures are ready, so that they pick up
+    // the final texture coordinates.
+    if (!is_ready())
+        return;
+
+    const size_t num_chunks = (count_ + kSpritesPerJob - 1) / kSpritesPerJob;
+    if (chunks_.size() < num_chunks)
+        chunks_.resize(num_chunks);
+    for (auto&& chunk : chunks_)
     {
-        for (unsigned int i = 0; i < count_; ++i)
-        {
-            needs_update |=
-                sprites_[i].update(
-                    ArraySpan<Vec2f>(normals_ + i * 4, 4), *normal_) |
-                sprites_[i].update(
-                    ArraySpan<SpriteVertex>(vertices_ + i * 4, 4), *texture_);
-        }
+        chunk.first = count_;
+        chunk.last = 0;
     }
-    else
+
+    rainbow::parallel_for(
+        count_, kSpritesPerJob, [this](size_t begin, size_t end) {
+            update(begin, end, chunks_[begin / kSpritesPerJob]);
+        });
+
+    bounds_ = rainbow::Rect::none();
+    for (size_t i = 0; i < num_chunks; ++i)
     {
-        for (unsigned int i = 0; i < count_; ++i)
-        {
-            needs_update |= sprites_[i].update(
-                ArraySpan<SpriteVertex>(vertices_ + i * 4, 4), *texture_);
-        }
+        first_dirty_ = std::min(first_dirty_, chunks_[i].first);
+        last_dirty_ = std::max(last_dirty_, chunks_[i].last);
+        bounds_.extend(chunks_[i].bounds);
     }
+}
+
+void SpriteBatch::update()
+{
+    prepare();
+    upload();
+}
 
-    if (needs_update)
+void SpriteBatch::upload()
+{
+    // Sprites may have been erased since the last update.
+    last_dirty_ = std::min(last_dirty_, count_);
+    if (first_dirty_ < last_dirty_ && instanced_)
     {
-        const unsigned int count = count_ * 4;
-        vertex_buffer_.upload(vertices_.get(), count * sizeof(SpriteVertex));
+        const size_t length = last_dirty_ - first_dirty_;
+        vertex_buffer_.upload(instances_.get(),
+                              count_ * sizeof(SpriteInstance),
+                              first_dirty_ * sizeof(SpriteInstance),
+                              length * sizeof(SpriteInstance));
+    }
+    else if (first_dirty_ < last_dirty_)
+    {
+        const size_t count = count_ * 4;
+        const size_t offset = first_dirty_ * 4;
+        const size_t length = (last_dirty_ - first_dirty_) * 4;
+        vertex_buffer_.upload(vertices_.get(),
+                              count * sizeof(SpriteVertex),
+                              offset * sizeof(SpriteVertex),
+                              length * sizeof(SpriteVertex));
         if (normals_)
-            normal_buffer_.upload(normals_.get(), count * sizeof(Vec2f));
+        {
+            normal_buffer_.upload(normals_.get(),
+                                  count * sizeof(Vec2f),
+                                  offset * sizeof(Vec2f),
+                                  length * sizeof(Vec2f));
+        }
     }
+
+    first_dirty_ = std::numeric_limits<unsigned int>::max();
+    last_dirty_ = 0;
 }
 
 void SpriteBatch::bind_arrays() const
 {
+    if (instanced_)
+    {
+        rainbow::graphics::detail::unit_quad().bind(Shader::kAttributeVertex);
+        vertex_buffer_.bind_instances();
+        return;
+    }
+
     vertex_buffer_.bind();
     if (normals_)
         normal_buffer_.bind(Shader::kAttributeNormal);
@@ -185,7 +314,17 @@ void SpriteBatch::bind_arrays() const
 void SpriteBatch::resize(unsigned int size)
 {
     sprites_.resize(count_, size);
-    vertices_.resize(count_ * 4, size * 4);
+    if (arrays_)
+    {
+        // Moved sprites have their buffers marked stale; do the same here.
+        arrays_->sprites = sprites_.get();
+        arrays_->reserve(size);
+        arrays_->invalidate(0, count_);
+    }
+    if (instanced_)
+        instances_.resize(count_, size);
+    else
+        vertices_.resize(count_ * 4, size * 4);
     if (normals_)
         normals_.resize(count_ * 4, size * 4);
     reserved_ = size;
@@ -198,12 +337,138 @@ void SpriteBatch::rotate(size_t first, size_t n_first, size_t last)
     R_ASSERT(last <= count_, "Index out of bounds");
 
     std::rotate(sprites_ + first, sprites_ + n_first, sprites_ + last);
+    if (arrays_)
+        arrays_->rotate(first, n_first, last);
+}
+
+void SpriteBatch::update(size_t begin, size_t end, Chunk& chunk)
+{
+    // Track the range of sprites that changed so that we only need to upload
+    // that part of the buffer.
+    unsigned int first = count_;
+    unsigned int last = 0;
+    if (instanced_)
+    {
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            if (sprites_[i].update(instances_[i], *texture_))
+            {
+                first = std::min(first, i);
+                last = i + 1;
+            }
+        }
+    }
+    else if (arrays_)
+    {
+        if (normals_)
+        {
+            for (unsigned int i = begin; i < end; ++i)
+            {
+                if (sprites_[i].update(ArraySpan<Vec2f>(normals_ + i * 4, 4),
+                                       *normal_))
+                {
+                    first = std::min(first, i);
+                    last = i + 1;
+                }
+            }
+        }
+
+        const unsigned int last_normal = last;
+        Sprite::update(*arrays_,
+                       sprites_.get(),
+                       begin,
+                       end,
+                       vertices_.get(),
+                       *texture_,
+                       first,
+                       last);
+        last = std::max(last, last_normal);
+    }
+    else if (normals_)
+    {
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            const bool dirty =
+                sprites_[i].update(
+                    ArraySpan<Vec2f>(normals_ + i * 4, 4), *normal_) |
+                sprites_[i].update(
+                    ArraySpan<SpriteVertex>(vertices_ + i * 4, 4),
+                    *texture_,
+                    &chunk.transforms);
+            if (dirty)
+            {
+                first = std::min(first, i);
+                last = i + 1;
+            }
+        }
+    }
+    else
+    {
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            if (sprites_[i].update(
+                    ArraySpan<SpriteVertex>(vertices_ + i * 4, 4),
+                    *texture_,
+                    &chunk.transforms))
+            {
+                first = std::min(first, i);
+                last = i + 1;
+            }
+        }
+    }
+
+    // Sprites that need a full transform were queued above, unless stored as
+    // a structure of arrays; compute their vertex positions in one go.
+    chunk.transforms.apply(sizeof(SpriteVertex));
+
+    // Bounds only need to be recalculated for chunks where sprites changed.
+    if (first < last)
+        update_bounds(begin, end, chunk);
+
+    chunk.first = first;
+    chunk.last = last;
+}
+
+void SpriteBatch::update_bounds(size_t begin, size_t end, Chunk& chunk) const
+{
+    rainbow::Rect bounds = rainbow::Rect::none();
+    if (instanced_)
+    {
+        // The pivot is inside the sprite, so no corner is farther from it
+        // than the length of the diagonal.
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (sprites_[i].is_hidden())
+                continue;
+
+            const SpriteInstance& instance = instances_[i];
+            const float r = instance.extent.distance(Vec2f::Zero);
+            bounds.extend(rainbow::Rect{instance.center.x - r,
+                                        instance.center.y - r,
+                                        instance.center.x + r,
+                                        instance.center.y + r});
+        }
+    }
+    else
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (sprites_[i].is_hidden())
+                continue;
+
+            for (size_t j = i * 4; j < i * 4 + 4; ++j)
+                bounds.extend(vertices_[j].position);
+        }
+    }
+    chunk.bounds = bounds;
 }
 
 #ifdef RAINBOW_TEST
 SpriteBatch::SpriteBatch(const rainbow::ISolemnlySwearThatIAmOnlyTesting& test)
     : count_(0), vertex_buffer_(test), normal_buffer_(test),
-      texture_(make_shared<TextureAtlas>(test)), reserved_(0), visible_(true)
+      texture_(make_shared<TextureAtlas>(test)), bounds_(rainbow::Rect::none()),
+      first_dirty_(std::numeric_limits<unsigned int>::max()), last_dirty_(0),
+      reserved_(0), instanced_(false), visible_(true)
 {
     resize(4);
     texture_->add_region(0, 0, 1, 1);
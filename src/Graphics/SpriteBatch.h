@@ -5,23 +5,41 @@
 #ifndef GRAPHICS_SPRITEBATCH_H_
 #define GRAPHICS_SPRITEBATCH_H_
 
+#include <memory>
+
 #include "Graphics/Buffer.h"
 #include "Graphics/Sprite.h"
 #include "Graphics/TextureAtlas.h"
 #include "Graphics/VertexArray.h"
+#include "Math/Geometry.h"
+#include "Math/TransformBatch.h"
 #include "Memory/Arena.h"
 
 namespace rainbow { struct ISolemnlySwearThatIAmOnlyTesting; }
 
 /// <summary>A drawable batch of sprites.</summary>
 /// <remarks>
-///   All sprites share a common vertex buffer object (at different offsets) and
-///   are drawn with a single glDraw call. The sprites must use the same texture
-///   atlas.
+///   <para>
+///     All sprites share a common vertex buffer object (at different offsets)
+///     and are drawn with a single glDraw call. The sprites must use the same
+///     texture atlas.
+///   </para>
+///   <para>
+///     Where instancing is supported, batches can be switched to upload one
+///     <see cref="SpriteInstance"/> per sprite instead of four vertices, and
+///     leave the quad expansion to the vertex shader.
+///   </para>
 /// </remarks>
 class SpriteBatch : private NonCopyable<SpriteBatch>
 {
 public:
+    /// <summary>How sprite properties are laid out in memory.</summary>
+    enum class Storage
+    {
+        ArrayOfStructs,  ///< Each sprite holds all its properties.
+        StructOfArrays,  ///< The batch holds properties read every frame.
+    };
+
     /// <summary>Creates a batch of sprites.</summary>
     /// <param name="hint">
     ///   If you know in advance how many sprites you'll need, set
@@ -38,9 +56,39 @@ public:
     /// <summary>Returns a pointer to the end.</summary>
     auto end() const -> Sprite* { return sprites() + count_; }
 
+    /// <summary>
+    ///   Returns the bounds of all visible sprites as of the last
+    ///   <c>prepare()</c>. May be larger than necessary after sprites have
+    ///   been erased.
+    /// </summary>
+    auto bounds() const -> const rainbow::Rect& { return bounds_; }
+
+    /// <summary>Returns whether sprites are drawn with instancing.</summary>
+    auto is_instanced() const { return instanced_; }
+
+    /// <summary>
+    ///   Returns whether the textures of the batch have been loaded. Batches
+    ///   are neither updated nor drawn until they are.
+    /// </summary>
+    bool is_ready() const
+    {
+        return (!texture_ || texture_->is_ready()) &&
+               (!normal_ || normal_->is_ready());
+    }
+
     /// <summary>Returns whether the batch is visible.</summary>
     auto is_visible() const { return visible_; }
 
+    /// <summary>
+    ///   Returns whether <paramref name="batch"/> uses the same texture atlas
+    ///   and normal map as this batch.
+    /// </summary>
+    bool has_same_textures(const SpriteBatch& batch) const
+    {
+        return texture_.get() == batch.texture_.get() &&
+               normal_.get() == batch.normal_.get();
+    }
+
     /// <summary>Returns current normal map.</summary>
     auto normal() const -> const TextureAtlas&
     {
@@ -48,12 +96,24 @@ public:
         return *normal_.get();
     }
 
+    /// <summary>
+    ///   Returns the client normal buffer; <c>nullptr</c> if the batch has no
+    ///   normal map.
+    /// </summary>
+    auto normals() const -> const Vec2f* { return normals_.get(); }
+
     /// <summary>Returns sprite count.</summary>
     auto size() const { return count_; }
 
     /// <summary>Returns the sprites array.</summary>
     auto sprites() const -> Sprite* { return sprites_.get(); }
 
+    /// <summary>Returns how sprite properties are stored.</summary>
+    auto storage() const
+    {
+        return !arrays_ ? Storage::ArrayOfStructs : Storage::StructOfArrays;
+    }
+
     /// <summary>Returns current texture.</summary>
     auto texture() const -> TextureAtlas&
     {
@@ -67,12 +127,46 @@ public:
         return array_;
     }
 
+    /// <summary>Returns the client instance buffer.</summary>
+    auto instances() const -> SpriteInstance* { return instances_.get(); }
+
+    /// <summary>
+    ///   Returns the client vertex buffer; <c>nullptr</c> if the batch is
+    ///   instanced.
+    /// </summary>
+    auto vertices() const -> SpriteVertex* { return vertices_.get(); }
+
     /// <summary>Returns the vertex count.</summary>
     auto vertex_count() const { return !visible_ ? 0 : count_ * 6; }
 
+    /// <summary>
+    ///   Sets whether sprites are drawn with instancing. Ignored if instancing
+    ///   is not supported, or if the batch has a normal map.
+    /// </summary>
+    /// <remarks>
+    ///   Instanced batches are drawn with their own program unless a custom
+    ///   program is in use, in which case their sprites are expanded on the
+    ///   CPU. Their sprites have no vertex array, e.g. for collision tests.
+    /// </remarks>
+    void set_instanced(bool enable);
+
     /// <summary>Assigns a normal map.</summary>
+    /// <remarks>Disables instancing.</remarks>
     void set_normal(SharedPtr<TextureAtlas> texture);
 
+    /// <summary>
+    ///   Sets how sprite properties are stored. With
+    ///   <see cref="Storage::StructOfArrays"/>, the properties read every
+    ///   frame (state, position, rotation, scale, pivot and size) are kept in
+    ///   one array each. Updates then stream through them instead of every
+    ///   sprite, and transforms are computed from them in place.
+    /// </summary>
+    /// <remarks>
+    ///   Sprites and references to them behave the same either way. Worth it
+    ///   for large batches where most sprites change every frame.
+    /// </remarks>
+    void set_storage(Storage storage);
+
     /// <summary>Assigns a texture atlas.</summary>
     void set_texture(SharedPtr<TextureAtlas> texture);
 
@@ -103,7 +197,12 @@ public:
     void bring_to_front(const SpriteRef&);
 
     /// <summary>Clears all sprites.</summary>
-    void clear() { count_ = 0; }
+    void clear()
+    {
+        count_ = 0;
+        if (arrays_)
+            arrays_->resize(0);
+    }
 
     /// <summary>Creates a sprite.</summary>
     /// <param name="width">Width of the sprite.</param>
@@ -126,27 +225,64 @@ public:
     /// <summary>Swaps two sprites' positions in the batch.</summary>
     void swap(const SpriteRef&, const SpriteRef&);
 
+    /// <summary>
+    ///   Updates the client vertex buffers. Large batches are split into
+    ///   chunks and updated on the job system.
+    /// </summary>
+    /// <remarks>
+    ///   Does not touch the graphics context, and may be called concurrently
+    ///   with other batches' <c>prepare()</c>.
+    /// </remarks>
+    void prepare();
+
     /// <summary>Updates the batch of sprites.</summary>
     void update();
 
+    /// <summary>
+    ///   Uploads changes made by the last <c>prepare()</c> to the GPU. Must be
+    ///   called on the render thread.
+    /// </summary>
+    void upload();
+
 #ifdef RAINBOW_TEST
     explicit SpriteBatch(const rainbow::ISolemnlySwearThatIAmOnlyTesting&);
 
     auto capacity() const { return reserved_; }
-    auto vertices() const { return vertices_.get(); }
 #endif
 
 private:
+    /// <summary>State of a range of sprites updated by a single job.</summary>
+    struct Chunk
+    {
+        rainbow::TransformBatch transforms;  ///< Staged sprite transforms.
+        rainbow::Rect bounds;                ///< Bounds of visible sprites.
+        unsigned int first;                  ///< First changed sprite.
+        unsigned int last;                   ///< One past last changed sprite.
+    };
+
     Arena<Sprite> sprites_;            ///< Sprite batch.
     Arena<SpriteVertex> vertices_;     ///< Client vertex buffer.
     Arena<Vec2f> normals_;             ///< Client normal buffer.
+    Arena<SpriteInstance> instances_;  ///< Client instance buffer.
+
+    /// <summary>
+    ///   Sprite properties read every frame, if stored as a structure of
+    ///   arrays. Sprites point here, so it must not move with the batch.
+    /// </summary>
+    std::unique_ptr<rainbow::SpriteArrays> arrays_;
+
     unsigned int count_;               ///< Number of sprites.
     rainbow::graphics::Buffer vertex_buffer_;  ///< Shared, interleaved vertex buffer.
     rainbow::graphics::Buffer normal_buffer_;  ///< Shared normal buffer.
     rainbow::graphics::VertexArray array_;     ///< Vertex array object.
     SharedPtr<TextureAtlas> normal_;   ///< Normal map used by all sprites in the batch.
     SharedPtr<TextureAtlas> texture_;  ///< Texture atlas used by all sprites in the batch.
+    std::vector<Chunk> chunks_;        ///< Per-job update state.
+    rainbow::Rect bounds_;             ///< Bounds of all visible sprites.
+    unsigned int first_dirty_;         ///< First sprite changed by prepare().
+    unsigned int last_dirty_;          ///< One past the last changed sprite.
     unsigned int reserved_;            ///< Number of sprites reserved for.
+    bool instanced_;                   ///< Whether sprites are instanced.
     bool visible_;                     ///< Whether the batch is visible.
 
     /// <summary>Sets the array state for this batch.</summary>
@@ -159,6 +295,15 @@ private:
 
     /// <summary>Performs a left rotation on a range of sprites.</summary>
     void rotate(size_t first, size_t n_first, size_t last);
+
+    /// <summary>Updates sprites in [begin, end).</summary>
+    void update(size_t begin, size_t end, Chunk& chunk);
+
+    /// <summary>
+    ///   Recalculates <paramref name="chunk"/>'s bounds from sprites in
+    ///   [begin, end).
+    /// </summary>
+    void update_bounds(size_t begin, size_t end, Chunk& chunk) const;
 };
 
 #endif
@@ -0,0 +1,35 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef GRAPHICS_SPRITEINSTANCE_H_
+#define GRAPHICS_SPRITEINSTANCE_H_
+
+#include <cstdint>
+
+#include "Common/Color.h"
+#include "Math/Vec2.h"
+
+/// <summary>
+///   A sprite as drawn by the instanced rendering path. The quad is expanded
+///   in the vertex shader instead of on the CPU.
+/// </summary>
+/// <remarks>
+///   Texture coordinates are those of the lower left (0) and upper right (2)
+///   corners, normalised to 16-bit. Flipping and mirroring swap the
+///   respective components.
+/// </remarks>
+struct SpriteInstance
+{
+    Vec2f center;          ///< Position of the sprite.
+    Vec2f extent;          ///< Size of the sprite, scaled.
+    Vec2f pivot;           ///< Pivot point (normalised).
+    float angle;           ///< Angle of rotation.
+    Colorb color;          ///< Texture colour, usually white.
+    uint16_t texcoord[4];  ///< Texture coordinates of corners 0 and 2.
+};
+
+static_assert(sizeof(SpriteInstance) == 40,
+              "SpriteInstance should be half the size of a sprite's vertices");
+
+#endif
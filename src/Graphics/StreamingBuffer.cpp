@@ -0,0 +1,224 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include "Graphics/StreamingBuffer.h"
+
+#include <algorithm>
+
+#include "Common/Logging.h"
+#include "Graphics/OpenGL.h"
+#include "Graphics/Renderer.h"
+
+// OpenGL ES 2.0 and legacy macOS contexts have neither fences nor
+// glDrawElementsBaseVertex.
+#if !defined(GL_ES_VERSION_2_0) && !defined(RAINBOW_OS_MACOS)
+#   define USE_RING_BUFFER 1
+#endif
+
+using rainbow::graphics::StreamingBuffer;
+
+namespace
+{
+#ifdef USE_RING_BUFFER
+    constexpr size_t kNumFrames = 3;
+    constexpr GLuint64 kFenceTimeout = 1000000000;  // 1 second
+
+    auto to_sync(void* fence) { return static_cast<GLsync>(fence); }
+#endif
+
+    bool supports_ring_buffer()
+    {
+#ifdef USE_RING_BUFFER
+        return rainbow::graphics::has_extension("GL_ARB_sync") &&
+               rainbow::graphics::has_extension("GL_ARB_map_buffer_range") &&
+               rainbow::graphics::has_extension(
+                   "GL_ARB_draw_elements_base_vertex");
+#else
+        return false;
+#endif
+    }
+}
+
+StreamingBuffer::StreamingBuffer()
+    : is_ring_buffer_(supports_ring_buffer()), base_vertex_(0), capacity_(0),
+      cursor_(0), staging_size_(0)
+{
+    array_.reconfigure([this] { buffer_.bind(); });
+}
+
+StreamingBuffer::StreamingBuffer(
+    const rainbow::ISolemnlySwearThatIAmOnlyTesting& test)
+    : buffer_(test), is_ring_buffer_(false), base_vertex_(0), capacity_(0),
+      cursor_(0), staging_size_(0)
+{
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+    release_all();
+}
+
+void StreamingBuffer::draw_elements(size_t count) const
+{
+    auto& elements = detail::element_buffer();
+    count = elements.reserve(count);
+    array_.bind();
+
+#ifdef USE_RING_BUFFER
+    if (is_ring_buffer_)
+    {
+        glDrawElementsBaseVertex(
+            GL_TRIANGLES, count, elements.type(), nullptr, base_vertex_);
+
+        // Fence the range right after the draw, so that it is protected even
+        // if nothing is mapped for a while. If it is drawn again, only the
+        // last draw needs to be waited on.
+        Range& range = ranges_.back();
+        if (range.fence != nullptr)
+            glDeleteSync(to_sync(range.fence));
+        range.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    else
+#endif
+    {
+        glDrawElements(GL_TRIANGLES, count, elements.type(), nullptr);
+    }
+
+#ifndef NDEBUG
+    ++detail::g_draw_count_accumulator;
+#endif
+}
+
+auto StreamingBuffer::map(size_t count) -> SpriteVertex*
+{
+    // Zero-length ranges cannot be mapped.
+    count = std::max<size_t>(count, 1);
+
+    if (!is_ring_buffer_)
+    {
+        if (count > staging_size_)
+        {
+            staging_ = std::make_unique<SpriteVertex[]>(count);
+            staging_size_ = count;
+        }
+        return staging_.get();
+    }
+
+#ifdef USE_RING_BUFFER
+    // Ranges are fenced when drawn. One that was never drawn is fenced here
+    // so that it does not hold up the release of later ranges.
+    if (!ranges_.empty() && ranges_.back().fence == nullptr)
+    {
+        ranges_.back().fence =
+            glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    const size_t size = count * sizeof(SpriteVertex);
+    if (size * kNumFrames > capacity_)
+        reallocate(std::max(size * kNumFrames, capacity_ * 2));
+    if (cursor_ + size > capacity_)
+        cursor_ = 0;
+
+    // Ranges are released in the order they were written, which is also the
+    // order in which the cursor reaches them.
+    while (!ranges_.empty() && release_oldest(false)) {}
+    while (!ranges_.empty() && ranges_.front().begin < cursor_ + size &&
+           cursor_ < ranges_.front().end)
+    {
+        release_oldest(true);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_.id());
+    void* data = glMapBufferRange(GL_ARRAY_BUFFER,
+                                  cursor_,
+                                  size,
+                                  GL_MAP_WRITE_BIT |
+                                      GL_MAP_INVALIDATE_RANGE_BIT |
+                                      GL_MAP_UNSYNCHRONIZED_BIT);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    R_ASSERT(data != nullptr, "Failed to map vertex buffer");
+
+    base_vertex_ = cursor_ / sizeof(SpriteVertex);
+    ranges_.push_back({nullptr, cursor_, cursor_ + size});
+    cursor_ += size;
+    return static_cast<SpriteVertex*>(data);
+#else
+    return nullptr;
+#endif
+}
+
+void StreamingBuffer::unmap(size_t count)
+{
+    if (!is_ring_buffer_)
+    {
+        buffer_.upload(staging_.get(), count * sizeof(SpriteVertex));
+        return;
+    }
+
+#ifdef USE_RING_BUFFER
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_.id());
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+#ifndef NDEBUG
+    detail::g_bytes_uploaded_accumulator += count * sizeof(SpriteVertex);
+#endif
+#endif  // USE_RING_BUFFER
+}
+
+void StreamingBuffer::reallocate(size_t size)
+{
+#ifdef USE_RING_BUFFER
+    // The old storage is orphaned; any pending draws keep using it.
+    release_all();
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_.id());
+    glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    capacity_ = size;
+    cursor_ = 0;
+#else
+    static_cast<void>(size);
+#endif
+}
+
+void StreamingBuffer::release_all()
+{
+#ifdef USE_RING_BUFFER
+    for (auto&& range : ranges_)
+    {
+        if (range.fence != nullptr)
+            glDeleteSync(to_sync(range.fence));
+    }
+#endif
+    ranges_.clear();
+}
+
+bool StreamingBuffer::release_oldest(bool wait)
+{
+#ifdef USE_RING_BUFFER
+    auto& range = ranges_.front();
+    if (range.fence != nullptr)
+    {
+        const GLenum status = glClientWaitSync(
+            to_sync(range.fence),
+            wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+            wait ? kFenceTimeout : 0);
+        if (!wait && status == GL_TIMEOUT_EXPIRED)
+            return false;
+
+        glDeleteSync(to_sync(range.fence));
+    }
+    else if (!wait)
+    {
+        return false;
+    }
+
+    ranges_.pop_front();
+    return true;
+#else
+    static_cast<void>(wait);
+    return false;
+#endif
+}
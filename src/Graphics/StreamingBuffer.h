@@ -0,0 +1,114 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef GRAPHICS_STREAMINGBUFFER_H_
+#define GRAPHICS_STREAMINGBUFFER_H_
+
+#include <deque>
+#include <memory>
+
+#include "Graphics/Buffer.h"
+#include "Graphics/SpriteVertex.h"
+#include "Graphics/VertexArray.h"
+
+namespace rainbow { namespace graphics
+{
+    /// <summary>
+    ///   Interleaved vertex buffer for vertices that are rewritten every time
+    ///   they change, e.g. animated meshes.
+    /// </summary>
+    /// <remarks>
+    ///   <para>
+    ///     Where fences and buffer mapping are available, vertices are written
+    ///     directly into a ring buffer large enough for three frames' worth of
+    ///     vertices. Each written range is fenced once it has been drawn, and
+    ///     is not rewritten until the GPU is done with it.
+    ///   </para>
+    ///   <para>
+    ///     Otherwise, e.g. on OpenGL ES 2.0, vertices are written to client
+    ///     memory and uploaded by orphaning the buffer.
+    ///   </para>
+    /// </remarks>
+    class StreamingBuffer : private NonCopyable<StreamingBuffer>
+    {
+    public:
+        StreamingBuffer();
+        explicit StreamingBuffer(
+            const rainbow::ISolemnlySwearThatIAmOnlyTesting&);
+        ~StreamingBuffer();
+
+        /// <summary>
+        ///   Returns the index of the first vertex written by the last
+        ///   <see cref="map"/>.
+        /// </summary>
+        auto base_vertex() const { return base_vertex_; }
+
+        /// <summary>Returns the vertex array object.</summary>
+        auto vertex_array() const -> const VertexArray& { return array_; }
+
+        /// <summary>
+        ///   Draws <paramref name="count"/> indices into the vertices written
+        ///   by the last <see cref="map"/>. Textures must already be bound.
+        /// </summary>
+        void draw_elements(size_t count) const;
+
+        /// <summary>
+        ///   Returns memory for writing <paramref name="count"/> vertices. The
+        ///   memory is write-only and must not be read from.
+        /// </summary>
+        /// <remarks>
+        ///   Must be followed by <see cref="unmap"/> before drawing. Does not
+        ///   touch the graphics context when falling back to orphaning.
+        /// </remarks>
+        auto map(size_t count) -> SpriteVertex*;
+
+        /// <summary>
+        ///   Makes the first <paramref name="count"/> vertices written since
+        ///   <see cref="map"/> available for drawing.
+        /// </summary>
+        void unmap(size_t count);
+
+    private:
+        struct Range
+        {
+            void* fence;   ///< Signalled when the GPU is done with the range.
+            size_t begin;  ///< Offset of the range, in bytes.
+            size_t end;    ///< Offset past the end of the range, in bytes.
+        };
+
+        Buffer buffer_;
+        VertexArray array_;
+        bool is_ring_buffer_;
+        size_t base_vertex_;
+        size_t capacity_;  ///< Size of the ring buffer, in bytes.
+        size_t cursor_;    ///< Offset of the next write, in bytes.
+
+        /// <summary>
+        ///   Ranges that may still be in use. Fenced as they are drawn.
+        /// </summary>
+        mutable std::deque<Range> ranges_;
+
+        std::unique_ptr<SpriteVertex[]> staging_;  ///< Orphaning fallback.
+        size_t staging_size_;
+
+        /// <summary>
+        ///   Reallocates the ring buffer with <paramref name="size"/> bytes.
+        /// </summary>
+        void reallocate(size_t size);
+
+        /// <summary>Forgets all ranges without waiting for the GPU.</summary>
+        void release_all();
+
+        /// <summary>
+        ///   Releases the oldest range once the GPU is done with it.
+        /// </summary>
+        /// <param name="wait">
+        ///   Whether to block until the GPU is done with the range.
+        /// </param>
+        /// <returns><c>true</c> if the range was released.</returns>
+        bool release_oldest(bool wait);
+    };
+}}  // namespace rainbow::graphics
+
+#endif
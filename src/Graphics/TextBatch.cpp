@@ -0,0 +1,210 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include "Graphics/TextBatch.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "Common/Algorithm.h"
+#include "Graphics/Label.h"
+
+using rainbow::is_equal;
+
+namespace
+{
+    bool has_same_effects(const Label::Effect& a, const Label::Effect& b)
+    {
+        return is_equal(a.width, b.width) && a.color == b.color;
+    }
+
+    /// <summary>
+    ///   Returns whether <paramref name="a"/> and <paramref name="b"/> can be
+    ///   drawn with the same shader state.
+    /// </summary>
+    bool has_same_state(const Label& a, const Label& b)
+    {
+        return a.font().mode() != FontAtlas::Mode::DistanceField ||
+               (is_equal(a.scale(), b.scale()) &&
+                has_same_effects(a.outline(), b.outline()) &&
+                has_same_effects(a.glow(), b.glow()));
+    }
+}
+
+TextBatch::TextBatch(SharedPtr<FontAtlas> font)
+    : bounds_(rainbow::Rect::none()),
+      first_dirty_(std::numeric_limits<unsigned int>::max()), last_dirty_(0),
+      needs_reserve_(false), font_(std::move(font))
+{
+    array_.reconfigure([this] { buffer_.bind(); });
+}
+
+TextBatch::~TextBatch()
+{
+    for (auto&& entry : entries_)
+    {
+        entry.label->batch_ = nullptr;
+        entry.label->set_needs_update(Label::kStaleBuffer);
+    }
+}
+
+void TextBatch::add(Label& label)
+{
+    R_ASSERT(label.batch_ == nullptr, "Label is already in a batch");
+    R_ASSERT(&label.font() == font_.get(),
+             "Label must use the same font as the batch");
+
+    label.batch_ = this;
+    entries_.push_back({&label, 0, 0, 0});
+    needs_reserve_ = true;
+}
+
+void TextBatch::move(const Vec2f& delta)
+{
+    for (auto&& entry : entries_)
+        entry.label->move(delta);
+}
+
+void TextBatch::remove(Label& label)
+{
+    auto i = std::find_if(
+        entries_.begin(), entries_.end(), [&label](const Entry& entry) {
+            return entry.label == &label;
+        });
+    if (i == entries_.end())
+        return;
+
+    // The label must upload to its own buffer again.
+    label.batch_ = nullptr;
+    label.set_needs_update(Label::kStaleBuffer);
+    entries_.erase(i);
+    needs_reserve_ = true;
+}
+
+void TextBatch::update()
+{
+    bounds_ = rainbow::Rect::none();
+    for (auto&& entry : entries_)
+    {
+        Label& label = *entry.label;
+        R_ASSERT(&label.font() == font_.get(),
+                 "Label must use the same font as the batch");
+
+        label.update();
+        if (label.count_ > entry.capacity)
+            needs_reserve_ = true;
+        bounds_.extend(label.bounds());
+    }
+
+    if (needs_reserve_)
+        reserve();
+
+    for (auto&& entry : entries_)
+        copy(entry);
+
+    update_runs();
+    upload();
+}
+
+void TextBatch::copy(Entry& entry)
+{
+    Label& label = *entry.label;
+    const unsigned int drawn =
+        std::min(label.count_ / 4, label.vertex_count() / 6);
+    unsigned int first = std::min(label.first_dirty_, drawn * 4);
+    if (drawn != entry.drawn)
+        first = std::min(first, std::min(drawn, entry.drawn) * 4);
+    label.first_dirty_ = std::numeric_limits<unsigned int>::max();
+
+    const unsigned int end = std::max(drawn, entry.drawn) * 4;
+    if (first >= end)
+        return;
+
+    // Characters that are no longer drawn are collapsed so that they can
+    // stay in the draw call.
+    auto vx = vertices_.begin() + entry.offset;
+    std::copy(label.vertices_.get() + first,
+              label.vertices_.get() + drawn * 4,
+              vx + first);
+    std::fill(vx + drawn * 4, vx + end, SpriteVertex{});
+
+    entry.drawn = drawn;
+    first_dirty_ = std::min(first_dirty_, entry.offset + first);
+    last_dirty_ = std::max(last_dirty_, entry.offset + end);
+}
+
+void TextBatch::reserve()
+{
+    unsigned int offset = 0;
+    for (auto&& entry : entries_)
+    {
+        // Leave room for the text to grow into its string buffer.
+        const Label& label = *entry.label;
+        entry.offset = offset;
+        entry.capacity = std::max<unsigned int>(label.size_ * 4, label.count_);
+        entry.drawn = 0;
+        entry.label->mark_dirty(0);
+        offset += entry.capacity;
+    }
+
+    vertices_.assign(offset, SpriteVertex{});
+    first_dirty_ = 0;
+    last_dirty_ = offset;
+    needs_reserve_ = false;
+}
+
+void TextBatch::update_runs()
+{
+    runs_.clear();
+    for (auto&& entry : entries_)
+    {
+        const unsigned int base = entry.offset / 4;
+        for (auto&& run : entry.label->runs())
+        {
+            if (run.first >= entry.drawn)
+                break;
+
+            const unsigned int first = base + run.first;
+            const unsigned int end =
+                base + std::min(run.first + run.count, entry.drawn);
+
+            // Characters in between are collapsed and can be drawn with
+            // either run.
+            if (!runs_.empty() && runs_.back().page == run.page &&
+                has_same_state(*runs_.back().label, *entry.label))
+            {
+                runs_.back().count = end - runs_.back().first;
+            }
+            else
+            {
+                runs_.push_back({run.page, first, end - first, entry.label});
+            }
+        }
+    }
+}
+
+void TextBatch::upload()
+{
+    if (first_dirty_ >= last_dirty_)
+        return;
+
+    const size_t size = vertices_.size() * sizeof(vertices_[0]);
+    const size_t offset = first_dirty_ * sizeof(vertices_[0]);
+    buffer_.upload(vertices_.data(),
+                   size,
+                   offset,
+                   (last_dirty_ - first_dirty_) * sizeof(vertices_[0]));
+    first_dirty_ = std::numeric_limits<unsigned int>::max();
+    last_dirty_ = 0;
+}
+
+#ifdef RAINBOW_TEST
+TextBatch::TextBatch(SharedPtr<FontAtlas> font,
+                     const rainbow::ISolemnlySwearThatIAmOnlyTesting& test)
+    : bounds_(rainbow::Rect::none()),
+      first_dirty_(std::numeric_limits<unsigned int>::max()), last_dirty_(0),
+      needs_reserve_(false), buffer_(test), font_(std::move(font))
+{
+}
+#endif  // RAINBOW_TEST
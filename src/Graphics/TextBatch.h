@@ -0,0 +1,143 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef GRAPHICS_TEXTBATCH_H_
+#define GRAPHICS_TEXTBATCH_H_
+
+#include <vector>
+
+#include "Graphics/Buffer.h"
+#include "Graphics/FontAtlas.h"
+#include "Graphics/VertexArray.h"
+#include "Math/Geometry.h"
+
+class Label;
+
+namespace rainbow { struct ISolemnlySwearThatIAmOnlyTesting; }
+
+/// <summary>A drawable batch of labels using the same font.</summary>
+/// <remarks>
+///   <para>
+///     The glyphs of all labels share a common vertex buffer, each label at
+///     its own offset, and are drawn with one draw call per font texture page
+///     in use. Only labels that changed are copied, and only their vertices
+///     are uploaded.
+///   </para>
+///   <para>
+///     Labels are drawn in the order they were added. A label in a batch must
+///     not be drawn on its own, and must keep using the font of the batch.
+///     Labels using distance field fonts are split into separate draw calls
+///     where their scale or effects differ.
+///   </para>
+/// </remarks>
+class TextBatch : private NonCopyable<TextBatch>
+{
+public:
+    /// <summary>Consecutive characters drawn with one draw call.</summary>
+    struct Run
+    {
+        unsigned int page;   ///< Font texture page.
+        unsigned int first;  ///< Index of the first character.
+        unsigned int count;  ///< Number of characters.
+        const Label* label;  ///< Label whose scale and effects apply.
+    };
+
+    explicit TextBatch(SharedPtr<FontAtlas> font);
+    ~TextBatch();
+
+    /// <summary>
+    ///   Returns the bounds of all labels as of the last update.
+    /// </summary>
+    auto bounds() const -> const rainbow::Rect& { return bounds_; }
+
+    /// <summary>Returns the font used by all labels.</summary>
+    auto font() const -> const FontAtlas& { return *font_.get(); }
+
+    /// <summary>Returns the number of labels in the batch.</summary>
+    auto size() const { return entries_.size(); }
+
+    /// <summary>
+    ///   Returns characters grouped by draw call, in drawing order.
+    /// </summary>
+    auto runs() const -> const std::vector<Run>& { return runs_; }
+
+    /// <summary>Returns the vertex array object.</summary>
+    auto vertex_array() const -> const rainbow::graphics::VertexArray&
+    {
+        return array_;
+    }
+
+    /// <summary>Returns the client vertex buffer.</summary>
+    auto vertices() const -> const SpriteVertex* { return vertices_.data(); }
+
+    /// <summary>Returns the vertex count.</summary>
+    auto vertex_count() const -> unsigned int
+    {
+        return vertices_.size() + (vertices_.size() >> 1);
+    }
+
+    /// <summary>Adds a label to the batch.</summary>
+    void add(Label& label);
+
+    /// <summary>Binds the font texture page of the first run.</summary>
+    void bind_textures() const
+    {
+        font_->bind(runs_.empty() ? 0 : runs_.front().page);
+    }
+
+    /// <summary>Moves all labels by (x,y).</summary>
+    void move(const Vec2f& delta);
+
+    /// <summary>Removes a label from the batch.</summary>
+    void remove(Label& label);
+
+    /// <summary>
+    ///   Updates all labels, and uploads the vertices of those that changed.
+    /// </summary>
+    void update();
+
+#ifdef RAINBOW_TEST
+    TextBatch(SharedPtr<FontAtlas> font,
+              const rainbow::ISolemnlySwearThatIAmOnlyTesting&);
+#endif
+
+private:
+    struct Entry
+    {
+        Label* label;
+        unsigned int offset;    ///< First vertex in the shared buffer.
+        unsigned int capacity;  ///< Number of vertices reserved.
+        unsigned int drawn;     ///< Number of characters copied.
+    };
+
+    std::vector<Entry> entries_;
+    std::vector<SpriteVertex> vertices_;  ///< Client vertex buffer.
+    std::vector<Run> runs_;               ///< Characters grouped by state.
+    rainbow::Rect bounds_;                ///< Bounds of all labels.
+    unsigned int first_dirty_;            ///< First vertex to upload.
+    unsigned int last_dirty_;             ///< End of vertices to upload.
+    bool needs_reserve_;                  ///< Whether offsets are stale.
+    rainbow::graphics::Buffer buffer_;      ///< Vertex buffer.
+    rainbow::graphics::VertexArray array_;  ///< Vertex array object.
+    SharedPtr<FontAtlas> font_;             ///< Font used by all labels.
+
+    /// <summary>
+    ///   Copies the characters of <paramref name="entry"/> that changed since
+    ///   the last update.
+    /// </summary>
+    void copy(Entry& entry);
+
+    /// <summary>
+    ///   Reserves room for all labels, and marks them as needing copy.
+    /// </summary>
+    void reserve();
+
+    /// <summary>Groups characters by draw call.</summary>
+    void update_runs();
+
+    /// <summary>Uploads vertices changed since the last update.</summary>
+    void upload();
+};
+
+#endif
@@ -9,12 +9,24 @@
 
 #include "Math/Vec2.h"
 
+class TextureManager;
+
 namespace rainbow
 {
     struct ISolemnlySwearThatIAmOnlyTesting;
 
     namespace detail
     {
+        /// <summary>
+        ///   Slot of a texture in <see cref="TextureManager"/>. The generation
+        ///   is bumped whenever the slot is reused.
+        /// </summary>
+        struct TextureHandle
+        {
+            unsigned int index;
+            unsigned int generation;
+        };
+
         struct Texture
         {
             std::string id;
@@ -23,36 +35,32 @@ namespace rainbow
             unsigned int height;
             unsigned int size;
             unsigned int use_count;
-
-            Texture(const char* id_, unsigned int name_)
-                : id(id_), name(name_), width(0), height(0), size(0),
-                  use_count(0) {}
-
-            friend bool operator==(const Texture& t, const char* id)
-            {
-                return t.id == id;
-            }
-
-            friend bool operator==(const Texture& t, unsigned int name)
-            {
-                return t.name == name;
-            }
+            unsigned int last_used;  ///< Frame the texture was last bound.
+            TextureHandle handle;
+            bool loading;  ///< Whether the texture is loaded asynchronously.
+            bool evicted;  ///< Whether the texture data has been freed.
+
+            Texture(unsigned int index)
+                : name(0), width(0), height(0), size(0), use_count(0),
+                  last_used(0), handle{index, 0}, loading(false),
+                  evicted(false) {}
         };
     }
 
     class Texture
     {
     public:
-        Texture() : name_(0) {}
+        Texture() : name_(0), handle_{0, 0} {}
 
         Texture(detail::Texture& texture)
-            : name_(texture.name), size_(texture.width, texture.height)
+            : name_(texture.name), size_(texture.width, texture.height),
+              handle_(texture.handle)
         {
             ++texture.use_count;
         }
 
         explicit Texture(const ISolemnlySwearThatIAmOnlyTesting&)
-            : name_(0), size_(64, 64) {}
+            : name_(0), size_(64, 64), handle_{0, 0} {}
 
         Texture(const Texture& texture);
         ~Texture();
@@ -72,6 +80,9 @@ namespace rainbow
     private:
         unsigned int name_;
         Vec2u size_;
+        detail::TextureHandle handle_;
+
+        friend TextureManager;
     };
 
     /// <summary>Stores texture id and UV coordinates.</summary>
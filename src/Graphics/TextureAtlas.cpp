@@ -4,23 +4,252 @@
 
 #include "Graphics/TextureAtlas.h"
 
+#include <algorithm>
+#include <memory>
+
 #include "FileSystem/Path.h"
+#include "Graphics/Decoders/Software.h"
 #include "Graphics/Image.h"
+#include "Graphics/Renderer.h"
 #include "Graphics/TextureManager.h"
 
 #define kInvalidColorDepth "Invalid colour depth"
 
 using rainbow::Texture;
 
+namespace
+{
+    /// <summary>
+    ///   Decodes the first level of compressed image data in software, if
+    ///   the driver does not support its format; mipmaps are not worth the
+    ///   time. Safe to call on worker threads.
+    /// </summary>
+    /// <returns>
+    ///   Decoded pixels in RGBA; <c>nullptr</c> if the image is not compressed,
+    ///   the format is supported, or decoding failed.
+    /// </returns>
+    auto decode_unsupported(const rainbow::Image& image)
+        -> std::unique_ptr<rainbow::byte_t[]>
+    {
+        if (image.data == nullptr || image.internal_format == 0 ||
+            rainbow::graphics::supports_compressed_format(
+                image.internal_format))
+        {
+            return {};
+        }
+
+        auto pixels = rainbow::software::decode(image.internal_format,
+                                                image.width,
+                                                image.height,
+                                                image.data,
+                                                image.size);
+        if (!pixels)
+        {
+            LOGE("Unsupported texture format: 0x%x", image.internal_format);
+            return {};
+        }
+
+        LOGW("Texture format 0x%x is not supported by hardware; texture "
+             "was decoded in software",
+             image.internal_format);
+        return pixels;
+    }
+
+    /// <summary>
+    ///   Uploads compressed image data, or <paramref name="pixels"/> if it had
+    ///   to be decoded in software.
+    /// </summary>
+    /// <param name="pixels">
+    ///   Image data decoded by <see cref="decode_unsupported"/>, if any.
+    /// </param>
+    void upload_compressed(TextureManager& texture_manager,
+                           const Texture& texture,
+                           const rainbow::Image& image,
+                           const rainbow::byte_t* pixels)
+    {
+        if (pixels != nullptr)
+        {
+            texture_manager.upload(texture, GL_RGBA8, image.width,
+                                   image.height, GL_RGBA, pixels);
+            return;
+        }
+
+        if (!rainbow::graphics::supports_compressed_format(
+                image.internal_format))
+        {
+            return;
+        }
+
+        texture_manager.upload_compressed(texture, image.internal_format,
+                                          image.width, image.height,
+                                          image.size, image.data);
+        unsigned int level = 0;
+        for (auto&& mipmap : image.mipmaps)
+        {
+            ++level;
+            texture_manager.upload_compressed(
+                texture, image.internal_format,
+                std::max(image.width >> level, 1u),
+                std::max(image.height >> level, 1u), mipmap.size, mipmap.data,
+                level);
+        }
+    }
+
+    void upload(TextureManager& texture_manager,
+                const Texture& texture,
+                const rainbow::Image& image,
+                const rainbow::byte_t* pixels)
+    {
+        if (!image.data)
+            return;
+
+        if (image.internal_format != 0)
+        {
+            upload_compressed(texture_manager, texture, image, pixels);
+            return;
+        }
+
+        switch (image.format)
+        {
+#ifdef GL_IMG_texture_compression_pvrtc
+            case rainbow::Image::Format::PVRTC: {
+                R_ASSERT(image.depth == 2 || image.depth == 4,
+                         kInvalidColorDepth);
+                R_ASSERT(image.channels == 3 || image.channels == 4,
+                         "Invalid number of colour channels");
+                GLint internal = 0;
+                if (image.channels == 3)
+                {
+                    internal = (image.depth == 2
+                        ? GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG
+                        : GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG);
+                }
+                else
+                {
+                    internal = (image.depth == 2
+                        ? GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG
+                        : GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG);
+                }
+                texture_manager.upload_compressed(
+                    texture, internal, image.width, image.height, image.size,
+                    image.data);
+                break;
+            }
+#endif  // PVRTC
+            default: {
+                GLint format = 0;
+                GLint internal = 0;
+                switch (image.channels)
+                {
+                    case 1:
+                        R_ASSERT(image.depth == 8, kInvalidColorDepth);
+                        format = GL_LUMINANCE;
+                        internal = GL_LUMINANCE;
+                        break;
+                    case 2:
+                        R_ASSERT(image.depth == 16, kInvalidColorDepth);
+                        format = GL_LUMINANCE_ALPHA;
+                        internal = GL_LUMINANCE_ALPHA;
+                        break;
+                    case 3:
+                        R_ASSERT(image.depth == 16 || image.depth == 24,
+                                 kInvalidColorDepth);
+                        format = GL_RGB;
+                        internal = (image.depth == 16 ? GL_RGBA4 : GL_RGBA8);
+                        break;
+                    case 4:
+                        R_ASSERT(image.depth == 16 || image.depth == 32,
+                                 kInvalidColorDepth);
+                        format = GL_RGBA;
+                        internal = (image.depth == 16 ? GL_RGBA4 : GL_RGBA8);
+                        break;
+                }
+                texture_manager.upload(
+                    texture, internal, image.width, image.height, format,
+                    image.data);
+                break;
+            }
+        }
+    }
+
+    void load(TextureManager& texture_manager,
+              const Texture& texture,
+              const DataMap& data,
+              float scale)
+    {
+        R_ASSERT(data, "Failed to load texture");
+
+        const auto image = rainbow::Image::decode(data, scale);
+        const auto pixels = decode_unsupported(image);
+        upload(texture_manager, texture, image, pixels.get());
+    }
+
+    /// <summary>Image decoded on a worker thread.</summary>
+    struct DecodedImage
+    {
+        rainbow::Image image;
+
+        /// <summary>See <see cref="decode_unsupported"/>.</summary>
+        std::unique_ptr<rainbow::byte_t[]> pixels;
+
+        explicit DecodedImage(rainbow::Image&& image)
+            : image(std::move(image)), pixels(decode_unsupported(this->image))
+        {
+        }
+    };
+
+    auto decode(const Path& path, float scale) -> TextureManager::Uploader
+    {
+        // Compressed images point into the mapped file, so it must be kept
+        // around until the image has been uploaded.
+        auto data = std::make_shared<DataMap>(path);
+        if (!*data)
+        {
+            LOGE("Failed to load texture: %s", static_cast<const char*>(path));
+            return nullptr;
+        }
+
+        // Software decoding is slow, so it must be done here rather than in
+        // the uploader, which runs on the render thread.
+        auto decoded = std::make_shared<DecodedImage>(
+            rainbow::Image::decode(*data, scale));
+        return [data, decoded](
+            TextureManager& texture_manager, const Texture& texture) {
+            upload(texture_manager,
+                   texture,
+                   decoded->image,
+                   decoded->pixels.get());
+        };
+    }
+}
+
 TextureAtlas::TextureAtlas(const char* path, float scale)
 {
-    texture_ = TextureManager::Get()->create(
+    auto texture_manager = TextureManager::Get();
+    texture_ = texture_manager->create(
         path,
         [this, path, scale](
             TextureManager& texture_manager, const Texture& texture)
         {
             load(texture_manager, texture, DataMap{Path(path)}, scale);
         });
+    check_texture(path);
+    if (!ready_)
+        return;
+
+    // Let the texture manager evict the texture when over budget.
+    texture_manager->set_source(
+        texture_, [path = Path(path), scale] { return decode(path, scale); });
+}
+
+TextureAtlas::TextureAtlas(const char* path, float scale, Callback on_ready)
+    : ready_(false), on_ready_(std::move(on_ready))
+{
+    texture_ = TextureManager::Get()->create_async(
+        path,
+        [path = Path(path), scale] { return decode(path, scale); },
+        this,
+        [this](const Texture& texture) { set_texture(texture); });
 }
 
 TextureAtlas::TextureAtlas(const char* path, float scale, TextureList regions)
@@ -45,6 +274,7 @@ TextureAtlas::TextureAtlas(const char* id, const DataMap& data, float scale)
         {
             load(texture_manager, texture, data, scale);
         });
+    check_texture(id);
 }
 
 TextureAtlas::TextureAtlas(const char* id,
@@ -63,8 +293,24 @@ TextureAtlas::TextureAtlas(const char* id,
     }
 }
 
+TextureAtlas::~TextureAtlas()
+{
+    if (!ready_ && texture_)
+        TextureManager::Get()->cancel(this);
+}
+
 auto TextureAtlas::add_region(int x, int y, int w, int h) -> unsigned int
 {
+    if (!ready_)
+    {
+        // The size is not known yet. Store the region in pixels until the
+        // texture has been uploaded.
+        const size_t i = regions_.size();
+        regions_.emplace_back(Vec2f(x, y), Vec2f(x + w, y + h));
+        regions_[i].atlas = texture_;
+        return i;
+    }
+
     const float width = static_cast<float>(texture_.width());
     const float height = static_cast<float>(texture_.height());
 
@@ -90,82 +336,66 @@ void TextureAtlas::set_regions(const ArrayView<int>& rects)
         add_region(rects[i], rects[i + 1], rects[i + 2], rects[i + 3]);
 }
 
-void TextureAtlas::load(TextureManager& texture_manager,
-                        const rainbow::Texture& texture,
-                        const DataMap& data,
-                        float scale)
+void TextureAtlas::check_texture(const char* id)
 {
-    R_ASSERT(data, "Failed to load texture");
+    if (texture_.width() > 0 && texture_.height() > 0)
+        return;
 
-    const rainbow::Image& image = rainbow::Image::decode(data, scale);
-    if (!image.data)
+    auto texture_manager = TextureManager::Get();
+    if (texture_manager->is_loading(texture_))
+    {
+        // Wait for the texture the same way an asynchronous atlas would. The
+        // decoder is only used for new textures.
+        ready_ = false;
+        texture_manager->create_async(
+            id, nullptr, this, [this](const Texture& texture) {
+                set_texture(texture);
+            });
         return;
+    }
+
+    // Nothing was uploaded, e.g. because the format is not supported by the
+    // driver and cannot be decoded in software.
+    LOGE("Failed to load texture: %s", id);
+    ready_ = false;
+    texture_ = Texture();
+}
 
-    switch (image.format)
+void TextureAtlas::finish_loading()
+{
+    const float width = static_cast<float>(texture_.width());
+    const float height = static_cast<float>(texture_.height());
+    for (auto&& region : regions_)
     {
-#ifdef GL_OES_compressed_ETC1_RGB8_texture
-        case rainbow::Image::Format::ETC1:
-            texture_manager.upload_compressed(
-                texture, GL_ETC1_RGB8_OES, image.width, image.height,
-                image.size, image.data);
-            break;
-#endif  // ETC1
-#ifdef GL_IMG_texture_compression_pvrtc
-        case rainbow::Image::Format::PVRTC: {
-            R_ASSERT(image.depth == 2 || image.depth == 4, kInvalidColorDepth);
-            R_ASSERT(image.channels == 3 || image.channels == 4,
-                     "Invalid number of colour channels");
-            GLint internal = 0;
-            if (image.channels == 3)
-            {
-                internal = (image.depth == 2
-                    ? GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG
-                    : GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG);
-            }
-            else
-            {
-                internal = (image.depth == 2
-                    ? GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG
-                    : GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG);
-            }
-            texture_manager.upload_compressed(
-                texture, internal, image.width, image.height, image.size,
-                image.data);
-            break;
+        for (auto&& uv : region.vx)
+        {
+            uv.x /= width;
+            uv.y /= height;
         }
-#endif  // PVRTC
-        default: {
-            GLint format = 0;
-            GLint internal = 0;
-            switch (image.channels)
-            {
-                case 1:
-                    R_ASSERT(image.depth == 8, kInvalidColorDepth);
-                    format = GL_LUMINANCE;
-                    internal = GL_LUMINANCE;
-                    break;
-                case 2:
-                    R_ASSERT(image.depth == 16, kInvalidColorDepth);
-                    format = GL_LUMINANCE_ALPHA;
-                    internal = GL_LUMINANCE_ALPHA;
-                    break;
-                case 3:
-                    R_ASSERT(image.depth == 16 || image.depth == 24,
-                             kInvalidColorDepth);
-                    format = GL_RGB;
-                    internal = (image.depth == 16 ? GL_RGBA4 : GL_RGBA8);
-                    break;
-                case 4:
-                    R_ASSERT(image.depth == 16 || image.depth == 32,
-                             kInvalidColorDepth);
-                    format = GL_RGBA;
-                    internal = (image.depth == 16 ? GL_RGBA4 : GL_RGBA8);
-                    break;
-            }
-            texture_manager.upload(
-                texture, internal, image.width, image.height, format,
-                image.data);
-            break;
+    }
+
+    ready_ = true;
+    if (on_ready_)
+    {
+        Callback on_ready = std::move(on_ready_);
+        on_ready(*this);
+    }
+}
+
+void TextureAtlas::set_texture(const Texture& texture)
+{
+    if (texture.width() == 0 || texture.height() == 0)
+    {
+        // Sprite batches using this atlas are never drawn.
+        texture_ = Texture();
+        if (on_ready_)
+        {
+            Callback on_ready = std::move(on_ready_);
+            on_ready(*this);
         }
+        return;
     }
+
+    texture_ = Texture(texture);
+    finish_loading();
 }
@@ -5,6 +5,7 @@
 #ifndef GRAPHICS_TEXTUREATLAS_H_
 #define GRAPHICS_TEXTUREATLAS_H_
 
+#include <functional>
 #include <tuple>
 #include <vector>
 
@@ -38,15 +39,38 @@ using TextureList = std::initializer_list<std::tuple<int, int, int, int>>;
 class TextureAtlas : public RefCounted
 {
 public:
+    using Callback = std::function<void(TextureAtlas&)>;
+
     explicit TextureAtlas(const char* path, float scale = 1.0f);
     TextureAtlas(const char* path, float scale, TextureList regions);
+
+    /// <summary>
+    ///   Loads texture atlas without blocking. The image is decoded on a
+    ///   worker thread and uploaded by <see cref="TextureManager::update"/>.
+    /// </summary>
+    /// <remarks>
+    ///   Regions may be added while the atlas is loading. Sprite batches
+    ///   using the atlas are not drawn until it is ready.
+    /// </remarks>
+    /// <param name="path">Path to image file.</param>
+    /// <param name="scale">Scale to rasterise vector images at.</param>
+    /// <param name="on_ready">
+    ///   Function called once the atlas has loaded, or failed to load.
+    /// </param>
+    TextureAtlas(const char* path, float scale, Callback on_ready);
+
     TextureAtlas(const char* id, const DataMap& data, float scale = 1.0f);
     TextureAtlas(const char* id,
                  const DataMap& data,
                  float scale,
                  TextureList regions);
+    ~TextureAtlas();
 
     auto height() const { return texture_.height(); }
+
+    /// <summary>Returns whether the texture has been uploaded.</summary>
+    auto is_ready() const { return ready_; }
+
     auto is_valid() const { return texture_; }
     auto size() const { return regions_.size(); }
     auto width() const { return texture_.width(); }
@@ -65,6 +89,12 @@ public:
     /// <returns>The id of the region.</returns>
     auto add_region(int x, int y, int width, int height) -> unsigned int;
 
+    /// <summary>
+    ///   Sets the function to call once the atlas has loaded. Ignored if the
+    ///   atlas has already loaded.
+    /// </summary>
+    void set_callback(Callback on_ready) { on_ready_ = std::move(on_ready); }
+
     /// <summary>
     ///   Replaces the current set of texture regions with the set in the
     ///   specified array.
@@ -82,14 +112,34 @@ public:
     explicit TextureAtlas(const rainbow::ISolemnlySwearThatIAmOnlyTesting& test)
         : texture_(test) {}
 
+#ifdef RAINBOW_TEST
+    TextureAtlas(const rainbow::ISolemnlySwearThatIAmOnlyTesting& test,
+                 Callback on_ready)
+        : texture_(test), ready_(false), on_ready_(std::move(on_ready)) {}
+
+    void finish_loading_for_testing() { finish_loading(); }
+#endif  // RAINBOW_TEST
+
 private:
     rainbow::Texture texture_;                     ///< Texture atlas' id.
     std::vector<rainbow::TextureRegion> regions_;  ///< Defined texture regions.
+    bool ready_ = true;  ///< Whether the texture has been uploaded.
+    Callback on_ready_;  ///< Called once the texture has been uploaded.
+
+    /// <summary>
+    ///   Normalises regions added while loading, and notifies the listener.
+    /// </summary>
+    void finish_loading();
+
+    /// <summary>
+    ///   Checks the texture of an atlas created synchronously. If another
+    ///   atlas is still loading it asynchronously, this atlas is not ready
+    ///   until the texture has been uploaded. If it failed to load, it is
+    ///   released and the atlas is never ready.
+    /// </summary>
+    void check_texture(const char* id);
 
-    void load(TextureManager& texture_manager,
-              const rainbow::Texture& texture,
-              const DataMap& data,
-              float scale);
+    void set_texture(const rainbow::Texture& texture);
 };
 
 #endif
@@ -4,7 +4,13 @@
 
 #include "Graphics/TextureManager.h"
 
+#include <algorithm>
+#include <deque>
+#include <mutex>
+
+#include "Common/Chrono.h"
 #include "Graphics/Renderer.h"
+#include "Threading/JobSystem.h"
 
 using rainbow::Texture;
 using rainbow::graphics::TextureFilter;
@@ -24,19 +30,33 @@ namespace
 #   define assert_texture_size(...) static_cast<void>(0)
 #endif
 
-    template <typename Container, typename T, typename F>
-    void perform_if(Container& container, const T& value, F&& action)
+    auto bytes_per_pixel(unsigned int internal_format) -> unsigned int
     {
-        for (auto&& element : container)
+        switch (internal_format)
         {
-            if (element == value)
-            {
-                action(element);
-                break;
-            }
+            case GL_LUMINANCE:
+                return 1;
+            case GL_LUMINANCE_ALPHA:
+            case GL_RGBA4:
+                return 2;
+            default:
+                return 4;
         }
     }
 
+    /// <summary>
+    ///   Returns the number of levels in a full mipmap chain for a texture of
+    ///   specified size.
+    /// </summary>
+    auto mipmap_levels(unsigned int width, unsigned int height)
+        -> unsigned int
+    {
+        unsigned int levels = 1;
+        for (unsigned int size = std::max(width, height); size > 1; size >>= 1)
+            ++levels;
+        return levels;
+    }
+
     int texture_filter(TextureFilter filter)
     {
         switch (filter)
@@ -49,9 +69,43 @@ namespace
     }
 }
 
+class TextureManager::DecodeQueue
+{
+public:
+    struct Item
+    {
+        unsigned int index;
+        Uploader upload;  ///< <c>nullptr</c> if already uploaded.
+    };
+
+    bool pop(Item& item)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (items_.empty())
+            return false;
+
+        item = std::move(items_.front());
+        items_.pop_front();
+        return true;
+    }
+
+    void push(unsigned int index, Uploader upload)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        items_.push_back({index, std::move(upload)});
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<Item> items_;
+};
+
 Texture::Texture(const Texture& texture)
-    : name_(texture.name_), size_(texture.size_)
+    : name_(texture.name_), size_(texture.size_), handle_(texture.handle_)
 {
+    if (name_ == 0)
+        return;
+
     TextureManager::Get()->retain(*this);
 }
 
@@ -65,12 +119,12 @@ Texture::~Texture()
 
 void Texture::bind() const
 {
-    TextureManager::Get()->bind(name_);
+    TextureManager::Get()->bind(*this);
 }
 
 void Texture::bind(unsigned int unit) const
 {
-    TextureManager::Get()->bind(name_, unit);
+    TextureManager::Get()->bind(*this, unit);
 }
 
 Texture& Texture::operator=(Texture&& texture)
@@ -79,6 +133,7 @@ Texture& Texture::operator=(Texture&& texture)
         TextureManager::Get()->release(*this);
     name_ = texture.name_;
     size_ = texture.size_;
+    handle_ = texture.handle_;
     texture.name_ = 0;
     texture.size_ = Vec2u::Zero;
     return *this;
@@ -92,10 +147,19 @@ void TextureManager::set_filter(TextureFilter filter)
 
 void TextureManager::bind(unsigned int name)
 {
+#ifndef NDEBUG
+    ++rainbow::graphics::detail::g_state_changes_accumulator.texture_requests;
+#endif
+
     if (name == active_[0])
         return;
 
-    glBindTexture(GL_TEXTURE_2D, name);
+#ifndef NDEBUG
+    ++rainbow::graphics::detail::g_state_changes_accumulator.textures;
+#endif
+
+    if (!headless_)
+        glBindTexture(GL_TEXTURE_2D, name);
     active_[0] = name;
 }
 
@@ -103,63 +167,236 @@ void TextureManager::bind(unsigned int name, unsigned int unit)
 {
     R_ASSERT(unit < kNumTextureUnits, "Invalid texture unit");
 
+#ifndef NDEBUG
+    ++rainbow::graphics::detail::g_state_changes_accumulator.texture_requests;
+#endif
+
     if (unit >= kNumTextureUnits || name == active_[unit])
         return;
 
-    glActiveTexture(GL_TEXTURE0 + unit);
-    glBindTexture(GL_TEXTURE_2D, name);
-    glActiveTexture(GL_TEXTURE0);
+#ifndef NDEBUG
+    ++rainbow::graphics::detail::g_state_changes_accumulator.textures;
+#endif
+
+    if (!headless_)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, name);
+        glActiveTexture(GL_TEXTURE0);
+    }
     active_[unit] = name;
 }
 
-void TextureManager::trim()
+void TextureManager::bind(const Texture& texture)
 {
-    auto first = std::remove_if(
-        textures_.begin(),
-        textures_.end(),
-        [](const rainbow::detail::Texture& texture) {
-            return texture.use_count == 0;
-        });
-    auto end = textures_.end();
-    if (first == end)
-        return;
+    if (texture)
+        touch(texture);
+    bind(static_cast<unsigned int>(texture));
+}
 
-    for (auto i = first; i != end; ++i)
+void TextureManager::bind(const Texture& texture, unsigned int unit)
+{
+    if (texture)
+        touch(texture);
+    bind(static_cast<unsigned int>(texture), unit);
+}
+
+auto TextureManager::create_async(const char* id,
+                                  Decoder decoder,
+                                  const void* owner,
+                                  Callback callback) -> Texture
+{
+    auto i = lookup_.find(id);
+    if (i != lookup_.end())
     {
-        glDeleteTextures(1, &i->name);
-#if RAINBOW_RECORD_VMEM_USAGE
-        mem_used_ -= i->size;
-#endif
+        const unsigned int index = i->second;
+        auto pending = std::find_if(
+            pending_.begin(), pending_.end(), [index](const Pending& p) {
+                return p.index == index;
+            });
+        if (pending == pending_.end())
+        {
+            pending_.push_back({index, {}});
+            pending = pending_.end() - 1;
+            decoded_->push(index, nullptr);
+        }
+        pending->listeners.push_back({owner, std::move(callback)});
+        return textures_[index];
+    }
+
+    Texture texture = create_texture(id);
+    const unsigned int index = texture.handle_.index;
+    sources_[index] = decoder;
+    decode_async(index, std::move(decoder));
+    pending_.back().listeners.push_back({owner, std::move(callback)});
+    return texture;
+}
+
+void TextureManager::cancel(const void* owner)
+{
+    for (auto&& pending : pending_)
+    {
+        auto& listeners = pending.listeners;
+        listeners.erase(std::remove_if(listeners.begin(),
+                                       listeners.end(),
+                                       [owner](const Listener& listener) {
+                                           return listener.owner == owner;
+                                       }),
+                        listeners.end());
     }
+}
+
+bool TextureManager::is_loading(const Texture& texture)
+{
+    return get(texture).loading;
+}
 
-    textures_.erase(first, end);
+void TextureManager::set_source(const Texture& texture, Decoder decoder)
+{
+    sources_[get(texture).handle.index] = std::move(decoder);
+}
+
+void TextureManager::trim()
+{
+    if (unused_.empty())
+        return;
+
+    // Textures that are still loading must be kept until they have been
+    // uploaded, or their slots may be reused.
+    auto last = std::remove_if(
+        unused_.begin(), unused_.end(), [this](unsigned int index) {
+            rainbow::detail::Texture& texture = textures_[index];
+            if (texture.loading)
+                return false;
+
+            // The texture may have been retained again, or already deleted
+            // if it was released more than once.
+            if (texture.use_count > 0 || texture.name == 0)
+                return true;
+
+            if (!headless_)
+                glDeleteTextures(1, &texture.name);
+            mem_used_ -= texture.size;
+            lookup_.erase(texture.id);
+            sources_[index] = nullptr;
+            texture.id.clear();
+            texture.name = 0;
+            texture.width = 0;
+            texture.height = 0;
+            texture.size = 0;
+            texture.evicted = false;
+            ++texture.handle.generation;
+            free_.push_back(index);
+            return true;
+        });
+    if (last == unused_.end())
+        return;
 
-#if RAINBOW_RECORD_VMEM_USAGE
+    unused_.erase(last, unused_.end());
     update_usage();
-#endif
+}
+
+void TextureManager::update(std::chrono::microseconds budget)
+{
+    ++frame_;
+    if (budget_ > 0 && mem_used_ > budget_)
+        evict();
+
+    if (pending_.empty())
+        return;
+
+    const auto deadline = Chrono::clock::now() + budget;
+    DecodeQueue::Item item;
+    while (decoded_->pop(item))
+    {
+        R_ASSERT(textures_[item.index].name != 0,
+                 "Pending texture was deleted");
+
+        if (item.upload)
+        {
+            item.upload(*this, textures_[item.index]);
+            item.upload = nullptr;
+        }
+        textures_[item.index].loading = false;
+
+        auto pending = std::find_if(
+            pending_.begin(), pending_.end(), [&item](const Pending& p) {
+                return p.index == item.index;
+            });
+        std::vector<Listener> listeners = std::move(pending->listeners);
+        pending_.erase(pending);
+
+        // Listeners may create more textures, invalidating references into
+        // the slot map.
+        const Texture texture = textures_[item.index];
+        for (auto&& listener : listeners)
+            listener.callback(texture);
+
+        if (Chrono::clock::now() >= deadline)
+            break;
+    }
 }
 
 TextureManager::TextureManager()
-    : mag_filter_(TextureFilter::Linear), min_filter_(TextureFilter::Linear)
-#if RAINBOW_RECORD_VMEM_USAGE
-    , mem_peak_(0.0), mem_used_(0.0)
-#endif
+    : decoded_(std::make_shared<DecodeQueue>()),
+      mag_filter_(TextureFilter::Linear), min_filter_(TextureFilter::Linear),
+      frame_(0), budget_(0), mem_peak_(0.0), mem_used_(0.0), evictions_(0),
+      reloads_(0), headless_(false)
 {
     std::fill_n(active_, kNumTextureUnits, 0);
     make_global();
 }
 
+#ifdef RAINBOW_TEST
+TextureManager::TextureManager(
+    const rainbow::ISolemnlySwearThatIAmOnlyTesting&)
+    : TextureManager()
+{
+    headless_ = true;
+}
+#endif
+
 TextureManager::~TextureManager()
 {
+    if (headless_)
+        return;
+
     for (const rainbow::detail::Texture& texture : textures_)
-        glDeleteTextures(1, &texture.name);
+    {
+        if (texture.name != 0)
+            glDeleteTextures(1, &texture.name);
+    }
 }
 
 auto TextureManager::create_texture(const char* id) -> Texture
 {
-    GLuint name;
-    glGenTextures(1, &name);
-    textures_.emplace_back(id, name);
+    unsigned int index;
+    if (free_.empty())
+    {
+        index = textures_.size();
+        textures_.emplace_back(index);
+        sources_.emplace_back();
+    }
+    else
+    {
+        index = free_.back();
+        free_.pop_back();
+    }
+
+    GLuint name = index + 1;
+    if (!headless_)
+        glGenTextures(1, &name);
+
+    rainbow::detail::Texture& texture = textures_[index];
+    texture.id = id;
+    texture.name = name;
+    texture.use_count = 0;
+    texture.last_used = frame_;
+    texture.loading = false;
+    lookup_.emplace(id, index);
+
+    if (headless_)
+        return texture;
 
     bind(name);
     glTexParameteri(
@@ -169,7 +406,78 @@ auto TextureManager::create_texture(const char* id) -> Texture
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    return textures_.back();
+    return texture;
+}
+
+void TextureManager::decode_async(unsigned int index, Decoder decoder)
+{
+    textures_[index].loading = true;
+    pending_.push_back({index, {}});
+
+    auto decode = [decoded = decoded_, index, decoder = std::move(decoder)] {
+        decoded->push(index, decoder());
+    };
+    auto jobs = rainbow::JobSystem::Get();
+    if (jobs == nullptr)
+        decode();
+    else
+        jobs->submit(std::move(decode));
+}
+
+void TextureManager::evict()
+{
+    std::vector<unsigned int> candidates;
+    for (auto&& texture : textures_)
+    {
+        if (texture.size == 0 || texture.loading ||
+            frame_ - texture.last_used < kMinIdleFrames ||
+            !sources_[texture.handle.index])
+        {
+            continue;
+        }
+
+        candidates.push_back(texture.handle.index);
+    }
+
+    std::sort(candidates.begin(),
+              candidates.end(),
+              [this](unsigned int a, unsigned int b) {
+                  return textures_[a].last_used < textures_[b].last_used;
+              });
+
+    for (auto index : candidates)
+    {
+        if (mem_used_ <= budget_)
+            break;
+
+        // Respecifying the texture with no data frees its storage, but keeps
+        // the name that sprites and texture regions refer to. Each level has
+        // its own storage, so mipmaps must be respecified as well; levels
+        // that were never uploaded are already empty.
+        rainbow::detail::Texture& texture = textures_[index];
+        bind(texture.name);
+        const unsigned int levels =
+            headless_ ? 0 : mipmap_levels(texture.width, texture.height);
+        for (unsigned int level = 0; level < levels; ++level)
+        {
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, 0, 0, 0, GL_RGBA,
+                         GL_UNSIGNED_BYTE, nullptr);
+        }
+        mem_used_ -= texture.size;
+        texture.size = 0;
+        texture.evicted = true;
+        ++evictions_;
+    }
+
+    update_usage();
+}
+
+auto TextureManager::get(const Texture& t) -> rainbow::detail::Texture&
+{
+    rainbow::detail::Texture& texture = textures_[t.handle_.index];
+    R_ASSERT(texture.handle.generation == t.handle_.generation,
+             "Texture has been deleted");
+    return texture;
 }
 
 void TextureManager::upload(const Texture& texture,
@@ -179,25 +487,41 @@ void TextureManager::upload(const Texture& texture,
                             unsigned int format,
                             const void* data)
 {
-    assert_texture_size(width, height);
+    bind(texture);
+    if (!headless_)
+    {
+        assert_texture_size(width, height);
+        glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0,
+                     format, GL_UNSIGNED_BYTE, data);
+
+        R_ASSERT(glGetError() == GL_NO_ERROR, "Failed to upload texture");
+    }
 
+    rainbow::detail::Texture& t = get(texture);
+    t.width = width;
+    t.height = height;
+    mem_used_ -= t.size;
+    t.size = width * height * bytes_per_pixel(internal_format);
+    mem_used_ += t.size;
+    update_usage();
+}
+
+void TextureManager::upload_region(const Texture& texture,
+                                   unsigned int x,
+                                   unsigned int y,
+                                   unsigned int width,
+                                   unsigned int height,
+                                   unsigned int format,
+                                   const void* data)
+{
     bind(texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format,
-                 GL_UNSIGNED_BYTE, data);
-
-    R_ASSERT(glGetError() == GL_NO_ERROR, "Failed to upload texture");
-
-    perform_if(textures_,
-               texture,
-               [this, width, height](rainbow::detail::Texture& texture) {
-                   texture.width = width;
-                   texture.height = height;
-                   texture.size = width * height * 4;
-#if RAINBOW_RECORD_VMEM_USAGE
-                   mem_used_ += texture.size;
-                   update_usage();
-#endif
-               });
+    if (headless_)
+        return;
+
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format,
+                    GL_UNSIGNED_BYTE, data);
+
+    R_ASSERT(glGetError() == GL_NO_ERROR, "Failed to upload texture region");
 }
 
 void TextureManager::upload_compressed(const Texture& texture,
@@ -205,48 +529,69 @@ void TextureManager::upload_compressed(const Texture& texture,
                                        unsigned int width,
                                        unsigned int height,
                                        unsigned int size,
-                                       const void* data)
+                                       const void* data,
+                                       unsigned int level)
 {
-    assert_texture_size(width, height);
-
     bind(texture);
-    glCompressedTexImage2D(
-        GL_TEXTURE_2D, 0, format, width, height, 0, size, data);
-
-    R_ASSERT(glGetError() == GL_NO_ERROR, "Failed to upload texture");
-
-    perform_if(textures_,
-               texture,
-               [this, width, height, size](rainbow::detail::Texture& texture) {
-                   texture.width = width;
-                   texture.height = height;
-                   texture.size = size;
-#if RAINBOW_RECORD_VMEM_USAGE
-                   mem_used_ += texture.size;
-                   update_usage();
-#endif
-               });
+    if (!headless_)
+    {
+        assert_texture_size(width, height);
+        glCompressedTexImage2D(
+            GL_TEXTURE_2D, level, format, width, height, 0, size, data);
+
+        R_ASSERT(glGetError() == GL_NO_ERROR, "Failed to upload texture");
+    }
+
+    rainbow::detail::Texture& t = get(texture);
+    if (level == 0)
+    {
+        t.width = width;
+        t.height = height;
+        mem_used_ -= t.size;
+        t.size = 0;
+    }
+    else if (width == 1 && height == 1 &&
+             min_filter_ == TextureFilter::Linear && !headless_)
+    {
+        // The mipmap chain is complete.
+        glTexParameteri(
+            GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+    }
+    t.size += size;
+    mem_used_ += size;
+    update_usage();
 }
 
 void TextureManager::release(const Texture& t)
 {
-    perform_if(textures_, t, [](rainbow::detail::Texture& texture) {
-        --texture.use_count;
-    });
+    rainbow::detail::Texture& texture = get(t);
+    R_ASSERT(texture.use_count > 0, "Texture was released too many times");
+
+    if (--texture.use_count == 0)
+        unused_.push_back(texture.handle.index);
 }
 
 void TextureManager::retain(const Texture& t)
 {
-    perform_if(textures_, t, [](rainbow::detail::Texture& texture) {
-        ++texture.use_count;
-    });
+    ++get(t).use_count;
+}
+
+void TextureManager::touch(const Texture& t)
+{
+    rainbow::detail::Texture& texture = get(t);
+    texture.last_used = frame_;
+    if (!texture.evicted)
+        return;
+
+    texture.evicted = false;
+    ++reloads_;
+    decode_async(texture.handle.index, sources_[texture.handle.index]);
 }
 
-#if RAINBOW_RECORD_VMEM_USAGE
 auto TextureManager::memory_usage() const -> TextureManager::MemoryUsage
 {
     const double M = 1e-6;
-    return {mem_used_ * M, mem_peak_ * M};
+    return {mem_used_ * M, mem_peak_ * M, budget_ * M, evictions_, reloads_};
 }
 
 void TextureManager::update_usage()
@@ -256,4 +601,3 @@ void TextureManager::update_usage()
 
     LOGD("Video: %.2f MBs of textures", memory_usage().used);
 }
-#endif
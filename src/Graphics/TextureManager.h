@@ -5,13 +5,16 @@
 #ifndef GRAPHICS_TEXTUREMANAGER_H_
 #define GRAPHICS_TEXTUREMANAGER_H_
 
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "Common/Global.h"
 #include "Graphics/Texture.h"
 
-#define RAINBOW_RECORD_VMEM_USAGE !defined(NDEBUG) || defined(USE_HEIMDALL)
-
 namespace rainbow { namespace graphics
 {
     struct State;
@@ -28,9 +31,48 @@ namespace rainbow { namespace graphics
 class TextureManager : public Global<TextureManager>
 {
 public:
+    /// <summary>Uploads decoded image data to a texture.</summary>
+    using Uploader =
+        std::function<void(TextureManager&, const rainbow::Texture&)>;
+
+    /// <summary>
+    ///   Decodes image data and returns a function that uploads it.
+    /// </summary>
+    using Decoder = std::function<Uploader()>;
+
+    /// <summary>Called when a texture has been uploaded.</summary>
+    using Callback = std::function<void(const rainbow::Texture&)>;
+
+    struct MemoryUsage
+    {
+        double used;              ///< Megabytes used by textures.
+        double peak;              ///< Peak megabytes used by textures.
+        double budget;            ///< Budget in megabytes; 0 if unlimited.
+        unsigned int evictions;   ///< Number of textures evicted.
+        unsigned int reloads;     ///< Number of evicted textures reloaded.
+    };
+
+    /// <summary>
+    ///   Returns the texture memory budget in bytes; 0 if unlimited.
+    /// </summary>
+    auto budget() const { return budget_; }
+
     auto mag_filter() const { return mag_filter_; }
     auto min_filter() const { return min_filter_; }
 
+    /// <summary>
+    ///   Sets the texture memory budget. Once exceeded, textures that have
+    ///   not been bound for a while are evicted, least recently used first.
+    ///   Evicted textures are reloaded in the background the next time they
+    ///   are bound.
+    /// </summary>
+    /// <remarks>
+    ///   Only textures with a source, see <see cref="set_source"/>, are
+    ///   evicted.
+    /// </remarks>
+    /// <param name="bytes">Budget in bytes; 0 for unlimited.</param>
+    void set_budget(size_t bytes) { budget_ = bytes; }
+
     /// <summary>Sets texture filtering function.</summary>
     /// <remarks>Existing textures are not affected by this setting.</remarks>
     void set_filter(rainbow::graphics::TextureFilter filter);
@@ -46,6 +88,18 @@ public:
     /// <param name="unit">Texture unit to bind to.</param>
     void bind(unsigned int name, unsigned int unit);
 
+    /// <summary>
+    ///   Makes texture active on current rendering target, and marks it as
+    ///   used this frame. Starts reloading the texture if it was evicted.
+    /// </summary>
+    void bind(const rainbow::Texture& texture);
+
+    /// <summary>
+    ///   Makes texture active on specified unit, and marks it as used this
+    ///   frame. Starts reloading the texture if it was evicted.
+    /// </summary>
+    void bind(const rainbow::Texture& texture, unsigned int unit);
+
     /// <summary>
     ///   Loads texture for unique identifier, using the specified loader.
     /// </summary>
@@ -61,18 +115,71 @@ public:
     template <typename F>
     auto create(const char* id, F&& loader) -> rainbow::Texture
     {
-        auto t = std::find(textures_.begin(), textures_.end(), id);
-        if (t == textures_.end())
+        auto i = lookup_.find(id);
+        if (i == lookup_.end())
         {
-            loader(*this, create_texture(id));
-            return textures_.back();
+            rainbow::Texture texture = create_texture(id);
+            loader(*this, texture);
+            return textures_[texture.handle_.index];
         }
-        return *t;
+        return textures_[i->second];
     }
 
+    /// <summary>
+    ///   Loads texture for unique identifier without blocking. Image data is
+    ///   decoded on a worker thread, and uploaded during a later
+    ///   <see cref="update"/>.
+    /// </summary>
+    /// <remarks>
+    ///   The returned texture has no size until it has been uploaded. If a
+    ///   texture with the same identifier already exists, it is returned and
+    ///   <paramref name="callback"/> is called on the next update.
+    /// </remarks>
+    /// <param name="id">A unique identifier.</param>
+    /// <param name="decoder">
+    ///   Function for decoding image data. Called on a worker thread, and must
+    ///   not touch the graphics context.
+    /// </param>
+    /// <param name="owner">
+    ///   Owner of <paramref name="callback"/>. See <see cref="cancel"/>.
+    /// </param>
+    /// <param name="callback">
+    ///   Function called once the texture has been uploaded.
+    /// </param>
+    /// <returns>Texture name.</returns>
+    auto create_async(const char* id,
+                      Decoder decoder,
+                      const void* owner,
+                      Callback callback) -> rainbow::Texture;
+
+    /// <summary>
+    ///   Cancels all callbacks registered by <paramref name="owner"/>.
+    /// </summary>
+    void cancel(const void* owner);
+
+    /// <summary>
+    ///   Returns whether <paramref name="texture"/> is still waiting to be
+    ///   decoded and uploaded.
+    /// </summary>
+    bool is_loading(const rainbow::Texture& texture);
+
+    /// <summary>
+    ///   Sets the function used to reload texture after it has been evicted.
+    ///   Textures loaded with <see cref="create_async"/> use their decoder.
+    /// </summary>
+    void set_source(const rainbow::Texture& texture, Decoder decoder);
+
     /// <summary>Deletes unused textures.</summary>
     void trim();
 
+    /// <summary>
+    ///   Advances the frame counter, and evicts textures if over the memory
+    ///   budget. Then uploads textures that have finished decoding, until
+    ///   <paramref name="budget"/> has been spent. At least one texture is
+    ///   uploaded if any are ready.
+    /// </summary>
+    void update(std::chrono::microseconds budget);
+
     /// <summary>Uploads image data to specified texture.</summary>
     /// <param name="name">Target texture.</param>
     /// <param name="internal_format">Internal format of the texture.</param>
@@ -87,58 +194,140 @@ public:
                 unsigned int format,
                 const void* data);
 
+    /// <summary>
+    ///   Uploads image data to a region of specified texture. The texture
+    ///   must already have been uploaded.
+    /// </summary>
+    /// <param name="texture">Target texture.</param>
+    /// <param name="x">Left of the region.</param>
+    /// <param name="y">Top of the region.</param>
+    /// <param name="width">Width of the region.</param>
+    /// <param name="height">Height of the region.</param>
+    /// <param name="format">Format of the image data.</param>
+    /// <param name="data">Image data.</param>
+    void upload_region(const rainbow::Texture& texture,
+                       unsigned int x,
+                       unsigned int y,
+                       unsigned int width,
+                       unsigned int height,
+                       unsigned int format,
+                       const void* data);
+
     /// <summary>
     ///   Uploads compressed image data to specified texture.
     /// </summary>
+    /// <remarks>
+    ///   Mipmaps must be uploaded in order, after level 0. Mipmap filtering
+    ///   is enabled once the last level, 1x1, has been uploaded.
+    /// </remarks>
     /// <param name="name">Target texture.</param>
     /// <param name="format">Compression format.</param>
-    /// <param name="width">Width of the texture.</param>
-    /// <param name="height">Height of the texture.</param>
+    /// <param name="width">Width of the mipmap level.</param>
+    /// <param name="height">Height of the mipmap level.</param>
     /// <param name="size">Data size.</param>
     /// <param name="data">Image data.</param>
+    /// <param name="level">Mipmap level.</param>
     void upload_compressed(const rainbow::Texture& texture,
                            unsigned int format,
                            unsigned int width,
                            unsigned int height,
                            unsigned int size,
-                           const void* data);
-
-#if RAINBOW_RECORD_VMEM_USAGE
-    struct MemoryUsage
-    {
-        double used;
-        double peak;
-    };
+                           const void* data,
+                           unsigned int level = 0);
 
     /// <summary>Returns total video memory used by textures.</summary>
     auto memory_usage() const -> MemoryUsage;
+
+#ifdef RAINBOW_TEST
+    /// <summary>
+    ///   Creates a texture manager that never touches the graphics context.
+    ///   Texture names are made up from their slots, and uploads only update
+    ///   the memory accounting.
+    /// </summary>
+    explicit TextureManager(const rainbow::ISolemnlySwearThatIAmOnlyTesting&);
+
+    ~TextureManager();
 #endif
 
 private:
     static const size_t kNumTextureUnits = 2;
 
+    /// <summary>
+    ///   Number of frames a texture must have gone unbound before it can be
+    ///   evicted.
+    /// </summary>
+    static const unsigned int kMinIdleFrames = 2;
+
+    struct Listener
+    {
+        const void* owner;
+        Callback callback;
+    };
+
+    /// <summary>Texture waiting to be decoded and uploaded.</summary>
+    struct Pending
+    {
+        unsigned int index;
+        std::vector<Listener> listeners;
+    };
+
+    /// <summary>Decoded textures, shared with worker threads.</summary>
+    class DecodeQueue;
+
     unsigned int active_[kNumTextureUnits];
+
+    /// <summary>
+    ///   Slot map of textures. Free slots have no name, and are listed in
+    ///   <see cref="free_"/>.
+    /// </summary>
     std::vector<rainbow::detail::Texture> textures_;
+    std::vector<Decoder> sources_;      ///< Texture reloaders, by slot.
+    std::vector<unsigned int> free_;    ///< Free texture slots.
+    std::vector<unsigned int> unused_;  ///< Slots released since last trim.
+    std::unordered_map<std::string, unsigned int> lookup_;  ///< Id to slot.
+    std::vector<Pending> pending_;
+    std::shared_ptr<DecodeQueue> decoded_;
     rainbow::graphics::TextureFilter mag_filter_;
     rainbow::graphics::TextureFilter min_filter_;
-
-#if RAINBOW_RECORD_VMEM_USAGE
+    unsigned int frame_;      ///< Number of updates so far.
+    size_t budget_;           ///< Texture memory budget in bytes.
     double mem_peak_;
     double mem_used_;
-#endif
+    unsigned int evictions_;  ///< Number of textures evicted.
+    unsigned int reloads_;    ///< Number of evicted textures reloaded.
+    bool headless_;           ///< Whether to skip all graphics calls.
 
     TextureManager();
+#ifndef RAINBOW_TEST
     ~TextureManager();
+#endif
 
     auto create_texture(const char* id) -> rainbow::Texture;
 
+    /// <summary>
+    ///   Decodes texture at slot <paramref name="index"/> on a worker thread.
+    /// </summary>
+    void decode_async(unsigned int index, Decoder decoder);
+
+    /// <summary>
+    ///   Evicts least recently used textures until within budget.
+    /// </summary>
+    void evict();
+
+    /// <summary>Returns the slot of specified texture.</summary>
+    auto get(const rainbow::Texture& t) -> rainbow::detail::Texture&;
+
+    /// <summary>
+    ///   Marks texture as used this frame, and starts reloading it if it was
+    ///   evicted.
+    /// </summary>
+    void touch(const rainbow::Texture& t);
+
     void release(const rainbow::Texture& t);
     void retain(const rainbow::Texture& t);
 
-#if RAINBOW_RECORD_VMEM_USAGE
     /// <summary>Updates and prints total texture memory used.</summary>
     void update_usage();
-#endif
 
     friend rainbow::Texture;
     friend rainbow::graphics::State;
@@ -4,8 +4,13 @@
 
 #include "Heimdall/Overlay.h"
 
+#include <algorithm>
 #include <numeric>
+#include <unordered_map>
+#include <vector>
 
+#include "Common/Logging.h"
+#include "Common/Profiler.h"
 #include "Graphics/Renderer.h"
 #include "ThirdParty/ImGui/ImGuiHelper.h"
 
@@ -17,6 +22,48 @@ using rainbow::SceneNode;
 namespace
 {
     constexpr size_t kDataSampleSize = 100;
+    constexpr size_t kMaxProfilerZones = 16;
+
+    struct ZoneTotal
+    {
+        const char* name;
+        uint64_t cpu_time;
+        uint64_t gpu_time;
+        unsigned int count;
+    };
+
+    /// <summary>
+    ///   Returns time spent in each zone during the last frame, most expensive
+    ///   first.
+    /// </summary>
+    auto zone_totals()
+    {
+        std::unordered_map<const char*, ZoneTotal> totals;
+        for (auto&& zone : rainbow::profiler::last_frame())
+        {
+            auto& total = totals[zone.name];
+            total.name = zone.name;
+            if (zone.thread == rainbow::profiler::kGpuThread)
+                total.gpu_time += zone.end - zone.begin;
+            else
+            {
+                total.cpu_time += zone.end - zone.begin;
+                ++total.count;
+            }
+        }
+
+        std::vector<ZoneTotal> sorted;
+        sorted.reserve(totals.size());
+        for (auto&& total : totals)
+            sorted.push_back(total.second);
+        std::sort(sorted.begin(),
+                  sorted.end(),
+                  [](const ZoneTotal& a, const ZoneTotal& b) {
+                      return std::max(a.cpu_time, a.gpu_time) >
+                             std::max(b.cpu_time, b.gpu_time);
+                  });
+        return sorted;
+    }
 
     template <typename T>
     float at(void* data, int i)
@@ -96,8 +143,26 @@ void Overlay::update_impl(unsigned long dt)
         {
             const ImVec2 graph_size(400, 100);
 
-            ImGui::LabelText(
-                "", "Draw count: %u", rainbow::graphics::draw_count());
+            ImGui::LabelText("",
+                             "Draw count: %u (%u merged)",
+                             rainbow::graphics::draw_count(),
+                             rainbow::graphics::draws_saved());
+            ImGui::LabelText("",
+                             "Culled nodes: %u",
+                             rainbow::graphics::culled_count());
+            ImGui::LabelText("",
+                             "Vertex uploads: %.1f KB/frame",
+                             rainbow::graphics::bytes_uploaded() / 1024.0f);
+
+            const auto& changes = rainbow::graphics::state_changes();
+            ImGui::LabelText("",
+                             "Program changes: %u (%u redundant)",
+                             changes.programs,
+                             changes.program_requests - changes.programs);
+            ImGui::LabelText("",
+                             "Texture binds: %u (%u redundant)",
+                             changes.textures,
+                             changes.texture_requests - changes.textures);
 
             snprintf_q(buffer,
                        rainbow::array_size(buffer),
@@ -128,6 +193,32 @@ void Overlay::update_impl(unsigned long dt)
                              graph_size);
         }
 
+        if (ImGui::CollapsingHeader("Profiler", nullptr, false, false))
+        {
+            bool recording = rainbow::profiler::is_enabled();
+            if (ImGui::Checkbox("Record", &recording))
+                rainbow::profiler::set_enabled(recording);
+            ImGui::SameLine();
+            if (ImGui::Button("Save trace"))
+            {
+                if (!rainbow::profiler::write_chrome_trace("trace.json"))
+                    LOGE("Failed to save profiler trace");
+            }
+
+            const auto totals = zone_totals();
+            const size_t count = std::min(totals.size(), kMaxProfilerZones);
+            for (size_t i = 0; i < count; ++i)
+            {
+                const auto& total = totals[i];
+                ImGui::LabelText("",
+                                 "%s: %.2f ms (%u), GPU %.2f ms",
+                                 total.name,
+                                 total.cpu_time / 1000000.0,
+                                 total.count,
+                                 total.gpu_time / 1000000.0);
+            }
+        }
+
         ImGui::End();
     }
 }
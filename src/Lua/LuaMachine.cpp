@@ -6,6 +6,7 @@
 
 #include "Common/Chrono.h"
 #include "Common/Data.h"
+#include "Common/Profiler.h"
 #include "Lua/LuaModules.h"
 #include "Lua/LuaScript.h"
 #include "Resources/Rainbow.lua.h"
@@ -98,6 +99,8 @@ namespace rainbow
 
     int LuaMachine::update(unsigned long t)
     {
+        R_PROFILE_ZONE("LuaMachine::update");
+
 #ifndef NDEBUG
         lua_rawgeti(state_, LUA_REGISTRYINDEX, traceback_);
 #endif
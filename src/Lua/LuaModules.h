@@ -13,12 +13,14 @@
 #include "Lua/lua_IO.h"
 #include "Lua/lua_Label.h"
 #include "Lua/lua_Platform.h"
+#include "Lua/lua_Profiler.h"
 #include "Lua/lua_Random.h"
 #include "Lua/lua_Renderer.h"
 #include "Lua/lua_SceneGraph.h"
 #include "Lua/lua_Shaders.h"
 #include "Lua/lua_Sprite.h"
 #include "Lua/lua_SpriteBatch.h"
+#include "Lua/lua_TextBatch.h"
 #include "Lua/lua_Texture.h"
 
 #include "ThirdParty/Box2D/Lua/Box2D.h"
@@ -36,6 +38,7 @@ NS_RAINBOW_LUA_BEGIN
         reg<ScopedNode>(L);
         reg<Sprite>(L);
         reg<SpriteBatch>(L);
+        reg<TextBatch>(L);
         reg<Texture>(L);
 
 #ifdef USE_SPINE
@@ -52,6 +55,7 @@ NS_RAINBOW_LUA_BEGIN
         random::init(L);    // Initialise "rainbow.random" function
         input::init(L);     // Initialise "rainbow.input" namespace
         audio::init(L);     // Initialise "rainbow.audio" namespace
+        profiler::init(L);  // Initialise "rainbow.profiler" namespace
 
 #ifdef USE_PHYSICS
         b2::lua::init(L);  // Initialise "b2" namespace
@@ -37,6 +37,11 @@ namespace
         return lua_type(L, n) == LUA_TBOOLEAN;
     }
 
+    bool is_function(lua_State* L, int n)
+    {
+        return lua_type(L, n) == LUA_TFUNCTION;
+    }
+
     bool is_table(lua_State* L, int n)
     {
         return lua_type(L, n) == LUA_TTABLE;
@@ -99,6 +104,14 @@ NS_RAINBOW_LUA_BEGIN
         require(L, n, lua_isstring, "string");
     }
 
+    /* lua_CFunction */
+
+    template <>
+    void Argument<lua_CFunction>::is_optional(lua_State* L, int n)
+    {
+        optional(L, n, is_function, "nil or function");
+    }
+
     /* void */
 
     template <>
@@ -233,6 +246,16 @@ NS_RAINBOW_LUA_BEGIN
         require(L, n, is_userdata, "sprite batch");
     }
 
+    /* rainbow::lua::TextBatch */
+
+    class TextBatch;
+
+    template <>
+    void Argument<TextBatch>::is_required(lua_State* L, int n)
+    {
+        require(L, n, is_userdata, "text batch");
+    }
+
     /* rainbow::lua::Texture */
 
     class Texture;
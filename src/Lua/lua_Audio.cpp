@@ -4,6 +4,8 @@
 
 #include "Lua/lua_Audio.h"
 
+#include <algorithm>
+
 #include "Audio/Mixer.h"
 #include "Lua/LuaHelper.h"
 #include "Lua/LuaSyntax.h"
@@ -16,6 +18,11 @@ namespace
     constexpr const char kChannelType[] = "rainbow::audio::Channel";
     constexpr const char kSoundType[] = "rainbow::audio::Sound";
 
+    // Upper bounds for stream buffering requested from Lua. Larger values
+    // are clamped; they only waste memory.
+    constexpr lua_Integer kMaxStreamBufferCount = 8;
+    constexpr lua_Integer kMaxStreamBufferSize = 1 << 20;
+
     Channel* tochannel(lua_State* L)
     {
         return static_cast<Channel*>(rainbow::lua::topointer(L, kChannelType));
@@ -28,10 +35,14 @@ namespace
 
     int load_sound(lua_State* L)
     {
-        // rainbow.audio.load_sound(file)
+        // rainbow.audio.load_sound(file, decode_on_first_play)
         rainbow::lua::Argument<char*>::is_required(L, 1);
+        rainbow::lua::Argument<bool>::is_optional(L, 2);
 
-        Sound* sound = rainbow::audio::load_sound(lua_tostring(L, 1));
+        const auto decode = lua_toboolean(L, 2)
+                                ? rainbow::audio::Decode::OnFirstPlay
+                                : rainbow::audio::Decode::OnLoad;
+        Sound* sound = rainbow::audio::load_sound(lua_tostring(L, 1), decode);
         if (sound == nullptr)
             return 0;
 
@@ -41,10 +52,22 @@ namespace
 
     int load_stream(lua_State* L)
     {
-        // rainbow.audio.load_stream(file)
+        // rainbow.audio.load_stream(file, buffer_count, buffer_size)
         rainbow::lua::Argument<char*>::is_required(L, 1);
+        rainbow::lua::Argument<lua_Number>::is_optional(L, 2);
+        rainbow::lua::Argument<lua_Number>::is_optional(L, 3);
 
-        Sound* sound = rainbow::audio::load_stream(lua_tostring(L, 1));
+        rainbow::audio::StreamBuffering buffering;
+        const lua_Integer count =
+            rainbow::lua::optinteger(L, 2, buffering.count);
+        luaL_argcheck(L, count > 0, 2, "buffer count must be positive");
+        const lua_Integer size = rainbow::lua::optinteger(L, 3, buffering.size);
+        luaL_argcheck(L, size > 0, 3, "buffer size must be positive");
+
+        buffering.count = std::min(count, kMaxStreamBufferCount);
+        buffering.size = std::min(size, kMaxStreamBufferSize);
+        Sound* sound =
+            rainbow::audio::load_stream(lua_tostring(L, 1), buffering);
         if (sound == nullptr)
             return 0;
 
@@ -52,6 +75,30 @@ namespace
         return 1;
     }
 
+    int memory_usage(lua_State* L)
+    {
+        // rainbow.audio.memory_usage()
+        const auto usage = rainbow::audio::memory_usage();
+        lua_createtable(L, 0, 5);
+        luaR_rawsetnumber(L, "used", usage.used);
+        luaR_rawsetnumber(L, "peak", usage.peak);
+        luaR_rawsetnumber(L, "budget", usage.budget);
+        luaR_rawsetinteger(L, "evictions", usage.evictions);
+        luaR_rawsetinteger(L, "reloads", usage.reloads);
+        return 1;
+    }
+
+    int set_memory_budget(lua_State* L)
+    {
+        // rainbow.audio.set_memory_budget(megabytes)
+        rainbow::lua::Argument<lua_Number>::is_required(L, 1);
+
+        const lua_Number megabytes = lua_tonumber(L, 1);
+        LUA_ASSERT(L, megabytes >= 0, "Budget cannot be negative");
+        rainbow::audio::set_memory_budget(megabytes * 1e6);
+        return 0;
+    }
+
     int release(lua_State* L)
     {
         // rainbow.audio.release(<sound>)
@@ -63,6 +110,21 @@ namespace
         return 0;
     }
 
+    int set_priority(lua_State* L)
+    {
+        // rainbow.audio.set_priority(<sound>, priority)
+        rainbow::lua::Argument<Sound>::is_required(L, 1);
+        rainbow::lua::Argument<lua_Number>::is_required(L, 2);
+
+        const int priority = lua_tointeger(L, 2);
+        lua_settop(L, 1);
+
+        auto sound = tosound(L);
+        if (sound != nullptr)
+            rainbow::audio::set_priority(sound, priority);
+        return 0;
+    }
+
     int is_paused(lua_State* L)
     {
         // rainbow.audio.is_paused(<channel>)
@@ -204,11 +266,15 @@ NS_RAINBOW_LUA_MODULE_BEGIN(audio)
     void init(lua_State* L)
     {
         lua_pushliteral(L, "audio");
-        lua_createtable(L, 0, 16);
+        lua_createtable(L, 0, 18);
 
         luaR_rawsetcfunction(L, "load_sound", &load_sound);
         luaR_rawsetcfunction(L, "load_stream", &load_stream);
         luaR_rawsetcfunction(L, "release", &release);
+        luaR_rawsetcfunction(L, "set_priority", &set_priority);
+
+        luaR_rawsetcfunction(L, "memory_usage", &memory_usage);
+        luaR_rawsetcfunction(L, "set_memory_budget", &set_memory_budget);
 
         luaR_rawsetcfunction(L, "is_paused", &is_paused);
         luaR_rawsetcfunction(L, "is_playing", &is_playing);
@@ -17,11 +17,16 @@ NS_RAINBOW_LUA_BEGIN
 
     Font::Font(lua_State* L)
     {
-        // rainbow.font("path/to/fontface", font_size)
+        // rainbow.font("path/to/fontface", font_size, distance_field = false)
         Argument<char*>::is_required(L, 1);
         Argument<lua_Number>::is_required(L, 2);
+        Argument<bool>::is_optional(L, 3);
 
-        font_ = make_shared<FontAtlas>(lua_tostring(L, 1), lua_tonumber(L, 2));
+        const auto mode = lua_toboolean(L, 3)
+                              ? FontAtlas::Mode::DistanceField
+                              : FontAtlas::Mode::Bitmap;
+        font_ = make_shared<FontAtlas>(
+            lua_tostring(L, 1), lua_tonumber(L, 2), mode);
         if (!font_->is_valid())
             luaL_error(L, "rainbow.font: Failed to create font texture");
     }
@@ -6,6 +6,21 @@
 
 #include "Lua/lua_Font.h"
 
+namespace
+{
+    /// <summary>Parses (width, r, g, b, a = 255) and passes it on.</summary>
+    template <typename F>
+    void set_effect(lua_State* L, ::Label& label, F&& set)
+    {
+        const float width = lua_tonumber(L, 2);
+        const unsigned char r = lua_tointeger(L, 3);
+        const unsigned char g = lua_tointeger(L, 4);
+        const unsigned char b = lua_tointeger(L, 5);
+        const unsigned char a = rainbow::lua::optinteger(L, 6, 0xff);
+        set(label, width, Colorb(r, g, b, a));
+    }
+}
+
 NS_RAINBOW_LUA_BEGIN
 {
     template <>
@@ -20,6 +35,8 @@ NS_RAINBOW_LUA_BEGIN
         {"set_alignment",  &Label::set_alignment},
         {"set_color",      &Label::set_color},
         {"set_font",       &Label::set_font},
+        {"set_glow",       &Label::set_glow},
+        {"set_outline",    &Label::set_outline},
         {"set_position",   &Label::set_position},
         {"set_rotation",   &Label::set_rotation},
         {"set_scale",      &Label::set_scale},
@@ -104,6 +121,44 @@ NS_RAINBOW_LUA_BEGIN
             });
     }
 
+    int Label::set_glow(lua_State* L)
+    {
+        // <label>:set_glow(width, r, g, b, a = 255)
+        Argument<lua_Number>::is_required(L, 2);
+        Argument<lua_Number>::is_required(L, 3);
+        Argument<lua_Number>::is_required(L, 4);
+        Argument<lua_Number>::is_required(L, 5);
+        Argument<lua_Number>::is_optional(L, 6);
+
+        Label* self = Bind::self(L);
+        if (!self)
+            return 0;
+
+        set_effect(L, self->label_, [](::Label& label, float w, Colorb c) {
+            label.set_glow(w, c);
+        });
+        return 0;
+    }
+
+    int Label::set_outline(lua_State* L)
+    {
+        // <label>:set_outline(width, r, g, b, a = 255)
+        Argument<lua_Number>::is_required(L, 2);
+        Argument<lua_Number>::is_required(L, 3);
+        Argument<lua_Number>::is_required(L, 4);
+        Argument<lua_Number>::is_required(L, 5);
+        Argument<lua_Number>::is_optional(L, 6);
+
+        Label* self = Bind::self(L);
+        if (!self)
+            return 0;
+
+        set_effect(L, self->label_, [](::Label& label, float w, Colorb c) {
+            label.set_outline(w, c);
+        });
+        return 0;
+    }
+
     int Label::set_position(lua_State* L)
     {
         // <label>:set_position(x, y)
@@ -24,6 +24,8 @@ NS_RAINBOW_LUA_BEGIN
         static int set_alignment(lua_State*);
         static int set_color(lua_State*);
         static int set_font(lua_State*);
+        static int set_glow(lua_State*);
+        static int set_outline(lua_State*);
         static int set_position(lua_State*);
         static int set_rotation(lua_State*);
         static int set_scale(lua_State*);
@@ -0,0 +1,56 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include "Lua/lua_Profiler.h"
+
+#include "Common/Profiler.h"
+#include "Lua/LuaHelper.h"
+#include "Lua/LuaSyntax.h"
+
+using rainbow::lua::Argument;
+
+namespace
+{
+    int is_enabled(lua_State* L)
+    {
+        // rainbow.profiler.is_enabled()
+        lua_pushboolean(L, rainbow::profiler::is_enabled());
+        return 1;
+    }
+
+    int set_enabled(lua_State* L)
+    {
+        // rainbow.profiler.set_enabled(enable)
+        Argument<bool>::is_required(L, 1);
+
+        rainbow::profiler::set_enabled(lua_toboolean(L, 1));
+        return 0;
+    }
+
+    int write_trace(lua_State* L)
+    {
+        // rainbow.profiler.write_trace(path)
+        Argument<char*>::is_required(L, 1);
+
+        lua_pushboolean(
+            L, rainbow::profiler::write_chrome_trace(lua_tostring(L, 1)));
+        return 1;
+    }
+}
+
+NS_RAINBOW_LUA_MODULE_BEGIN(profiler)
+{
+    void init(lua_State* L)
+    {
+        // Initialise "rainbow.profiler" namespace
+        lua_pushliteral(L, "profiler");
+        lua_createtable(L, 0, 3);
+
+        luaR_rawsetcfunction(L, "is_enabled", &is_enabled);
+        luaR_rawsetcfunction(L, "set_enabled", &set_enabled);
+        luaR_rawsetcfunction(L, "write_trace", &write_trace);
+
+        lua_rawset(L, -3);
+    }
+} NS_RAINBOW_LUA_MODULE_END(profiler)
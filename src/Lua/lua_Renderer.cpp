@@ -54,6 +54,30 @@ namespace
                                            lua_tonumber(L, 4)});
         return 0;
     }
+
+    int set_texture_budget(lua_State* L)
+    {
+        // rainbow.renderer.set_texture_budget(megabytes)
+        Argument<lua_Number>::is_required(L, 1);
+
+        const lua_Number megabytes = lua_tonumber(L, 1);
+        LUA_ASSERT(L, megabytes >= 0, "Budget cannot be negative");
+        TextureManager::Get()->set_budget(megabytes * 1e6);
+        return 0;
+    }
+
+    int texture_memory(lua_State* L)
+    {
+        // rainbow.renderer.texture_memory()
+        const auto usage = TextureManager::Get()->memory_usage();
+        lua_createtable(L, 0, 5);
+        luaR_rawsetnumber(L, "used", usage.used);
+        luaR_rawsetnumber(L, "peak", usage.peak);
+        luaR_rawsetnumber(L, "budget", usage.budget);
+        luaR_rawsetinteger(L, "evictions", usage.evictions);
+        luaR_rawsetinteger(L, "reloads", usage.reloads);
+        return 1;
+    }
 }
 
 NS_RAINBOW_LUA_MODULE_BEGIN(renderer)
@@ -62,7 +86,7 @@ NS_RAINBOW_LUA_MODULE_BEGIN(renderer)
     {
         // Initialise "rainbow.renderer" namespace
         lua_pushliteral(L, "renderer");
-        lua_createtable(L, 0, 5);
+        lua_createtable(L, 0, 7);
 
         luaR_rawsetinteger(L, "max_texture_size", graphics::max_texture_size());
 
@@ -74,6 +98,8 @@ NS_RAINBOW_LUA_MODULE_BEGIN(renderer)
         luaR_rawsetcfunction(L, "set_clear_color", &set_clear_color);
         luaR_rawsetcfunction(L, "set_filter", &set_filter);
         luaR_rawsetcfunction(L, "set_projection", &set_projection);
+        luaR_rawsetcfunction(L, "set_texture_budget", &set_texture_budget);
+        luaR_rawsetcfunction(L, "texture_memory", &texture_memory);
 
         lua_rawset(L, -3);
 
@@ -13,6 +13,7 @@
 #include "Lua/lua_Shaders.h"
 #include "Lua/lua_Sprite.h"
 #include "Lua/lua_SpriteBatch.h"
+#include "Lua/lua_TextBatch.h"
 
 using rainbow::SceneNode;
 
@@ -71,11 +72,16 @@ NS_RAINBOW_LUA_BEGIN
         {"add_drawable",    &SceneGraph::add_drawable},
         {"add_label",       &SceneGraph::add_label},
         {"add_node",        &SceneGraph::add_node},
+        {"add_textbatch",   &SceneGraph::add_textbatch},
         {"attach_program",  &SceneGraph::attach_program},
         {"disable",         &SceneGraph::disable},
         {"enable",          &SceneGraph::enable},
         {"remove",          &SceneGraph::remove},
+        {"set_auto_merge",  &SceneGraph::set_auto_merge},
+        {"set_culling",     &SceneGraph::set_culling},
+        {"set_layer",       &SceneGraph::set_layer},
         {"set_parent",      &SceneGraph::set_parent},
+        {"set_state_sorting", &SceneGraph::set_state_sorting},
         {"set_tag",         &SceneGraph::set_tag},
         {"move",            &SceneGraph::move},
         {nullptr,           nullptr}
@@ -189,6 +195,12 @@ NS_RAINBOW_LUA_BEGIN
         return 1;
     }
 
+    int SceneGraph::add_textbatch(lua_State* L)
+    {
+        // rainbow.scenegraph:add_textbatch([node], <textbatch>)
+        return add_child<TextBatch>(L, touserdata<TextBatch>);
+    }
+
     int SceneGraph::attach_program(lua_State* L)
     {
         // rainbow.scenegraph:attach_program(node, program)
@@ -234,6 +246,36 @@ NS_RAINBOW_LUA_BEGIN
         return 0;
     }
 
+    int SceneGraph::set_auto_merge(lua_State* L)
+    {
+        // rainbow.scenegraph:set_auto_merge(node, enable)
+        Argument<SceneNode>::is_required(L, 2);
+        Argument<bool>::is_required(L, 3);
+
+        tonode(L, 2)->set_auto_merge(lua_toboolean(L, 3));
+        return 0;
+    }
+
+    int SceneGraph::set_culling(lua_State* L)
+    {
+        // rainbow.scenegraph:set_culling(node, enable)
+        Argument<SceneNode>::is_required(L, 2);
+        Argument<bool>::is_required(L, 3);
+
+        tonode(L, 2)->set_culling(lua_toboolean(L, 3));
+        return 0;
+    }
+
+    int SceneGraph::set_layer(lua_State* L)
+    {
+        // rainbow.scenegraph:set_layer(node, layer)
+        Argument<SceneNode>::is_required(L, 2);
+        Argument<lua_Number>::is_required(L, 3);
+
+        tonode(L, 2)->set_layer(lua_tointeger(L, 3));
+        return 0;
+    }
+
     int SceneGraph::set_parent(lua_State* L)
     {
         // rainbow.scenegraph:set_parent(parent, child)
@@ -244,6 +286,16 @@ NS_RAINBOW_LUA_BEGIN
         return 0;
     }
 
+    int SceneGraph::set_state_sorting(lua_State* L)
+    {
+        // rainbow.scenegraph:set_state_sorting(node, enable)
+        Argument<SceneNode>::is_required(L, 2);
+        Argument<bool>::is_required(L, 3);
+
+        tonode(L, 2)->set_state_sorting(lua_toboolean(L, 3));
+        return 0;
+    }
+
     int SceneGraph::set_tag(lua_State* L)
     {
         // rainbow.scenegraph:set_tag(node, tag)
@@ -29,11 +29,16 @@ NS_RAINBOW_LUA_BEGIN
         static int add_drawable(lua_State*);
         static int add_label(lua_State*);
         static int add_node(lua_State*);
+        static int add_textbatch(lua_State*);
         static int attach_program(lua_State*);
         static int disable(lua_State*);
         static int enable(lua_State*);
         static int remove(lua_State*);
+        static int set_auto_merge(lua_State*);
+        static int set_culling(lua_State*);
+        static int set_layer(lua_State*);
         static int set_parent(lua_State*);
+        static int set_state_sorting(lua_State*);
         static int set_tag(lua_State*);
         static int move(lua_State*);
 
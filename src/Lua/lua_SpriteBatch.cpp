@@ -19,6 +19,7 @@ NS_RAINBOW_LUA_BEGIN
     const luaL_Reg SpriteBatch::Bind::functions[] = {
         {"add",            &SpriteBatch::add},
         {"create_sprite",  &SpriteBatch::create_sprite},
+        {"set_instanced",  &SpriteBatch::set_instanced},
         {"set_normal",     &SpriteBatch::set_normal},
         {"set_texture",    &SpriteBatch::set_texture},
         {nullptr,          nullptr}};
@@ -71,6 +72,19 @@ NS_RAINBOW_LUA_BEGIN
         return alloc<Sprite>(L);
     }
 
+    int SpriteBatch::set_instanced(lua_State* L)
+    {
+        // <spritebatch>:set_instanced(enable)
+        Argument<bool>::is_required(L, 2);
+
+        SpriteBatch* self = Bind::self(L);
+        if (!self)
+            return 0;
+
+        self->batch_.set_instanced(lua_toboolean(L, 2));
+        return 0;
+    }
+
     int SpriteBatch::set_normal(lua_State* L)
     {
         // <spritebatch>:set_normal(<texture>)
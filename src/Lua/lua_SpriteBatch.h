@@ -22,6 +22,7 @@ NS_RAINBOW_LUA_BEGIN
     private:
         static int add(lua_State*);
         static int create_sprite(lua_State*);
+        static int set_instanced(lua_State*);
         static int set_normal(lua_State*);
         static int set_texture(lua_State*);
 
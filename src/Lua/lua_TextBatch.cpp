@@ -0,0 +1,48 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include "Lua/lua_TextBatch.h"
+
+#include "Lua/lua_Font.h"
+#include "Lua/lua_Label.h"
+
+NS_RAINBOW_LUA_BEGIN
+{
+    template <>
+    const char TextBatch::Bind::class_name[] = "textbatch";
+
+    template <>
+    const bool TextBatch::Bind::is_constructible = true;
+
+    template <>
+    const luaL_Reg TextBatch::Bind::functions[] = {
+        {"add",     &TextBatch::add},
+        {"remove",  &TextBatch::remove},
+        {nullptr,   nullptr}};
+
+    TextBatch::TextBatch(lua_State* L)
+    {
+        // rainbow.textbatch(<font>)
+        Argument<Font>::is_required(L, 1);
+
+        replacetable(L, 1);
+        batch_ = std::make_unique<::TextBatch>(touserdata<Font>(L, 1)->get());
+    }
+
+    int TextBatch::add(lua_State* L)
+    {
+        // <textbatch>:add(<label>)
+        return set1ud<Label>(
+            L,
+            [](::TextBatch* batch, ::Label* label) { batch->add(*label); });
+    }
+
+    int TextBatch::remove(lua_State* L)
+    {
+        // <textbatch>:remove(<label>)
+        return set1ud<Label>(
+            L,
+            [](::TextBatch* batch, ::Label* label) { batch->remove(*label); });
+    }
+} NS_RAINBOW_LUA_END
@@ -0,0 +1,41 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef LUA_TEXTBATCH_H_
+#define LUA_TEXTBATCH_H_
+
+#include <memory>
+#include <utility>
+
+#include "Graphics/TextBatch.h"
+#include "Lua/LuaBind.h"
+
+NS_RAINBOW_LUA_BEGIN
+{
+    class TextBatch : public Bind<TextBatch>
+    {
+        friend Bind;
+
+    public:
+        TextBatch(lua_State* L);
+
+#ifdef RAINBOW_TEST
+        TextBatch(std::unique_ptr<::TextBatch> batch,
+                  const rainbow::ISolemnlySwearThatIAmOnlyTesting&)
+            : batch_(std::move(batch))
+        {
+        }
+#endif
+
+        ::TextBatch* get() const { return batch_.get(); }
+
+    private:
+        static int add(lua_State*);
+        static int remove(lua_State*);
+
+        std::unique_ptr<::TextBatch> batch_;
+    };
+} NS_RAINBOW_LUA_END
+
+#endif
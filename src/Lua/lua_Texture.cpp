@@ -8,6 +8,12 @@
 
 #include "FileSystem/Path.h"
 
+namespace
+{
+    const char kErrorHandlingTextureLoaded[] =
+        "An error occurred while handling a texture load event";
+}
+
 NS_RAINBOW_LUA_BEGIN
 {
     template <>
@@ -18,18 +24,46 @@ NS_RAINBOW_LUA_BEGIN
 
     template <>
     const luaL_Reg Texture::Bind::functions[]{
-        {"create",  &Texture::create},
-        {"trim",    &Texture::trim},
-        {nullptr,   nullptr}};
+        {"create",    &Texture::create},
+        {"is_ready",  &Texture::is_ready},
+        {"trim",      &Texture::trim},
+        {nullptr,     nullptr}};
 
-    Texture::Texture(lua_State* L)
+    Texture::Texture(lua_State* L) : state_(L), on_ready_(LUA_NOREF)
     {
-        // rainbow.texture("/path/to/texture")
+        // rainbow.texture("/path/to/texture", on_ready = nil)
         Argument<char*>::is_required(L, 1);
+        Argument<lua_CFunction>::is_optional(L, 2);
 
-        texture_ = make_shared<TextureAtlas>(lua_tostring(L, 1));
-        if (!texture_->is_valid())
-            luaL_error(L, "rainbow.texture: Failed to create texture");
+        if (!lua_isfunction(L, 2))
+        {
+            texture_ = make_shared<TextureAtlas>(lua_tostring(L, 1));
+            if (!texture_->is_valid())
+                luaL_error(L, "rainbow.texture: Failed to create texture");
+            return;
+        }
+
+        lua_pushvalue(L, 2);
+        on_ready_ = luaL_ref(L, LUA_REGISTRYINDEX);
+        texture_ = make_shared<TextureAtlas>(
+            lua_tostring(L, 1), 1.0f, [this](TextureAtlas& atlas) {
+                const int ref = on_ready_;
+                on_ready_ = LUA_NOREF;
+                lua_rawgeti(state_, LUA_REGISTRYINDEX, ref);
+                luaL_unref(state_, LUA_REGISTRYINDEX, ref);
+                lua_pushboolean(state_, static_cast<bool>(atlas.is_valid()));
+                call(state_, 1, 0, 0, kErrorHandlingTextureLoaded);
+            });
+    }
+
+    Texture::~Texture()
+    {
+        // The atlas may outlive this object, e.g. in a sprite batch.
+        if (on_ready_ != LUA_NOREF)
+        {
+            texture_->set_callback(nullptr);
+            luaL_unref(state_, LUA_REGISTRYINDEX, on_ready_);
+        }
     }
 
     SharedPtr<TextureAtlas> Texture::get() const { return texture_; }
@@ -54,6 +88,17 @@ NS_RAINBOW_LUA_BEGIN
         return 1;
     }
 
+    int Texture::is_ready(lua_State* L)
+    {
+        // <texture>:is_ready()
+        Texture* self = Bind::self(L);
+        if (!self)
+            return 0;
+
+        lua_pushboolean(L, self->texture_->is_ready());
+        return 1;
+    }
+
     int Texture::trim(lua_State* L)
     {
         Texture* self = Bind::self(L);
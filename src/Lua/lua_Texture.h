@@ -16,14 +16,18 @@ NS_RAINBOW_LUA_BEGIN
 
     public:
         Texture(lua_State*);
+        ~Texture();
 
         SharedPtr<TextureAtlas> get() const;
 
     private:
         static int create(lua_State*);
+        static int is_ready(lua_State*);
         static int trim(lua_State*);
 
         SharedPtr<TextureAtlas> texture_;
+        lua_State* state_;
+        int on_ready_;  ///< Reference to the load callback.
     };
 } NS_RAINBOW_LUA_END
 
@@ -5,6 +5,9 @@
 #ifndef MATH_GEOMETRY_H_
 #define MATH_GEOMETRY_H_
 
+#include <algorithm>
+#include <limits>
+
 #include "Math/Vec2.h"
 
 namespace rainbow
@@ -43,6 +46,26 @@ namespace rainbow
 
     struct Rect
     {
+        /// <summary>
+        ///   Returns a rectangle that contains everything, e.g. the bounds of
+        ///   something that can be drawn anywhere.
+        /// </summary>
+        static Rect infinite()
+        {
+            constexpr float inf = std::numeric_limits<float>::infinity();
+            return Rect{-inf, -inf, inf, inf};
+        }
+
+        /// <summary>
+        ///   Returns a rectangle that contains nothing. Extending it with a
+        ///   point yields a rectangle containing only that point.
+        /// </summary>
+        static Rect none()
+        {
+            constexpr float inf = std::numeric_limits<float>::infinity();
+            return Rect{inf, inf, -inf, -inf};
+        }
+
         float left;
         float bottom;
         float right;
@@ -57,6 +80,41 @@ namespace rainbow
         auto top_left() const { return Vec2f{left, top}; }
         auto top_right() const { return Vec2f{right, top}; }
 
+        /// <summary>Returns whether this rectangle contains nothing.</summary>
+        bool is_empty() const { return left > right || bottom > top; }
+
+        /// <summary>
+        ///   Returns whether this rectangle and <paramref name="r"/> overlap.
+        ///   Touching edges count as overlapping.
+        /// </summary>
+        bool intersects(const Rect& r) const
+        {
+            return left <= r.right && r.left <= right && bottom <= r.top &&
+                   r.bottom <= top;
+        }
+
+        /// <summary>
+        ///   Grows this rectangle to contain <paramref name="p"/>.
+        /// </summary>
+        void extend(const Vec2f& p)
+        {
+            left = std::min(left, p.x);
+            bottom = std::min(bottom, p.y);
+            right = std::max(right, p.x);
+            top = std::max(top, p.y);
+        }
+
+        /// <summary>
+        ///   Grows this rectangle to contain <paramref name="r"/>.
+        /// </summary>
+        void extend(const Rect& r)
+        {
+            left = std::min(left, r.left);
+            bottom = std::min(bottom, r.bottom);
+            right = std::max(right, r.right);
+            top = std::max(top, r.top);
+        }
+
         friend bool operator!=(const Rect& r, const Rect& s)
         {
             return !(r == s);
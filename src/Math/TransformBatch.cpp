@@ -0,0 +1,445 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include "Math/TransformBatch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Platform/Macros.h"
+
+#if defined(RAINBOW_SIMD_SSE2)
+#   include <emmintrin.h>
+#elif defined(RAINBOW_SIMD_NEON)
+#   include <arm_neon.h>
+#endif
+
+using rainbow::TransformBatch;
+
+namespace
+{
+#if defined(RAINBOW_SIMD_SSE2) || defined(RAINBOW_SIMD_NEON)
+    constexpr size_t kLanes = 4;
+
+#   if defined(RAINBOW_SIMD_SSE2)
+    using float4 = __m128;
+    using int4 = __m128i;
+
+    float4 load(const float* p) { return _mm_loadu_ps(p); }
+    void store(float* p, float4 v) { _mm_storeu_ps(p, v); }
+    float4 splat(float f) { return _mm_set1_ps(f); }
+    float4 add(float4 a, float4 b) { return _mm_add_ps(a, b); }
+    float4 sub(float4 a, float4 b) { return _mm_sub_ps(a, b); }
+    float4 mul(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+    float4 abs(float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+    float4 to_float(int4 a) { return _mm_cvtepi32_ps(a); }
+
+    /// <summary>Picks <paramref name="a"/> where mask is set, else b.</summary>
+    float4 select(int4 mask, float4 a, float4 b)
+    {
+        const float4 m = _mm_castsi128_ps(mask);
+        return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+    }
+
+    float4 xor_sign(float4 a, int4 sign)
+    {
+        return _mm_xor_ps(a, _mm_castsi128_ps(sign));
+    }
+
+    int4 isplat(int i) { return _mm_set1_epi32(i); }
+    int4 iadd(int4 a, int4 b) { return _mm_add_epi32(a, b); }
+    int4 isub(int4 a, int4 b) { return _mm_sub_epi32(a, b); }
+    int4 iand(int4 a, int4 b) { return _mm_and_si128(a, b); }
+    int4 iandnot(int4 a, int4 b) { return _mm_andnot_si128(a, b); }
+    int4 ixor(int4 a, int4 b) { return _mm_xor_si128(a, b); }
+    int4 ishl29(int4 a) { return _mm_slli_epi32(a, 29); }
+    int4 iszero(int4 a) { return _mm_cmpeq_epi32(a, _mm_setzero_si128()); }
+    int4 to_int(float4 a) { return _mm_cvttps_epi32(a); }
+
+    int4 sign_of(float4 a)
+    {
+        return _mm_castps_si128(_mm_and_ps(a, _mm_set1_ps(-0.0f)));
+    }
+#   else
+    using float4 = float32x4_t;
+    using int4 = int32x4_t;
+
+    float4 load(const float* p) { return vld1q_f32(p); }
+    void store(float* p, float4 v) { vst1q_f32(p, v); }
+    float4 splat(float f) { return vdupq_n_f32(f); }
+    float4 add(float4 a, float4 b) { return vaddq_f32(a, b); }
+    float4 sub(float4 a, float4 b) { return vsubq_f32(a, b); }
+    float4 mul(float4 a, float4 b) { return vmulq_f32(a, b); }
+    float4 abs(float4 a) { return vabsq_f32(a); }
+    float4 to_float(int4 a) { return vcvtq_f32_s32(a); }
+
+    /// <summary>Picks <paramref name="a"/> where mask is set, else b.</summary>
+    float4 select(int4 mask, float4 a, float4 b)
+    {
+        return vbslq_f32(vreinterpretq_u32_s32(mask), a, b);
+    }
+
+    float4 xor_sign(float4 a, int4 sign)
+    {
+        return vreinterpretq_f32_s32(veorq_s32(vreinterpretq_s32_f32(a), sign));
+    }
+
+    int4 isplat(int i) { return vdupq_n_s32(i); }
+    int4 iadd(int4 a, int4 b) { return vaddq_s32(a, b); }
+    int4 isub(int4 a, int4 b) { return vsubq_s32(a, b); }
+    int4 iand(int4 a, int4 b) { return vandq_s32(a, b); }
+    int4 iandnot(int4 a, int4 b) { return vbicq_s32(b, a); }
+    int4 ixor(int4 a, int4 b) { return veorq_s32(a, b); }
+    int4 ishl29(int4 a) { return vshlq_n_s32(a, 29); }
+    int4 to_int(float4 a) { return vcvtq_s32_f32(a); }
+
+    int4 iszero(int4 a)
+    {
+        return vreinterpretq_s32_u32(vceqq_s32(a, vdupq_n_s32(0)));
+    }
+
+    int4 sign_of(float4 a)
+    {
+        return vreinterpretq_s32_u32(vandq_u32(vreinterpretq_u32_f32(a),
+                                               vdupq_n_u32(0x80000000u)));
+    }
+#   endif
+
+    /// <summary>
+    ///   Largest angle, in radians, that <see cref="sincos"/> handles
+    ///   accurately.
+    /// </summary>
+    constexpr float kMaxSinCosAngle = 8192.0f;
+
+    /// <summary>
+    ///   Computes sine and cosine of four angles at once. Uses the range
+    ///   reduction and minimax polynomials from Cephes' sinf/cosf, which are
+    ///   accurate to a couple of ulps for angles below
+    ///   <see cref="kMaxSinCosAngle"/>.
+    /// </summary>
+    void sincos(float4 x, float4& out_sin, float4& out_cos)
+    {
+        constexpr float kFourOverPi = 1.27323954473516f;
+        constexpr float kPiOver4Part1 = 0.78515625f;
+        constexpr float kPiOver4Part2 = 2.4187564849853515625e-4f;
+        constexpr float kPiOver4Part3 = 3.77489497744594108e-8f;
+
+        int4 sign_sin = sign_of(x);
+        x = abs(x);
+
+        // Find the octant, rounded up to an even number.
+        int4 j = to_int(mul(x, splat(kFourOverPi)));
+        j = iand(iadd(j, isplat(1)), isplat(~1));
+        const float4 y = to_float(j);
+
+        const int4 use_sin_poly = iszero(iand(j, isplat(2)));
+        sign_sin = ixor(sign_sin, ishl29(iand(j, isplat(4))));
+        const int4 sign_cos = ishl29(iandnot(isub(j, isplat(2)), isplat(4)));
+
+        // Extended precision modular arithmetic: x = x - y * pi/4
+        x = sub(x, mul(y, splat(kPiOver4Part1)));
+        x = sub(x, mul(y, splat(kPiOver4Part2)));
+        x = sub(x, mul(y, splat(kPiOver4Part3)));
+        const float4 z = mul(x, x);
+
+        float4 c = splat(2.443315711809948e-5f);
+        c = add(mul(c, z), splat(-1.388731625493765e-3f));
+        c = add(mul(c, z), splat(4.166664568298827e-2f));
+        c = mul(mul(c, z), z);
+        c = sub(c, mul(z, splat(0.5f)));
+        c = add(c, splat(1.0f));
+
+        float4 s = splat(-1.9515295891e-4f);
+        s = add(mul(s, z), splat(8.3321608736e-3f));
+        s = add(mul(s, z), splat(-1.6666654611e-1f));
+        s = mul(s, mul(z, x));
+        s = add(s, x);
+
+        out_sin = xor_sign(select(use_sin_poly, s, c), sign_sin);
+        out_cos = xor_sign(select(use_sin_poly, c, s), sign_cos);
+    }
+
+    /// <summary>
+    ///   Reduces angles too large for <see cref="sincos"/> to within a full
+    ///   turn. Returns <paramref name="angle"/> if none are.
+    /// </summary>
+    const float* reduce_angles(const float* angle, float (&reduced)[kLanes])
+    {
+        if (std::none_of(angle, angle + kLanes, [](float r) {
+                return std::abs(r) >= kMaxSinCosAngle;
+            }))
+        {
+            return angle;
+        }
+
+        // fmod is exact, but 2π is not representable as a float. Use doubles
+        // so that the error does not grow with the number of turns.
+        constexpr double kTwoPi = 6.283185307179586476925;
+        for (size_t i = 0; i < kLanes; ++i)
+            reduced[i] = static_cast<float>(std::fmod(angle[i], kTwoPi));
+        return reduced;
+    }
+
+    void transform_lanes(const float* x,
+                         const float* y,
+                         const float* angle,
+                         const float* scale_x,
+                         const float* scale_y,
+                         const float* left,
+                         const float* bottom,
+                         const float* width,
+                         const float* height,
+                         float (&out_x)[4][kLanes],
+                         float (&out_y)[4][kLanes])
+    {
+        float reduced[kLanes];
+        float4 sin_r, cos_r;
+        sincos(sub(splat(0.0f), load(reduce_angles(angle, reduced))),
+               sin_r,
+               cos_r);
+
+        const float4 sx = load(scale_x);
+        const float4 sy = load(scale_y);
+        const float4 s_sin_x = mul(sx, sin_r);
+        const float4 s_sin_y = mul(sy, sin_r);
+        const float4 s_cos_x = mul(sx, cos_r);
+        const float4 s_cos_y = mul(sy, cos_r);
+
+        const float4 px = load(x);
+        const float4 py = load(y);
+        const float4 l = load(left);
+        const float4 b = load(bottom);
+        const float4 r = add(l, load(width));
+        const float4 t = add(b, load(height));
+
+        const float4 corners[4][2]{{l, b}, {r, b}, {r, t}, {l, t}};
+        for (size_t i = 0; i < 4; ++i)
+        {
+            const float4 qx = corners[i][0];
+            const float4 qy = corners[i][1];
+            store(out_x[i],
+                  add(sub(mul(s_cos_x, qx), mul(s_sin_y, qy)), px));
+            store(out_y[i],
+                  add(add(mul(s_sin_x, qx), mul(s_cos_y, qy)), py));
+        }
+    }
+#else
+    constexpr size_t kLanes = 1;
+
+    void transform_lanes(const float* x,
+                         const float* y,
+                         const float* angle,
+                         const float* scale_x,
+                         const float* scale_y,
+                         const float* left,
+                         const float* bottom,
+                         const float* width,
+                         const float* height,
+                         float (&out_x)[4][kLanes],
+                         float (&out_y)[4][kLanes])
+    {
+        const float sin_r = std::sin(-*angle);
+        const float cos_r = std::cos(-*angle);
+        const float s_sin_x = *scale_x * sin_r;
+        const float s_sin_y = *scale_y * sin_r;
+        const float s_cos_x = *scale_x * cos_r;
+        const float s_cos_y = *scale_y * cos_r;
+
+        const float l = *left;
+        const float b = *bottom;
+        const float r = l + *width;
+        const float t = b + *height;
+
+        const float corners[4][2]{{l, b}, {r, b}, {r, t}, {l, t}};
+        for (size_t i = 0; i < 4; ++i)
+        {
+            const float qx = corners[i][0];
+            const float qy = corners[i][1];
+            out_x[i][0] = s_cos_x * qx - s_sin_y * qy + *x;
+            out_y[i][0] = s_sin_x * qx + s_cos_y * qy + *y;
+        }
+    }
+#endif
+
+    /// <summary>
+    ///   Writes the positions of the first <paramref name="lanes"/> quads
+    ///   transformed by <see cref="transform_lanes"/>.
+    /// </summary>
+    template <typename F>
+    void scatter(const float (&out_x)[4][kLanes],
+                 const float (&out_y)[4][kLanes],
+                 size_t lanes,
+                 size_t stride,
+                 F&& target_of)
+    {
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            auto target = reinterpret_cast<char*>(target_of(lane));
+            for (size_t v = 0; v < 4; ++v, target += stride)
+            {
+                auto position = reinterpret_cast<Vec2f*>(target);
+                position->x = out_x[v][lane];
+                position->y = out_y[v][lane];
+            }
+        }
+    }
+}
+
+void TransformBatch::clear()
+{
+    x_.clear();
+    y_.clear();
+    angle_.clear();
+    scale_x_.clear();
+    scale_y_.clear();
+    left_.clear();
+    bottom_.clear();
+    width_.clear();
+    height_.clear();
+    targets_.clear();
+}
+
+void TransformBatch::apply(size_t stride)
+{
+    const size_t count = targets_.size();
+
+    // Pad with identity transforms so that every lane reads valid data.
+    const size_t padded = (count + kLanes - 1) / kLanes * kLanes;
+    x_.resize(padded, 0.0f);
+    y_.resize(padded, 0.0f);
+    angle_.resize(padded, 0.0f);
+    scale_x_.resize(padded, 1.0f);
+    scale_y_.resize(padded, 1.0f);
+    left_.resize(padded, 0.0f);
+    bottom_.resize(padded, 0.0f);
+    width_.resize(padded, 0.0f);
+    height_.resize(padded, 0.0f);
+
+    float out_x[4][kLanes];
+    float out_y[4][kLanes];
+    for (size_t i = 0; i < count; i += kLanes)
+    {
+        transform_lanes(x_.data() + i,
+                        y_.data() + i,
+                        angle_.data() + i,
+                        scale_x_.data() + i,
+                        scale_y_.data() + i,
+                        left_.data() + i,
+                        bottom_.data() + i,
+                        width_.data() + i,
+                        height_.data() + i,
+                        out_x,
+                        out_y);
+
+        scatter(out_x,
+                out_y,
+                std::min(kLanes, count - i),
+                stride,
+                [this, i](size_t lane) { return targets_[i + lane]; });
+    }
+
+    clear();
+}
+
+void TransformBatch::push(const Vec2f& origin,
+                          const Vec2f& size,
+                          const Vec2f& position,
+                          float angle,
+                          const Vec2f& scale,
+                          Vec2f* target)
+{
+    x_.push_back(position.x);
+    y_.push_back(position.y);
+    angle_.push_back(angle);
+    scale_x_.push_back(scale.x);
+    scale_y_.push_back(scale.y);
+    left_.push_back(origin.x);
+    bottom_.push_back(origin.y);
+    width_.push_back(size.x);
+    height_.push_back(size.y);
+    targets_.push_back(target);
+}
+
+void TransformBatch::reserve(size_t n)
+{
+    // Leave room for padding in apply().
+    n += 3;
+    x_.reserve(n);
+    y_.reserve(n);
+    angle_.reserve(n);
+    scale_x_.reserve(n);
+    scale_y_.reserve(n);
+    left_.reserve(n);
+    bottom_.reserve(n);
+    width_.reserve(n);
+    height_.reserve(n);
+    targets_.reserve(n);
+}
+
+void rainbow::transform_quads(const Vec2f* position,
+                              const float* angle,
+                              const Vec2f* scale,
+                              const Vec2f* pivot,
+                              const Vec2f* size,
+                              size_t count,
+                              Vec2f* target,
+                              size_t stride)
+{
+    // Lanes past the end of the last, partial group keep whatever they held
+    // before. Their results are never written.
+    float x[kLanes]{};
+    float y[kLanes]{};
+    float scale_x[kLanes]{};
+    float scale_y[kLanes]{};
+    float left[kLanes]{};
+    float bottom[kLanes]{};
+    float width[kLanes]{};
+    float height[kLanes]{};
+    float padded_angle[kLanes]{};
+
+    float out_x[4][kLanes];
+    float out_y[4][kLanes];
+    for (size_t i = 0; i < count; i += kLanes)
+    {
+        const size_t lanes = std::min(kLanes, count - i);
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            const size_t j = i + lane;
+            x[lane] = position[j].x;
+            y[lane] = position[j].y;
+            scale_x[lane] = scale[j].x;
+            scale_y[lane] = scale[j].y;
+            width[lane] = size[j].x;
+            height[lane] = size[j].y;
+            left[lane] = size[j].x * -pivot[j].x;
+            bottom[lane] = size[j].y * -(1 - pivot[j].y);
+        }
+
+        // Angles are already laid out as the kernel wants them, except in
+        // the last, partial group.
+        const float* angles = angle + i;
+        if (lanes < kLanes)
+        {
+            std::copy_n(angles, lanes, padded_angle);
+            angles = padded_angle;
+        }
+
+        transform_lanes(x,
+                        y,
+                        angles,
+                        scale_x,
+                        scale_y,
+                        left,
+                        bottom,
+                        width,
+                        height,
+                        out_x,
+                        out_y);
+
+        auto quads = reinterpret_cast<char*>(target) + i * 4 * stride;
+        scatter(out_x, out_y, lanes, stride, [quads, stride](size_t lane) {
+            return reinterpret_cast<Vec2f*>(quads + lane * 4 * stride);
+        });
+    }
+}
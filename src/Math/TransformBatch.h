@@ -0,0 +1,99 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef MATH_TRANSFORMBATCH_H_
+#define MATH_TRANSFORMBATCH_H_
+
+#include <vector>
+
+#include "Math/Vec2.h"
+
+namespace rainbow
+{
+    /// <summary>
+    ///   Collects quad transforms in structure-of-arrays form so that they can
+    ///   be computed four at a time.
+    /// </summary>
+    /// <remarks>
+    ///   Each queued quad produces four vertex positions, in the same order as
+    ///   <see cref="rainbow::transform"/>. Uses SSE2 or NEON when available,
+    ///   and falls back to scalar code otherwise.
+    /// </remarks>
+    class TransformBatch
+    {
+    public:
+        /// <summary>Returns the number of queued quads.</summary>
+        auto size() const { return targets_.size(); }
+
+        /// <summary>Removes all queued quads.</summary>
+        void clear();
+
+        /// <summary>
+        ///   Transforms all queued quads, then clears the queue. Positions are
+        ///   written to each quad's target, <paramref name="stride"/> bytes
+        ///   apart.
+        /// </summary>
+        void apply(size_t stride);
+
+        /// <summary>
+        ///   Queues a quad of size <paramref name="size"/>, whose bottom-left
+        ///   corner is at <paramref name="origin"/> relative to its pivot.
+        /// </summary>
+        void push(const Vec2f& origin,
+                  const Vec2f& size,
+                  const Vec2f& position,
+                  float angle,
+                  const Vec2f& scale,
+                  Vec2f* target);
+
+        /// <summary>Queues a sprite-like object's quad.</summary>
+        template <typename T>
+        void push(const T& sprite, Vec2f* target)
+        {
+            const Vec2f size(sprite.width(), sprite.height());
+            push({size.x * -sprite.pivot().x,
+                  size.y * -(1 - sprite.pivot().y)},
+                 size,
+                 sprite.position(),
+                 sprite.angle(),
+                 sprite.scale(),
+                 target);
+        }
+
+        /// <summary>Reserves storage for <paramref name="n"/> quads.</summary>
+        void reserve(size_t n);
+
+    private:
+        std::vector<float> x_;
+        std::vector<float> y_;
+        std::vector<float> angle_;
+        std::vector<float> scale_x_;
+        std::vector<float> scale_y_;
+        std::vector<float> left_;
+        std::vector<float> bottom_;
+        std::vector<float> width_;
+        std::vector<float> height_;
+        std::vector<Vec2f*> targets_;
+    };
+
+    /// <summary>
+    ///   Transforms <paramref name="count"/> quads whose properties are
+    ///   already stored as a structure of arrays, without queueing them.
+    ///   Writes four positions per quad, one after the other and
+    ///   <paramref name="stride"/> bytes apart, starting at
+    ///   <paramref name="target"/>.
+    /// </summary>
+    /// <param name="pivot">Normalised pivot points.</param>
+    /// <param name="size">Unscaled sizes.</param>
+    void transform_quads(const Vec2f* position,
+                         const float* angle,
+                         const Vec2f* scale,
+                         const Vec2f* pivot,
+                         const Vec2f* size,
+                         size_t count,
+                         Vec2f* target,
+                         size_t stride);
+}
+
+#endif
@@ -31,6 +31,15 @@ public:
             arena_[--count].~T();
     }
 
+    /// <summary>
+    ///   Frees the arena. Elements must already have been released.
+    /// </summary>
+    void reset()
+    {
+        operator delete(arena_);
+        arena_ = nullptr;
+    }
+
     /// <summary>
     ///   Resizes arena to hold <paramref name="new_count"/> elements and moves
     ///   <paramref name="old_count"/> elements over.
@@ -36,6 +36,14 @@
 #   define RAINBOW_SDL
 #endif
 
+// SIMD instruction sets that can be assumed at compile time.
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define RAINBOW_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#   define RAINBOW_SIMD_NEON
+#endif
+
 #define RAINBOW_BUILD \
     "Rainbow / Bifrost Entertainment Property / Built " __DATE__
 
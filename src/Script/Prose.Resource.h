@@ -20,7 +20,7 @@ Prose::Asset create_font(lua_State* L, rainbow::ScopeStack& stack)
         LOGE(kProseFailedOpening, path);
         return no_asset();
     }
-    auto font = stack.allocate<FontAtlas>(data, pt);
+    auto font = stack.allocate<FontAtlas>(path, data, pt);
     if (!font->is_valid())
     {
         LOGE(kProseFailedLoading, "font", path);
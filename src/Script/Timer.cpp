@@ -4,6 +4,8 @@
 
 #include "Script/Timer.h"
 
+#include "Common/Profiler.h"
+
 void TimerManager::clear_timer(Timer* t) { free_ = t->clear(free_); }
 
 Timer* TimerManager::set_timer(Timer::Closure func,
@@ -28,6 +30,8 @@ Timer* TimerManager::set_timer(Timer::Closure func,
 
 void TimerManager::update(unsigned long dt)
 {
+    R_PROFILE_ZONE("TimerManager::update");
+
     const size_t count = timers_.size();
     for (size_t i = 0; i < count; ++i)
         timers_[i].update(dt);
@@ -0,0 +1,145 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+// Headless audio benchmark. Disabled by default; run it with
+//
+//   rainbow --test --gtest_filter=AudioBenchmark.*
+//                  --gtest_also_run_disabled_tests
+//
+// from Tests/Resources, or build the 'audio_benchmark' target.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Audio/Mixer.h"
+#include "Common/Algorithm.h"
+
+using rainbow::audio::Channel;
+using rainbow::audio::Mixer;
+using rainbow::audio::Sound;
+using rainbow::audio::Statistics;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int kMaxAudioChannels = 32;
+    constexpr int kStreams = 24;
+    constexpr const char* kFixtures[]{"Silence.ogg"};
+
+    constexpr std::chrono::milliseconds kFrameTime{16};
+    constexpr std::chrono::milliseconds kRunTime{2000};
+    constexpr std::chrono::milliseconds kStallTime{250};
+
+    /// <summary>
+    ///   Makes OpenAL Soft render to its null device, so that no audio
+    ///   hardware is needed. Other implementations ignore this.
+    /// </summary>
+    /// <remarks>Must be called before OpenAL is first used.</remarks>
+    void use_null_device()
+    {
+#ifdef RAINBOW_OS_WINDOWS
+        _putenv_s("ALSOFT_DRIVERS", "null");
+#else
+        setenv("ALSOFT_DRIVERS", "null", 1);
+#endif
+    }
+
+    /// <summary>Updates the mixer at a steady frame rate.</summary>
+    void run_frames(Mixer& mixer, std::chrono::milliseconds duration)
+    {
+        const auto end = Clock::now() + duration;
+        while (Clock::now() < end)
+        {
+            mixer.process();
+            std::this_thread::sleep_for(kFrameTime);
+        }
+    }
+
+    void report(const char* phase, const Statistics& a, const Statistics& b)
+    {
+        const unsigned int updates = b.updates - a.updates;
+        const double process_time = b.process_time - a.process_time;
+        const double decode_time = b.decode_time - a.decode_time;
+        const double bytes_decoded =
+            static_cast<double>(b.bytes_decoded - a.bytes_decoded);
+        std::printf(
+            "%-8s  %6.2f ms decoding  %8.2f MB/s  %6.3f ms/update  "
+            "%3u underruns  %3d voices\n",
+            phase,
+            decode_time * 1e3,
+            decode_time > 0.0 ? bytes_decoded / decode_time * 1e-6 : 0.0,
+            updates > 0 ? process_time / updates * 1e3 : 0.0,
+            b.underruns - a.underruns,
+            b.active_voices);
+    }
+}
+
+TEST(AudioBenchmark, DISABLED_StreamsThroughFrameStall)
+{
+    use_null_device();
+
+    Mixer mixer;
+    ASSERT_TRUE(mixer.initialize(kMaxAudioChannels));
+
+    // Sounds are keyed by path, and a sound can only be streamed once at a
+    // time. Prefixing the path gives every stream its own decoder, while
+    // still reading the same file.
+    std::vector<Sound*> sounds;
+    std::vector<Channel*> channels;
+    std::string prefix;
+    for (int i = 0; i < kStreams; ++i)
+    {
+        const size_t fixture = i % rainbow::array_size(kFixtures);
+        if (fixture == 0 && i > 0)
+            prefix += "./";
+
+        auto sound = rainbow::audio::load_stream(
+            (prefix + kFixtures[fixture]).c_str());
+        ASSERT_NE(nullptr, sound);
+        sounds.push_back(sound);
+
+        auto channel = rainbow::audio::play(sound);
+        ASSERT_NE(nullptr, channel);
+        rainbow::audio::set_loop_count(channel, -1);
+        channels.push_back(channel);
+    }
+
+    std::printf("%d streams, %d ms frames, %d ms stall\n",
+                kStreams,
+                static_cast<int>(kFrameTime.count()),
+                static_cast<int>(kStallTime.count()));
+
+    const auto start = rainbow::audio::statistics();
+    run_frames(mixer, kRunTime / 2);
+    const auto before_stall = rainbow::audio::statistics();
+    report("steady", start, before_stall);
+
+    // Simulate a long frame on the game thread. Streams are refilled by
+    // the audio thread, so they should not run dry.
+    std::this_thread::sleep_for(kStallTime);
+    const auto after_stall = rainbow::audio::statistics();
+    report("stall", before_stall, after_stall);
+
+    run_frames(mixer, kRunTime / 2);
+    const auto end = rainbow::audio::statistics();
+    report("recovery", after_stall, end);
+    report("total", start, end);
+
+    for (size_t i = 0; i < channels.size(); ++i)
+    {
+        const unsigned int underruns = rainbow::audio::underruns(channels[i]);
+        if (underruns > 0)
+            std::printf("channel %2zu: %u underruns\n", i, underruns);
+    }
+
+    for (auto&& sound : sounds)
+        rainbow::audio::release(sound);
+}
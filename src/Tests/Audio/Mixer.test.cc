@@ -2,6 +2,9 @@
 // Distributed under the MIT License.
 // (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
 
+#include <chrono>
+#include <thread>
+
 #include <gtest/gtest.h>
 
 #include "Audio/Mixer.h"
@@ -19,6 +22,18 @@ namespace
     DEFINE_NOT_FN(not_paused, rainbow::audio::is_paused, Channel*);
     DEFINE_NOT_FN(not_playing, rainbow::audio::is_playing, Channel*);
 
+    /// <summary>
+    ///   Waits for the audio thread until <paramref name="pred"/> holds, or
+    ///   a second has passed.
+    /// </summary>
+    template <typename F>
+    bool wait_until(F&& pred)
+    {
+        for (int i = 0; i < 100 && !pred(); ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return pred();
+    }
+
     struct Static
     {
         Sound* load() const
@@ -142,6 +157,22 @@ TYPED_TEST(AudioTest, StopsPlaybackWhenSoundIsReleased)
     ASSERT_PRED1(not_playing, channel);
 }
 
+TYPED_TEST(AudioTest, ReportsStatistics)
+{
+    auto channel = rainbow::audio::play(this->sound_);
+    ASSERT_TRUE(wait_until([] {
+        const auto stats = rainbow::audio::statistics();
+        return stats.active_voices == 1 && stats.updates > 0 &&
+               stats.bytes_decoded > 0;
+    }));
+    ASSERT_EQ(0u, rainbow::audio::underruns(channel));
+
+    rainbow::audio::stop(channel);
+    ASSERT_TRUE(wait_until([] {
+        return rainbow::audio::statistics().active_voices == 0;
+    }));
+}
+
 TEST(AudioTest, CanPlaySingleSoundOnMultipleChannels)
 {
     Mixer mixer_;
@@ -211,3 +242,60 @@ TEST(AudioTest, CanPlaySingleSoundOnMultipleChannels)
         ASSERT_PRED1(not_playing, channel);
     }
 }
+
+#ifdef RAINBOW_AUDIO_AL
+TEST(AudioTest, DecodesSoundsOnFirstPlay)
+{
+    Mixer mixer_;
+    ASSERT_TRUE(mixer_.initialize(kMaxAudioChannels));
+    auto sound = rainbow::audio::load_sound(
+        kAudioTestFile, rainbow::audio::Decode::OnFirstPlay);
+    ASSERT_NE(nullptr, sound);
+    ASSERT_EQ(0.0, rainbow::audio::memory_usage().used);
+
+    rainbow::audio::play(sound);
+    ASSERT_TRUE(wait_until([] {
+        return rainbow::audio::memory_usage().used > 0.0;
+    }));
+
+    rainbow::audio::release(sound);
+    ASSERT_EQ(0.0, rainbow::audio::memory_usage().used);
+}
+
+TEST(AudioTest, EvictsSoundsOverBudget)
+{
+    Mixer mixer_;
+    ASSERT_TRUE(mixer_.initialize(kMaxAudioChannels));
+    auto sound = rainbow::audio::load_sound(kAudioTestFile);
+    ASSERT_TRUE(wait_until([] {
+        return rainbow::audio::memory_usage().used > 0.0;
+    }));
+
+    const double peak = rainbow::audio::memory_usage().peak;
+    rainbow::audio::set_memory_budget(1);
+    ASSERT_TRUE(wait_until([] {
+        return rainbow::audio::memory_usage().evictions == 1;
+    }));
+
+    auto usage = rainbow::audio::memory_usage();
+    ASSERT_EQ(0.0, usage.used);
+    ASSERT_EQ(peak, usage.peak);
+    ASSERT_EQ(0u, usage.reloads);
+
+    // Sounds attached to a channel cannot be evicted.
+    auto channel = rainbow::audio::play(sound);
+    rainbow::audio::pause(channel);
+    ASSERT_TRUE(wait_until([] {
+        return rainbow::audio::memory_usage().reloads == 1;
+    }));
+    ASSERT_LT(0.0, rainbow::audio::memory_usage().used);
+
+    rainbow::audio::stop(channel);
+    ASSERT_TRUE(wait_until([] {
+        return rainbow::audio::memory_usage().evictions == 2;
+    }));
+    ASSERT_EQ(0.0, rainbow::audio::memory_usage().used);
+
+    rainbow::audio::release(sound);
+}
+#endif  // RAINBOW_AUDIO_AL
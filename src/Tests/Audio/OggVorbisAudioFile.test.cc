@@ -0,0 +1,51 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Audio/Codecs/OggVorbisAudioFile.h"
+
+using rainbow::audio::OggVorbisAudioFile;
+
+namespace
+{
+    constexpr const char kAudioTestFile[] = "Silence.ogg";
+}
+
+TEST(OggVorbisAudioFileTest, SharesMappingsBetweenStreams)
+{
+    auto data = OggVorbisAudioFile::map(kAudioTestFile);
+    ASSERT_TRUE(data);
+    ASSERT_EQ(data, OggVorbisAudioFile::map(kAudioTestFile));
+
+    OggVorbisAudioFile a(data);
+    OggVorbisAudioFile b(data);
+    ASSERT_TRUE(a);
+    ASSERT_TRUE(b);
+    ASSERT_EQ(a.size(), b.size());
+
+    // Each stream reads from its own position.
+    std::vector<char> buffer_a(a.size());
+    std::vector<char> buffer_b(b.size());
+    const size_t half = a.size() / 2;
+    ASSERT_EQ(half, a.read(buffer_a.data(), half));
+    ASSERT_EQ(b.size(), b.read(buffer_b.data(), b.size()));
+    ASSERT_EQ(a.size() - half,
+              a.read(buffer_a.data() + half, a.size() - half));
+    ASSERT_EQ(buffer_a, buffer_b);
+
+    b.rewind();
+    ASSERT_EQ(half, b.read(buffer_b.data(), half));
+    ASSERT_TRUE(std::equal(buffer_b.begin(),
+                           buffer_b.begin() + half,
+                           buffer_a.begin()));
+}
+
+TEST(OggVorbisAudioFileTest, FailsToMapMissingFiles)
+{
+    ASSERT_FALSE(OggVorbisAudioFile::map("NonExistentFile.ogg"));
+}
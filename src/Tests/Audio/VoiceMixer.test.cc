@@ -0,0 +1,386 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+#include "Audio/Software/VoiceMixer.h"
+
+using rainbow::audio::VoiceMixer;
+
+namespace
+{
+    constexpr int kRate = 44100;
+    constexpr int16_t kAmplitude = 10000;
+
+    // Equal gain on both sides when panned to the centre.
+    constexpr float kCentreGain = 0.70710678f;
+
+    auto make_source(size_t frames, int channels = 1, int rate = kRate)
+    {
+        VoiceMixer::Source source;
+        source.samples.assign(frames * channels, kAmplitude);
+        source.channels = channels;
+        source.rate = rate;
+        return source;
+    }
+
+    auto render(VoiceMixer& mixer, size_t frames)
+    {
+        std::vector<int16_t> out(frames * VoiceMixer::kOutputChannels, -1);
+        mixer.render(out.data(), frames);
+        return out;
+    }
+
+    /// <summary>Mono stream of <c>kAmplitude</c>.</summary>
+    class FakeAudioFile final : public rainbow::audio::IAudioFile
+    {
+    public:
+        explicit FakeAudioFile(size_t frames) : frames_(frames), read_(0) {}
+
+        auto channels() const -> int override { return 1; }
+        auto rate() const -> int override { return kRate; }
+        void rewind() override { read_ = 0; }
+
+        auto size() const -> size_t override
+        {
+            return frames_ * sizeof(int16_t);
+        }
+
+        auto read(void* dst, size_t size) -> size_t override
+        {
+            const size_t count =
+                std::min(size / sizeof(int16_t), frames_ - read_);
+            std::fill_n(static_cast<int16_t*>(dst), count, kAmplitude);
+            read_ += count;
+            return count * sizeof(int16_t);
+        }
+
+        auto seek(long, int) -> int override { return 0; }
+        auto write(const void*, size_t) -> size_t override { return 0; }
+        operator bool() const override { return true; }
+
+    private:
+        const size_t frames_;
+        size_t read_;
+    };
+
+    auto make_stream()
+    {
+        VoiceMixer::Source source;
+        source.channels = 1;
+        source.rate = kRate;
+        source.stream = true;
+        return source;
+    }
+
+    /// <summary>
+    ///   Renders <paramref name="frames"/> frames in small buffers, decoding
+    ///   streams before each like the mixer thread does.
+    /// </summary>
+    auto render_streams(VoiceMixer& mixer, size_t frames)
+    {
+        constexpr size_t kBufferFrames = 512;
+
+        std::vector<int16_t> out;
+        std::vector<std::shared_ptr<VoiceMixer::Stream>> streams;
+        while (frames > 0)
+        {
+            mixer.streams(streams);
+            for (auto&& stream : streams)
+                mixer.decode(*stream);
+            streams.clear();
+
+            const size_t count = std::min(frames, kBufferFrames);
+            const auto buffer = render(mixer, count);
+            out.insert(out.end(), buffer.cbegin(), buffer.cend());
+            frames -= count;
+        }
+        return out;
+    }
+}
+
+TEST(VoiceMixerTest, RendersSilenceWhenIdle)
+{
+    VoiceMixer mixer(4, 4, kRate);
+    for (auto&& sample : render(mixer, 100))
+        ASSERT_EQ(0, sample);
+}
+
+TEST(VoiceMixerTest, MixesVoicesWithVolumeAndPan)
+{
+    VoiceMixer mixer(4, 4, kRate);
+    auto source = make_source(1000);
+
+    auto voice = mixer.play(&source, Vec2f::Zero);
+    auto out = render(mixer, 8);
+    for (auto&& sample : out)
+        ASSERT_NEAR(kAmplitude * kCentreGain, sample, 1);
+
+    mixer.set_volume(voice, 0.5f);
+    mixer.set_world_position(voice, Vec2f(-0.5f, 0.0f));
+    out = render(mixer, 8);
+    for (size_t i = 0; i < out.size(); i += 2)
+    {
+        ASSERT_NEAR(kAmplitude * 0.5f, out[i], 1);
+        ASSERT_EQ(0, out[i + 1]);
+    }
+
+    // Sounds are attenuated by inverse distance.
+    mixer.set_volume(voice, 1.0f);
+    mixer.set_world_position(voice, Vec2f(4.0f, 0.0f));
+    out = render(mixer, 8);
+    for (size_t i = 0; i < out.size(); i += 2)
+    {
+        ASSERT_EQ(0, out[i]);
+        ASSERT_NEAR(kAmplitude * 0.25f, out[i + 1], 1);
+    }
+
+    // Stereo sources are not positioned.
+    auto stereo = make_source(1000, 2);
+    mixer.stop(voice);
+    mixer.play(&stereo, Vec2f(4.0f, 0.0f));
+    for (auto&& sample : render(mixer, 8))
+        ASSERT_EQ(kAmplitude, sample);
+}
+
+TEST(VoiceMixerTest, SaturatesOutput)
+{
+    VoiceMixer mixer(8, 8, kRate);
+    auto source = make_source(100, 2);
+    for (int i = 0; i < 8; ++i)
+        mixer.play(&source, Vec2f::Zero);
+
+    for (auto&& sample : render(mixer, 10))
+        ASSERT_EQ(32767, sample);
+}
+
+TEST(VoiceMixerTest, ResamplesToOutputRate)
+{
+    VoiceMixer mixer(4, 4, kRate);
+    auto source = make_source(100, 1, kRate / 2);
+    source.samples[99] = 0;
+
+    auto voice = mixer.play(&source, Vec2f::Zero);
+    auto out = render(mixer, 197);
+    ASSERT_TRUE(mixer.is_playing(voice));
+    ASSERT_NEAR(kAmplitude * kCentreGain, out[0], 1);
+    ASSERT_NEAR(kAmplitude * kCentreGain, out[196], 1);
+
+    // Interpolates between the last two frames.
+    out = render(mixer, 2);
+    ASSERT_NEAR(kAmplitude * kCentreGain * 0.5f, out[0], 1);
+    ASSERT_EQ(0, out[2]);
+
+    out = render(mixer, 1);
+    ASSERT_EQ(0, out[0]);
+    ASSERT_FALSE(mixer.is_playing(voice));
+}
+
+TEST(VoiceMixerTest, LoopsVoices)
+{
+    VoiceMixer mixer(4, 4, kRate);
+    auto source = make_source(100);
+
+    auto voice = mixer.play(&source, Vec2f::Zero);
+    mixer.set_loop_count(voice, 2);
+    render(mixer, 299);
+    ASSERT_TRUE(mixer.is_playing(voice));
+    render(mixer, 1);
+    ASSERT_FALSE(mixer.is_playing(voice));
+
+    voice = mixer.play(&source, Vec2f::Zero);
+    mixer.set_loop_count(voice, -1);
+    render(mixer, 10000);
+    ASSERT_TRUE(mixer.is_playing(voice));
+}
+
+TEST(VoiceMixerTest, PausesVoices)
+{
+    VoiceMixer mixer(4, 4, kRate);
+    auto source = make_source(100);
+
+    auto voice = mixer.play(&source, Vec2f::Zero);
+    mixer.set_paused(voice, true);
+    ASSERT_TRUE(mixer.is_paused(voice));
+    for (auto&& sample : render(mixer, 1000))
+        ASSERT_EQ(0, sample);
+
+    mixer.set_paused(voice, false);
+    ASSERT_FALSE(mixer.is_paused(voice));
+    render(mixer, 99);
+    ASSERT_TRUE(mixer.is_playing(voice));
+    render(mixer, 1);
+    ASSERT_FALSE(mixer.is_playing(voice));
+}
+
+TEST(VoiceMixerTest, VirtualizesQuietVoices)
+{
+    VoiceMixer mixer(8, 2, kRate);
+    auto source = make_source(100);
+
+    VoiceMixer::Voice* voices[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        voices[i] = mixer.play(&source, Vec2f::Zero);
+        mixer.set_volume(voices[i], 0.25f * (i + 1));
+    }
+
+    auto out = render(mixer, 50);
+    ASSERT_EQ(2, mixer.audible_voices());
+    ASSERT_EQ(2, mixer.virtual_voices());
+    ASSERT_NEAR(kAmplitude * kCentreGain * 1.75f, out[0], 1);
+
+    // Inaudible voices are never mixed.
+    mixer.set_volume(voices[3], 0.0f);
+    mixer.set_volume(voices[2], 0.0f);
+    render(mixer, 1);
+    ASSERT_EQ(2, mixer.audible_voices());
+    ASSERT_EQ(2, mixer.virtual_voices());
+    mixer.set_volume(voices[1], 0.0f);
+    render(mixer, 1);
+    ASSERT_EQ(1, mixer.audible_voices());
+    ASSERT_EQ(3, mixer.virtual_voices());
+
+    // Virtual voices keep playing, and end on time.
+    render(mixer, 47);
+    for (auto&& voice : voices)
+        ASSERT_TRUE(mixer.is_playing(voice));
+    render(mixer, 1);
+    for (auto&& voice : voices)
+        ASSERT_FALSE(mixer.is_playing(voice));
+}
+
+TEST(VoiceMixerTest, StealsLeastAudibleVoices)
+{
+    VoiceMixer mixer(3, 3, kRate);
+    auto source = make_source(100);
+
+    VoiceMixer::Voice* voices[3];
+    for (auto&& voice : voices)
+        voice = mixer.play(&source, Vec2f::Zero);
+    mixer.set_volume(voices[1], 0.5f);
+
+    ASSERT_EQ(voices[1], mixer.play(&source, Vec2f::Zero));
+    ASSERT_EQ(1u, mixer.steals());
+
+    // The oldest voice is stolen when equally audible.
+    ASSERT_EQ(voices[0], mixer.play(&source, Vec2f::Zero));
+    ASSERT_EQ(2u, mixer.steals());
+}
+
+TEST(VoiceMixerTest, RejectsHandlesToReusedVoices)
+{
+    VoiceMixer mixer(1, 1, kRate);
+    auto source = make_source(100);
+
+    ASSERT_EQ(nullptr, mixer.voice_of(0));
+
+    auto voice = mixer.play(&source, Vec2f::Zero);
+    const auto handle = mixer.handle_of(voice);
+    ASSERT_NE(0u, handle);
+    ASSERT_EQ(voice, mixer.voice_of(handle));
+
+    // Stealing the voice invalidates the old handle.
+    ASSERT_EQ(voice, mixer.play(&source, Vec2f::Zero));
+    ASSERT_EQ(nullptr, mixer.voice_of(handle));
+    ASSERT_EQ(voice, mixer.voice_of(mixer.handle_of(voice)));
+
+    // So does stopping and playing it again.
+    const auto stolen = mixer.handle_of(voice);
+    mixer.stop(voice);
+    mixer.play(&source, Vec2f::Zero);
+    ASSERT_EQ(nullptr, mixer.voice_of(stolen));
+}
+
+TEST(VoiceMixerTest, LoopsSoundsShorterThanOneStep)
+{
+    VoiceMixer mixer(1, 1, kRate / 8);
+    auto source = make_source(2);
+
+    // Every output frame passes over the sound four times.
+    auto voice = mixer.play(&source, Vec2f::Zero);
+    mixer.set_loop_count(voice, 9);
+    render(mixer, 2);
+    ASSERT_TRUE(mixer.is_playing(voice));
+    render(mixer, 1);
+    ASSERT_FALSE(mixer.is_playing(voice));
+
+    voice = mixer.play(&source, Vec2f::Zero);
+    mixer.set_loop_count(voice, -1);
+    for (auto&& sample : render(mixer, 1000))
+        ASSERT_NEAR(kAmplitude * kCentreGain, sample, 1);
+    ASSERT_TRUE(mixer.is_playing(voice));
+}
+
+TEST(VoiceMixerTest, StealsVoicesByPriority)
+{
+    VoiceMixer mixer(2, 2, kRate);
+    auto important = make_source(100);
+    important.priority = 1;
+    auto source = make_source(100);
+
+    auto voice = mixer.play(&important, Vec2f::Zero);
+    mixer.set_volume(voice, 0.25f);
+    auto other = mixer.play(&source, Vec2f::Zero);
+
+    // The quieter voice is kept because of its priority.
+    ASSERT_EQ(other, mixer.play(&source, Vec2f::Zero));
+
+    // Sources of lower priority cannot steal voices.
+    auto important_too = mixer.play(&important, Vec2f::Zero);
+    ASSERT_EQ(other, important_too);
+    ASSERT_EQ(nullptr, mixer.play(&source, Vec2f::Zero));
+    ASSERT_EQ(2u, mixer.steals());
+
+    // Voices of higher priority are mixed first.
+    VoiceMixer one(2, 1, kRate);
+    auto quiet = one.play(&important, Vec2f::Zero);
+    one.set_volume(quiet, 0.5f);
+    one.play(&source, Vec2f::Zero);
+    auto out = render(one, 1);
+    ASSERT_NEAR(kAmplitude * kCentreGain * 0.5f, out[0], 1);
+}
+
+TEST(VoiceMixerTest, DecodesStreamsPerVoice)
+{
+    VoiceMixer mixer(4, 4, kRate);
+    auto source = make_stream();
+
+    // Streams are silent until they have been decoded.
+    auto a = mixer.play(
+        &source, Vec2f::Zero, std::make_unique<FakeAudioFile>(6000));
+    for (auto&& sample : render(mixer, 8))
+        ASSERT_EQ(0, sample);
+    ASSERT_TRUE(mixer.is_playing(a));
+
+    // Each voice reads its own file, so both play it in full.
+    auto b = mixer.play(
+        &source, Vec2f::Zero, std::make_unique<FakeAudioFile>(6000));
+    for (auto&& sample : render_streams(mixer, 5999))
+        ASSERT_NEAR(kAmplitude * kCentreGain * 2, sample, 2);
+    ASSERT_TRUE(mixer.is_playing(a));
+    ASSERT_TRUE(mixer.is_playing(b));
+
+    render_streams(mixer, 1);
+    ASSERT_FALSE(mixer.is_playing(a));
+    ASSERT_FALSE(mixer.is_playing(b));
+}
+
+TEST(VoiceMixerTest, LoopsStreams)
+{
+    VoiceMixer mixer(4, 4, kRate);
+    auto source = make_stream();
+
+    auto voice = mixer.play(
+        &source, Vec2f::Zero, std::make_unique<FakeAudioFile>(5000));
+    mixer.set_loop_count(voice, 1);
+    for (auto&& sample : render_streams(mixer, 9999))
+        ASSERT_NEAR(kAmplitude * kCentreGain, sample, 1);
+    ASSERT_TRUE(mixer.is_playing(voice));
+
+    render_streams(mixer, 1);
+    ASSERT_FALSE(mixer.is_playing(voice));
+}
@@ -0,0 +1,103 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include <cstring>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "Common/Profiler.h"
+
+namespace profiler = rainbow::profiler;
+
+namespace
+{
+    const char kInnerZone[] = "inner";
+    const char kOuterZone[] = "outer";
+
+    class ProfilerTest : public testing::Test
+    {
+    protected:
+        void SetUp() override { profiler::set_enabled(true); }
+        void TearDown() override { profiler::set_enabled(false); }
+    };
+}
+
+TEST(ZoneBufferTest, DropsZonesWhenFull)
+{
+    profiler::ZoneBuffer buffer(0, 4);
+    for (uint64_t i = 0; i < 6; ++i)
+        buffer.push({kOuterZone, i, i + 1, 0, 0});
+
+    ASSERT_EQ(2u, buffer.dropped());
+
+    uint64_t expected = 0;
+    buffer.drain([&expected](const profiler::Zone& zone) {
+        ASSERT_EQ(expected++, zone.begin);
+    });
+    ASSERT_EQ(4u, expected);
+
+    buffer.push({kOuterZone, 10, 11, 0, 0});
+    buffer.drain([](const profiler::Zone& zone) {
+        ASSERT_EQ(10u, zone.begin);
+    });
+}
+
+TEST_F(ProfilerTest, RecordsNestedZones)
+{
+    {
+        R_PROFILE_ZONE(kOuterZone);
+        R_PROFILE_ZONE(kInnerZone);
+    }
+    profiler::end_frame();
+
+    const auto& zones = profiler::last_frame();
+    ASSERT_EQ(2u, zones.size());
+
+    // Zones are recorded as they end.
+    ASSERT_EQ(kInnerZone, zones[0].name);
+    ASSERT_EQ(1u, zones[0].depth);
+    ASSERT_EQ(kOuterZone, zones[1].name);
+    ASSERT_EQ(0u, zones[1].depth);
+    ASSERT_LE(zones[1].begin, zones[0].begin);
+    ASSERT_GE(zones[1].end, zones[0].end);
+}
+
+TEST_F(ProfilerTest, CollectsZonesFromAllThreads)
+{
+    std::thread worker([] { R_PROFILE_ZONE(kInnerZone); });
+    worker.join();
+    {
+        R_PROFILE_ZONE(kOuterZone);
+    }
+    profiler::end_frame();
+
+    const auto& zones = profiler::last_frame();
+    ASSERT_EQ(2u, zones.size());
+    ASSERT_NE(zones[0].thread, zones[1].thread);
+}
+
+TEST_F(ProfilerTest, RecordsNothingWhileDisabled)
+{
+    profiler::set_enabled(false);
+    {
+        R_PROFILE_ZONE(kOuterZone);
+    }
+    profiler::set_enabled(true);
+    profiler::end_frame();
+
+    ASSERT_TRUE(profiler::last_frame().empty());
+}
+
+TEST_F(ProfilerTest, ExportsChromeTrace)
+{
+    profiler::record({profiler::intern("\"quoted\""), 1000, 3500, 0, 0});
+    profiler::end_frame();
+
+    const auto trace = profiler::to_chrome_trace();
+    ASSERT_EQ(0u, trace.find("{\"traceEvents\":["));
+    ASSERT_NE(std::string::npos,
+              trace.find("{\"name\":\"\\\"quoted\\\"\",\"ph\":\"X\","
+                         "\"ts\":1.000,\"dur\":2.500,\"pid\":0,\"tid\":0}"));
+}
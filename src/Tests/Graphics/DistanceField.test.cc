@@ -0,0 +1,100 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Graphics/DistanceField.h"
+
+using rainbow::graphics::make_distance_field;
+
+namespace
+{
+    constexpr unsigned int kSize = 8;
+    constexpr unsigned int kPadding = 2;
+    constexpr unsigned int kFieldSize = kSize + kPadding * 2;
+    constexpr float kSpread = 4.0f;
+
+    auto at(const std::vector<uint8_t>& field, unsigned int x, unsigned int y)
+    {
+        return field[(y + kPadding) * kFieldSize + x + kPadding];
+    }
+}
+
+TEST(DistanceFieldTest, IncreasesTowardsTheInside)
+{
+    // A 4x4 square in the middle of the bitmap.
+    uint8_t bitmap[kSize * kSize]{};
+    for (unsigned int y = 2; y < 6; ++y)
+    {
+        for (unsigned int x = 2; x < 6; ++x)
+            bitmap[y * kSize + x] = 0xff;
+    }
+
+    std::vector<uint8_t> field(kFieldSize * kFieldSize);
+    make_distance_field(
+        bitmap, Vec2u(kSize, kSize), kSize, kPadding, kSpread, field.data());
+
+    // Pixels on either side of the edge are half a pixel away from it.
+    const int inside = at(field, 2, 4);
+    const int outside = at(field, 1, 4);
+    ASSERT_GT(inside, 128);
+    ASSERT_LT(outside, 128);
+    ASSERT_NEAR(255, inside + outside, 1);
+
+    ASSERT_GT(at(field, 3, 4), inside);
+    ASSERT_LT(at(field, 0, 4), outside);
+
+    // The field is symmetric.
+    ASSERT_EQ(at(field, 2, 4), at(field, 5, 4));
+    ASSERT_EQ(at(field, 4, 2), at(field, 4, 5));
+
+    // The padding is outside, and saturates beyond the spread.
+    ASSERT_EQ(0, field.front());
+}
+
+TEST(DistanceFieldTest, PlacesEdgesByCoverage)
+{
+    // A vertical edge through column 3, which is partially covered.
+    for (int coverage : {0x40, 0x80, 0xc0})
+    {
+        uint8_t bitmap[kSize * kSize]{};
+        for (unsigned int y = 0; y < kSize; ++y)
+        {
+            for (unsigned int x = 0; x < 3; ++x)
+                bitmap[y * kSize + x] = 0xff;
+            bitmap[y * kSize + 3] = coverage;
+        }
+
+        std::vector<uint8_t> field(kFieldSize * kFieldSize);
+        make_distance_field(bitmap,
+                            Vec2u(kSize, kSize),
+                            kSize,
+                            kPadding,
+                            kSpread,
+                            field.data());
+
+        // The edge is |coverage| into column 3, from the left.
+        const double edge = 2.5 + coverage / 255.0;
+        for (unsigned int x = 2; x < 5; ++x)
+        {
+            const double expected =
+                (0.5 + (edge - x) * 0.5 / kSpread) * 255.0;
+            ASSERT_NEAR(expected, at(field, x, 4), 1.0)
+                << "coverage: " << coverage << ", x: " << x;
+        }
+    }
+}
+
+TEST(DistanceFieldTest, EmptyBitmapsAreOutside)
+{
+    const uint8_t bitmap[kSize * kSize]{};
+    std::vector<uint8_t> field(kFieldSize * kFieldSize, 0xff);
+    make_distance_field(
+        bitmap, Vec2u(kSize, kSize), kSize, kPadding, kSpread, field.data());
+
+    for (auto value : field)
+        ASSERT_EQ(0, value);
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include <gtest/gtest.h>
+
+#include "Graphics/DynamicBatch.h"
+#include "Graphics/SpriteBatch.h"
+
+namespace rainbow { struct ISolemnlySwearThatIAmOnlyTesting {}; }
+
+using rainbow::graphics::DynamicBatch;
+
+namespace
+{
+    void fill(SpriteBatch& batch, unsigned int count, float x)
+    {
+        for (unsigned int i = 0; i < count; ++i)
+            batch.create_sprite(1, 1)->set_position(Vec2f(x + i, 0.0f));
+        batch.prepare();
+    }
+}
+
+class DynamicBatchTest : public ::testing::Test
+{
+public:
+    DynamicBatchTest()
+        : a_(rainbow::ISolemnlySwearThatIAmOnlyTesting{}),
+          b_(rainbow::ISolemnlySwearThatIAmOnlyTesting{}),
+          c_(rainbow::ISolemnlySwearThatIAmOnlyTesting{}),
+          dynamic_batch_(rainbow::ISolemnlySwearThatIAmOnlyTesting{})
+    {
+        auto atlas = make_shared<TextureAtlas>(
+            rainbow::ISolemnlySwearThatIAmOnlyTesting{});
+        atlas->add_region(0, 0, 1, 1);
+        a_.set_texture(atlas);
+        b_.set_texture(atlas);
+        fill(a_, 2, 0.0f);
+        fill(b_, 3, 100.0f);
+        fill(c_, 1, 200.0f);
+    }
+
+protected:
+    SpriteBatch a_;
+    SpriteBatch b_;
+    SpriteBatch c_;
+    DynamicBatch dynamic_batch_;
+};
+
+TEST_F(DynamicBatchTest, MergesBatchesSharingTextures)
+{
+    ASSERT_TRUE(DynamicBatch::can_merge(a_, b_));
+    ASSERT_TRUE(DynamicBatch::can_merge(b_, a_));
+    ASSERT_FALSE(DynamicBatch::can_merge(a_, c_));
+}
+
+TEST_F(DynamicBatchTest, PreservesDrawOrder)
+{
+    const SpriteBatch* batches[]{&b_, &a_};
+    dynamic_batch_.assign(batches, 2);
+
+    ASSERT_EQ(2u, dynamic_batch_.size());
+    ASSERT_EQ((3u + 2u) * 6, dynamic_batch_.vertex_count());
+
+    const SpriteVertex* vertices = dynamic_batch_.vertices();
+    for (size_t i = 0; i < 3 * 4; ++i)
+        ASSERT_EQ(b_.vertices()[i].position, vertices[i].position);
+    for (size_t i = 0; i < 2 * 4; ++i)
+        ASSERT_EQ(a_.vertices()[i].position, vertices[12 + i].position);
+}
+
+TEST_F(DynamicBatchTest, SkipsInvisibleBatches)
+{
+    b_.set_visible(false);
+
+    const SpriteBatch* batches[]{&a_, &b_};
+    dynamic_batch_.assign(batches, 2);
+
+    ASSERT_EQ(2u * 6, dynamic_batch_.vertex_count());
+    for (size_t i = 0; i < 2 * 4; ++i)
+    {
+        ASSERT_EQ(a_.vertices()[i].position,
+                  dynamic_batch_.vertices()[i].position);
+    }
+}
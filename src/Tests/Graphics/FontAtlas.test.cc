@@ -0,0 +1,271 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/Data.h"
+#include "Graphics/FontAtlas.h"
+#include "Graphics/FontCache.h"
+#include "Resources/NewsCycle-Regular.ttf.h"
+#include "Threading/JobSystem.h"
+
+namespace rainbow { struct ISolemnlySwearThatIAmOnlyTesting {}; }
+
+namespace
+{
+    auto make_font(float pt)
+    {
+        return std::make_unique<FontAtlas>(
+            Data::from_bytes(NewsCycle_Regular_ttf),
+            pt,
+            rainbow::ISolemnlySwearThatIAmOnlyTesting{});
+    }
+}
+
+TEST(FontAtlasTest, RasterizesGlyphsOnFirstUse)
+{
+    auto font = make_font(12.0f);
+    ASSERT_TRUE(font->is_valid());
+    ASSERT_EQ(0u, font->glyph_count());
+    ASSERT_EQ(1u, font->page_count());
+
+    const FontGlyph* glyph = font->get_glyph('A');
+    ASSERT_NE(nullptr, glyph);
+    ASSERT_EQ(static_cast<unsigned int>('A'), glyph->code);
+    ASSERT_EQ(0u, glyph->page);
+    ASSERT_GT(glyph->advance, 0);
+    ASSERT_EQ(1u, font->glyph_count());
+
+    ASSERT_EQ(glyph, font->get_glyph('A'));
+    ASSERT_EQ(1u, font->glyph_count());
+
+    const FontGlyph* aring = font->get_glyph(0x00e5);
+    ASSERT_NE(nullptr, aring);
+    ASSERT_FALSE(glyph->quad[0].texcoord == aring->quad[0].texcoord);
+}
+
+TEST(FontAtlasTest, ShapesLinesWithPairKerning)
+{
+    auto font = make_font(24.0f);
+    const char text[] = "AVATAR";
+    const size_t length = sizeof(text) - 1;
+
+    const FontAtlas::ShapedText& shaped = font->shape(text, length);
+    ASSERT_EQ(length, shaped.size());
+    ASSERT_EQ(static_cast<uint32_t>('A'), shaped[0].code);
+    ASSERT_EQ(0, shaped[0].kerning);
+    for (size_t i = 1; i < length; ++i)
+    {
+        ASSERT_EQ(static_cast<uint32_t>(text[i]), shaped[i].code);
+        ASSERT_EQ(font->kerning(text[i - 1], text[i]), shaped[i].kerning);
+    }
+}
+
+TEST(FontAtlasTest, CachesShapedLines)
+{
+    auto font = make_font(12.0f);
+    const FontAtlas::ShapedText* shaped = &font->shape("Hello", 5);
+    ASSERT_EQ(1u, font->shaped_count());
+    ASSERT_EQ(shaped, &font->shape("Hello, world", 5));
+    ASSERT_EQ(1u, font->shaped_count());
+    ASSERT_EQ(3u, font->shape("Hello", 3).size());
+    ASSERT_EQ(2u, font->shaped_count());
+
+    for (unsigned int i = 0; i < FontAtlas::kMaxShapedLines; ++i)
+    {
+        const std::string line = std::to_string(i);
+        font->shape("Hello", 5);
+        font->shape(line.c_str(), line.size());
+        ASSERT_LE(font->shaped_count(), FontAtlas::kMaxShapedLines);
+    }
+    ASSERT_EQ(shaped, &font->shape("Hello", 5));
+}
+
+TEST(FontAtlasTest, ReturnsNullForMissingGlyphs)
+{
+    auto font = make_font(12.0f);
+    ASSERT_EQ(nullptr, font->get_glyph(0x4e00));  // CJK UNIFIED IDEOGRAPH-4E00
+    ASSERT_EQ(0u, font->glyph_count());
+}
+
+TEST(FontAtlasTest, EvictsLeastRecentlyUsedGlyphs)
+{
+    // At this size, only a few glyphs fit on each page.
+    auto font = make_font(960.0f);
+
+    const FontGlyph* retained = font->get_glyph('W');
+    ASSERT_NE(nullptr, retained);
+    font->retain(*retained);
+
+    size_t requested = 1;
+    for (unsigned int c = 'a'; c <= 'z'; ++c, ++requested)
+        ASSERT_NE(nullptr, font->get_glyph(c)) << static_cast<char>(c);
+    for (unsigned int c = 'A'; c <= 'Z'; ++c, ++requested)
+        ASSERT_NE(nullptr, font->get_glyph(c)) << static_cast<char>(c);
+
+    ASSERT_EQ(FontAtlas::kMaxPages, font->page_count());
+    ASSERT_LT(font->glyph_count(), requested);
+
+    // The retained glyph was never evicted.
+    ASSERT_EQ(retained, font->get_glyph('W'));
+    ASSERT_EQ(static_cast<unsigned int>('W'), retained->code);
+
+    font->release(*retained);
+}
+
+TEST(FontAtlasTest, SharesFacesOfSameSize)
+{
+    auto& cache = rainbow::graphics::FontCache::Get();
+    const size_t open_faces = cache.face_count();
+    {
+        auto font = make_font(12.0f);
+        auto same_size = make_font(12.0f);
+        ASSERT_EQ(open_faces + 1, cache.face_count());
+        ASSERT_EQ(font->height(), same_size->height());
+
+        auto other_size = make_font(24.0f);
+        ASSERT_EQ(open_faces + 2, cache.face_count());
+        ASSERT_LT(font->height(), other_size->height());
+    }
+    ASSERT_EQ(open_faces, cache.face_count());
+}
+
+TEST(FontAtlasTest, SharesFacesOfSameFontData)
+{
+    // A copy at a different address is still the same font.
+    const std::vector<uint8_t> copy(std::begin(NewsCycle_Regular_ttf),
+                                    std::end(NewsCycle_Regular_ttf));
+
+    auto& cache = rainbow::graphics::FontCache::Get();
+    const size_t open_faces = cache.face_count();
+    {
+        auto font = make_font(12.0f);
+        FontAtlas same_font(Data(copy.data(),
+                                 copy.size(),
+                                 Data::Ownership::Reference),
+                            12.0f,
+                            rainbow::ISolemnlySwearThatIAmOnlyTesting{});
+        ASSERT_EQ(open_faces + 1, cache.face_count());
+        ASSERT_EQ(font->height(), same_font.height());
+    }
+    ASSERT_EQ(open_faces, cache.face_count());
+}
+
+TEST(FontAtlasTest, RasterizesCommonGlyphsInBackground)
+{
+    rainbow::JobSystem jobs(1);
+
+    // Keep the only worker busy until the font has been created.
+    std::atomic<bool> blocked(true);
+    jobs.submit([&blocked] {
+        while (blocked)
+            std::this_thread::yield();
+    });
+
+    auto font = make_font(12.0f);
+    ASSERT_FALSE(font->is_ready());
+
+    const FontGlyph* placeholder = font->get_glyph('A');
+    ASSERT_NE(nullptr, placeholder);
+    ASSERT_TRUE(font->is_placeholder(*placeholder));
+    ASSERT_GT(placeholder->advance, 0);
+    font->retain(*placeholder);
+    font->release(*placeholder);
+    ASSERT_EQ(0u, font->glyph_count());
+
+    blocked = false;
+    while (!font->is_ready())
+        std::this_thread::yield();
+
+    ASSERT_LE(95u, font->glyph_count());
+    const FontGlyph* glyph = font->get_glyph('A');
+    ASSERT_FALSE(font->is_placeholder(*glyph));
+    ASSERT_EQ(static_cast<unsigned int>('A'), glyph->code);
+    ASSERT_LE(95u, font->glyph_count());
+}
+
+TEST(FontAtlasTest, ExtendsDistanceFieldGlyphsBySpread)
+{
+    auto bitmap = make_font(32.0f);
+    auto distance_field = std::make_unique<FontAtlas>(
+        Data::from_bytes(NewsCycle_Regular_ttf),
+        32.0f,
+        rainbow::ISolemnlySwearThatIAmOnlyTesting{},
+        FontAtlas::Mode::DistanceField);
+    ASSERT_EQ(FontAtlas::Mode::DistanceField, distance_field->mode());
+    ASSERT_LE(bitmap->page_size(), distance_field->page_size());
+
+    const FontGlyph* a = bitmap->get_glyph('A');
+    const FontGlyph* b = distance_field->get_glyph('A');
+    ASSERT_EQ(a->advance, b->advance);
+
+    // Quads extend beyond the glyph to make room for outlines and glows.
+    const float width = a->quad[1].position.x - a->quad[0].position.x;
+    const float df_width = b->quad[1].position.x - b->quad[0].position.x;
+    ASSERT_LT(width, df_width);
+    ASSERT_GE(b->quad[1].position.x - a->quad[1].position.x,
+              FontAtlas::kDistanceFieldSpread / 2.0f);
+}
+
+TEST(FontAtlasBenchmark, DISABLED_FirstFrameOfCJKParagraph)
+{
+    // Set RAINBOW_CJK_FONT to the path of a font covering CJK ideographs.
+    const char* path = std::getenv("RAINBOW_CJK_FONT");
+    FILE* file = path == nullptr ? nullptr : std::fopen(path, "rb");
+    if (file == nullptr)
+    {
+        printf("[ BENCHMARK] RAINBOW_CJK_FONT is not set to a readable font\n");
+        return;
+    }
+
+    std::fseek(file, 0, SEEK_END);
+    const size_t size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    auto bytes = std::make_unique<unsigned char[]>(size);
+    const size_t read = std::fread(bytes.get(), 1, size, file);
+    std::fclose(file);
+    ASSERT_EQ(size, read);
+
+    constexpr unsigned int kNumCharacters = 2000;
+    constexpr uint32_t kFirstIdeograph = 0x4e00;
+
+    const Data data(bytes.get(), size, Data::Ownership::Reference);
+    FontAtlas font(data, 16.0f, rainbow::ISolemnlySwearThatIAmOnlyTesting{});
+
+    using clock = std::chrono::steady_clock;
+    auto lay_out = [&font] {
+        unsigned int missing = 0;
+        const auto start = clock::now();
+        for (uint32_t c = kFirstIdeograph; c < kFirstIdeograph + kNumCharacters;
+             ++c)
+        {
+            if (font.get_glyph(c) == nullptr)
+                ++missing;
+        }
+        const auto end = clock::now();
+        return std::make_pair(
+            std::chrono::duration<double, std::milli>(end - start).count(),
+            missing);
+    };
+
+    const auto first = lay_out();
+    const auto second = lay_out();
+    printf("[ BENCHMARK] %u characters (%u missing), %u pages: first frame "
+           "%.3f ms, cached %.3f ms\n",
+           kNumCharacters,
+           first.second,
+           font.page_count(),
+           first.first,
+           second.first);
+}
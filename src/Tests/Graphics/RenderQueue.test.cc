@@ -0,0 +1,111 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Graphics/RenderQueue.h"
+#include "Graphics/ShaderManager.h"
+
+namespace rainbow { struct ISolemnlySwearThatIAmOnlyTesting {}; }
+
+using rainbow::graphics::BlendMode;
+using rainbow::graphics::RenderQueue;
+
+namespace
+{
+    std::vector<int> g_drawn;
+
+    const int kObjects[]{0, 1, 2, 3, 4, 5, 6, 7};
+    const int kTextures[2]{};
+    const int& kTextureA = kTextures[0];
+    const int& kTextureB = kTextures[1];
+
+    void draw(const void* object)
+    {
+        g_drawn.push_back(*static_cast<const int*>(object));
+    }
+
+    void push(RenderQueue& queue,
+              int i,
+              const void* texture,
+              int layer = 0,
+              unsigned int group = RenderQueue::kNoGroup)
+    {
+        queue.push(draw,
+                   &kObjects[i],
+                   ShaderManager::kInvalidProgram,
+                   texture,
+                   BlendMode::Alpha,
+                   layer,
+                   group);
+    }
+
+    std::vector<int> order(const RenderQueue& queue)
+    {
+        std::vector<int> objects;
+        for (auto&& command : queue)
+            objects.push_back(*static_cast<const int*>(command.object));
+        return objects;
+    }
+}
+
+TEST(RenderQueueTest, KeepsSubmissionOrderOutsideGroups)
+{
+    RenderQueue queue;
+    push(queue, 0, &kTextureA);
+    push(queue, 1, &kTextureB);
+    push(queue, 2, &kTextureA);
+    push(queue, 3, &kTextureB);
+    queue.sort();
+
+    ASSERT_EQ(std::vector<int>({0, 1, 2, 3}), order(queue));
+    ASSERT_EQ(4u, queue.batch_count());
+}
+
+TEST(RenderQueueTest, DrawsLayersInAscendingOrder)
+{
+    RenderQueue queue;
+    push(queue, 0, &kTextureA, 2);
+    push(queue, 1, &kTextureA, 0);
+    push(queue, 2, &kTextureA, -1);
+    push(queue, 3, &kTextureA, 0);
+    queue.sort();
+
+    ASSERT_EQ(std::vector<int>({2, 1, 3, 0}), order(queue));
+}
+
+TEST(RenderQueueTest, SortsByStateWithinGroups)
+{
+    RenderQueue queue;
+    push(queue, 0, &kTextureB);
+
+    const unsigned int group = queue.next_sequence();
+    push(queue, 1, &kTextureA, 0, group);
+    push(queue, 2, &kTextureB, 0, group);
+    push(queue, 3, &kTextureA, 0, group);
+    push(queue, 4, &kTextureB, 0, group);
+
+    push(queue, 5, &kTextureA);
+    queue.sort();
+
+    ASSERT_EQ(std::vector<int>({0, 1, 3, 2, 4, 5}), order(queue));
+    ASSERT_EQ(4u, queue.batch_count());
+}
+
+TEST(RenderQueueTest, FlushesInSortedOrder)
+{
+    ShaderManager shader_manager(rainbow::ISolemnlySwearThatIAmOnlyTesting{});
+    g_drawn.clear();
+
+    RenderQueue queue;
+    push(queue, 0, &kTextureA, 1);
+    push(queue, 1, &kTextureA, 0);
+    queue.sort();
+    queue.flush();
+
+    ASSERT_EQ(std::vector<int>({1, 0}), g_drawn);
+    ASSERT_EQ(0u, queue.size());
+}
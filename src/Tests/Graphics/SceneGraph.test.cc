@@ -13,19 +13,32 @@ using rainbow::SceneNode;
 
 namespace
 {
+    int g_draw_sequence = 0;
+
     class DummyNode final : public SceneNode
     {
     public:
         int draw_count() const { return draw_count_; }
+        int draw_order() const { return draw_order_; }
         int move_count() const { return move_count_; }
         int update_count() const { return update_count_; }
 
+        void set_bounds(const rainbow::Rect& bounds) { bounds_ = bounds; }
+
     private:
+        rainbow::Rect bounds_ = rainbow::Rect::infinite();
         mutable int draw_count_ = 0;
+        mutable int draw_order_ = -1;
         mutable int move_count_ = 0;
         mutable int update_count_ = 0;
 
-        void draw_impl() const override { ++draw_count_; }
+        auto bounds_impl() const -> rainbow::Rect override { return bounds_; }
+
+        void draw_impl() const override
+        {
+            ++draw_count_;
+            draw_order_ = g_draw_sequence++;
+        }
         void move_impl(const Vec2f&) const override { ++move_count_; }
 
         void update_impl(unsigned long) const override
@@ -111,6 +124,28 @@ TEST_F(SceneNodeTest, DrawsAllEnabledChildren)
     ASSERT_EQ(1, nodes_[4]->draw_count());
 }
 
+TEST_F(SceneNodeTest, DrawsLayerByLayer)
+{
+    ShaderManager shader_manager(rainbow::ISolemnlySwearThatIAmOnlyTesting{});
+    root_.draw();
+
+    // Depth-first: 0, 2, 3, 4, 1
+    ASSERT_LT(nodes_[0]->draw_order(), nodes_[2]->draw_order());
+    ASSERT_LT(nodes_[2]->draw_order(), nodes_[3]->draw_order());
+    ASSERT_LT(nodes_[3]->draw_order(), nodes_[4]->draw_order());
+    ASSERT_LT(nodes_[4]->draw_order(), nodes_[1]->draw_order());
+
+    nodes_[0]->set_layer(1);
+    nodes_[3]->set_layer(-1);
+    root_.draw();
+
+    // Layer -1: 3, 4; layer 0: 1; layer 1: 0, 2
+    ASSERT_LT(nodes_[3]->draw_order(), nodes_[4]->draw_order());
+    ASSERT_LT(nodes_[4]->draw_order(), nodes_[1]->draw_order());
+    ASSERT_LT(nodes_[1]->draw_order(), nodes_[0]->draw_order());
+    ASSERT_LT(nodes_[0]->draw_order(), nodes_[2]->draw_order());
+}
+
 TEST_F(SceneNodeTest, MovesAllEnabledChildren)
 {
     root_.move(Vec2f::Zero);
@@ -180,3 +215,29 @@ TEST_F(SceneNodeTest, UpdatesAllEnabledChildren)
     ASSERT_EQ(1, nodes_[3]->update_count());
     ASSERT_EQ(1, nodes_[4]->update_count());
 }
+
+TEST_F(SceneNodeTest, TracksSubtreeBounds)
+{
+    ASSERT_EQ(rainbow::Rect::infinite(), root_.bounds());
+
+    nodes_[0]->set_bounds(rainbow::Rect::none());
+    nodes_[1]->set_bounds({0.0f, 0.0f, 1.0f, 1.0f});
+    nodes_[2]->set_bounds({-5.0f, 2.0f, -4.0f, 3.0f});
+    nodes_[3]->set_bounds({10.0f, 10.0f, 20.0f, 20.0f});
+    nodes_[4]->set_bounds({15.0f, -8.0f, 16.0f, -7.0f});
+    root_.update(0);
+
+    ASSERT_EQ(rainbow::Rect(-5.0f, -8.0f, 20.0f, 20.0f), root_.bounds());
+    ASSERT_EQ(rainbow::Rect(-5.0f, -8.0f, 20.0f, 20.0f), nodes_[0]->bounds());
+    ASSERT_EQ(rainbow::Rect(10.0f, -8.0f, 20.0f, 20.0f), nodes_[3]->bounds());
+
+    nodes_[3]->set_enabled(false);
+    root_.update(0);
+
+    ASSERT_EQ(rainbow::Rect(-5.0f, 0.0f, 1.0f, 3.0f), root_.bounds());
+
+    nodes_[2]->set_bounds(rainbow::Rect::infinite());
+    root_.update(0);
+
+    ASSERT_EQ(rainbow::Rect::infinite(), root_.bounds());
+}
@@ -0,0 +1,53 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include <gtest/gtest.h>
+
+#include "Graphics/ShelfPacker.h"
+
+using rainbow::graphics::ShelfPacker;
+
+TEST(ShelfPackerTest, PacksRectanglesOnShelves)
+{
+    ShelfPacker packer(64, 64);
+    Vec2u position;
+
+    ASSERT_TRUE(packer.insert(Vec2u(32, 16), position));
+    ASSERT_EQ(Vec2u(0, 0), position);
+    ASSERT_TRUE(packer.insert(Vec2u(32, 16), position));
+    ASSERT_EQ(Vec2u(32, 0), position);
+
+    // The first shelf is full.
+    ASSERT_TRUE(packer.insert(Vec2u(16, 16), position));
+    ASSERT_EQ(Vec2u(0, 16), position);
+
+    // Too short for the existing shelf, so a new one is opened.
+    ASSERT_TRUE(packer.insert(Vec2u(16, 8), position));
+    ASSERT_EQ(Vec2u(0, 32), position);
+}
+
+TEST(ShelfPackerTest, FillsTallShelvesWhenOutOfSpace)
+{
+    ShelfPacker packer(64, 32);
+    Vec2u position;
+
+    ASSERT_TRUE(packer.insert(Vec2u(16, 32), position));
+    ASSERT_TRUE(packer.insert(Vec2u(16, 8), position));
+    ASSERT_EQ(Vec2u(16, 0), position);
+}
+
+TEST(ShelfPackerTest, RejectsRectanglesThatDoNotFit)
+{
+    ShelfPacker packer(64, 64);
+    Vec2u position;
+
+    ASSERT_FALSE(packer.insert(Vec2u(65, 1), position));
+    ASSERT_TRUE(packer.insert(Vec2u(64, 64), position));
+    ASSERT_FALSE(packer.insert(Vec2u(1, 1), position));
+
+    packer.clear();
+
+    ASSERT_TRUE(packer.insert(Vec2u(1, 1), position));
+    ASSERT_EQ(Vec2u(0, 0), position);
+}
@@ -0,0 +1,157 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+#include "Graphics/Decoders/Software.h"
+#include "Graphics/OpenGL.h"
+
+using rainbow::byte_t;
+
+namespace
+{
+    struct Pixel
+    {
+        int r, g, b, a;
+    };
+
+    void expect_pixel(const Pixel& expected,
+                      const byte_t* pixels,
+                      unsigned int width,
+                      unsigned int x,
+                      unsigned int y)
+    {
+        const byte_t* pixel = pixels + (y * width + x) * 4;
+        EXPECT_EQ(expected.r, pixel[0]);
+        EXPECT_EQ(expected.g, pixel[1]);
+        EXPECT_EQ(expected.b, pixel[2]);
+        EXPECT_EQ(expected.a, pixel[3]);
+    }
+
+    void write_be(uint64_t bits, byte_t* block)
+    {
+        for (int i = 7; i >= 0; --i)
+        {
+            block[i] = bits & 0xff;
+            bits >>= 8;
+        }
+    }
+}
+
+TEST(SoftwareDecoderTest, RejectsUnsupportedFormats)
+{
+    const byte_t block[16]{};
+    ASSERT_FALSE(rainbow::software::can_decode(GL_RGBA));
+    ASSERT_FALSE(
+        rainbow::software::can_decode(GL_COMPRESSED_RGBA_ASTC_4x4_KHR));
+    ASSERT_FALSE(rainbow::software::decode(
+        GL_COMPRESSED_RGBA_ASTC_4x4_KHR, 4, 4, block, sizeof(block)));
+}
+
+TEST(SoftwareDecoderTest, RejectsTruncatedData)
+{
+    const byte_t blocks[24]{};
+
+    // 5x5 pixels need four 8-byte blocks.
+    ASSERT_FALSE(rainbow::software::decode(
+        GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 5, 5, blocks, sizeof(blocks)));
+    ASSERT_TRUE(rainbow::software::decode(
+        GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 5, 4, blocks, sizeof(blocks)));
+
+    // Sizes must not wrap around.
+    ASSERT_FALSE(rainbow::software::decode(
+        GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 0x40000, 0x40000, blocks, 16));
+}
+
+TEST(SoftwareDecoderTest, DecodesBC1)
+{
+    // Red and blue endpoints; indices 0, 1, 2, 3 on every row.
+    const byte_t blocks[16]{0x00, 0xf8, 0x1f, 0x00, 0xe4, 0xe4, 0xe4, 0xe4,
+                            // Black and white endpoints in 3-colour mode; the
+                            // fourth colour is transparent.
+                            0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+    ASSERT_TRUE(
+        rainbow::software::can_decode(GL_COMPRESSED_RGBA_S3TC_DXT1_EXT));
+
+    // Pixels outside the image are discarded.
+    auto pixels = rainbow::software::decode(
+        GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 6, 3, blocks, sizeof(blocks));
+    ASSERT_TRUE(pixels);
+
+    for (unsigned int y = 0; y < 3; ++y)
+    {
+        expect_pixel({255, 0, 0, 255}, pixels.get(), 6, 0, y);
+        expect_pixel({0, 0, 255, 255}, pixels.get(), 6, 1, y);
+        expect_pixel({170, 0, 85, 255}, pixels.get(), 6, 2, y);
+        expect_pixel({85, 0, 170, 255}, pixels.get(), 6, 3, y);
+        expect_pixel({0, 0, 0, 0}, pixels.get(), 6, 4, y);
+        expect_pixel({0, 0, 0, 0}, pixels.get(), 6, 5, y);
+    }
+}
+
+TEST(SoftwareDecoderTest, DecodesBC3)
+{
+    // Alpha from 255 to 0 with indices 0, 1, 2, ...; a white colour block.
+    const byte_t block[16]{0xff, 0x00, 0x88, 0xc6, 0xfa, 0x88, 0xc6, 0xfa,
+                           0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00};
+    auto pixels = rainbow::software::decode(
+        GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 4, 4, block, sizeof(block));
+    ASSERT_TRUE(pixels);
+
+    const int alpha[8]{255, 0, 218, 182, 145, 109, 72, 36};
+    for (unsigned int i = 0; i < 16; ++i)
+    {
+        expect_pixel(
+            {255, 255, 255, alpha[i % 8]}, pixels.get(), 4, i % 4, i / 4);
+    }
+}
+
+TEST(SoftwareDecoderTest, DecodesETC1)
+{
+    // Individual mode with white on the left half and black on the right.
+    // All pixels use the smallest positive modifier, except (1,2) which uses
+    // the smallest negative one.
+    byte_t block[8];
+    write_be((0xfull << 60) | (0xfull << 52) | (0xfull << 44) |
+                 (1ull << (1 * 4 + 2 + 16)),
+             block);
+    auto pixels = rainbow::software::decode(
+        GL_ETC1_RGB8_OES, 4, 4, block, sizeof(block));
+    ASSERT_TRUE(pixels);
+
+    for (unsigned int y = 0; y < 4; ++y)
+    {
+        for (unsigned int x = 0; x < 4; ++x)
+        {
+            if (x == 1 && y == 2)
+                expect_pixel({253, 253, 253, 255}, pixels.get(), 4, x, y);
+            else if (x < 2)
+                expect_pixel({255, 255, 255, 255}, pixels.get(), 4, x, y);
+            else
+                expect_pixel({2, 2, 2, 255}, pixels.get(), 4, x, y);
+        }
+    }
+}
+
+TEST(SoftwareDecoderTest, DecodesETC2Planar)
+{
+    // Differential mode where blue overflows selects planar mode. Red goes
+    // from 0 at the origin to 255 one block to the right.
+    byte_t block[8];
+    write_be((1ull << 42) | (0x1full << 34) | (1ull << 33) | (1ull << 32),
+             block);
+    auto pixels =
+        rainbow::software::decode(
+            GL_COMPRESSED_RGB8_ETC2, 4, 4, block, sizeof(block));
+    ASSERT_TRUE(pixels);
+
+    const int red[4]{0, 64, 128, 191};
+    for (unsigned int y = 0; y < 4; ++y)
+    {
+        for (unsigned int x = 0; x < 4; ++x)
+            expect_pixel({red[x], 0, 0, 255}, pixels.get(), 4, x, y);
+    }
+}
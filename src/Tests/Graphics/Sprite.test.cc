@@ -2,6 +2,8 @@
 // Distributed under the MIT License.
 // (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
 
+#include <cmath>
+
 #include <gtest/gtest.h>
 
 #include "Graphics/Sprite.h"
@@ -632,6 +634,72 @@ TEST_F(SpriteHiddenTest, CanBeMoved)
     ASSERT_EQ(Vec2f(0, 2), vertex_array[3].position);
 }
 
+TEST(SpriteTest, InstanceExpandsToSameQuad)
+{
+    // Mirrors the quad expansion in Fixed2DInstanced.vsh.
+    const Vec2f corners[]{{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+    auto expand = [](const SpriteInstance& instance, const Vec2f& corner) {
+        const Vec2f p{
+            instance.extent.x * (corner.x - instance.pivot.x),
+            instance.extent.y * (corner.y - (1.0f - instance.pivot.y))};
+        const float c = std::cos(instance.angle);
+        const float s = std::sin(instance.angle);
+        return Vec2f{instance.center.x + c * p.x + s * p.y,
+                     instance.center.y + c * p.y - s * p.x};
+    };
+    auto texcoord = [](const SpriteInstance& instance, const Vec2f& corner) {
+        const Vec2f uv0{instance.texcoord[0] / 65535.0f,
+                        instance.texcoord[1] / 65535.0f};
+        const Vec2f uv2{instance.texcoord[2] / 65535.0f,
+                        instance.texcoord[3] / 65535.0f};
+        return Vec2f{uv0.x + (uv2.x - uv0.x) * corner.x,
+                     uv0.y + (uv2.y - uv0.y) * corner.y};
+    };
+
+    auto atlas = create_texture();
+    const unsigned int region = atlas->add_region(8, 16, 32, 16);
+
+    Sprite sprite(4, 2);
+    Sprite instanced(4, 2);
+    for (auto s : {&sprite, &instanced})
+    {
+        s->set_texture(region);
+        s->set_color(0x11223344);
+        s->set_pivot({0.25f, 0.75f});
+        s->set_position({10.0f, -20.0f});
+        s->set_rotation(rainbow::radians(30.0f));
+        s->set_scale({1.5f, 2.0f});
+        s->flip();
+        s->mirror();
+    }
+
+    SpriteVertex vertex_array[4];
+    SpriteInstance instance;
+
+    ASSERT_TRUE(sprite.update(vertex_array, *atlas));
+    ASSERT_TRUE(instanced.update(instance, *atlas));
+    ASSERT_FALSE(instanced.update(instance, *atlas));
+    ASSERT_EQ(nullptr, instanced.vertex_array());
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        const Vec2f p = expand(instance, corners[i]);
+        ASSERT_NEAR(vertex_array[i].position.x, p.x, 1e-4f);
+        ASSERT_NEAR(vertex_array[i].position.y, p.y, 1e-4f);
+
+        const Vec2f uv = texcoord(instance, corners[i]);
+        ASSERT_NEAR(vertex_array[i].texcoord.x, uv.x, 1e-4f);
+        ASSERT_NEAR(vertex_array[i].texcoord.y, uv.y, 1e-4f);
+
+        ASSERT_EQ(vertex_array[i].color, instance.color);
+    }
+
+    instanced.hide();
+
+    ASSERT_TRUE(instanced.update(instance, *atlas));
+    ASSERT_EQ(Vec2f::Zero, instance.extent);
+}
+
 TEST(SpriteTest, UpdatesOnlyOnChange)
 {
     Sprite sprite(2, 2);
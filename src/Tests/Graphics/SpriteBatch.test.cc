@@ -2,9 +2,14 @@
 // Distributed under the MIT License.
 // (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
 
+#include <chrono>
+#include <string>
+
 #include <gtest/gtest.h>
 
+#include "Graphics/ElementBuffer.h"
 #include "Graphics/SpriteBatch.h"
+#include "Threading/JobSystem.h"
 
 namespace rainbow
 {
@@ -72,6 +77,34 @@ namespace
         }
     }
 
+    void verify_same_sprites(const SpriteBatch& expected,
+                             const SpriteBatch& actual)
+    {
+        ASSERT_EQ(expected.size(), actual.size());
+
+        const auto a = expected.sprites();
+        const auto b = actual.sprites();
+        for (unsigned int i = 0; i < expected.size(); ++i)
+        {
+            ASSERT_EQ(a[i].id(), b[i].id());
+            ASSERT_EQ(a[i].state(), b[i].state());
+            ASSERT_EQ(a[i].position(), b[i].position());
+            ASSERT_EQ(a[i].angle(), b[i].angle());
+            ASSERT_EQ(a[i].pivot(), b[i].pivot());
+            ASSERT_EQ(a[i].scale(), b[i].scale());
+            ASSERT_EQ(a[i].is_hidden(), b[i].is_hidden());
+        }
+
+        const auto u = expected.vertices();
+        const auto v = actual.vertices();
+        for (unsigned int i = 0; i < expected.size() * 4; ++i)
+        {
+            ASSERT_EQ(u[i].position, v[i].position) << "vertex " << i;
+            ASSERT_EQ(u[i].texcoord, v[i].texcoord) << "vertex " << i;
+            ASSERT_EQ(u[i].color, v[i].color) << "vertex " << i;
+        }
+    }
+
     class SpriteBatchOperationsTest : public ::testing::Test
     {
     public:
@@ -201,6 +234,92 @@ TEST(SpriteBatchTest, ExpandsToAccommodateNewSprites)
     }
 }
 
+TEST(SpriteBatchTest, HoldsMoreThan4096Sprites)
+{
+    constexpr unsigned int kNumSprites = 20000;
+
+    SpriteBatch batch(rainbow::ISolemnlySwearThatIAmOnlyTesting{});
+    for (unsigned int i = 0; i < kNumSprites; ++i)
+        batch.create_sprite(1, 1);
+    update(batch);
+
+    ASSERT_EQ(kNumSprites, batch.size());
+    ASSERT_EQ(kNumSprites * 6, batch.vertex_count());
+    verify_batch_integrity(batch);
+}
+
+TEST(SpriteBatchTest, PreparesLargeBatchesOnJobSystem)
+{
+    constexpr unsigned int kNumSprites = 10000;
+
+    rainbow::JobSystem jobs(3);
+    SpriteBatch batch(rainbow::ISolemnlySwearThatIAmOnlyTesting{});
+    for (unsigned int i = 0; i < kNumSprites; ++i)
+        batch.create_sprite(1, 1);
+    batch.prepare();
+
+    verify_batch_integrity(batch);
+
+    for (auto&& sprite : batch)
+        sprite.set_position(Vec2f(2.0f, 3.0f));
+    batch.prepare();
+
+    const SpriteVertex* vertices = batch.vertices();
+    for (unsigned int i = 0; i < batch.size(); ++i)
+    {
+        verify_sprite_vertices(
+            batch.sprites()[i], vertices + i * 4, Vec2f(2.0f, 3.0f));
+    }
+}
+
+TEST(SpriteBatchTest, TracksBoundsOfVisibleSprites)
+{
+    SpriteBatch batch(rainbow::ISolemnlySwearThatIAmOnlyTesting{});
+    batch.prepare();
+
+    ASSERT_TRUE(batch.bounds().is_empty());
+
+    auto a = batch.create_sprite(2, 2);
+    auto b = batch.create_sprite(4, 2);
+    a->set_position(Vec2f(-10.0f, 0.0f));
+    b->set_position(Vec2f(10.0f, 5.0f));
+    batch.prepare();
+
+    ASSERT_EQ(rainbow::Rect(-11.0f, -1.0f, 12.0f, 6.0f), batch.bounds());
+
+    b->move(Vec2f(100.0f, 0.0f));
+    batch.prepare();
+
+    ASSERT_EQ(rainbow::Rect(-11.0f, -1.0f, 112.0f, 6.0f), batch.bounds());
+
+    a->hide();
+    batch.prepare();
+
+    ASSERT_EQ(rainbow::Rect(108.0f, 4.0f, 112.0f, 6.0f), batch.bounds());
+}
+
+TEST(SpriteBatchTest, GeneratesQuadIndices)
+{
+    unsigned short indices[12];
+    rainbow::graphics::generate_quad_indices(ArraySpan<unsigned short>(indices));
+
+    const unsigned short expected[]{0, 1, 2, 2, 3, 0, 4, 5, 6, 6, 7, 4};
+    for (size_t i = 0; i < rainbow::array_size(expected); ++i)
+        ASSERT_EQ(expected[i], indices[i]);
+
+    const size_t first = rainbow::graphics::kMaxQuadsPerShortIndex;
+    unsigned int wide[6];
+    rainbow::graphics::generate_quad_indices(ArraySpan<unsigned int>(wide),
+                                             first);
+
+    ASSERT_EQ(first * 4, wide[0]);
+    ASSERT_EQ(first * 4 + 1, wide[1]);
+    ASSERT_EQ(first * 4 + 2, wide[2]);
+    ASSERT_EQ(first * 4 + 2, wide[3]);
+    ASSERT_EQ(first * 4 + 3, wide[4]);
+    ASSERT_EQ(first * 4, wide[5]);
+}
+
 TEST_F(SpriteBatchOperationsTest, SpritesShareASingleBuffer)
 {
     ASSERT_EQ(count * 6, batch.vertex_count());
@@ -370,3 +489,177 @@ TEST_F(SpriteBatchOperationsTest, SwapsSprites)
 
     verify_batch_integrity(batch);
 }
+
+TEST(SpriteBatchTest, SwitchesStorageWithoutLosingState)
+{
+    SpriteBatch batch(rainbow::ISolemnlySwearThatIAmOnlyTesting{});
+    ASSERT_EQ(SpriteBatch::Storage::ArrayOfStructs, batch.storage());
+
+    auto sprite = batch.create_sprite(2, 4);
+    sprite->set_position(Vec2f(3.0f, 5.0f));
+    sprite->set_rotation(0.5f);
+    sprite->set_scale(Vec2f(2.0f, 3.0f));
+    sprite->set_pivot(Vec2f(0.0f, 1.0f));
+    batch.prepare();
+    sprite->move(Vec2f(1.0f, 1.0f));
+
+    const Vec2f position = sprite->position();
+    const unsigned int state = sprite->state();
+
+    batch.set_storage(SpriteBatch::Storage::StructOfArrays);
+    ASSERT_EQ(SpriteBatch::Storage::StructOfArrays, batch.storage());
+    ASSERT_EQ(state, sprite->state());
+    ASSERT_EQ(position, sprite->position());
+    ASSERT_EQ(0.5f, sprite->angle());
+    ASSERT_EQ(Vec2f(2.0f, 3.0f), sprite->scale());
+    ASSERT_EQ(Vec2f(0.0f, 1.0f), sprite->pivot());
+
+    sprite->rotate(0.25f);
+    batch.set_storage(SpriteBatch::Storage::ArrayOfStructs);
+    ASSERT_EQ(SpriteBatch::Storage::ArrayOfStructs, batch.storage());
+    ASSERT_EQ(position, sprite->position());
+    ASSERT_EQ(0.75f, sprite->angle());
+}
+
+TEST(SpriteBatchTest, StructOfArraysMatchesArrayOfStructs)
+{
+    rainbow::ISolemnlySwearThatIAmOnlyTesting mock;
+
+    SpriteBatch expected(mock);
+    SpriteBatch actual(mock);
+    actual.set_storage(SpriteBatch::Storage::StructOfArrays);
+
+    // Applies the same changes to both batches, then compares them.
+    auto apply = [&expected, &actual](auto&& f) {
+        f(expected);
+        f(actual);
+        expected.prepare();
+        actual.prepare();
+        verify_same_sprites(expected, actual);
+    };
+
+    // Create enough sprites to resize the batches a few times, with gaps
+    // between the ones that need a full transform.
+    apply([](SpriteBatch& batch) {
+        for (int i = 0; i < 37; ++i)
+        {
+            auto sprite = batch.create_sprite(i % 5 + 1, i % 3 + 1);
+            sprite->set_id(i + 1);
+            sprite->set_position(Vec2f(i * 2.0f, i * -3.0f));
+            if (i % 4 != 0)
+                sprite->set_rotation(i * 0.3f);
+            if (i % 3 == 0)
+                sprite->set_scale(Vec2f(1.5f, 0.5f));
+            if (i % 5 == 0)
+                sprite->set_pivot(Vec2f(0.25f, 0.75f));
+        }
+    });
+
+    apply([](SpriteBatch& batch) {
+        for (unsigned int i = 0; i < batch.size(); i += 2)
+            SpriteRef(&batch, i)->move(Vec2f(1.0f, -1.0f));
+    });
+
+    apply([](SpriteBatch& batch) {
+        for (unsigned int i = 0; i < batch.size(); i += 3)
+            SpriteRef(&batch, i)->rotate(8192.0f * i);
+    });
+
+    apply([](SpriteBatch& batch) {
+        SpriteRef(&batch, 1)->hide();
+        SpriteRef(&batch, 2)->flip();
+        SpriteRef(&batch, 3)->mirror();
+        SpriteRef(&batch, 4)->set_color(Colorb(0x11223344));
+        SpriteRef(&batch, 5)->set_pivot(Vec2f(1.0f, 0.0f));
+    });
+
+    apply([](SpriteBatch& batch) {
+        SpriteRef(&batch, 1)->show();
+        batch.swap(SpriteRef(&batch, 2), SpriteRef(&batch, 30));
+        batch.bring_to_front(SpriteRef(&batch, 7));
+        batch.erase(SpriteRef(&batch, 11));
+        batch.erase(batch.find_sprite_by_id(37));
+    });
+
+    apply([](SpriteBatch& batch) {
+        batch.move(Vec2f(-4.0f, 2.0f));
+        batch.create_sprite(3, 3)->set_rotation(1.0f);
+    });
+
+    apply([](SpriteBatch& batch) {
+        batch.clear();
+        batch.create_sprite(2, 2)->set_position(Vec2f(1.0f, 1.0f));
+    });
+}
+
+TEST(SpriteBatchTest, StructOfArraysSurvivesMoves)
+{
+    SpriteBatch batch(rainbow::ISolemnlySwearThatIAmOnlyTesting{});
+    batch.set_storage(SpriteBatch::Storage::StructOfArrays);
+    batch.create_sprite(2, 2)->set_position(Vec2f(1.0f, 1.0f));
+
+    SpriteBatch moved(std::move(batch));
+    ASSERT_EQ(SpriteBatch::Storage::StructOfArrays, moved.storage());
+
+    SpriteRef sprite(&moved, 0);
+    ASSERT_EQ(Vec2f(1.0f, 1.0f), sprite->position());
+
+    sprite->move(Vec2f(1.0f, 1.0f));
+    moved.prepare();
+    verify_sprite_vertices(*sprite, moved.vertices(), Vec2f(2.0f, 2.0f));
+}
+
+TEST(SpriteBatchBenchmark, DISABLED_UpdatesRotatingSprites)
+{
+    using clock = std::chrono::steady_clock;
+
+    constexpr int kNumFrames = 100;
+
+    auto run = [](SpriteBatch& batch) {
+        const auto start = clock::now();
+        for (int frame = 0; frame < kNumFrames; ++frame)
+        {
+            for (auto&& sprite : batch)
+                sprite.rotate(0.01f);
+            batch.prepare();
+        }
+        return std::chrono::duration<double, std::milli>(clock::now() -
+                                                         start)
+                   .count() /
+               kNumFrames;
+    };
+
+    auto measure = [&run](unsigned int count, SpriteBatch::Storage storage) {
+        SpriteBatch batch(rainbow::ISolemnlySwearThatIAmOnlyTesting{});
+        batch.set_storage(storage);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            batch.create_sprite(16, 16)->set_position(
+                Vec2f(i % 1920, i % 1080));
+        }
+        batch.prepare();
+        return run(batch);
+    };
+
+    auto report = [&measure](unsigned int count, const char* workers) {
+        const double aos =
+            measure(count, SpriteBatch::Storage::ArrayOfStructs);
+        const double soa =
+            measure(count, SpriteBatch::Storage::StructOfArrays);
+        printf("[ BENCHMARK] %6u sprites, %s: AoS %.3f ms/frame, "
+               "SoA %.3f ms/frame\n",
+               count,
+               workers,
+               aos,
+               soa);
+    };
+
+    for (unsigned int count : {1000, 10000, 100000})
+        report(count, "serial");
+
+    rainbow::JobSystem jobs;
+    const std::string workers = std::to_string(jobs.worker_count()) +
+                                " workers";
+    for (unsigned int count : {1000, 10000, 100000})
+        report(count, workers.c_str());
+}
@@ -0,0 +1,147 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "Common/Data.h"
+#include "Graphics/Label.h"
+#include "Graphics/TextBatch.h"
+#include "Resources/NewsCycle-Regular.ttf.h"
+
+namespace rainbow { struct ISolemnlySwearThatIAmOnlyTesting {}; }
+
+namespace
+{
+    const rainbow::ISolemnlySwearThatIAmOnlyTesting kTesting{};
+
+    auto bounds_of(const SpriteVertex* vertices, size_t count)
+    {
+        auto bounds = rainbow::Rect::none();
+        for (size_t i = 0; i < count; ++i)
+            bounds.extend(vertices[i].position);
+        return bounds;
+    }
+
+    bool is_collapsed(const SpriteVertex* vertices, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!vertices[i].position.is_zero())
+                return false;
+        }
+        return true;
+    }
+
+    class TextBatchTest : public ::testing::Test
+    {
+    protected:
+        SharedPtr<FontAtlas> font;
+        std::unique_ptr<TextBatch> batch;
+        std::unique_ptr<Label> labels[3];
+        size_t capacity[3];  ///< Longest text set on each label.
+
+        void SetUp() override
+        {
+            font = make_shared<FontAtlas>(
+                Data::from_bytes(NewsCycle_Regular_ttf), 12.0f, kTesting);
+            batch = std::make_unique<TextBatch>(font, kTesting);
+
+            const char* text[]{"HP 100", "MP 50", "XP 1234"};
+            for (size_t i = 0; i < 3; ++i)
+            {
+                capacity[i] = 0;
+                labels[i] = std::make_unique<Label>(kTesting);
+                labels[i]->set_font(font);
+                set_text(i, text[i]);
+                labels[i]->set_position(Vec2f(10.0f, 100.0f - i * 20.0f));
+                batch->add(*labels[i]);
+            }
+            batch->update();
+        }
+
+        void set_text(size_t i, const char* text)
+        {
+            labels[i]->set_text(text);
+            capacity[i] = std::max(capacity[i], strlen(text));
+        }
+
+        /// <summary>
+        ///   Returns where label <paramref name="i"/> is in the batch. Labels
+        ///   are laid out in order, with room for their longest text.
+        /// </summary>
+        auto vertices_of(size_t i) const
+        {
+            size_t offset = 0;
+            for (size_t j = 0; j < i; ++j)
+                offset += capacity[j] * 4;
+            return batch->vertices() + offset;
+        }
+
+        void expect_copied(size_t i) const
+        {
+            const Label& label = *labels[i];
+            const auto bounds = bounds_of(vertices_of(i), label.length() * 4);
+            EXPECT_EQ(label.bounds().left, bounds.left);
+            EXPECT_EQ(label.bounds().bottom, bounds.bottom);
+            EXPECT_EQ(label.bounds().right, bounds.right);
+            EXPECT_EQ(label.bounds().top, bounds.top);
+        }
+    };
+}
+
+TEST_F(TextBatchTest, DrawsLabelsOnSamePageWithOneRun)
+{
+    ASSERT_EQ(3u, batch->size());
+    ASSERT_EQ(1u, batch->runs().size());
+
+    const auto& run = batch->runs().front();
+    ASSERT_EQ(0u, run.first);
+    ASSERT_EQ((vertices_of(2) - batch->vertices()) / 4 + labels[2]->length(),
+              run.count);
+
+    for (size_t i = 0; i < 3; ++i)
+        expect_copied(i);
+}
+
+TEST_F(TextBatchTest, CollapsesCharactersNoLongerDrawn)
+{
+    set_text(0, "HP 9");
+    labels[1]->move(Vec2f(5.0f, 5.0f));
+    batch->update();
+
+    ASSERT_EQ(4u, labels[0]->length());
+    expect_copied(0);
+    ASSERT_TRUE(is_collapsed(vertices_of(0) + 4 * 4, 2 * 4));
+    expect_copied(1);
+    expect_copied(2);
+}
+
+TEST_F(TextBatchTest, MakesRoomForLabelsThatGrow)
+{
+    set_text(0, "HP 100000");
+    batch->update();
+
+    for (size_t i = 0; i < 3; ++i)
+        expect_copied(i);
+}
+
+TEST_F(TextBatchTest, RemovesDestroyedLabels)
+{
+    labels[0].reset();
+    ASSERT_EQ(2u, batch->size());
+
+    batch->update();
+    ASSERT_EQ(1u, batch->runs().size());
+
+    labels[0].swap(labels[1]);
+    labels[1].swap(labels[2]);
+    capacity[0] = capacity[1];
+    capacity[1] = capacity[2];
+    expect_copied(0);
+    expect_copied(1);
+}
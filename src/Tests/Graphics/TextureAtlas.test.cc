@@ -2,9 +2,13 @@
 // Distributed under the MIT License.
 // (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
 
+#include <chrono>
+
 #include <gtest/gtest.h>
 
+#include "Graphics/OpenGL.h"
 #include "Graphics/TextureAtlas.h"
+#include "Graphics/TextureManager.h"
 
 namespace rainbow
 {
@@ -77,3 +81,74 @@ TEST(TextureAtlasTest, SetsRegions)
         ASSERT_EQ(Vec2f(value, value + value), region.vx[0]);
     }
 }
+
+TEST(TextureAtlasTest, NormalizesRegionsAddedWhileLoading)
+{
+    int loaded = 0;
+    TextureAtlas atlas{rainbow::ISolemnlySwearThatIAmOnlyTesting{},
+                       [&loaded](TextureAtlas&) { ++loaded; }};
+
+    ASSERT_FALSE(atlas.is_ready());
+
+    const unsigned int region = atlas.add_region(16, 16, 16, 16);
+
+    ASSERT_EQ(0, loaded);
+
+    atlas.finish_loading_for_testing();
+
+    ASSERT_TRUE(atlas.is_ready());
+    ASSERT_EQ(1, loaded);
+    ASSERT_EQ(Vec2f(0.25f, 0.25f), atlas[region].vx[3]);
+    ASSERT_EQ(Vec2f(0.5f, 0.25f), atlas[region].vx[2]);
+    ASSERT_EQ(Vec2f(0.5f, 0.5f), atlas[region].vx[1]);
+    ASSERT_EQ(Vec2f(0.25f, 0.5f), atlas[region].vx[0]);
+
+    const unsigned int next = atlas.add_region(32, 32, 16, 16);
+
+    ASSERT_EQ(Vec2f(0.5f, 0.5f), atlas[next].vx[3]);
+}
+
+TEST(TextureAtlasTest, WaitsForTexturesStillLoading)
+{
+    TextureManager texture_manager{rainbow::ISolemnlySwearThatIAmOnlyTesting{}};
+    texture_manager.create_async(
+        "atlas",
+        [] {
+            return [](TextureManager& texture_manager,
+                      const rainbow::Texture& texture) {
+                texture_manager.upload(
+                    texture, GL_RGBA, 64, 64, GL_RGBA, nullptr);
+            };
+        },
+        nullptr,
+        [](const rainbow::Texture&) {});
+
+    const rainbow::byte_t kNoData[1]{};
+    const DataMap data{kNoData};
+    TextureAtlas atlas{"atlas", data, 1.0f};
+
+    ASSERT_FALSE(atlas.is_ready());
+
+    const unsigned int region = atlas.add_region(16, 16, 16, 16);
+    texture_manager.update(std::chrono::microseconds{4000});
+
+    ASSERT_TRUE(atlas.is_ready());
+    ASSERT_EQ(64u, atlas.width());
+    ASSERT_EQ(Vec2f(0.25f, 0.25f), atlas[region].vx[3]);
+}
+
+TEST(TextureAtlasTest, IsNeverReadyIfNothingWasUploaded)
+{
+    TextureManager texture_manager{rainbow::ISolemnlySwearThatIAmOnlyTesting{}};
+
+    const rainbow::byte_t kNoData[1]{};
+    const DataMap data{kNoData};
+    TextureAtlas atlas{"atlas", data, 1.0f};
+
+    ASSERT_FALSE(atlas.is_ready());
+    ASSERT_EQ(0u, atlas.width());
+
+    atlas.add_region(16, 16, 16, 16);
+
+    ASSERT_EQ(1u, atlas.size());
+}
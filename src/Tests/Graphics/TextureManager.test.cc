@@ -0,0 +1,243 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+#include "Graphics/OpenGL.h"
+#include "Graphics/TextureManager.h"
+
+namespace rainbow { struct ISolemnlySwearThatIAmOnlyTesting {}; }
+
+using rainbow::Texture;
+
+namespace
+{
+    constexpr unsigned int kTextureSize = 16;
+    constexpr unsigned int kTextureBytes = kTextureSize * kTextureSize * 4;
+    constexpr std::chrono::microseconds kUpdateBudget{4000};
+
+    void upload(TextureManager& texture_manager, const Texture& texture)
+    {
+        texture_manager.upload(texture,
+                               GL_RGBA,
+                               kTextureSize,
+                               kTextureSize,
+                               GL_RGBA,
+                               nullptr);
+    }
+
+    auto reloader() -> TextureManager::Decoder
+    {
+        return [] { return TextureManager::Uploader{upload}; };
+    }
+
+    void no_op(TextureManager&, const Texture&) {}
+
+    auto megabytes(unsigned int bytes) { return bytes * 1e-6; }
+}
+
+class TextureManagerTest : public ::testing::Test
+{
+public:
+    TextureManagerTest()
+        : texture_manager_(rainbow::ISolemnlySwearThatIAmOnlyTesting{})
+    {
+    }
+
+protected:
+    TextureManager texture_manager_;
+
+    /// <summary>Creates a texture that can be evicted and reloaded.</summary>
+    auto create(const char* id)
+    {
+        auto texture = texture_manager_.create(id, upload);
+        texture_manager_.set_source(texture, reloader());
+        return texture;
+    }
+
+    void update() { texture_manager_.update(kUpdateBudget); }
+};
+
+TEST_F(TextureManagerTest, ReturnsExistingTexturesForSameId)
+{
+    auto a = texture_manager_.create("a", no_op);
+    auto b = texture_manager_.create("a", no_op);
+
+    ASSERT_TRUE(a);
+    ASSERT_EQ(static_cast<unsigned int>(a), static_cast<unsigned int>(b));
+}
+
+TEST_F(TextureManagerTest, RecyclesFreeSlots)
+{
+    auto a = texture_manager_.create("a", no_op);
+    const unsigned int name_b = texture_manager_.create("b", no_op);
+    auto c = texture_manager_.create("c", no_op);
+
+    // Slots are not freed until trimmed.
+    auto d = texture_manager_.create("d", no_op);
+    ASSERT_NE(name_b, static_cast<unsigned int>(d));
+
+    texture_manager_.trim();
+
+    auto e = texture_manager_.create("e", no_op);
+    ASSERT_EQ(name_b, static_cast<unsigned int>(e));
+
+    auto f = texture_manager_.create("f", no_op);
+    ASSERT_NE(static_cast<unsigned int>(a), static_cast<unsigned int>(f));
+    ASSERT_NE(static_cast<unsigned int>(c), static_cast<unsigned int>(f));
+    ASSERT_NE(static_cast<unsigned int>(d), static_cast<unsigned int>(f));
+    ASSERT_NE(name_b, static_cast<unsigned int>(f));
+}
+
+TEST_F(TextureManagerTest, ForgetsIdsOfTrimmedTextures)
+{
+    bool loaded = false;
+    auto loader = [&loaded](TextureManager&, const Texture&) {
+        loaded = true;
+    };
+
+    texture_manager_.create("a", loader);
+    ASSERT_TRUE(loaded);
+
+    loaded = false;
+    texture_manager_.trim();
+    texture_manager_.create("a", loader);
+    ASSERT_TRUE(loaded);
+}
+
+#ifndef NDEBUG
+TEST_F(TextureManagerTest, BumpsGenerationWhenReusingSlots)
+{
+    // Assertions are logged to stdout, so only the abort can be checked.
+    ASSERT_DEATH(
+        {
+            const unsigned int name =
+                texture_manager_.create("a", no_op);
+            texture_manager_.trim();
+            texture_manager_.create("b", no_op);
+
+            // A handle to the first texture in the slot, i.e. generation 0.
+            rainbow::detail::Texture slot(0);
+            slot.name = name;
+            Texture stale(slot);
+            stale.bind();
+        },
+        "");
+}
+#endif
+
+TEST_F(TextureManagerTest, TrimSkipsTexturesStillLoading)
+{
+    int uploads = 0;
+    int callbacks = 0;
+    const unsigned int name = texture_manager_.create_async(
+        "a",
+        [&uploads] {
+            return [&uploads](TextureManager& texture_manager,
+                              const Texture& texture) {
+                ++uploads;
+                upload(texture_manager, texture);
+            };
+        },
+        this,
+        [&callbacks](const Texture&) { ++callbacks; });
+
+    // The texture is unused, but must keep its slot until uploaded.
+    texture_manager_.trim();
+    auto b = texture_manager_.create("b", no_op);
+    ASSERT_NE(name, static_cast<unsigned int>(b));
+
+    update();
+    ASSERT_EQ(1, uploads);
+    ASSERT_EQ(1, callbacks);
+    ASSERT_DOUBLE_EQ(megabytes(kTextureBytes),
+                     texture_manager_.memory_usage().used);
+
+    texture_manager_.trim();
+    ASSERT_DOUBLE_EQ(0.0, texture_manager_.memory_usage().used);
+
+    auto c = texture_manager_.create("c", no_op);
+    ASSERT_EQ(name, static_cast<unsigned int>(c));
+}
+
+TEST_F(TextureManagerTest, EvictsLeastRecentlyUsedFirst)
+{
+    auto a = create("a");
+    auto b = create("b");
+    auto c = create("c");
+    ASSERT_DOUBLE_EQ(megabytes(kTextureBytes * 3),
+                     texture_manager_.memory_usage().used);
+
+    update();
+    b.bind();
+    update();
+    a.bind();
+    update();
+    c.bind();
+
+    // Only one texture must go, and 'b' was used least recently.
+    texture_manager_.set_budget(kTextureBytes * 2);
+    update();
+
+    auto usage = texture_manager_.memory_usage();
+    ASSERT_EQ(1u, usage.evictions);
+    ASSERT_DOUBLE_EQ(megabytes(kTextureBytes * 2), usage.used);
+
+    a.bind();
+    c.bind();
+    ASSERT_EQ(0u, texture_manager_.memory_usage().reloads);
+
+    b.bind();
+    ASSERT_EQ(1u, texture_manager_.memory_usage().reloads);
+}
+
+TEST_F(TextureManagerTest, EvictsOnlyIdleTextures)
+{
+    auto a = create("a");
+    texture_manager_.set_budget(1);
+
+    // Textures bound within the last couple of frames are kept.
+    update();
+    ASSERT_EQ(0u, texture_manager_.memory_usage().evictions);
+
+    update();
+    ASSERT_EQ(1u, texture_manager_.memory_usage().evictions);
+    ASSERT_DOUBLE_EQ(0.0, texture_manager_.memory_usage().used);
+}
+
+TEST_F(TextureManagerTest, EvictsOnlyTexturesWithSources)
+{
+    auto a = texture_manager_.create("a", upload);
+    texture_manager_.set_budget(1);
+
+    update();
+    update();
+    update();
+    ASSERT_EQ(0u, texture_manager_.memory_usage().evictions);
+    ASSERT_DOUBLE_EQ(megabytes(kTextureBytes),
+                     texture_manager_.memory_usage().used);
+}
+
+TEST_F(TextureManagerTest, ReloadsEvictedTexturesWhenBound)
+{
+    auto a = create("a");
+    texture_manager_.set_budget(1);
+    update();
+    update();
+    ASSERT_EQ(1u, texture_manager_.memory_usage().evictions);
+
+    texture_manager_.set_budget(0);
+    a.bind();
+    ASSERT_EQ(1u, texture_manager_.memory_usage().reloads);
+
+    // Binding again while reloading does not start another reload.
+    a.bind();
+    ASSERT_EQ(1u, texture_manager_.memory_usage().reloads);
+
+    update();
+    ASSERT_DOUBLE_EQ(megabytes(kTextureBytes),
+                     texture_manager_.memory_usage().used);
+}
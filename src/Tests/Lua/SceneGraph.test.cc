@@ -0,0 +1,97 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "Common/Data.h"
+#include "Graphics/SceneGraph.h"
+#include "Lua/lua_SceneGraph.h"
+#include "Lua/lua_TextBatch.h"
+#include "Resources/NewsCycle-Regular.ttf.h"
+
+namespace rainbow { struct ISolemnlySwearThatIAmOnlyTesting {}; }
+
+using rainbow::SceneNode;
+
+namespace
+{
+    const rainbow::ISolemnlySwearThatIAmOnlyTesting kTesting{};
+
+    class LuaSceneGraphTest : public ::testing::Test
+    {
+    protected:
+        std::unique_ptr<SceneNode> root;
+        lua_State* L = nullptr;
+        rainbow::lua::SceneGraph* scenegraph = nullptr;
+        std::string error;
+
+        void SetUp() override
+        {
+            root = SceneNode::create();
+
+            L = luaL_newstate();
+            luaL_requiref(L, "_G", luaopen_base, 1);
+            lua_pop(L, 1);
+
+            // rainbow.scenegraph
+            lua_createtable(L, 0, 1);
+            scenegraph = rainbow::lua::SceneGraph::create(L, root.get());
+            lua_setglobal(L, "rainbow");
+        }
+
+        void TearDown() override
+        {
+            rainbow::lua::SceneGraph::destroy(L, scenegraph);
+            lua_close(L);
+        }
+
+        bool run(const char* chunk)
+        {
+            if (luaL_dostring(L, chunk) == LUA_OK)
+                return true;
+
+            error = lua_tostring(L, -1);
+            lua_pop(L, 1);
+            return false;
+        }
+    };
+}
+
+TEST_F(LuaSceneGraphTest, AddsTextBatches)
+{
+    auto font = make_shared<FontAtlas>(
+        Data::from_bytes(NewsCycle_Regular_ttf), 12.0f, kTesting);
+
+    // Text batches need a graphics context when created from Lua.
+    luaL_newmetatable(L, rainbow::lua::TextBatch::class_name);
+    lua_pop(L, 1);
+    void* data = lua_newuserdata(L, sizeof(rainbow::lua::TextBatch));
+    luaL_setmetatable(L, rainbow::lua::TextBatch::class_name);
+    auto batch = new (data) rainbow::lua::TextBatch(
+        std::make_unique<TextBatch>(font, kTesting), kTesting);
+    lua_setglobal(L, "batch");
+
+    ASSERT_TRUE(run("node = rainbow.scenegraph:add_textbatch(batch)"))
+        << error;
+    lua_getglobal(L, "node");
+    auto node = static_cast<SceneNode*>(lua_touserdata(L, -1));
+    lua_pop(L, 1);
+    ASSERT_NE(nullptr, node);
+    ASSERT_EQ(root.get(), node->parent());
+
+    ASSERT_TRUE(run("rainbow.scenegraph:add_textbatch(node, batch)"))
+        << error;
+
+#ifndef NDEBUG
+    ASSERT_FALSE(run("rainbow.scenegraph:add_textbatch(42)"));
+    ASSERT_NE(std::string::npos, error.find("text batch")) << error;
+#endif
+
+    ASSERT_TRUE(run("rainbow.scenegraph:remove(node)")) << error;
+    batch->~TextBatch();
+}
@@ -0,0 +1,197 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "Graphics/SpriteVertex.h"
+#include "Math/Transform.h"
+#include "Math/TransformBatch.h"
+
+namespace
+{
+    struct Sprite
+    {
+        unsigned int width_;
+        unsigned int height_;
+        Vec2f pivot_;
+        Vec2f position_;
+        float angle_;
+        Vec2f scale_;
+
+        auto angle() const { return angle_; }
+        auto height() const { return height_; }
+        auto pivot() const { return pivot_; }
+        auto position() const { return position_; }
+        auto scale() const { return scale_; }
+        auto width() const { return width_; }
+    };
+
+    Sprite make_sprite(size_t i)
+    {
+        const float f = static_cast<float>(i);
+        return {16 + static_cast<unsigned int>(i % 7),
+                32 - static_cast<unsigned int>(i % 5),
+                {(i % 3) * 0.5f, (i % 4) * 0.25f},
+                {f * 1.5f - 300.0f, 200.0f - f * 0.75f},
+                (i % 2 == 0 ? 1.0f : -1.0f) * f * 0.37f,
+                {0.5f + (i % 4) * 0.5f, 1.0f + (i % 3) * 0.25f}};
+    }
+
+    void apply(rainbow::TransformBatch& batch,
+               const std::unique_ptr<Sprite[]>& sprites,
+               SpriteVertex* vertices,
+               size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            batch.push(sprites[i], &vertices[i * 4].position);
+        batch.apply(sizeof(SpriteVertex));
+    }
+
+    std::unique_ptr<Sprite[]> make_sprites(size_t count)
+    {
+        auto sprites = std::make_unique<Sprite[]>(count);
+        for (size_t i = 0; i < count; ++i)
+            sprites[i] = make_sprite(i);
+        return sprites;
+    }
+}
+
+TEST(TransformBatchTest, MatchesScalarTransform)
+{
+    constexpr size_t kNumSprites = 103;  // Not a multiple of the lane count.
+
+    const auto sprites = make_sprites(kNumSprites);
+    SpriteVertex expected[kNumSprites * 4];
+    for (size_t i = 0; i < kNumSprites; ++i)
+    {
+        rainbow::transform(
+            sprites[i], ArraySpan<SpriteVertex>(expected + i * 4, 4));
+    }
+
+    SpriteVertex actual[kNumSprites * 4];
+    rainbow::TransformBatch batch;
+    apply(batch, sprites, actual, kNumSprites);
+
+    ASSERT_EQ(0u, batch.size());
+    for (size_t i = 0; i < kNumSprites * 4; ++i)
+    {
+        const float tolerance =
+            1e-5f * std::max(1.0f, expected[i].position.distance(Vec2f::Zero));
+        ASSERT_NEAR(expected[i].position.x, actual[i].position.x, tolerance);
+        ASSERT_NEAR(expected[i].position.y, actual[i].position.y, tolerance);
+    }
+}
+
+TEST(TransformBatchTest, IsExactWithoutRotation)
+{
+    constexpr size_t kNumSprites = 5;
+
+    auto sprites = make_sprites(kNumSprites);
+    SpriteVertex expected[kNumSprites * 4];
+    for (size_t i = 0; i < kNumSprites; ++i)
+    {
+        sprites[i].angle_ = 0.0f;
+        rainbow::transform(
+            sprites[i], ArraySpan<SpriteVertex>(expected + i * 4, 4));
+    }
+
+    SpriteVertex actual[kNumSprites * 4];
+    rainbow::TransformBatch batch;
+    apply(batch, sprites, actual, kNumSprites);
+
+    for (size_t i = 0; i < kNumSprites * 4; ++i)
+        ASSERT_EQ(expected[i].position, actual[i].position);
+}
+
+TEST(TransformBatchTest, HandlesLargeAngles)
+{
+    constexpr size_t kNumSprites = 8;
+
+    auto sprites = make_sprites(kNumSprites);
+    SpriteVertex expected[kNumSprites * 4];
+    for (size_t i = 0; i < kNumSprites; ++i)
+    {
+        // Far beyond what the polynomial range reduction handles.
+        sprites[i].angle_ = (i % 2 == 0 ? 1.0f : -1.0f) * (1e5f + i * 1e6f);
+        rainbow::transform(
+            sprites[i], ArraySpan<SpriteVertex>(expected + i * 4, 4));
+    }
+
+    SpriteVertex actual[kNumSprites * 4];
+    rainbow::TransformBatch batch;
+    apply(batch, sprites, actual, kNumSprites);
+
+    for (size_t i = 0; i < kNumSprites * 4; ++i)
+    {
+        const float tolerance =
+            1e-4f * std::max(1.0f, expected[i].position.distance(Vec2f::Zero));
+        ASSERT_NEAR(expected[i].position.x, actual[i].position.x, tolerance);
+        ASSERT_NEAR(expected[i].position.y, actual[i].position.y, tolerance);
+    }
+}
+
+TEST(TransformBatchTest, OnlyWritesPositions)
+{
+    const auto sprites = make_sprites(1);
+    SpriteVertex vertices[4];
+    for (auto&& vertex : vertices)
+    {
+        vertex.color = 0xdeadbeef;
+        vertex.texcoord = Vec2f(0.25f, 0.75f);
+    }
+
+    rainbow::TransformBatch batch;
+    apply(batch, sprites, vertices, 1);
+
+    for (auto&& vertex : vertices)
+    {
+        ASSERT_EQ(Colorb(0xdeadbeef), vertex.color);
+        ASSERT_EQ(Vec2f(0.25f, 0.75f), vertex.texcoord);
+    }
+}
+
+TEST(TransformBatchBenchmark, DISABLED_ScalarVersusBatched)
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int kIterations = 50;
+
+    for (size_t count : {1000, 10000, 100000})
+    {
+        const auto sprites = make_sprites(count);
+        auto vertices = std::make_unique<SpriteVertex[]>(count * 4);
+
+        auto start = Clock::now();
+        for (int n = 0; n < kIterations; ++n)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                rainbow::transform(
+                    sprites[i],
+                    ArraySpan<SpriteVertex>(vertices.get() + i * 4, 4));
+            }
+        }
+        const std::chrono::duration<double, std::micro> scalar =
+            Clock::now() - start;
+
+        rainbow::TransformBatch batch;
+        batch.reserve(count);
+        start = Clock::now();
+        for (int n = 0; n < kIterations; ++n)
+            apply(batch, sprites, vertices.get(), count);
+        const std::chrono::duration<double, std::micro> batched =
+            Clock::now() - start;
+
+        printf("[ BENCHMARK] %6zu sprites: scalar %8.1f us, batched %8.1f us "
+               "(%.2fx)\n",
+               count,
+               scalar.count() / kIterations,
+               batched.count() / kIterations,
+               scalar.count() / batched.count());
+    }
+}
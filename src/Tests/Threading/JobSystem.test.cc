@@ -0,0 +1,144 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Threading/JobSystem.h"
+
+using rainbow::JobSystem;
+
+namespace
+{
+    constexpr size_t kCount = 10000;
+
+    void verify_each_index_visited_once(size_t grain)
+    {
+        std::vector<std::atomic<int>> visits(kCount);
+        for (auto&& v : visits)
+            v = 0;
+
+        rainbow::parallel_for(
+            kCount, grain, [&visits](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                    ++visits[i];
+            });
+
+        for (auto&& v : visits)
+            ASSERT_EQ(1, v);
+    }
+}
+
+TEST(JobSystemTest, RunsSeriallyWithoutJobSystem)
+{
+    ASSERT_EQ(nullptr, JobSystem::Get());
+
+    int calls = 0;
+    rainbow::parallel_for(kCount, 16, [&calls](size_t begin, size_t end) {
+        ASSERT_EQ(0u, begin);
+        ASSERT_EQ(kCount, end);
+        ++calls;
+    });
+    ASSERT_EQ(1, calls);
+
+    rainbow::parallel_for(0, 16, [&calls](size_t, size_t) { ++calls; });
+    ASSERT_EQ(1, calls);
+}
+
+TEST(JobSystemTest, VisitsEachIndexOnce)
+{
+    JobSystem jobs(3);
+    ASSERT_EQ(&jobs, JobSystem::Get());
+    ASSERT_EQ(3u, jobs.worker_count());
+
+    const size_t grains[]{1, 7, 64, kCount, kCount * 2};
+    for (size_t grain : grains)
+        verify_each_index_visited_once(grain);
+}
+
+TEST(JobSystemTest, WorksWithoutWorkers)
+{
+    JobSystem jobs(0);
+    verify_each_index_visited_once(64);
+}
+
+TEST(JobSystemTest, SupportsNestedCalls)
+{
+    JobSystem jobs(3);
+
+    std::atomic<size_t> sum(0);
+    rainbow::parallel_for(16, 1, [&sum](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            rainbow::parallel_for(
+                1000, 10, [&sum](size_t inner_begin, size_t inner_end) {
+                    sum += inner_end - inner_begin;
+                });
+        }
+    });
+
+    ASSERT_EQ(16u * 1000u, sum);
+}
+
+TEST(JobSystemTest, RunsSubmittedJobs)
+{
+    std::atomic<int> calls(0);
+    {
+        JobSystem jobs(2);
+        for (int i = 0; i < 100; ++i)
+            jobs.submit([&calls] { ++calls; });
+    }
+    ASSERT_EQ(100, calls);
+
+    JobSystem jobs(0);
+    jobs.submit([&calls] { ++calls; });
+    ASSERT_EQ(101, calls);
+}
+
+TEST(JobSystemTest, OnlyWorkersRunSubmittedJobs)
+{
+    constexpr int kJobs = 16;
+
+    JobSystem jobs(2);
+    const auto caller = std::this_thread::get_id();
+    std::atomic<int> done(0);
+    std::atomic<int> ran_on_caller(0);
+
+    // The caller always takes the first chunk. Jobs submitted from it must
+    // not be picked up while it waits for the second chunk.
+    jobs.parallel_for(2, 1, [&](size_t begin, size_t) {
+        if (begin > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return;
+        }
+
+        for (int i = 0; i < kJobs; ++i)
+        {
+            jobs.submit([caller, &done, &ran_on_caller] {
+                if (std::this_thread::get_id() == caller)
+                    ++ran_on_caller;
+                ++done;
+            });
+        }
+    });
+
+    while (done < kJobs)
+        std::this_thread::yield();
+
+    ASSERT_EQ(0, ran_on_caller);
+}
+
+TEST(JobSystemTest, UnregistersOnDestruction)
+{
+    {
+        JobSystem jobs(1);
+        ASSERT_EQ(&jobs, JobSystem::Get());
+    }
+    ASSERT_EQ(nullptr, JobSystem::Get());
+}
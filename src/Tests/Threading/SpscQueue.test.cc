@@ -0,0 +1,88 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "Threading/SpscQueue.h"
+
+using rainbow::SpscQueue;
+
+TEST(SpscQueueTest, PopsValuesInOrder)
+{
+    SpscQueue<int, 4> queue;
+    ASSERT_TRUE(queue.empty());
+
+    int value = -1;
+    ASSERT_FALSE(queue.try_pop(value));
+    ASSERT_EQ(-1, value);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_TRUE(queue.try_push(i * 2));
+        ASSERT_TRUE(queue.try_push(i * 2 + 1));
+        ASSERT_FALSE(queue.empty());
+
+        ASSERT_TRUE(queue.try_pop(value));
+        ASSERT_EQ(i * 2, value);
+        ASSERT_TRUE(queue.try_pop(value));
+        ASSERT_EQ(i * 2 + 1, value);
+        ASSERT_TRUE(queue.empty());
+    }
+}
+
+TEST(SpscQueueTest, RejectsValuesWhenFull)
+{
+    SpscQueue<int, 4> queue;
+    for (int i = 0; i < 4; ++i)
+        ASSERT_TRUE(queue.try_push(i));
+    ASSERT_FALSE(queue.try_push(4));
+
+    int value = -1;
+    ASSERT_TRUE(queue.try_pop(value));
+    ASSERT_EQ(0, value);
+    ASSERT_TRUE(queue.try_push(4));
+
+    for (int i = 1; i <= 4; ++i)
+    {
+        ASSERT_TRUE(queue.try_pop(value));
+        ASSERT_EQ(i, value);
+    }
+    ASSERT_TRUE(queue.empty());
+}
+
+TEST(SpscQueueTest, PassesValuesBetweenThreads)
+{
+    constexpr int kCount = 100000;
+
+    SpscQueue<int, 64> queue;
+    std::thread producer([&queue] {
+        for (int i = 0; i < kCount; ++i)
+        {
+            while (!queue.try_push(i))
+                std::this_thread::yield();
+        }
+    });
+
+    int popped = 0;
+    int out_of_order = 0;
+    while (popped < kCount)
+    {
+        int value;
+        if (!queue.try_pop(value))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        if (value != popped)
+            ++out_of_order;
+        ++popped;
+    }
+
+    producer.join();
+    ASSERT_EQ(0, out_of_order);
+    ASSERT_TRUE(queue.empty());
+}
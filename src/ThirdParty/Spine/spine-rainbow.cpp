@@ -251,15 +251,12 @@ Skeleton* Skeleton::from_json(const char* path, float scale)
 
 Skeleton::Skeleton(spSkeletonData* data, spAtlas* atlas)
     : skeleton_(nullptr), state_(nullptr), time_scale_(1.0f), num_vertices_(0),
-      texture_(nullptr), max_vertices_(0), animation_data_(nullptr),
-      atlas_(atlas), data_(data)
+      texture_(nullptr), animation_data_(nullptr), atlas_(atlas), data_(data)
 {
     skeleton_ = spSkeleton_create(data);
     spSkeleton_setToSetupPose(skeleton_);
     animation_data_ = spAnimationStateData_create(data);
     state_ = spAnimationState_create(animation_data_);
-
-    array_.reconfigure([this] { vertex_buffer_.bind(); });
 }
 
 Skeleton::~Skeleton()
@@ -339,7 +336,8 @@ void Skeleton::set_skin(const char* skin)
 
 void Skeleton::draw()
 {
-    rainbow::graphics::draw_arrays(*this, 0, num_vertices_);
+    rainbow::graphics::draw_arrays(
+        *this, vertex_buffer_.base_vertex(), num_vertices_);
 }
 
 void Skeleton::update(unsigned long dt)
@@ -353,14 +351,13 @@ void Skeleton::update(unsigned long dt)
     // This solution is not ideal. We iterate over the bones twice: First to
     // determine number of vertices, second to update the vertex buffer.
     num_vertices_ = get_vertex_count(skeleton_, &texture_);
-    if (num_vertices_ > max_vertices_)
-    {
-        max_vertices_ = num_vertices_;
-        vertices_ = std::make_unique<SpriteVertex[]>(max_vertices_);
-    }
+
+    // Vertices are written straight into the vertex buffer, which must not be
+    // read from.
+    SpriteVertex* buffer = vertex_buffer_.map(num_vertices_);
 
     size_t i = 0;
-    for_each(skeleton_, [this, &i](spSlot* slot) {
+    for_each(skeleton_, [this, buffer, &i](spSlot* slot) {
         if (!slot->attachment)
             return;
 
@@ -380,47 +377,37 @@ void Skeleton::update(unsigned long dt)
                 const char b = skeleton_->b * slot->b * 0xff;
                 const char a = skeleton_->a * slot->a * 0xff;
 
-                vertices_[i].color.r = r;
-                vertices_[i].color.g = g;
-                vertices_[i].color.b = b;
-                vertices_[i].color.a = a;
-                vertices_[i].texcoord.x = region->uvs[SP_VERTEX_X1];
-                vertices_[i].texcoord.y = region->uvs[SP_VERTEX_Y1];
-                vertices_[i].position.x = vertices[SP_VERTEX_X1];
-                vertices_[i].position.y = vertices[SP_VERTEX_Y1];
-
-                vertices_[++i].color.r = r;
-                vertices_[i].color.g = g;
-                vertices_[i].color.b = b;
-                vertices_[i].color.a = a;
-                vertices_[i].texcoord.x = region->uvs[SP_VERTEX_X2];
-                vertices_[i].texcoord.y = region->uvs[SP_VERTEX_Y2];
-                vertices_[i].position.x = vertices[SP_VERTEX_X2];
-                vertices_[i].position.y = vertices[SP_VERTEX_Y2];
-
-                vertices_[++i].color.r = r;
-                vertices_[i].color.g = g;
-                vertices_[i].color.b = b;
-                vertices_[i].color.a = a;
-                vertices_[i].texcoord.x = region->uvs[SP_VERTEX_X3];
-                vertices_[i].texcoord.y = region->uvs[SP_VERTEX_Y3];
-                vertices_[i].position.x = vertices[SP_VERTEX_X3];
-                vertices_[i].position.y = vertices[SP_VERTEX_Y3];
-
-                ++i;
-                vertices_[i] = vertices_[i - 1];
-
-                vertices_[++i].color.r = r;
-                vertices_[i].color.g = g;
-                vertices_[i].color.b = b;
-                vertices_[i].color.a = a;
-                vertices_[i].texcoord.x = region->uvs[SP_VERTEX_X4];
-                vertices_[i].texcoord.y = region->uvs[SP_VERTEX_Y4];
-                vertices_[i].position.x = vertices[SP_VERTEX_X4];
-                vertices_[i].position.y = vertices[SP_VERTEX_Y4];
-
-                ++i;
-                vertices_[i] = vertices_[i - 5];
+                SpriteVertex quad[4];
+                for (auto&& vertex : quad)
+                {
+                    vertex.color.r = r;
+                    vertex.color.g = g;
+                    vertex.color.b = b;
+                    vertex.color.a = a;
+                }
+                quad[0].texcoord.x = region->uvs[SP_VERTEX_X1];
+                quad[0].texcoord.y = region->uvs[SP_VERTEX_Y1];
+                quad[0].position.x = vertices[SP_VERTEX_X1];
+                quad[0].position.y = vertices[SP_VERTEX_Y1];
+                quad[1].texcoord.x = region->uvs[SP_VERTEX_X2];
+                quad[1].texcoord.y = region->uvs[SP_VERTEX_Y2];
+                quad[1].position.x = vertices[SP_VERTEX_X2];
+                quad[1].position.y = vertices[SP_VERTEX_Y2];
+                quad[2].texcoord.x = region->uvs[SP_VERTEX_X3];
+                quad[2].texcoord.y = region->uvs[SP_VERTEX_Y3];
+                quad[2].position.x = vertices[SP_VERTEX_X3];
+                quad[2].position.y = vertices[SP_VERTEX_Y3];
+                quad[3].texcoord.x = region->uvs[SP_VERTEX_X4];
+                quad[3].texcoord.y = region->uvs[SP_VERTEX_Y4];
+                quad[3].position.x = vertices[SP_VERTEX_X4];
+                quad[3].position.y = vertices[SP_VERTEX_Y4];
+
+                buffer[i] = quad[0];
+                buffer[++i] = quad[1];
+                buffer[++i] = quad[2];
+                buffer[++i] = quad[2];
+                buffer[++i] = quad[3];
+                buffer[++i] = quad[0];
 
                 ++i;
                 break;
@@ -432,7 +419,7 @@ void Skeleton::update(unsigned long dt)
                     reinterpret_cast<spMeshAttachment*>(slot->attachment);
                 R_ASSERT(texture_ == get_texture(mesh),
                          kErrorMultipleTexturesUnsupported);
-                i += update_mesh(&vertices_[i], skeleton_, mesh, slot);
+                i += update_mesh(&buffer[i], skeleton_, mesh, slot);
                 break;
             }
             case SP_ATTACHMENT_SKINNED_MESH: {
@@ -441,7 +428,7 @@ void Skeleton::update(unsigned long dt)
                         slot->attachment);
                 R_ASSERT(texture_ == get_texture(mesh),
                          kErrorMultipleTexturesUnsupported);
-                i += update_mesh(&vertices_[i], skeleton_, mesh, slot);
+                i += update_mesh(&buffer[i], skeleton_, mesh, slot);
                 break;
             }
         }
@@ -449,7 +436,7 @@ void Skeleton::update(unsigned long dt)
             LOGE("Non-normal blend mode not yet implemented");
     });
 
-    vertex_buffer_.upload(vertices_.get(), i * sizeof(SpriteVertex));
+    vertex_buffer_.unmap(i);
 }
 
 #if USE_LUA_SCRIPT
@@ -10,9 +10,8 @@
 #include <spine/AnimationState.h>
 #include <spine/AnimationStateData.h>
 
-#include "Graphics/Buffer.h"
 #include "Graphics/Drawable.h"
-#include "Graphics/VertexArray.h"
+#include "Graphics/StreamingBuffer.h"
 
 #if USE_LUA_SCRIPT
 #   include "Lua/LuaBind.h"
@@ -36,7 +35,7 @@ public:
     /// <summary>Returns the vertex array object.</summary>
     auto vertex_array() const -> const rainbow::graphics::VertexArray&
     {
-        return array_;
+        return vertex_buffer_.vertex_array();
     }
 
     /// <summary>
@@ -116,12 +115,9 @@ private:
     spSkeleton* skeleton_;
     spAnimationState* state_;
     float time_scale_;
-    std::unique_ptr<SpriteVertex[]> vertices_;
     size_t num_vertices_;
-    rainbow::graphics::Buffer vertex_buffer_;
-    rainbow::graphics::VertexArray array_;
+    rainbow::graphics::StreamingBuffer vertex_buffer_;
     TextureAtlas* texture_;
-    size_t max_vertices_;
     spAnimationStateData* animation_data_;
     spAtlas* atlas_;
     spSkeletonData* data_;
@@ -0,0 +1,192 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#include "Threading/JobSystem.h"
+
+#include <algorithm>
+
+#include "Common/Logging.h"
+#include "Platform/Macros.h"
+
+using rainbow::JobSystem;
+
+namespace
+{
+    JobSystem* g_job_system = nullptr;
+
+    /// <summary>
+    ///   Index of the calling thread's queue. Threads not owned by the job
+    ///   system share the first queue.
+    /// </summary>
+    thread_local size_t t_queue_index = 0;
+}
+
+auto JobSystem::Get() -> JobSystem*
+{
+    return g_job_system;
+}
+
+auto JobSystem::default_worker_count() -> unsigned int
+{
+#ifdef RAINBOW_JS
+    return 0;
+#else
+    const unsigned int threads = std::thread::hardware_concurrency();
+    return threads > 1 ? threads - 1 : 0;
+#endif
+}
+
+JobSystem::JobSystem(unsigned int num_workers) : queued_(0), stopping_(false)
+{
+    R_ASSERT(g_job_system == nullptr, "A job system already exists");
+
+    for (unsigned int i = 0; i <= num_workers; ++i)
+        queues_.push_back(std::make_unique<Queue>());
+
+    workers_.reserve(num_workers);
+    for (unsigned int i = 1; i <= num_workers; ++i)
+        workers_.emplace_back(&JobSystem::work, this, i);
+
+    g_job_system = this;
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+
+    for (auto&& worker : workers_)
+        worker.join();
+
+    // Detached jobs own their context and must run to release it.
+    while (run_detached()) {}
+
+    g_job_system = nullptr;
+}
+
+void JobSystem::push_detached(void* context, Task task)
+{
+    // Count the job before it can be taken, or |queued_| may underflow.
+    ++queued_;
+    detached_.push({task, context, 0, 0, nullptr});
+
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    wake_.notify_one();
+}
+
+void JobSystem::run(size_t count, size_t grain, void* context, Task task)
+{
+    if (count == 0)
+        return;
+
+    grain = std::max<size_t>(grain, 1);
+    const size_t chunks = (count + grain - 1) / grain;
+    if (chunks == 1 || workers_.empty())
+    {
+        task(context, 0, count);
+        return;
+    }
+
+    // The calling thread takes the first chunk; the rest go into its queue
+    // for anyone to pick up.
+    std::atomic<size_t> pending(chunks - 1);
+    queued_ += chunks - 1;
+
+    auto& queue = *queues_[t_queue_index];
+    for (size_t i = chunks - 1; i > 0; --i)
+    {
+        const size_t begin = i * grain;
+        queue.push({task, context, begin, std::min(begin + grain, count),
+                    &pending});
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    wake_.notify_all();
+
+    task(context, 0, grain);
+
+    while (pending.load(std::memory_order_acquire) > 0)
+    {
+        if (!run_one(t_queue_index))
+            std::this_thread::yield();
+    }
+}
+
+bool JobSystem::run_one(size_t index)
+{
+    Job job;
+    bool found = queues_[index]->pop(job);
+    for (size_t i = 1; !found && i < queues_.size(); ++i)
+        found = queues_[(index + i) % queues_.size()]->steal(job);
+
+    if (!found)
+        return false;
+
+    --queued_;
+    job.task(job.context, job.begin, job.end);
+    if (job.pending != nullptr)
+        job.pending->fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+bool JobSystem::run_detached()
+{
+    Job job;
+    if (!detached_.steal(job))
+        return false;
+
+    --queued_;
+    job.task(job.context, job.begin, job.end);
+    return true;
+}
+
+void JobSystem::work(size_t index)
+{
+    t_queue_index = index;
+    while (true)
+    {
+        if (run_one(index) || run_detached())
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [this] { return queued_ > 0 || stopping_; });
+        if (stopping_)
+            break;
+    }
+}
+
+bool JobSystem::Queue::pop(Job& job)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (jobs_.empty())
+        return false;
+
+    job = jobs_.back();
+    jobs_.pop_back();
+    return true;
+}
+
+void JobSystem::Queue::push(const Job& job)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back(job);
+}
+
+bool JobSystem::Queue::steal(Job& job)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (jobs_.empty())
+        return false;
+
+    job = jobs_.front();
+    jobs_.pop_front();
+    return true;
+}
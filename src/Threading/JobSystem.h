@@ -0,0 +1,173 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef THREADING_JOBSYSTEM_H_
+#define THREADING_JOBSYSTEM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "Common/NonCopyable.h"
+
+namespace rainbow
+{
+    /// <summary>
+    ///   Fixed pool of worker threads. Each thread, including the one that
+    ///   created the job system, owns a job queue. Idle threads steal work from
+    ///   the front of other threads' queues. Detached jobs go into a separate
+    ///   queue that only workers drain, so that threads waiting on
+    ///   <see cref="parallel_for"/> are never held up by unrelated work.
+    /// </summary>
+    /// <remarks>
+    ///   Only one job system may exist at a time. Jobs must not touch the
+    ///   OpenGL context or the Lua state.
+    /// </remarks>
+    class JobSystem : private NonCopyable<JobSystem>
+    {
+    public:
+        /// <summary>
+        ///   Returns the current job system, or <c>nullptr</c> if none has been
+        ///   created.
+        /// </summary>
+        static auto Get() -> JobSystem*;
+
+        /// <summary>
+        ///   Returns the number of workers to use if none is specified; one
+        ///   less than the number of hardware threads.
+        /// </summary>
+        static auto default_worker_count() -> unsigned int;
+
+        explicit JobSystem(unsigned int num_workers = default_worker_count());
+        ~JobSystem();
+
+        /// <summary>Returns the number of worker threads.</summary>
+        auto worker_count() const { return workers_.size(); }
+
+        /// <summary>
+        ///   Splits [0, <paramref name="count"/>) into chunks of
+        ///   <paramref name="grain"/> and calls
+        ///   <paramref name="f"/>(begin, end) on each, possibly in parallel.
+        ///   Returns when all chunks have been processed. The calling thread
+        ///   also runs jobs while waiting, so calls may be nested.
+        /// </summary>
+        template <typename F>
+        void parallel_for(size_t count, size_t grain, F&& f)
+        {
+            using Function = std::remove_reference_t<F>;
+            run(count,
+                grain,
+                const_cast<void*>(static_cast<const void*>(&f)),
+                [](void* context, size_t begin, size_t end) {
+                    (*static_cast<Function*>(context))(begin, end);
+                });
+        }
+
+        /// <summary>
+        ///   Calls <paramref name="f"/>() on a worker thread without waiting
+        ///   for it to return. Workers prefer <see cref="parallel_for"/> jobs
+        ///   over submitted ones. If there are no workers,
+        ///   <paramref name="f"/> is called on the calling thread instead.
+        /// </summary>
+        template <typename F>
+        void submit(F&& f)
+        {
+            using Function = std::decay_t<F>;
+            if (workers_.empty())
+            {
+                f();
+                return;
+            }
+
+            push_detached(new Function(std::forward<F>(f)),
+                          [](void* context, size_t, size_t) {
+                              std::unique_ptr<Function> function(
+                                  static_cast<Function*>(context));
+                              (*function)();
+                          });
+        }
+
+    private:
+        using Task = void (*)(void*, size_t, size_t);
+
+        struct Job
+        {
+            Task task;
+            void* context;
+            size_t begin;
+            size_t end;
+            std::atomic<size_t>* pending;  ///< <c>nullptr</c> if detached.
+        };
+
+        /// <summary>
+        ///   Mutex-protected deque. The owner pushes and pops at the back;
+        ///   thieves take from the front.
+        /// </summary>
+        class Queue
+        {
+        public:
+            bool pop(Job& job);
+            void push(const Job& job);
+            bool steal(Job& job);
+
+        private:
+            std::mutex mutex_;
+            std::deque<Job> jobs_;
+        };
+
+        std::vector<std::unique_ptr<Queue>> queues_;
+        Queue detached_;  ///< Jobs that nobody waits for.
+        std::vector<std::thread> workers_;
+        std::atomic<size_t> queued_;
+        std::mutex sleep_mutex_;
+        std::condition_variable wake_;
+        bool stopping_;
+
+        /// <summary>
+        ///   Queues a job that nobody waits for. <paramref name="task"/> owns
+        ///   <paramref name="context"/>.
+        /// </summary>
+        void push_detached(void* context, Task task);
+
+        void run(size_t count, size_t grain, void* context, Task task);
+
+        /// <summary>
+        ///   Runs one job from the queue at <paramref name="index"/>, or one
+        ///   stolen from another queue.
+        /// </summary>
+        /// <returns><c>true</c> if a job was run.</returns>
+        bool run_one(size_t index);
+
+        /// <summary>Runs one detached job.</summary>
+        /// <returns><c>true</c> if a job was run.</returns>
+        bool run_detached();
+
+        void work(size_t index);
+    };
+
+    /// <summary>
+    ///   Runs <see cref="JobSystem::parallel_for"/> on the current job system,
+    ///   or serially on the calling thread if there is none.
+    /// </summary>
+    template <typename F>
+    void parallel_for(size_t count, size_t grain, F&& f)
+    {
+        auto jobs = JobSystem::Get();
+        if (jobs == nullptr)
+        {
+            if (count > 0)
+                f(size_t{0}, count);
+            return;
+        }
+
+        jobs->parallel_for(count, grain, std::forward<F>(f));
+    }
+}
+
+#endif
@@ -0,0 +1,84 @@
+// Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+// Distributed under the MIT License.
+// (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+#ifndef THREADING_SPSCQUEUE_H_
+#define THREADING_SPSCQUEUE_H_
+
+#include <array>
+#include <atomic>
+#include <utility>
+
+#include "Common/NonCopyable.h"
+
+namespace rainbow
+{
+    /// <summary>
+    ///   Fixed-size, lock-free queue for passing values from one thread to
+    ///   another. Only one thread may push, and only one thread may pop.
+    /// </summary>
+    template <typename T, size_t N>
+    class SpscQueue : private NonCopyable<SpscQueue<T, N>>
+    {
+        static_assert(N > 0 && (N & (N - 1)) == 0,
+                      "Capacity must be a power of two");
+
+    public:
+        SpscQueue() : head_(0), tail_(0) {}
+
+        /// <summary>Returns the maximum number of queued values.</summary>
+        static constexpr auto capacity() { return N; }
+
+        /// <summary>
+        ///   Returns whether the queue is empty. The result may be stale by
+        ///   the time it is used, unless called by the consumer.
+        /// </summary>
+        bool empty() const
+        {
+            return head_.load(std::memory_order_acquire) ==
+                   tail_.load(std::memory_order_acquire);
+        }
+
+        /// <summary>
+        ///   Removes the value at the front of the queue, and stores it in
+        ///   <paramref name="value"/>. Must only be called by the consumer.
+        /// </summary>
+        /// <returns><c>false</c> if the queue is empty.</returns>
+        bool try_pop(T& value)
+        {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            if (head == tail_.load(std::memory_order_acquire))
+                return false;
+
+            value = std::move(items_[head & (N - 1)]);
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// <summary>
+        ///   Adds <paramref name="value"/> to the back of the queue. Must only
+        ///   be called by the producer.
+        /// </summary>
+        /// <returns><c>false</c> if the queue is full.</returns>
+        bool try_push(T value)
+        {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_.load(std::memory_order_acquire) == N)
+                return false;
+
+            items_[tail & (N - 1)] = std::move(value);
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        std::array<T, N> items_;
+
+        // Keep the indices on separate cache lines so that the producer and
+        // the consumer do not contend.
+        alignas(64) std::atomic<size_t> head_;  ///< Next value to pop.
+        alignas(64) std::atomic<size_t> tail_;  ///< Next slot to push to.
+    };
+}
+
+#endif
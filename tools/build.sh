@@ -50,6 +50,7 @@ case $1 in
     echo "  -DUSE_HEIMDALL=1         Enable Heimdall debugging facilities"
     echo "  -DUSE_LUA_SCRIPT=1       Enable Lua scripting"
     echo "  -DUSE_PHYSICS=1          Enable physics module (Box2D)"
+    echo "  -DUSE_SOFTWARE_MIXER=1   Enable software audio mixer"
     echo "  -DUSE_SPINE=1            Enable Spine runtime"
     echo "  -DUSE_VECTOR=1           Enable vector drawing library (NanoVG)"
     echo
@@ -0,0 +1,250 @@
+#!/usr/bin/python
+# Copyright (c) 2010-16 Bifrost Entertainment AS and Tommy Nguyen
+# Distributed under the MIT License.
+# (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+
+# Converts PNG images to compressed KTX textures, with mipmaps.
+#
+#   ktx-convert.py [--format bc1|bc3|etc1|etc2] [--no-mipmaps] input.png [output.ktx]
+#
+# BC1 and BC3 (S3TC) are for desktops. ETC1 is supported by all OpenGL ES 2.0
+# devices; ETC2 is the same data tagged as ETC2 RGB8, which is backwards
+# compatible and required by OpenGL ES 3.0. Neither ETC format has alpha.
+# Textures in formats the driver does not support are decoded in software.
+
+import os
+import struct
+import sys
+import zlib
+
+GL_COMPRESSED_RGB_S3TC_DXT1_EXT = 0x83F0
+GL_COMPRESSED_RGBA_S3TC_DXT5_EXT = 0x83F3
+GL_ETC1_RGB8_OES = 0x8D64
+GL_COMPRESSED_RGB8_ETC2 = 0x9274
+GL_RGB = 0x1907
+GL_RGBA = 0x1908
+
+KTX_IDENTIFIER = b'\xabKTX 11\xbb\r\n\x1a\n'
+
+ETC_MODIFIERS = [
+    (2, 8), (5, 17), (9, 29), (13, 42), (18, 60), (24, 80), (33, 106), (47, 183)
+]
+
+def clamp(value):
+    return min(max(value, 0), 255)
+
+def read_png(path):
+    """Returns width, height, and rows of RGBA tuples."""
+    f = open(path, 'rb')
+    data = f.read()
+    f.close()
+    if data[:8] != b'\x89PNG\r\n\x1a\n':
+        raise ValueError(path + ': Not a PNG file')
+
+    idat = b''
+    offset = 8
+    while offset < len(data):
+        length, chunk = struct.unpack('>I4s', data[offset:offset + 8])
+        body = data[offset + 8:offset + 8 + length]
+        if chunk == b'IHDR':
+            width, height, depth, color_type, _, _, interlace = \
+                struct.unpack('>IIBBBBB', body)
+        elif chunk == b'IDAT':
+            idat += body
+        offset += length + 12
+
+    if depth != 8 or color_type not in (2, 6) or interlace != 0:
+        raise ValueError(path + ': Only non-interlaced 8-bit RGB(A) is supported')
+
+    channels = 4 if color_type == 6 else 3
+    stride = width * channels
+    raw = zlib.decompress(idat)
+    rows = []
+    previous = bytearray(stride)
+    for y in range(height):
+        start = y * (stride + 1)
+        kind = raw[start]
+        line = bytearray(raw[start + 1:start + 1 + stride])
+        for x in range(stride):
+            a = line[x - channels] if x >= channels else 0
+            b = previous[x]
+            c = previous[x - channels] if x >= channels else 0
+            if kind == 1:
+                line[x] = (line[x] + a) & 0xff
+            elif kind == 2:
+                line[x] = (line[x] + b) & 0xff
+            elif kind == 3:
+                line[x] = (line[x] + ((a + b) >> 1)) & 0xff
+            elif kind == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                predictor = a if pa <= pb and pa <= pc else (b if pb <= pc else c)
+                line[x] = (line[x] + predictor) & 0xff
+        previous = line
+        if channels == 3:
+            rows.append([tuple(line[i:i + 3]) + (255,) for i in range(0, stride, 3)])
+        else:
+            rows.append([tuple(line[i:i + 4]) for i in range(0, stride, 4)])
+    return width, height, rows
+
+def downsample(width, height, rows):
+    """Halves the image using a box filter."""
+    w = max(width >> 1, 1)
+    h = max(height >> 1, 1)
+    result = []
+    for y in range(h):
+        row = []
+        for x in range(w):
+            samples = [rows[min(y * 2 + j, height - 1)][min(x * 2 + i, width - 1)]
+                       for j in range(2) for i in range(2)]
+            row.append(tuple((sum(s[c] for s in samples) + 2) >> 2 for c in range(4)))
+        result.append(row)
+    return w, h, result
+
+def blocks(width, height, rows):
+    """Yields 4x4 blocks of pixels, row by row. Edges are clamped."""
+    for by in range(0, height, 4):
+        for bx in range(0, width, 4):
+            yield [rows[min(by + y, height - 1)][min(bx + x, width - 1)]
+                   for y in range(4) for x in range(4)]
+
+def to_565(color):
+    return ((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3)
+
+def from_565(value):
+    r, g, b = (value >> 11) & 0x1f, (value >> 5) & 0x3f, value & 0x1f
+    return ((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2))
+
+def distance(a, b):
+    return sum((a[i] - b[i]) ** 2 for i in range(3))
+
+def encode_bc1(block):
+    # Endpoints are the corners of the bounding box of the colours.
+    lo = tuple(min(p[c] for p in block) for c in range(3))
+    hi = tuple(max(p[c] for p in block) for c in range(3))
+    c0, c1 = to_565(hi), to_565(lo)
+    if c0 < c1:
+        c0, c1 = c1, c0
+    if c0 == c1:
+        return struct.pack('<HHI', c0, c1, 0)
+
+    e0, e1 = from_565(c0), from_565(c1)
+    palette = [e0, e1,
+               tuple((2 * e0[i] + e1[i]) // 3 for i in range(3)),
+               tuple((e0[i] + 2 * e1[i]) // 3 for i in range(3))]
+    indices = 0
+    for i, pixel in enumerate(block):
+        best = min(range(4), key=lambda k: distance(pixel, palette[k]))
+        indices |= best << (i * 2)
+    return struct.pack('<HHI', c0, c1, indices)
+
+def encode_bc3(block):
+    a0 = max(p[3] for p in block)
+    a1 = min(p[3] for p in block)
+    if a0 == a1:
+        alpha = struct.pack('<BB', a0, a1) + b'\0' * 6
+    else:
+        palette = [a0, a1] + [((8 - i) * a0 + (i - 1) * a1) // 7 for i in range(2, 8)]
+        indices = 0
+        for i, pixel in enumerate(block):
+            best = min(range(8), key=lambda k: abs(pixel[3] - palette[k]))
+            indices |= best << (i * 3)
+        alpha = struct.pack('<BB', a0, a1) + indices.to_bytes(6, 'little')
+    return alpha + encode_bc1(block)
+
+def encode_etc1_subblock(pixels):
+    """Returns base colour, table, and indices for (index, pixel) pairs."""
+    avg = [sum(p[c] for _, p in pixels) // len(pixels) for c in range(3)]
+    base = [(v * 15 + 127) // 255 for v in avg]
+    color = [b * 17 for b in base]
+    best = None
+    for table, (a, b) in enumerate(ETC_MODIFIERS):
+        modifiers = (a, b, -a, -b)
+        error = 0
+        indices = []
+        for k, pixel in pixels:
+            candidates = [(distance(pixel, [clamp(c + m) for c in color]), i)
+                          for i, m in enumerate(modifiers)]
+            e, i = min(candidates)
+            error += e
+            indices.append((k, i))
+        if best is None or error < best[0]:
+            best = (error, table, indices)
+    return best[0], base, best[1], best[2]
+
+def encode_etc1(block):
+    # Individual mode with 4-bit base colours; both split directions are
+    # tried. These blocks are valid ETC2 RGB8 blocks as well.
+    best = None
+    for flip in (0, 1):
+        halves = ([], [])
+        for y in range(4):
+            for x in range(4):
+                half = (y if flip else x) >= 2
+                halves[half].append((x * 4 + y, block[y * 4 + x]))
+        e0, base0, table0, indices0 = encode_etc1_subblock(halves[0])
+        e1, base1, table1, indices1 = encode_etc1_subblock(halves[1])
+        if best is None or e0 + e1 < best[0]:
+            best = (e0 + e1, flip, base0, base1, table0, table1, indices0 + indices1)
+
+    _, flip, base0, base1, table0, table1, indices = best
+    bits = 0
+    for i in range(3):
+        bits |= ((base0[i] << 4) | base1[i]) << (56 - i * 8)
+    bits |= (table0 << 37) | (table1 << 34) | (flip << 32)
+    for k, i in indices:
+        bits |= ((i >> 1) << (k + 16)) | ((i & 1) << k)
+    return struct.pack('>Q', bits)
+
+FORMATS = {
+    'bc1': (GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_RGB, encode_bc1),
+    'bc3': (GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_RGBA, encode_bc3),
+    'etc1': (GL_ETC1_RGB8_OES, GL_RGB, encode_etc1),
+    'etc2': (GL_COMPRESSED_RGB8_ETC2, GL_RGB, encode_etc1),
+}
+
+def main(argv):
+    format = 'etc2'
+    mipmaps = True
+    args = []
+    i = 1
+    while i < len(argv):
+        if argv[i] == '--format':
+            i += 1
+            format = argv[i]
+        elif argv[i] == '--no-mipmaps':
+            mipmaps = False
+        else:
+            args.append(argv[i])
+        i += 1
+    if not args or format not in FORMATS:
+        sys.stderr.write('Usage: ' + argv[0] +
+                         ' [--format bc1|bc3|etc1|etc2] [--no-mipmaps]' +
+                         ' input.png [output.ktx]\n')
+        return 1
+
+    internal_format, base_format, encode = FORMATS[format]
+    output = args[1] if len(args) > 1 else os.path.splitext(args[0])[0] + '.ktx'
+
+    width, height, rows = read_png(args[0])
+    levels = []
+    w, h = width, height
+    while True:
+        levels.append(b''.join(encode(block) for block in blocks(w, h, rows)))
+        if not mipmaps or (w == 1 and h == 1):
+            break
+        w, h, rows = downsample(w, h, rows)
+
+    f = open(output, 'wb')
+    f.write(KTX_IDENTIFIER)
+    f.write(struct.pack('<13I', 0x04030201, 0, 1, 0, internal_format,
+                        base_format, width, height, 0, 0, 1, len(levels), 0))
+    for level in levels:
+        f.write(struct.pack('<I', len(level)))
+        f.write(level)
+        f.write(b'\0' * (-len(level) % 4))
+    f.close()
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))